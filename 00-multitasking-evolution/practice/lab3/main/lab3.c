@@ -2,20 +2,58 @@
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "driver/gpio.h"
+#include "driver/gptimer.h"
 #include "esp_log.h"
-#include "esp_timer.h"
+#include "tstamp.h"
+#include "irqlat.h"
 
 #define LED1_PIN GPIO_NUM_2   // Task 1 indicator
 #define LED2_PIN GPIO_NUM_4   // Task 2 indicator
 #define LED3_PIN GPIO_NUM_5   // Task 3 indicator
 #define BUTTON_PIN GPIO_NUM_0 // Emergency button
 
+#define EMERGENCY_HOLD_MS   200     // LED on; bounces in this window are dropped
+#define PROBE_RESOLUTION_HZ 10000000
+#define PROBE_PERIOD_US     9973    // Prime, so it drifts across the tick
+#define LATENCY_REPORT_MS   10000
+
 static const char *TAG = "COOPERATIVE";
 
 // Global variables for cooperative scheduling
 static volatile bool emergency_flag = false;
-static uint64_t task_start_time = 0;
-static uint32_t max_response_time = 0;
+
+// Interrupt-to-task latency: the emergency button, plus a timer-driven
+// probe whose alarm time is known, so its masked stage is measured too
+static irqlat_source_t src_button;
+static irqlat_source_t src_probe;
+static TaskHandle_t emergency_task_handle = NULL;  // NULL = cooperative mode
+static TaskHandle_t probe_task_handle = NULL;
+static uint32_t probe_cycles_per_count;
+
+// Button ISR: wakes the emergency task (preemptive) or raises the flag
+// the cooperative tasks poll
+static void IRAM_ATTR button_isr(void *arg)
+{
+    BaseType_t woken = pdFALSE;
+    irqlat_isr_enter(&src_button);
+    irqlat_isr_give(&src_button);
+    if (emergency_task_handle != NULL) {
+        vTaskNotifyGiveFromISR(emergency_task_handle, &woken);
+    } else {
+        emergency_flag = true;
+    }
+    irqlat_isr_exit(&src_button, woken);
+    portYIELD_FROM_ISR(woken);
+}
+
+// Drop bounces that came in during the hold-off and listen again
+static void emergency_rearm(void)
+{
+    ulTaskNotifyTake(pdTRUE, 0);
+    irqlat_task_discard(&src_button);
+    emergency_flag = false;
+    gpio_intr_enable(BUTTON_PIN);
+}
 
 // Task structures for cooperative multitasking
 typedef struct {
@@ -81,21 +119,19 @@ void cooperative_task2(void)
 void cooperative_task3_emergency(void)
 {
     if (emergency_flag) {
-        uint64_t response_time = esp_timer_get_time() - task_start_time;
-        uint32_t response_ms = (uint32_t)(response_time / 1000);
+        // Nothing woke us: the whole wait for our turn counts as preempted
+        irqlat_task_run(&src_button);
+        gpio_intr_disable(BUTTON_PIN);
         
-        if (response_ms > max_response_time) {
-            max_response_time = response_ms;
-        }
+        gpio_set_level(LED3_PIN, 1);
+        uint32_t response_ns = irqlat_task_done(&src_button);
         
-        ESP_LOGW(TAG, "EMERGENCY RESPONSE! Response time: %d ms (Max: %d ms)", 
-                 response_ms, max_response_time);
+        ESP_LOGW(TAG, "EMERGENCY RESPONSE! Response time: %lu us", response_ns / 1000);
         
-        gpio_set_level(LED3_PIN, 1);
-        vTaskDelay(pdMS_TO_TICKS(200));
+        vTaskDelay(pdMS_TO_TICKS(EMERGENCY_HOLD_MS));
         gpio_set_level(LED3_PIN, 0);
         
-        emergency_flag = false;
+        emergency_rearm();
     }
 }
 
@@ -112,12 +148,8 @@ void cooperative_scheduler(void)
     int current_task = 0;
     
     while (1) {
-        // Check for emergency button
-        if (gpio_get_level(BUTTON_PIN) == 0 && !emergency_flag) {
-            emergency_flag = true;
-            task_start_time = esp_timer_get_time();
-            ESP_LOGW(TAG, "Emergency button pressed!");
-        }
+        // The button ISR sets emergency_flag; tasks notice it at their
+        // next yield point
         
         // Run current task if ready
         if (tasks[current_task].ready) {
@@ -143,9 +175,6 @@ void test_cooperative_multitasking(void)
 
 // Preemptive multitasking using FreeRTOS
 static const char *PREEMPT_TAG = "PREEMPTIVE";
-static volatile bool preempt_emergency = false;
-static uint64_t preempt_start_time = 0;
-static uint32_t preempt_max_response = 0;
 
 void preemptive_task1(void *pvParameters)
 {
@@ -192,30 +221,86 @@ void preemptive_task2(void *pvParameters)
 void preemptive_emergency_task(void *pvParameters)
 {
     while (1) {
-        // Check button every 5ms
-        if (gpio_get_level(BUTTON_PIN) == 0 && !preempt_emergency) {
-            preempt_emergency = true;
-            preempt_start_time = esp_timer_get_time();
-            
-            // This high-priority task will IMMEDIATELY preempt others
-            uint64_t response_time = esp_timer_get_time() - preempt_start_time;
-            uint32_t response_ms = (uint32_t)(response_time / 1000);
-            
-            if (response_ms > preempt_max_response) {
-                preempt_max_response = response_ms;
-            }
-            
-            ESP_LOGW(PREEMPT_TAG, "IMMEDIATE EMERGENCY! Response: %d ms (Max: %d ms)", 
-                     response_ms, preempt_max_response);
-            
-            gpio_set_level(LED3_PIN, 1);
-            vTaskDelay(pdMS_TO_TICKS(200));
-            gpio_set_level(LED3_PIN, 0);
-            
-            preempt_emergency = false;
+        // Blocked until the button ISR notifies - no polling
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        if (!irqlat_task_run(&src_button)) {
+            continue;
         }
+        gpio_intr_disable(BUTTON_PIN);
+        
+        // This high-priority task preempts the others as soon as the ISR returns
+        gpio_set_level(LED3_PIN, 1);
+        uint32_t response_ns = irqlat_task_done(&src_button);
+        
+        ESP_LOGW(PREEMPT_TAG, "IMMEDIATE EMERGENCY! Response: %lu us", response_ns / 1000);
         
-        vTaskDelay(pdMS_TO_TICKS(5)); // Check every 5ms
+        vTaskDelay(pdMS_TO_TICKS(EMERGENCY_HOLD_MS));
+        gpio_set_level(LED3_PIN, 0);
+        
+        emergency_rearm();
+    }
+}
+
+// ================ LATENCY PROBE ================
+// Stand-in for a safety input with a known event time: the timer
+// counter restarts from 0 at each alarm, so reading it in the ISR says
+// how long ago the event was - interrupts masked, higher-priority ISRs
+// and the driver's dispatch all land in the "masked" stage
+
+static bool IRAM_ATTR probe_alarm_isr(gptimer_handle_t timer, const gptimer_alarm_event_data_t *edata, void *arg)
+{
+    uint64_t since_alarm = 0;
+    gptimer_get_raw_count(timer, &since_alarm);
+    irqlat_isr_enter_at(&src_probe, ts_now() - since_alarm * probe_cycles_per_count);
+    
+    BaseType_t woken = pdFALSE;
+    irqlat_isr_give(&src_probe);
+    vTaskNotifyGiveFromISR(probe_task_handle, &woken);
+    irqlat_isr_exit(&src_probe, woken);
+    return woken == pdTRUE;
+}
+
+void probe_task(void *pvParameters)
+{
+    while (1) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        if (irqlat_task_run(&src_probe)) {
+            irqlat_task_done(&src_probe);
+        }
+    }
+}
+
+static void start_latency_probe(UBaseType_t priority)
+{
+    probe_cycles_per_count = (uint32_t)(ts_hz() / PROBE_RESOLUTION_HZ);
+    xTaskCreate(probe_task, "Probe", 2048, NULL, priority, &probe_task_handle);
+    
+    gptimer_handle_t timer = NULL;
+    gptimer_config_t timer_cfg = {
+        .clk_src = GPTIMER_CLK_SRC_DEFAULT,
+        .direction = GPTIMER_COUNT_UP,
+        .resolution_hz = PROBE_RESOLUTION_HZ,
+    };
+    gptimer_alarm_config_t alarm_cfg = {
+        .alarm_count = (uint64_t)PROBE_PERIOD_US * (PROBE_RESOLUTION_HZ / 1000000),
+        .reload_count = 0,
+        .flags.auto_reload_on_alarm = true,
+    };
+    gptimer_event_callbacks_t cbs = { .on_alarm = probe_alarm_isr };
+    
+    ESP_ERROR_CHECK(gptimer_new_timer(&timer_cfg, &timer));
+    ESP_ERROR_CHECK(gptimer_set_alarm_action(timer, &alarm_cfg));
+    ESP_ERROR_CHECK(gptimer_register_event_callbacks(timer, &cbs, NULL));
+    ESP_ERROR_CHECK(gptimer_enable(timer));
+    ESP_ERROR_CHECK(gptimer_start(timer));
+}
+
+void latency_report_task(void *pvParameters)
+{
+    while (1) {
+        vTaskDelay(pdMS_TO_TICKS(LATENCY_REPORT_MS));
+        ESP_LOGI("LATENCY", "⏱️ Interrupt-to-task latency since boot:");
+        irqlat_report(stdout);
     }
 }
 
@@ -228,7 +313,10 @@ void test_preemptive_multitasking(void)
     // Create tasks with different priorities
     xTaskCreate(preemptive_task1, "PreTask1", 2048, NULL, 2, NULL);      // Normal priority
     xTaskCreate(preemptive_task2, "PreTask2", 2048, NULL, 1, NULL);      // Low priority
-    xTaskCreate(preemptive_emergency_task, "Emergency", 2048, NULL, 5, NULL); // High priority
+    xTaskCreate(preemptive_emergency_task, "Emergency", 2048, NULL, 5, &emergency_task_handle); // High priority
+    
+    // Safety-input stand-in just below the emergency task
+    start_latency_probe(4);
     
     // Delete the main task
     vTaskDelete(NULL);
@@ -246,11 +334,20 @@ void app_main(void)
     };
     gpio_config(&io_conf);
 
-    // Button configuration
+    // Button configuration (falling edge = pressed)
+    io_conf.intr_type = GPIO_INTR_NEGEDGE;
     io_conf.mode = GPIO_MODE_INPUT;
     io_conf.pin_bit_mask = 1ULL << BUTTON_PIN;
     io_conf.pull_up_en = 1;
     gpio_config(&io_conf);
+    
+    // Latency profiling: cycle timestamps, sources, then the ISR
+    ts_init();
+    irqlat_source_init(&src_button, "button");
+    irqlat_source_init(&src_probe, "probe");
+    gpio_install_isr_service(0);
+    gpio_isr_handler_add(BUTTON_PIN, button_isr, NULL);
+    xTaskCreate(latency_report_task, "LatReport", 3072, NULL, 1, NULL);
 
     ESP_LOGI("MAIN", "Multitasking Comparison Demo");
     ESP_LOGI("MAIN", "Choose test mode:");
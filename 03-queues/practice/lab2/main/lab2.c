@@ -9,6 +9,11 @@
 #include "esp_log.h"
 #include "driver/gpio.h"
 #include "esp_random.h"
+#include "lab_messages.h"
+#include "tstamp.h"
+#include "loadgen.h"
+#include "ratelim.h"
+#include "aqm.h"
 
 static const char *TAG = "PROD_CONS";
 
@@ -19,7 +24,25 @@ static const char *TAG = "PROD_CONS";
 #define LED_CONSUMER_1 GPIO_NUM_18
 #define LED_CONSUMER_2 GPIO_NUM_19
 
-// Queue handle
+// 1 = the lab starts with an open-loop sweep (loadgen, ~15 min): products
+// arrive on a schedule instead of from the three producer tasks, and the
+// consumer reports latency from the time each product was due. The
+// producers back off whenever the queue is full, so their own numbers
+// never show the overload. After the sweep the producers take over
+#define LOADGEN_ENABLE 0
+
+// Product queue with CoDel-style AQM: once products have been waiting
+// more than 2 s (a bit over one 0.5-2.5 s processing time) for 5 s
+// straight, the stalest are dropped at the head, so under overload a
+// product waits a few seconds instead of through a full queue (~15 s).
+// AQM_TAIL_DROP = the plain queue, AQM_CODEL_MARK = deliver but flag
+#define PRODUCT_AQM_MODE    AQM_CODEL_DROP
+#define PRODUCT_AQM_TARGET_MS   2000
+#define PRODUCT_AQM_INTERVAL_MS 5000
+
+static aqm_queue_t product_queue;
+
+// Queue handle (the queue underneath product_queue, for monitoring)
 QueueHandle_t xProductQueue;
 SemaphoreHandle_t xPrintMutex; // For synchronized printing
 
@@ -28,18 +51,28 @@ typedef struct {
     uint32_t produced;
     uint32_t consumed;
     uint32_t dropped;
+    uint32_t limited;       // Held back at the producer by its rate limiter
+    uint32_t shed;          // Marked by the AQM and skipped by a consumer
 } stats_t;
 
-stats_t global_stats = {0, 0, 0};
+stats_t global_stats = {0, 0, 0, 0, 0};
 
-// Product data structure
-typedef struct {
-    int producer_id;
-    int product_id;
-    char product_name[30];
-    uint32_t production_time;
-    int processing_time_ms;
-} product_t;
+// จำกัดอัตราที่ต้นทาง: each producer gets 0.2 products/s sustained with
+// bursts of 3, so the three together (0.6/s) stay under what one
+// consumer handles (~0.67/s) instead of overflowing the shared queue.
+// One policy per producer to compare them in the statistics.
+#define PRODUCER_RATE       0.2f
+#define PRODUCER_BURST      3
+
+static rl_t producer_limits[3];
+static const rl_policy_t producer_policies[3] = { RL_BLOCK, RL_DROP, RL_DEFER };
+static const char *producer_limit_names[3] = { "producer1", "producer2", "producer3" };
+static rl_t drop_log_limit;         // "Queue full" lines: 1/s, bursts of 5
+
+// Product data structure: product_msg_t from lab_messages.h. The queue
+// carries the encoded product_msg_wire_t (32 bytes instead of 48, of
+// which a product uses about 10) and the display name is formatted from
+// the ids only in the lines that print it.
 
 // Safe printing function
 void safe_printf(const char* format, ...) {
@@ -57,8 +90,9 @@ void safe_printf(const char* format, ...) {
 // Producer task
 void producer_task(void *pvParameters) {
     int producer_id = *((int*)pvParameters);
-    product_t product;
-    int product_counter = 0;
+    product_msg_t product = {0};
+    product_msg_wire_t wire;
+    uint32_t product_counter = 0;
     gpio_num_t led_pin;
     
     // Assign LED pin based on producer ID
@@ -69,24 +103,45 @@ void producer_task(void *pvParameters) {
         default: led_pin = LED_PRODUCER_1;
     }
     
+    rl_t *limit = &producer_limits[(producer_id - 1) % 3];
+    bool deferred = false;          // RL_DEFER: product still waiting for a token
+    uint32_t retry_ms = 0;
+    
     safe_printf("Producer %d started\n", producer_id);
     
     while (1) {
-        // Create product
-        product.producer_id = producer_id;
-        product.product_id = product_counter++;
-        snprintf(product.product_name, sizeof(product.product_name), 
-                "Product-P%d-#%d", producer_id, product.product_id);
-        product.production_time = xTaskGetTickCount();
-        product.processing_time_ms = 500 + (esp_random() % 2000); // 0.5-2.5 seconds
+        // Create product (a deferred one is retried as is)
+        if (!deferred) {
+            product.producer_id = producer_id;
+            product.product_id = product_counter++;
+            product.production_time = xTaskGetTickCount();
+            product.processing_time_ms = 500 + (esp_random() % 2000); // 0.5-2.5 seconds
+            product_msg_pack(&product, &wire);
+        }
+        
+        // RL_BLOCK sleeps in here until a token is due
+        switch (rl_admit(limit, &retry_ms)) {
+            case RL_OK:
+                deferred = false;
+                break;
+            case RL_DEFERRED:
+                deferred = true;
+                vTaskDelay(pdMS_TO_TICKS(retry_ms) + 1);
+                continue;
+            case RL_DROPPED:
+                global_stats.limited++;
+                vTaskDelay(pdMS_TO_TICKS(1000 + (esp_random() % 2000)));
+                continue;
+        }
         
         // Try to send product to queue
-        BaseType_t xStatus = xQueueSend(xProductQueue, &product, pdMS_TO_TICKS(100));
+        BaseType_t xStatus = aqm_send(&product_queue, &wire, pdMS_TO_TICKS(100));
         
         if (xStatus == pdPASS) {
             global_stats.produced++;
-            safe_printf("✓ Producer %d: Created %s (processing: %dms)\n", 
-                       producer_id, product.product_name, product.processing_time_ms);
+            safe_printf("✓ Producer %d: Created " PRODUCT_NAME_FMT " (processing: %lums, %u bytes)\n", 
+                       producer_id, product.producer_id, product.product_id,
+                       product.processing_time_ms, wire.len);
             
             // Blink producer LED
             gpio_set_level(led_pin, 1);
@@ -94,8 +149,11 @@ void producer_task(void *pvParameters) {
             gpio_set_level(led_pin, 0);
         } else {
             global_stats.dropped++;
-            safe_printf("✗ Producer %d: Queue full! Dropped %s\n", 
-                       producer_id, product.product_name);
+            uint32_t suppressed;
+            if (rl_log_ok(&drop_log_limit, &suppressed)) {
+                safe_printf("✗ Producer %d: Queue full! Dropped " PRODUCT_NAME_FMT " (+%lu not shown)\n", 
+                           producer_id, product.producer_id, product.product_id, suppressed);
+            }
         }
         
         // Random production rate (1-3 seconds)
@@ -104,10 +162,88 @@ void producer_task(void *pvParameters) {
     }
 }
 
+// Producer IDs (must be static or global for task parameters)
+static int producer1_id = 1, producer2_id = 2, producer3_id = 3;
+
+static void start_producers(void) {
+    for (int i = 0; i < 3; i++) {
+        rl_init(&producer_limits[i], producer_limit_names[i], PRODUCER_RATE, PRODUCER_BURST,
+                producer_policies[i]);
+    }
+    rl_init(&drop_log_limit, "drop_log", 1.0f, 5, RL_DROP);
+    xTaskCreate(producer_task, "Producer1", 3072, &producer1_id, 3, NULL);
+    xTaskCreate(producer_task, "Producer2", 3072, &producer2_id, 3, NULL);
+    xTaskCreate(producer_task, "Producer3", 3072, &producer3_id, 3, NULL);
+}
+
+#if LOADGEN_ENABLE
+static lg_t *loadgen;           // NULL once the sweep is over
+
+// One consumer handles 1/1.5 s = 0.67 products/s on average; the sweep
+// goes from well under that to past it
+static const float loadgen_rates[] = { 0.2f, 0.4f, 0.5f, 0.6f, 0.7f, 0.8f };
+
+// Stands in for the producers: builds a product when the schedule says
+// it is due and never blocks - a full queue is a drop at this rate
+static lg_result_t issue_product(void *ctx, const lg_request_t *req) {
+    (void)ctx;
+    product_msg_t product = {
+        .producer_id = 1 + req->seq % 3,
+        .product_id = req->seq,
+        .production_time = xTaskGetTickCount(),
+        .processing_time_ms = 500 + (lg_rand32(loadgen) % 2000), // 0.5-2.5 seconds
+        .intended_at = req->intended,
+    };
+    product_msg_wire_t wire;
+    product_msg_pack(&product, &wire);
+
+    if (aqm_send(&product_queue, &wire, 0) != pdPASS) {
+        global_stats.dropped++;
+        return LG_REJECTED;
+    }
+    global_stats.produced++;
+    return LG_ASYNC;
+}
+
+// Runs the sweep, then hands the queue back to the producers
+static void loadgen_sweep_task(void *pvParameters) {
+    lg_t *lg = loadgen;
+    lg_run(lg);
+    
+    // The consumer completes through `loadgen`: once it is NULL no new
+    // completion starts, and a second covers one already under way.
+    // Products still queued from the sweep are then just consumed
+    __atomic_store_n(&loadgen, NULL, __ATOMIC_RELEASE);
+    vTaskDelay(pdMS_TO_TICKS(1000));
+    lg_destroy(lg);
+    
+    safe_printf("Load sweep done - producers take over\n");
+    start_producers();
+    vTaskDelete(NULL);
+}
+#endif
+
+// CoDel head drop (AQM_CODEL_DROP), in the consumer's aqm_receive(): the
+// product was queued but never reaches a consumer
+static void product_dropped(const void *item, void *ctx) {
+    (void)ctx;
+    global_stats.dropped++;
+#if LOADGEN_ENABLE
+    product_msg_t product;
+    lg_t *lg = __atomic_load_n(&loadgen, __ATOMIC_ACQUIRE);
+    if (lg != NULL && product_msg_unpack(item, &product) == ESP_OK && product.intended_at != 0) {
+        lg_reject(lg, product.intended_at);
+    }
+#else
+    (void)item;
+#endif
+}
+
 // Consumer task
 void consumer_task(void *pvParameters) {
     int consumer_id = *((int*)pvParameters);
-    product_t product;
+    product_msg_t product;
+    product_msg_wire_t wire;
     gpio_num_t led_pin;
     
     // Assign LED pin based on consumer ID
@@ -121,14 +257,33 @@ void consumer_task(void *pvParameters) {
     
     while (1) {
         // Wait for product from queue
-        BaseType_t xStatus = xQueueReceive(xProductQueue, &product, pdMS_TO_TICKS(5000));
+        bool marked;
+        BaseType_t xStatus = aqm_receive(&product_queue, &wire, pdMS_TO_TICKS(5000), &marked);
         
         if (xStatus == pdPASS) {
+            if (product_msg_unpack(&wire, &product) != ESP_OK) {
+                safe_printf("✗ Consumer %d: Malformed product (%u bytes)\n", consumer_id, wire.len);
+                continue;
+            }
+            if (marked) {
+                // AQM_CODEL_MARK: the queue is backed up - skip the work
+                global_stats.shed++;
+                safe_printf("⚡ Consumer %d: Shed stale " PRODUCT_NAME_FMT "\n",
+                           consumer_id, product.producer_id, product.product_id);
+#if LOADGEN_ENABLE
+                lg_t *lg = __atomic_load_n(&loadgen, __ATOMIC_ACQUIRE);
+                if (product.intended_at != 0 && lg != NULL) {
+                    lg_reject(lg, product.intended_at);
+                }
+#endif
+                continue;
+            }
             global_stats.consumed++;
             uint32_t queue_time = xTaskGetTickCount() - product.production_time;
             
-            safe_printf("→ Consumer %d: Processing %s (queue time: %lums)\n", 
-                       consumer_id, product.product_name, queue_time * portTICK_PERIOD_MS);
+            safe_printf("→ Consumer %d: Processing " PRODUCT_NAME_FMT " (queue time: %lums)\n", 
+                       consumer_id, product.producer_id, product.product_id,
+                       queue_time * portTICK_PERIOD_MS);
             
             // Turn on consumer LED during processing
             gpio_set_level(led_pin, 1);
@@ -139,7 +294,14 @@ void consumer_task(void *pvParameters) {
             // Turn off consumer LED
             gpio_set_level(led_pin, 0);
             
-            safe_printf("✓ Consumer %d: Finished %s\n", consumer_id, product.product_name);
+            safe_printf("✓ Consumer %d: Finished " PRODUCT_NAME_FMT "\n",
+                       consumer_id, product.producer_id, product.product_id);
+#if LOADGEN_ENABLE
+            lg_t *lg = __atomic_load_n(&loadgen, __ATOMIC_ACQUIRE);
+            if (product.intended_at != 0 && lg != NULL) {
+                lg_complete(lg, product.intended_at);
+            }
+#endif
         } else {
             safe_printf("⏰ Consumer %d: No products to process (timeout)\n", consumer_id);
         }
@@ -159,6 +321,8 @@ void statistics_task(void *pvParameters) {
         safe_printf("Products Produced: %lu\n", global_stats.produced);
         safe_printf("Products Consumed: %lu\n", global_stats.consumed);
         safe_printf("Products Dropped:  %lu\n", global_stats.dropped);
+        safe_printf("Rate Limited:      %lu\n", global_stats.limited);
+        safe_printf("Shed (marked):     %lu\n", global_stats.shed);
         safe_printf("Queue Backlog:     %d\n", queue_items);
         safe_printf("System Efficiency: %.1f%%\n", 
                    global_stats.produced > 0 ? 
@@ -174,6 +338,11 @@ void statistics_task(void *pvParameters) {
             }
         }
         printf("]\n");
+        if (xSemaphoreTake(xPrintMutex, pdMS_TO_TICKS(1000)) == pdTRUE) {
+            rl_report(stdout);
+            aqm_report(stdout);
+            xSemaphoreGive(xPrintMutex);
+        }
         safe_printf("═══════════════════════════\n\n");
         
         vTaskDelay(pdMS_TO_TICKS(5000)); // Report every 5 seconds
@@ -215,6 +384,7 @@ void load_balancer_task(void *pvParameters) {
 
 void app_main(void) {
     ESP_LOGI(TAG, "Producer-Consumer System Lab Starting...");
+    ts_init();
     
     // Configure LED pins
     gpio_set_direction(LED_PRODUCER_1, GPIO_MODE_OUTPUT);
@@ -231,7 +401,14 @@ void app_main(void) {
     gpio_set_level(LED_CONSUMER_2, 0);
     
     // Create queue (buffer for 10 products)
-    xProductQueue = xQueueCreate(10, sizeof(product_t));
+    aqm_config_t aqm_cfg = AQM_CONFIG_DEFAULT();
+    aqm_cfg.mode = PRODUCT_AQM_MODE;
+    aqm_cfg.target_us = PRODUCT_AQM_TARGET_MS * 1000;
+    aqm_cfg.interval_us = PRODUCT_AQM_INTERVAL_MS * 1000;
+    aqm_cfg.on_drop = product_dropped;
+    if (aqm_create(&product_queue, "products", 10, sizeof(product_msg_wire_t), &aqm_cfg) == ESP_OK) {
+        xProductQueue = product_queue.queue;
+    }
     
     // Create mutex for synchronized printing
     xPrintMutex = xSemaphoreCreateMutex();
@@ -239,15 +416,33 @@ void app_main(void) {
     if (xProductQueue != NULL && xPrintMutex != NULL) {
         ESP_LOGI(TAG, "Queue and mutex created successfully");
         
-        // Producer IDs (must be static or global for task parameters)
-        static int producer1_id = 1, producer2_id = 2, producer3_id = 3;
         static int consumer1_id = 1, consumer2_id = 2;
         static int producer4_id = 4;
         
+#if LOADGEN_ENABLE
+        lg_config_t lg_cfg = LG_CONFIG_DEFAULT();
+        lg_cfg.name = "product_queue";
+        lg_cfg.issue = issue_product;
+        lg_cfg.arrival = LG_POISSON;
+        lg_cfg.rates_hz = loadgen_rates;
+        lg_cfg.steps = sizeof(loadgen_rates) / sizeof(loadgen_rates[0]);
+        lg_cfg.step_ms = 120000;
+        lg_cfg.settle_ms = 30000;           // A full queue takes ~15 s to drain
+        lg_cfg.seed = 2024;
+        lg_cfg.priority = 3;                // Where the producers ran
+        // The generator outranks the producers it stands in for
+        if (lg_create(&lg_cfg, &loadgen) != ESP_OK ||
+            xTaskCreate(loadgen_sweep_task, "LoadGen", lg_cfg.stack_size, NULL,
+                        lg_cfg.priority + 1, NULL) != pdPASS) {
+            ESP_LOGE(TAG, "Failed to start load generator - running the producers");
+            lg_destroy(loadgen);
+            loadgen = NULL;
+            start_producers();
+        }
+#else
         // Create producer tasks
-        xTaskCreate(producer_task, "Producer1", 3072, &producer1_id, 3, NULL);
-        xTaskCreate(producer_task, "Producer2", 3072, &producer2_id, 3, NULL);
-        xTaskCreate(producer_task, "Producer3", 3072, &producer3_id, 3, NULL);
+        start_producers();
+#endif
         // xTaskCreate(producer_task, "Producer4", 3072, &producer4_id, 3, NULL);
         
         // Create consumer tasks
@@ -8,6 +8,13 @@
 #include "esp_log.h"
 #include "driver/gpio.h"
 #include "esp_random.h"
+#include "esp_timer.h"
+#include "esp_netif.h"
+#include "uplink.h"
+#include "lab_messages.h"
+#include "ratelim.h"
+#include "streamop.h"
+#include "ingest.h"
 
 static const char *TAG = "QUEUE_SETS";
 
@@ -28,12 +35,12 @@ SemaphoreHandle_t xTimerSemaphore;
 QueueSetHandle_t xQueueSet;
 
 // Data structures for different message types
+// Sensor readings travel as batches of samples, merged in time order
+// from all sensors by the ingest collector
 typedef struct {
-    int sensor_id;
-    float temperature;
-    float humidity;
-    uint32_t timestamp;
-} sensor_data_t;
+    uint32_t count;
+    ingest_sample_t samples[INGEST_BATCH];
+} sensor_batch_t;
 
 typedef struct {
     int button_id;
@@ -41,11 +48,8 @@ typedef struct {
     uint32_t duration_ms;
 } user_input_t;
 
-typedef struct {
-    char source[20];
-    char message[100];
-    int priority;
-} network_message_t;
+// Network messages are network_msg_t from lab_messages.h: source and text
+// are interned, so the queue item (network_msg_wire_t) is 8 bytes, not 124
 
 // Message type identifier
 typedef enum {
@@ -65,32 +69,104 @@ typedef struct {
 
 message_stats_t stats = {0, 0, 0, 0};
 
-// Sensor simulation task
+// Telemetry uplink (owned by network_task): batched UDP frames to a
+// loopback receiver - point UPLINK_HOST at a real collector to see them
+#define UPLINK_HOST         "127.0.0.1"
+#define UPLINK_PORT         5005
+#define UPLINK_REPORT_MS    15000
+
+static uplink_t uplink;
+
+// Network messages: 0.4/s sustained (one per 2.5 s, the middle of the
+// 1-4 s the processor was sized for), bursts of 4. Over the limit the
+// message waits (RL_DEFER) while the loop keeps servicing the uplink
+#define NETWORK_RATE        0.4f
+#define NETWORK_BURST       4
+#define NETWORK_POLL_MS     500
+
+static rl_t network_limit;
+
+// Sensor ingestion: SENSOR_COUNT sensors sampled at SENSOR_RATE_HZ,
+// temperature and humidity per reading. Each sensor task reads its FIFO
+// every SENSOR_READ_MS into its own ring - no lock, no log, no LED - and
+// the collector task merges the rings every INGEST_PERIOD_MS into
+// batches for the processor. Only the counters are logged, by the
+// monitor. HOLD covers a FIFO read stamping samples up to
+// SENSOR_READ_MS before they reach the ring
+#define SENSOR_COUNT        3
+#define SENSOR_RATE_HZ      500
+#define SENSOR_READ_MS      20
+#define SENSOR_RING         256     // Per sensor: 2 channels x 10 readings per read, with room
+#define INGEST_PERIOD_MS    20
+#define INGEST_HOLD_MS      (SENSOR_READ_MS + 10)
+#define SENSOR_BATCH_QUEUE  8
+
+enum { CH_TEMPERATURE, CH_HUMIDITY };
+
+static ingest_t sensor_ingest;
+static ingest_sample_t sensor_rings[SENSOR_COUNT][SENSOR_RING];
+static uint32_t sensor_batches_dropped;
+
+// Sensor windows (owned by processor_task): alerts on the mean of the
+// last 30 s per sensor, re-evaluated every 10 s, instead of on every
+// single reading. 5 s covers readings that sat in the queue behind a
+// slow network message
+#define SENSOR_WINDOW_MS    30000
+#define SENSOR_SLIDE_MS     10000
+#define SENSOR_LATENESS_MS  5000
+#define TEMP_ALERT_C        35.0f
+#define HUMIDITY_ALERT_PCT  60.0f
+
+static so_stream_t temp_windows;
+static so_stream_t humidity_windows;
+
+static void temperature_window(const so_window_t *w, void *ctx) {
+    ESP_LOGI(TAG, "🌡️  Sensor %lu: T avg %.1f°C (%.1f-%.1f, %lu readings, %lu-%lu s)",
+             w->key, w->mean, w->min, w->max, w->count, w->start_ms / 1000, w->end_ms / 1000);
+    if (w->mean > TEMP_ALERT_C) {
+        ESP_LOGW(TAG, "⚠️  High temperature alert! Sensor %lu", w->key);
+    }
+}
+
+static void humidity_window(const so_window_t *w, void *ctx) {
+    ESP_LOGI(TAG, "💧 Sensor %lu: H avg %.1f%% (%.1f-%.1f, %lu readings)",
+             w->key, w->mean, w->min, w->max, w->count);
+    if (w->mean > HUMIDITY_ALERT_PCT) {
+        ESP_LOGW(TAG, "⚠️  High humidity alert! Sensor %lu", w->key);
+    }
+}
+
+// Collector task: one merged batch into the processor's queue set
+static void queue_sensor_batch(const ingest_sample_t *samples, uint32_t n, void *ctx) {
+    static sensor_batch_t batch;
+    batch.count = n;
+    memcpy(batch.samples, samples, n * sizeof(*samples));
+    if (xQueueSend(xSensorQueue, &batch, 0) != pdPASS) {
+        sensor_batches_dropped++;
+    }
+}
+
+// Sensor simulation task (one per sensor, pvParameters = its ring)
 void sensor_task(void *pvParameters) {
-    sensor_data_t sensor_data;
-    int sensor_id = 1;
+    ingest_ring_t *ring = (ingest_ring_t *)pvParameters;
+    const int64_t sample_us = 1000000 / SENSOR_RATE_HZ;
     
-    ESP_LOGI(TAG, "Sensor task started");
+    ESP_LOGI(TAG, "%s task started (%d Hz)", ring->name, SENSOR_RATE_HZ);
     
+    int64_t next_sample_us = esp_timer_get_time();
+    TickType_t last_wake = xTaskGetTickCount();
     while (1) {
-        // Simulate sensor reading
-        sensor_data.sensor_id = sensor_id;
-        sensor_data.temperature = 20.0 + (esp_random() % 200) / 10.0; // 20-40°C
-        sensor_data.humidity = 30.0 + (esp_random() % 400) / 10.0;    // 30-70%
-        sensor_data.timestamp = xTaskGetTickCount();
+        vTaskDelayUntil(&last_wake, pdMS_TO_TICKS(SENSOR_READ_MS));
         
-        if (xQueueSend(xSensorQueue, &sensor_data, pdMS_TO_TICKS(100)) == pdPASS) {
-            ESP_LOGI(TAG, "📊 Sensor: T=%.1f°C, H=%.1f%%, ID=%d", 
-                    sensor_data.temperature, sensor_data.humidity, sensor_id);
-            
-            // Blink sensor LED
-            gpio_set_level(LED_SENSOR, 1);
-            vTaskDelay(pdMS_TO_TICKS(50));
-            gpio_set_level(LED_SENSOR, 0);
+        // Drain what the sensor's FIFO sampled since the last read,
+        // stamped with each reading's own time
+        int64_t now_us = esp_timer_get_time();
+        while (next_sample_us <= now_us) {
+            uint32_t t_ms = (uint32_t)(next_sample_us / 1000);
+            ingest_put(ring, t_ms, CH_TEMPERATURE, 20.0f + (esp_random() % 200) / 10.0f); // 20-40°C
+            ingest_put(ring, t_ms, CH_HUMIDITY, 30.0f + (esp_random() % 400) / 10.0f);    // 30-70%
+            next_sample_us += sample_us;
         }
-        
-        // Random sensor reading interval (2-5 seconds)
-        vTaskDelay(pdMS_TO_TICKS(2000 + (esp_random() % 3000)));
     }
 }
 
@@ -123,27 +199,46 @@ void user_input_task(void *pvParameters) {
 
 // Network simulation task
 void network_task(void *pvParameters) {
-    network_message_t network_msg;
-    const char* sources[] = {"WiFi", "Bluetooth", "LoRa", "Ethernet"};
-    const char* messages[] = {
-        "Status update received",
-        "Configuration changed",
-        "Alert notification",
-        "Data synchronization",
-        "Heartbeat signal"
-    };
+    network_msg_t net_msg = {0};
+    network_msg_wire_t wire;
     
     ESP_LOGI(TAG, "Network task started");
     
+    // รวมข้อความเป็น frame (512 B หรือ 2 วินาที) แทนการส่งทีละข้อความ
+    static uplink_udp_t udp;
+    uplink_transport_t transport;
+    uplink_config_t uplink_cfg = UPLINK_CONFIG_DEFAULT();
+    uplink_cfg.max_delay_ms = 2000;
+    
+    bool uplink_ok = uplink_udp_open(&udp, UPLINK_HOST, UPLINK_PORT, &transport) == ESP_OK &&
+                     uplink_init(&uplink, &uplink_cfg, &transport) == ESP_OK;
+    if (!uplink_ok) {
+        ESP_LOGW(TAG, "⚠️ Uplink unavailable - messages stay local");
+    }
+    
+    uplink_stats_t prev_stats = {0};
+    int64_t last_report = esp_timer_get_time();
+    bool pending = false;
+    
     while (1) {
-        // Simulate network message
-        strcpy(network_msg.source, sources[esp_random() % 4]);
-        strcpy(network_msg.message, messages[esp_random() % 5]);
-        network_msg.priority = 1 + (esp_random() % 5); // Priority 1-5
+        // Simulate network message (a deferred one waits its turn first)
+        if (!pending) {
+            net_msg.source = network_sources.strings[esp_random() % network_sources.count];
+            net_msg.message = network_texts.strings[esp_random() % network_texts.count];
+            net_msg.priority = 1 + (esp_random() % 5); // Priority 1-5
+            network_msg_pack(&net_msg, &wire);
+            pending = true;
+        }
+        
+        uint32_t retry_ms = 0;
+        bool admitted = rl_admit(&network_limit, &retry_ms) == RL_OK;
+        if (admitted) {
+            pending = false;
+        }
         
-        if (xQueueSend(xNetworkQueue, &network_msg, pdMS_TO_TICKS(100)) == pdPASS) {
-            ESP_LOGI(TAG, "🌐 Network [%s]: %s (P:%d)", 
-                    network_msg.source, network_msg.message, network_msg.priority);
+        if (admitted && xQueueSend(xNetworkQueue, &wire, pdMS_TO_TICKS(100)) == pdPASS) {
+            ESP_LOGI(TAG, "🌐 Network [%s]: %s (P:%lu)", 
+                    net_msg.source, net_msg.message, net_msg.priority);
             
             // Blink network LED
             gpio_set_level(LED_NETWORK, 1);
@@ -151,8 +246,37 @@ void network_task(void *pvParameters) {
             gpio_set_level(LED_NETWORK, 0);
         }
         
-        // Random network activity (1-4 seconds)
-        vTaskDelay(pdMS_TO_TICKS(500));
+        int64_t now = esp_timer_get_time();
+        if (uplink_ok) {
+            // Same encoded bytes as the queue item - the collector decodes
+            // with network_msg_decode()
+            if (admitted) {
+                uplink_submit(&uplink, wire.data, wire.len, now);
+            }
+            uplink_poll(&uplink, now);
+            
+            if (now - last_report >= UPLINK_REPORT_MS * 1000LL) {
+                uplink_stats_t st;
+                uplink_rates_t rates;
+                uplink_get_stats(&uplink, &st);
+                uplink_rates(&st, &prev_stats, (uint32_t)((now - last_report) / 1000), &rates);
+                ESP_LOGI(TAG, "📡 Uplink: %.2f frames/s, %.1f msgs/frame, %.1f B/msg on wire (LZ %.2fx)",
+                         rates.frames_per_s, rates.msgs_per_frame,
+                         rates.wire_bytes_per_msg, rates.compression_ratio);
+                ESP_LOGI(TAG, "📡 Uplink: queue delay avg %.0f ms (max %lu ms), backlog %lu, dropped %lu, failures %lu",
+                         rates.avg_queue_delay_ms, st.queue_delay_max_us / 1000, st.backlog,
+                         st.messages_dropped, st.send_failures);
+                prev_stats = st;
+                last_report = now;
+            }
+        }
+        
+        // A new message every poll; network_limit sets the real rate
+        uint32_t next_ms = NETWORK_POLL_MS;
+        if (pending && retry_ms < next_ms) {
+            next_ms = retry_ms;
+        }
+        vTaskDelay(pdMS_TO_TICKS(next_ms) + 1);
     }
 }
 
@@ -177,9 +301,10 @@ void timer_task(void *pvParameters) {
 // Main processing task using Queue Sets
 void processor_task(void *pvParameters) {
     QueueSetMemberHandle_t xActivatedMember;
-    sensor_data_t sensor_data;
+    static sensor_batch_t sensor_batch;
     user_input_t user_input;
-    network_message_t network_msg;
+    network_msg_wire_t net_wire;
+    network_msg_t net_msg;
     
     ESP_LOGI(TAG, "Processor task started - waiting for events...");
     
@@ -193,19 +318,20 @@ void processor_task(void *pvParameters) {
             
             // Determine which queue/semaphore was activated
             if (xActivatedMember == xSensorQueue) {
-                if (xQueueReceive(xSensorQueue, &sensor_data, 0) == pdPASS) {
-                    stats.sensor_count++;
-                    ESP_LOGI(TAG, "→ Processing SENSOR data: T=%.1f°C, H=%.1f%%", 
-                            sensor_data.temperature, sensor_data.humidity);
+                if (xQueueReceive(xSensorQueue, &sensor_batch, 0) == pdPASS) {
+                    stats.sensor_count += sensor_batch.count;
                     
-                    // Simulate sensor data processing
-                    if (sensor_data.temperature > 35.0) {
-                        ESP_LOGW(TAG, "⚠️  High temperature alert!");
-                    }
-                    if (sensor_data.humidity > 60.0) {
-                        ESP_LOGW(TAG, "⚠️  High humidity alert!");
+                    // Into the windows; alerts come from the window sinks
+                    for (uint32_t i = 0; i < sensor_batch.count; i++) {
+                        const ingest_sample_t *s = &sensor_batch.samples[i];
+                        so_stream_t *windows = s->channel == CH_TEMPERATURE ? &temp_windows : &humidity_windows;
+                        so_push(windows, s->source + 1, s->t_ms, s->value);
                     }
                 }
+                // No simulated processing time for batches - at ~100
+                // batches/s the sensors would back up behind it
+                gpio_set_level(LED_PROCESSOR, 0);
+                continue;
             }
             else if (xActivatedMember == xUserQueue) {
                 if (xQueueReceive(xUserQueue, &user_input, 0) == pdPASS) {
@@ -228,13 +354,18 @@ void processor_task(void *pvParameters) {
                 }
             }
             else if (xActivatedMember == xNetworkQueue) {
-                if (xQueueReceive(xNetworkQueue, &network_msg, 0) == pdPASS) {
+                if (xQueueReceive(xNetworkQueue, &net_wire, 0) == pdPASS) {
+                    if (network_msg_unpack(&net_wire, &net_msg) != ESP_OK) {
+                        ESP_LOGW(TAG, "⚠️  Malformed network message (%u bytes)", net_wire.len);
+                        gpio_set_level(LED_PROCESSOR, 0);
+                        continue;
+                    }
                     stats.network_count++;
                     ESP_LOGI(TAG, "→ Processing NETWORK msg: [%s] %s", 
-                            network_msg.source, network_msg.message);
+                            net_msg.source, net_msg.message);
                     
                     // Simulate network message processing
-                    if (network_msg.priority >= 4) {
+                    if (net_msg.priority >= 4) {
                         ESP_LOGW(TAG, "🚨 High priority network message!");
                     }
                 }
@@ -244,6 +375,11 @@ void processor_task(void *pvParameters) {
                     stats.timer_count++;
                     ESP_LOGI(TAG, "→ Processing TIMER event: Periodic maintenance");
                     
+                    // Close windows even if the sensors went quiet
+                    uint32_t now_ms = ingest_now_ms();
+                    so_advance(&temp_windows, now_ms);
+                    so_advance(&humidity_windows, now_ms);
+                    
                     // Show system statistics
                     ESP_LOGI(TAG, "📈 Stats - Sensor:%lu, User:%lu, Network:%lu, Timer:%lu", 
                             stats.sensor_count, stats.user_count, 
@@ -269,18 +405,22 @@ void monitor_task(void *pvParameters) {
         
         ESP_LOGI(TAG, "\n═══ SYSTEM MONITOR ═══");
         ESP_LOGI(TAG, "Queue States:");
-        ESP_LOGI(TAG, "  Sensor Queue:  %d/%d", 
-                uxQueueMessagesWaiting(xSensorQueue), 5);
+        ESP_LOGI(TAG, "  Sensor Queue:  %d/%d batches (%lu dropped)", 
+                uxQueueMessagesWaiting(xSensorQueue), SENSOR_BATCH_QUEUE, sensor_batches_dropped);
         ESP_LOGI(TAG, "  User Queue:    %d/%d", 
                 uxQueueMessagesWaiting(xUserQueue), 3);
         ESP_LOGI(TAG, "  Network Queue: %d/%d", 
                 uxQueueMessagesWaiting(xNetworkQueue), 8);
         
         ESP_LOGI(TAG, "Message Statistics:");
-        ESP_LOGI(TAG, "  Sensor:  %lu messages", stats.sensor_count);
+        ESP_LOGI(TAG, "  Sensor:  %lu samples", stats.sensor_count);
         ESP_LOGI(TAG, "  User:    %lu messages", stats.user_count);
         ESP_LOGI(TAG, "  Network: %lu messages", stats.network_count);
         ESP_LOGI(TAG, "  Timer:   %lu events", stats.timer_count);
+        ingest_report(&sensor_ingest, ingest_now_ms(), stdout);
+        rl_report(stdout);
+        so_report(&temp_windows, stdout);
+        so_report(&humidity_windows, stdout);
         ESP_LOGI(TAG, "═══════════════════════\n");
     }
 }
@@ -302,14 +442,17 @@ void app_main(void) {
     gpio_set_level(LED_TIMER, 0);
     gpio_set_level(LED_PROCESSOR, 0);
     
+    // TCP/IP stack for the loopback UDP uplink
+    ESP_ERROR_CHECK(esp_netif_init());
+    
     // Create individual queues
-    xSensorQueue = xQueueCreate(5, sizeof(sensor_data_t));
+    xSensorQueue = xQueueCreate(SENSOR_BATCH_QUEUE, sizeof(sensor_batch_t));
     xUserQueue = xQueueCreate(3, sizeof(user_input_t));
-    xNetworkQueue = xQueueCreate(8, sizeof(network_message_t));
+    xNetworkQueue = xQueueCreate(8, sizeof(network_msg_wire_t));
     xTimerSemaphore = xSemaphoreCreateBinary();
     
     // Create queue set (can hold references to all queues + semaphore)
-    xQueueSet = xQueueCreateSet(5 + 3 + 8 + 1); // Total capacity
+    xQueueSet = xQueueCreateSet(SENSOR_BATCH_QUEUE + 3 + 8 + 1); // Total capacity
     
     if (xSensorQueue && xUserQueue && xNetworkQueue && 
         xTimerSemaphore && xQueueSet) {
@@ -326,12 +469,28 @@ void app_main(void) {
         
         ESP_LOGI(TAG, "Queue set created and configured successfully");
         
-        // Create producer tasks
-        xTaskCreate(sensor_task, "Sensor", 2048, NULL, 3, NULL);
+        // Create producer tasks: a ring per sensor, one collector for all
+        static const char *sensor_names[SENSOR_COUNT] = { "Sensor1", "Sensor2", "Sensor3" };
+        ESP_ERROR_CHECK(ingest_init(&sensor_ingest, "sensors", INGEST_HOLD_MS, queue_sensor_batch, NULL));
+        for (int i = 0; i < SENSOR_COUNT; i++) {
+            ingest_ring_t *ring = ingest_producer(&sensor_ingest, sensor_names[i], sensor_rings[i], SENSOR_RING);
+            configASSERT(ring != NULL);
+            xTaskCreate(sensor_task, sensor_names[i], 2048, ring, 3, NULL);
+        }
+        ESP_ERROR_CHECK(ingest_start(&sensor_ingest, INGEST_PERIOD_MS, 4));
         xTaskCreate(user_input_task, "UserInput", 2048, NULL, 3, NULL);
-        xTaskCreate(network_task, "Network", 2048, NULL, 3, NULL);
+        rl_init(&network_limit, "network", NETWORK_RATE, NETWORK_BURST, RL_DEFER);
+        xTaskCreate(network_task, "Network", 4096, NULL, 3, NULL);
         xTaskCreate(timer_task, "Timer", 2048, NULL, 2, NULL);
         
+        so_config_t window_cfg = {
+            .size_ms = SENSOR_WINDOW_MS,
+            .slide_ms = SENSOR_SLIDE_MS,
+            .lateness_ms = SENSOR_LATENESS_MS,
+        };
+        so_init(&temp_windows, "temperature", &window_cfg, temperature_window, NULL);
+        so_init(&humidity_windows, "humidity", &window_cfg, humidity_window, NULL);
+        
         // Create main processor task
         xTaskCreate(processor_task, "Processor", 3072, NULL, 4, NULL);
         
@@ -8,6 +8,7 @@
 #include "driver/gpio.h"
 #include "driver/gptimer.h"
 #include "esp_random.h"
+#include "apserver.h"
 
 static const char *TAG = "BINARY_SEM";
 
@@ -25,6 +26,16 @@ SemaphoreHandle_t xButtonSemaphore;
 // Timer handle
 gptimer_handle_t gptimer = NULL;
 
+// Button handling runs at priority 4 on a sporadic server: 20 ms of CPU
+// per second, then priority 1 until the budget comes back, so a bouncing
+// or stuck button can't starve the producer (3) and consumers (2)
+#define BUTTON_PRIO         4
+#define BUTTON_LOW_PRIO     1
+#define BUTTON_BUDGET_US    20000
+#define BUTTON_PERIOD_US    1000000
+
+static aps_server_t srv_button;
+
 // Statistics
 typedef struct {
     uint32_t signals_sent;
@@ -145,16 +156,18 @@ void button_event_task(void *pvParameters) {
     while (1) {
         // Wait for button semaphore from ISR
         if (xSemaphoreTake(xButtonSemaphore, portMAX_DELAY) == pdTRUE) {
+            aps_begin(&srv_button);
             stats.button_presses++;
             ESP_LOGI(TAG, "🔘 Button: Press detected #%lu", stats.button_presses);
             
-            // Debounce delay
-            vTaskDelay(pdMS_TO_TICKS(300));
-            
             // Trigger immediate event to producer
             ESP_LOGI(TAG, "🚀 Button: Triggering immediate producer event");
             xSemaphoreGive(xBinarySemaphore);
             stats.signals_sent++;
+            aps_end(&srv_button);
+            
+            // Debounce delay (outside the job: sleeping would be charged)
+            vTaskDelay(pdMS_TO_TICKS(300));
         }
     }
 }
@@ -183,6 +196,7 @@ void monitor_task(void *pvParameters) {
         float efficiency = stats.signals_sent > 0 ? 
                           (float)stats.signals_received / stats.signals_sent * 100 : 0;
         ESP_LOGI(TAG, "  System Efficiency: %.1f%%", efficiency);
+        aps_report(stdout);
         ESP_LOGI(TAG, "══════════════════════════════\n");
     }
 }
@@ -242,12 +256,15 @@ void app_main(void) {
         
         ESP_LOGI(TAG, "Timer configured for 8-second intervals");
         
+        ESP_ERROR_CHECK(aps_init(&srv_button, "button", APS_SPORADIC, BUTTON_BUDGET_US,
+                                 BUTTON_PERIOD_US, BUTTON_PRIO, BUTTON_LOW_PRIO));
+        
         // Create tasks
         xTaskCreate(producer_task, "Producer", 2048, NULL, 3, NULL);
         xTaskCreate(consumer_task, "Consumer", 2048, NULL, 2, NULL);
         xTaskCreate(timer_event_task, "TimerEvent", 2048, NULL, 2, NULL);
-        xTaskCreate(button_event_task, "ButtonEvent", 2048, NULL, 4, NULL);
-        xTaskCreate(monitor_task, "Monitor", 2048, NULL, 1, NULL);
+        xTaskCreate(button_event_task, "ButtonEvent", 2048, NULL, BUTTON_PRIO, NULL);
+        xTaskCreate(monitor_task, "Monitor", 3072, NULL, 1, NULL);
         
         ESP_LOGI(TAG, "All tasks created. System operational.");
         ESP_LOGI(TAG, "💡 Press the BOOT button (GPIO0) to trigger immediate events!");
@@ -7,6 +7,7 @@
 #include "esp_log.h"
 #include "driver/gpio.h"
 #include "esp_random.h"
+#include "integrity.h"
 
 static const char *TAG = "MUTEX_LAB";
 
@@ -39,13 +40,9 @@ typedef struct {
 
 access_stats_t stats = {0, 0, 0, 0};
 
-// Function to calculate simple checksum
+// Checksum over buffer + counter (word-at-a-time hash, counter as seed)
 uint32_t calculate_checksum(const char* data, uint32_t counter) {
-    uint32_t sum = counter;
-    for (int i = 0; data[i] != '\0'; i++) {
-        sum += (uint32_t)data[i] * (i + 1);
-    }
-    return sum;
+    return integrity_hash32(data, strlen(data), counter);
 }
 
 // Critical section function (simulates accessing shared resource)
@@ -7,6 +7,8 @@
 #include "esp_log.h"
 #include "driver/gpio.h"
 #include "esp_random.h"
+#include "tstamp.h"
+#include "loadgen.h"
 
 static const char *TAG = "COUNTING_SEM";
 
@@ -219,10 +221,61 @@ void statistics_task(void *pvParameters) {
     }
 }
 
-// Load generator task (creates bursts of requests)
+// Load generator: bursts of resource requests on an open-loop schedule.
+// Each request is timed from when it was due to when it got a resource,
+// so waits behind the producers - and requests that time out - land in
+// the numbers instead of just slowing the generator down
+static lg_t *loadgen;
+static const float loadgen_rates[] = { 0.25f, 0.5f, 1.0f, 2.0f };
+
+static lg_result_t issue_resource_request(void *ctx, const lg_request_t *req) {
+    (void)ctx;
+    stats.total_requests++;
+    if (xSemaphoreTake(xCountingSemaphore, pdMS_TO_TICKS(8000)) != pdTRUE) {
+        stats.failed_acquisitions++;
+        return LG_REJECTED;
+    }
+    stats.successful_acquisitions++;
+    lg_complete(loadgen, req->intended);
+
+    int res_idx = acquire_resource("LoadGen");
+    if (res_idx >= 0) {
+        vTaskDelay(pdMS_TO_TICKS(500)); // Hold briefly
+        release_resource(res_idx, 500);
+    }
+    xSemaphoreGive(xCountingSemaphore);
+    return LG_ASYNC;                    // Already completed at acquisition
+}
+
 void load_generator_task(void *pvParameters) {
     ESP_LOGI(TAG, "Load generator started");
+
+    lg_config_t cfg = LG_CONFIG_DEFAULT();
+    cfg.name = "resource_pool";
+    cfg.issue = issue_resource_request;
+    cfg.arrival = LG_BURSTY;
+    cfg.on_ms = 2000;
+    cfg.off_ms = 8000;
+    cfg.rates_hz = loadgen_rates;
+    cfg.steps = sizeof(loadgen_rates) / sizeof(loadgen_rates[0]);
+    cfg.step_ms = 60000;
+    cfg.settle_ms = 10000;
+    cfg.seed = 42;
+    cfg.workers = 6;                    // Requests wait on the pool in parallel
+    cfg.backlog = 16;
+    cfg.priority = 3;                   // Same as the producers
+    if (lg_create(&cfg, &loadgen) == ESP_OK) {
+        gpio_set_level(LED_SYSTEM, 1);
+        lg_run(loadgen);                // Workers gone: no completion can follow
+        gpio_set_level(LED_SYSTEM, 0);
+        lg_destroy(loadgen);
+        loadgen = NULL;
+        ESP_LOGI(TAG, "Load sweep completed\n");
+    } else {
+        ESP_LOGE(TAG, "Failed to create load generator!");
+    }
     
+    // Then the periodic bursts for as long as the board runs
     while (1) {
         vTaskDelay(pdMS_TO_TICKS(20000)); // Every 20 seconds
         
@@ -261,6 +314,7 @@ void load_generator_task(void *pvParameters) {
 
 void app_main(void) {
     ESP_LOGI(TAG, "Counting Semaphores Lab Starting...");
+    ts_init();
     
     // Configure LED pins
     gpio_set_direction(LED_RESOURCE_1, GPIO_MODE_OUTPUT);
@@ -295,7 +349,7 @@ void app_main(void) {
         // Create monitoring tasks
         xTaskCreate(resource_monitor_task, "ResMonitor", 3072, NULL, 2, NULL);
         xTaskCreate(statistics_task, "Statistics", 3072, NULL, 1, NULL);
-        xTaskCreate(load_generator_task, "LoadGen", 2048, NULL, 4, NULL);
+        xTaskCreate(load_generator_task, "LoadGen", 4096, NULL, 4, NULL);
         
         ESP_LOGI(TAG, "System created with:");
         ESP_LOGI(TAG, "  Resources: %d", MAX_RESOURCES);
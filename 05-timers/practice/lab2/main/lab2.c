@@ -12,6 +12,10 @@
 #include "esp_adc_cal.h"
 #include "esp_random.h"
 #include "esp_system.h"
+#include "led_sequencer.h"
+#include "delayq.h"
+#include "streamop.h"
+#include "ingest.h"
 
 static const char *TAG = "TIMER_APPS";
 
@@ -27,7 +31,6 @@ static const char *TAG = "TIMER_APPS";
 // Timer Periods
 #define WATCHDOG_TIMEOUT_MS     5000    // 5 seconds
 #define WATCHDOG_FEED_MS        2000    // Feed every 2 seconds
-#define PATTERN_BASE_MS         500     // Base pattern timing
 #define SENSOR_SAMPLE_MS        1000    // Sensor sampling rate
 #define STATUS_UPDATE_MS        3000    // Status update interval
 
@@ -42,13 +45,6 @@ typedef enum {
     PATTERN_MAX
 } led_pattern_t;
 
-// Sensor Data Structure
-typedef struct {
-    float value;
-    uint32_t timestamp;
-    bool valid;
-} sensor_data_t;
-
 // System Health Structure
 typedef struct {
     uint32_t watchdog_feeds;
@@ -62,35 +58,68 @@ typedef struct {
 // Global Variables
 TimerHandle_t watchdog_timer;
 TimerHandle_t feed_timer;
-TimerHandle_t pattern_timer;
 TimerHandle_t sensor_timer;
 TimerHandle_t status_timer;
 
-QueueHandle_t sensor_queue;
 QueueHandle_t pattern_queue;
 
+led_sequencer_t led_sequencer;
+
 led_pattern_t current_pattern = PATTERN_OFF;
-int pattern_step = 0;
+TickType_t pattern_since;
 system_health_t health_stats = {0, 0, 0, 0, 0, true};
 
-// Pattern state for complex patterns
-typedef struct {
-    int step;
-    int direction;
-    int intensity;
-    bool state;
-} pattern_state_t;
-
-pattern_state_t pattern_state = {0, 1, 0, false};
-
 // ADC calibration
 esp_adc_cal_characteristics_t *adc_chars;
 
 // Forward declaration for change_led_pattern
 void change_led_pattern(led_pattern_t new_pattern);
 
-// Forward declaration for recovery_callback
-void recovery_callback(TimerHandle_t timer);
+// ================ DEFERRED ACTIONS ================
+// "Do this later" work goes through one delay queue serviced by a single
+// esp_timer, instead of a one-shot timer per action or a vTaskDelay()
+// that stalls the timer service task (and every other callback with it)
+
+#define RECOVERY_DELAY_MS       8000
+#define DEFERRED_CAPACITY       32
+
+typedef enum {
+    ACTION_RESUME_FEEDS,
+    ACTION_LED,
+} deferred_kind_t;
+
+typedef struct {
+    deferred_kind_t kind;
+    gpio_num_t pin;
+    uint8_t level;
+} deferred_action_t;
+
+static dq_queue_t deferred;
+
+// esp_timer task: short, no blocking
+static void run_deferred(void *item, void *arg) {
+    deferred_action_t *action = (deferred_action_t *)item;
+    switch (action->kind) {
+        case ACTION_RESUME_FEEDS:
+            ESP_LOGI(TAG, "🔄 System recovered - resuming watchdog feeds");
+            xTimerStart(feed_timer, 0);
+            break;
+        case ACTION_LED:
+            gpio_set_level(action->pin, action->level);
+            break;
+    }
+}
+
+static void led_later(gpio_num_t pin, uint8_t level, uint32_t delay_ms) {
+    deferred_action_t action = { .kind = ACTION_LED, .pin = pin, .level = level };
+    dq_send_after(&deferred, &action, delay_ms);
+}
+
+// LED on now, off again after on_ms
+static void flash_led(gpio_num_t pin, uint32_t on_ms) {
+    gpio_set_level(pin, 1);
+    led_later(pin, 0, on_ms);
+}
 
 // ================ WATCHDOG SYSTEM ================
 
@@ -102,12 +131,11 @@ void watchdog_timeout_callback(TimerHandle_t timer) {
     ESP_LOGE(TAG, "System stats: Feeds=%lu, Timeouts=%lu", 
              health_stats.watchdog_feeds, health_stats.watchdog_timeouts);
     
-    // Flash watchdog LED rapidly
+    // Flash watchdog LED rapidly (scheduled, so the timer service task
+    // isn't held up for a second)
     for (int i = 0; i < 10; i++) {
-        gpio_set_level(WATCHDOG_LED, 1);
-        vTaskDelay(pdMS_TO_TICKS(50));
-        gpio_set_level(WATCHDOG_LED, 0);
-        vTaskDelay(pdMS_TO_TICKS(50));
+        led_later(WATCHDOG_LED, 1, i * 100);
+        led_later(WATCHDOG_LED, 0, i * 100 + 50);
     }
     
     // In production, this would trigger system reset
@@ -127,13 +155,12 @@ void feed_watchdog_callback(TimerHandle_t timer) {
         ESP_LOGW(TAG, "🐛 Simulating system hang - stopping watchdog feeds for 8 seconds");
         xTimerStop(feed_timer, 0);
         
-        // Create recovery timer
-        TimerHandle_t recovery_timer = xTimerCreate("Recovery", 
-                                                   pdMS_TO_TICKS(8000),
-                                                   pdFALSE, // One-shot
-                                                   (void*)0,
-                                                   recovery_callback);
-        xTimerStart(recovery_timer, 0);
+        // Schedule the recovery
+        deferred_action_t resume = { .kind = ACTION_RESUME_FEEDS };
+        if (dq_send_after(&deferred, &resume, RECOVERY_DELAY_MS) == DQ_NO_HANDLE) {
+            ESP_LOGE(TAG, "Deferred queue full - resuming feeds now");
+            xTimerStart(feed_timer, 0);
+        }
         return;
     }
     
@@ -144,15 +171,7 @@ void feed_watchdog_callback(TimerHandle_t timer) {
     xTimerReset(watchdog_timer, 0);
     
     // Flash status LED briefly
-    gpio_set_level(STATUS_LED, 1);
-    vTaskDelay(pdMS_TO_TICKS(50));
-    gpio_set_level(STATUS_LED, 0);
-}
-
-void recovery_callback(TimerHandle_t timer) {
-    ESP_LOGI(TAG, "🔄 System recovered - resuming watchdog feeds");
-    xTimerStart(feed_timer, 0);
-    xTimerDelete(timer, 0);
+    flash_led(STATUS_LED, 50);
 }
 
 // ================ LED PATTERN SYSTEM ================
@@ -163,104 +182,92 @@ void set_pattern_leds(bool led1, bool led2, bool led3) {
     gpio_set_level(PATTERN_LED_3, led3);
 }
 
-void pattern_timer_callback(TimerHandle_t timer) {
-    static uint32_t pattern_cycle = 0;
-    pattern_cycle++;
-    
+// Pattern tables - action is an LED bitmask (bit0=LED1, bit1=LED2, bit2=LED3)
+#define LED1 0x01
+#define LED2 0x02
+#define LED3 0x04
+#define LED_ALL (LED1 | LED2 | LED3)
+
+// Change pattern after this many steps (checked when a pattern wraps)
+#define PATTERN_ROTATE_STEPS    50
+// OFF is held with the sequencer stopped, so it has no wraps to count;
+// the status timer moves on after this long
+#define PATTERN_OFF_HOLD_MS     30000
+
+static const seq_step_t off_steps[] = {
+    {0, 1000},
+};
+
+static const seq_step_t slow_blink_steps[] = {
+    {LED1, 1000}, {0, 1000},
+};
+
+static const seq_step_t fast_blink_steps[] = {
+    {LED2, 200}, {0, 200},
+};
+
+// Double pulse: on 200, off 100, on 200, off 500
+static const seq_step_t heartbeat_steps[] = {
+    {LED3, 200}, {0, 100}, {LED3, 200}, {0, 500},
+};
+
+// SOS: dot 200, dash 600, 200 gap between symbols, 1000 pause between repeats
+static const seq_step_t sos_steps[] = {
+    {LED_ALL, 200}, {0, 200}, {LED_ALL, 200}, {0, 200}, {LED_ALL, 200}, {0, 200},
+    {LED_ALL, 600}, {0, 200}, {LED_ALL, 600}, {0, 200}, {LED_ALL, 600}, {0, 200},
+    {LED_ALL, 200}, {0, 200}, {LED_ALL, 200}, {0, 200}, {LED_ALL, 200}, {0, 1000},
+};
+
+// Cycle through LED combinations
+static const seq_step_t rainbow_steps[] = {
+    {0, 300}, {1, 300}, {2, 300}, {3, 300}, {4, 300}, {5, 300}, {6, 300}, {7, 300},
+};
+
+static const seq_pattern_t pattern_table[PATTERN_MAX] = {
+    [PATTERN_OFF]        = SEQ_PATTERN("OFF", off_steps),
+    [PATTERN_SLOW_BLINK] = SEQ_PATTERN("SLOW_BLINK", slow_blink_steps),
+    [PATTERN_FAST_BLINK] = SEQ_PATTERN("FAST_BLINK", fast_blink_steps),
+    [PATTERN_HEARTBEAT]  = SEQ_PATTERN("HEARTBEAT", heartbeat_steps),
+    [PATTERN_SOS]        = SEQ_PATTERN("SOS", sos_steps),
+    [PATTERN_RAINBOW]    = SEQ_PATTERN("RAINBOW", rainbow_steps),
+};
+
+void apply_pattern_step(uint8_t action) {
+    set_pattern_leds(action & LED1, action & LED2, action & LED3);
+}
+
+// Runs in the timer daemon once per completed pattern - must not block
+void pattern_cycle_callback(const seq_pattern_t *pattern, uint32_t cycles) {
     switch (current_pattern) {
-        case PATTERN_OFF:
-            set_pattern_leds(0, 0, 0);
-            xTimerChangePeriod(timer, pdMS_TO_TICKS(1000), 0);
-            break;
-            
-        case PATTERN_SLOW_BLINK:
-            pattern_state.state = !pattern_state.state;
-            set_pattern_leds(pattern_state.state, 0, 0);
-            xTimerChangePeriod(timer, pdMS_TO_TICKS(1000), 0);
-            ESP_LOGI(TAG, "💡 Slow Blink: %s", pattern_state.state ? "ON" : "OFF");
+        case PATTERN_HEARTBEAT:
+            ESP_LOGI(TAG, "💓 Heartbeat pulse");
             break;
-            
-        case PATTERN_FAST_BLINK:
-            pattern_state.state = !pattern_state.state;
-            set_pattern_leds(0, pattern_state.state, 0);
-            xTimerChangePeriod(timer, pdMS_TO_TICKS(200), 0);
+        case PATTERN_SOS:
+            ESP_LOGI(TAG, "🆘 SOS Pattern Complete");
             break;
-            
-        case PATTERN_HEARTBEAT: {
-            // Double pulse pattern
-            int step = pattern_step % 10;
-            bool pulse = (step < 2) || (step >= 3 && step < 5);
-            set_pattern_leds(0, 0, pulse);
-            pattern_step++;
-            xTimerChangePeriod(timer, pdMS_TO_TICKS(100), 0);
-            if (step == 9) ESP_LOGI(TAG, "💓 Heartbeat pulse");
+        case PATTERN_RAINBOW:
+            ESP_LOGI(TAG, "🌈 Rainbow cycle complete");
             break;
-        }
-        
-        case PATTERN_SOS: {
-            // SOS: ... --- ... (dots and dashes)
-            static const char* sos = "...---...";
-            static int sos_pos = 0;
-            
-            bool on = (sos[sos_pos] == '.');
-            int duration = on ? 200 : 600; // Dot: 200ms, Dash: 600ms
-            
-            set_pattern_leds(on, on, on);
-            
-            sos_pos = (sos_pos + 1) % strlen(sos);
-            if (sos_pos == 0) {
-                ESP_LOGI(TAG, "🆘 SOS Pattern Complete");
-                vTaskDelay(pdMS_TO_TICKS(1000)); // Pause between repeats
-            }
-            
-            xTimerChangePeriod(timer, pdMS_TO_TICKS(duration), 0);
-            break;
-        }
-        
-        case PATTERN_RAINBOW: {
-            // Cycle through LED combinations
-            int rainbow_step = pattern_step % 8;
-            bool led1 = (rainbow_step & 1) != 0;
-            bool led2 = (rainbow_step & 2) != 0;
-            bool led3 = (rainbow_step & 4) != 0;
-            
-            set_pattern_leds(led1, led2, led3);
-            pattern_step++;
-            
-            if (rainbow_step == 7) ESP_LOGI(TAG, "🌈 Rainbow cycle complete");
-            xTimerChangePeriod(timer, pdMS_TO_TICKS(300), 0);
-            break;
-        }
-        
         default:
-            set_pattern_leds(0, 0, 0);
             break;
     }
-    
-    // Change pattern every 50 cycles
-    if (pattern_cycle % 50 == 0) {
+
+    if (led_sequencer.steps_since_load >= PATTERN_ROTATE_STEPS) {
         led_pattern_t new_pattern = (current_pattern + 1) % PATTERN_MAX;
         change_led_pattern(new_pattern);
     }
 }
 
 void change_led_pattern(led_pattern_t new_pattern) {
-    const char* pattern_names[] = {
-        "OFF", "SLOW_BLINK", "FAST_BLINK", 
-        "HEARTBEAT", "SOS", "RAINBOW"
-    };
-    
     ESP_LOGI(TAG, "🎨 Changing pattern: %s -> %s", 
-             pattern_names[current_pattern], pattern_names[new_pattern]);
+             pattern_table[current_pattern].name, pattern_table[new_pattern].name);
     
     current_pattern = new_pattern;
-    pattern_step = 0;
-    pattern_state.step = 0;
-    pattern_state.state = false;
+    pattern_since = xTaskGetTickCount();
     health_stats.pattern_changes++;
     
-    // Reset timer with new pattern
-    xTimerReset(pattern_timer, 0);
+    // No timer command needed - the sequencer picks it up on its next tick
+    led_sequencer_load(&led_sequencer, &pattern_table[new_pattern]);
 }
 
 // ================ SENSOR SYSTEM ================
@@ -286,33 +293,34 @@ float read_sensor_value(void) {
     return sensor_value;
 }
 
+// Samples go through a ring (ingest): the timer callback only stores
+// them, sensor_processing_task collects every SENSOR_POLL_MS. A full
+// ring and out-of-range readings are counted, not logged per sample
+#define SENSOR_RING             16
+#define SENSOR_POLL_MS          250
+
+static ingest_t sensor_ingest;
+static ingest_sample_t sensor_samples[SENSOR_RING];
+static ingest_ring_t *sensor_ring;
+
+// Runs in the timer daemon task (not an ISR)
 void sensor_timer_callback(TimerHandle_t timer) {
-    sensor_data_t sensor_data;
-    
-    sensor_data.value = read_sensor_value();
-    sensor_data.timestamp = xTaskGetTickCount();
-    sensor_data.valid = (sensor_data.value >= 0 && sensor_data.value <= 50);
+    float value = read_sensor_value();
     
     health_stats.sensor_readings++;
-    
-    // Send to processing queue
-    BaseType_t higher_priority_task_woken = pdFALSE;
-    if (xQueueSendFromISR(sensor_queue, &sensor_data, &higher_priority_task_woken) != pdTRUE) {
-        ESP_LOGW(TAG, "Sensor queue full - dropping sample");
-    }
+    ingest_put(sensor_ring, ingest_now_ms(), 0, value);
     
     // Adaptive sampling based on sensor value
     TickType_t new_period;
-    if (sensor_data.value > 40.0) {
+    if (value > 40.0) {
         new_period = pdMS_TO_TICKS(500);  // High temp - sample faster
-    } else if (sensor_data.value > 25.0) {
+    } else if (value > 25.0) {
         new_period = pdMS_TO_TICKS(1000); // Normal temp
     } else {
         new_period = pdMS_TO_TICKS(2000); // Low temp - sample slower
     }
     
-    xTimerChangePeriodFromISR(timer, new_period, &higher_priority_task_woken);
-    portYIELD_FROM_ISR(higher_priority_task_woken);
+    xTimerChangePeriod(timer, new_period, 0);
 }
 
 // ================ STATUS SYSTEM ================
@@ -327,62 +335,76 @@ void status_timer_callback(TimerHandle_t timer) {
     ESP_LOGI(TAG, "Watchdog Timeouts: %lu", health_stats.watchdog_timeouts);
     ESP_LOGI(TAG, "Pattern Changes: %lu", health_stats.pattern_changes);
     ESP_LOGI(TAG, "Sensor Readings: %lu", health_stats.sensor_readings);
-    ESP_LOGI(TAG, "Current Pattern: %d", current_pattern);
+    ESP_LOGI(TAG, "Current Pattern: %s", pattern_table[current_pattern].name);
+    ESP_LOGI(TAG, "Pattern Steps: %lu (cycles %lu, loads %lu)",
+             led_sequencer.steps_run, led_sequencer.cycles, led_sequencer.pattern_loads);
     
     // Check timer states
     ESP_LOGI(TAG, "Timer States:");
     ESP_LOGI(TAG, "  Watchdog: %s", xTimerIsTimerActive(watchdog_timer) ? "ACTIVE" : "INACTIVE");
     ESP_LOGI(TAG, "  Feed: %s", xTimerIsTimerActive(feed_timer) ? "ACTIVE" : "INACTIVE");
-    ESP_LOGI(TAG, "  Pattern: %s", xTimerIsTimerActive(pattern_timer) ? "ACTIVE" : "INACTIVE");
+    ESP_LOGI(TAG, "  Pattern: %s", xTimerIsTimerActive(led_sequencer.timer) ? "ACTIVE" : "INACTIVE");
     ESP_LOGI(TAG, "  Sensor: %s", xTimerIsTimerActive(sensor_timer) ? "ACTIVE" : "INACTIVE");
     ESP_LOGI(TAG, "════════════════════════════\n");
     
+    if (current_pattern == PATTERN_OFF &&
+        xTaskGetTickCount() - pattern_since >= pdMS_TO_TICKS(PATTERN_OFF_HOLD_MS)) {
+        change_led_pattern((current_pattern + 1) % PATTERN_MAX);
+    }
+    
     // Flash status LED
-    gpio_set_level(STATUS_LED, 1);
-    vTaskDelay(pdMS_TO_TICKS(200));
-    gpio_set_level(STATUS_LED, 0);
+    flash_led(STATUS_LED, 200);
 }
 
 // ================ PROCESSING TASKS ================
 
+// ================ TEMPERATURE WINDOWS ================
+// Samples go into 10 s tumbling windows; logging, warnings and LED
+// changes happen once per window instead of once per sample
+
+#define TEMP_WINDOW_MS          10000
+#define TEMP_LATENESS_MS        2000    // Queue delay tolerated before a window closes
+#define TEMP_VALID_MIN          0.0f
+#define TEMP_VALID_MAX          50.0f
+
+static so_stream_t temp_stream;
+
+// Invalid readings show up as "filtered" in so_report()
+static bool temperature_in_range(uint32_t key, float value, void *ctx) {
+    return value >= TEMP_VALID_MIN && value <= TEMP_VALID_MAX;
+}
+
+static void temperature_window(const so_window_t *w, void *ctx) {
+    ESP_LOGI(TAG, "📊 Temperature window %lu-%lu ms: avg %.2f°C (min %.2f, max %.2f, %lu samples)",
+             w->start_ms, w->end_ms, w->mean, w->min, w->max, w->count);
+
+    // Trigger warnings
+    if (w->mean > 35.0) {
+        ESP_LOGW(TAG, "🔥 High temperature warning!");
+        change_led_pattern(PATTERN_FAST_BLINK);
+    } else if (w->mean < 15.0) {
+        ESP_LOGW(TAG, "🧊 Low temperature warning!");
+        change_led_pattern(PATTERN_SOS);
+    }
+}
+
+// Collected samples, oldest first
+static void window_samples(const ingest_sample_t *batch, uint32_t n, void *ctx) {
+    for (uint32_t i = 0; i < n; i++) {
+        so_push(&temp_stream, batch[i].channel, batch[i].t_ms, batch[i].value);
+    }
+}
+
 void sensor_processing_task(void *parameter) {
-    sensor_data_t sensor_data;
-    float temp_sum = 0;
-    int sample_count = 0;
-    
     ESP_LOGI(TAG, "Sensor processing task started");
     
+    TickType_t last_wake = xTaskGetTickCount();
     while (1) {
-        if (xQueueReceive(sensor_queue, &sensor_data, portMAX_DELAY) == pdTRUE) {
-            if (sensor_data.valid) {
-                temp_sum += sensor_data.value;
-                sample_count++;
-                
-                ESP_LOGI(TAG, "🌡️ Sensor: %.2f°C at %lu ms", 
-                         sensor_data.value, sensor_data.timestamp);
-                
-                // Calculate moving average every 10 samples
-                if (sample_count >= 10) {
-                    float average = temp_sum / sample_count;
-                    ESP_LOGI(TAG, "📊 Temperature Average: %.2f°C", average);
-                    
-                    // Trigger warnings
-                    if (average > 35.0) {
-                        ESP_LOGW(TAG, "🔥 High temperature warning!");
-                        change_led_pattern(PATTERN_FAST_BLINK);
-                    } else if (average < 15.0) {
-                        ESP_LOGW(TAG, "🧊 Low temperature warning!");
-                        change_led_pattern(PATTERN_SOS);
-                    }
-                    
-                    // Reset counters
-                    temp_sum = 0;
-                    sample_count = 0;
-                }
-            } else {
-                ESP_LOGW(TAG, "Invalid sensor reading: %.2f", sensor_data.value);
-            }
-        }
+        vTaskDelayUntil(&last_wake, pdMS_TO_TICKS(SENSOR_POLL_MS));
+        uint32_t now_ms = ingest_now_ms();
+        ingest_poll(&sensor_ingest, now_ms);
+        // Also closes the window the sensor stopped in, if it went quiet
+        so_advance(&temp_stream, now_ms);
     }
 }
 
@@ -413,6 +435,10 @@ void system_monitor_task(void *parameter) {
         if (free_heap < 10000) {
             ESP_LOGW(TAG, "⚠️ Low memory warning!");
         }
+        
+        dq_report(stdout);
+        ingest_report(&sensor_ingest, ingest_now_ms(), stdout);
+        so_report(&temp_stream, stdout);
     }
 }
 
@@ -461,12 +487,9 @@ void create_timers(void) {
                              (void*)2,
                              feed_watchdog_callback);
     
-    // Create pattern timer (auto-reload)
-    pattern_timer = xTimerCreate("PatternTimer",
-                                pdMS_TO_TICKS(PATTERN_BASE_MS),
-                                pdTRUE, // Auto-reload
-                                (void*)3,
-                                pattern_timer_callback);
+    // Create pattern sequencer (fixed-period auto-reload timer)
+    bool sequencer_ok = led_sequencer_init(&led_sequencer, apply_pattern_step,
+                                           pattern_cycle_callback);
     
     // Create sensor timer (auto-reload)
     sensor_timer = xTimerCreate("SensorTimer",
@@ -482,7 +505,7 @@ void create_timers(void) {
                                (void*)5,
                                status_timer_callback);
     
-    if (!watchdog_timer || !feed_timer || !pattern_timer || !sensor_timer || !status_timer) {
+    if (!watchdog_timer || !feed_timer || !sequencer_ok || !sensor_timer || !status_timer) {
         ESP_LOGE(TAG, "Failed to create one or more timers");
         return;
     }
@@ -491,10 +514,21 @@ void create_timers(void) {
 }
 
 void create_queues(void) {
-    sensor_queue = xQueueCreate(20, sizeof(sensor_data_t));
     pattern_queue = xQueueCreate(10, sizeof(led_pattern_t));
+    esp_err_t dq_err = dq_create(&deferred, "deferred", DEFERRED_CAPACITY,
+                                 sizeof(deferred_action_t), run_deferred, NULL);
+    so_config_t temp_cfg = { .size_ms = TEMP_WINDOW_MS, .lateness_ms = TEMP_LATENESS_MS };
+    esp_err_t so_err = so_init(&temp_stream, "temperature", &temp_cfg, temperature_window, NULL);
+    if (so_err == ESP_OK) {
+        so_err = so_filter(&temp_stream, temperature_in_range, NULL);
+    }
+    // One producer, so nothing to hold back for the merge
+    esp_err_t in_err = ingest_init(&sensor_ingest, "sensor", 0, window_samples, NULL);
+    if (in_err == ESP_OK) {
+        sensor_ring = ingest_producer(&sensor_ingest, "ADC1_CH0", sensor_samples, SENSOR_RING);
+    }
     
-    if (!sensor_queue || !pattern_queue) {
+    if (!pattern_queue || dq_err != ESP_OK || so_err != ESP_OK || sensor_ring == NULL) {
         ESP_LOGE(TAG, "Failed to create queues");
         return;
     }
@@ -508,7 +542,7 @@ void start_system(void) {
     
     xTimerStart(watchdog_timer, 0);
     xTimerStart(feed_timer, 0);
-    xTimerStart(pattern_timer, 0);
+    led_sequencer_start(&led_sequencer);
     xTimerStart(sensor_timer, 0);
     xTimerStart(status_timer, 0);
     
@@ -0,0 +1,103 @@
+#include "led_sequencer.h"
+
+static uint16_t duration_to_ticks(uint16_t duration_ms) {
+    uint16_t ticks = duration_ms / SEQ_TICK_MS;
+    return ticks ? ticks : 1;
+}
+
+static void enter_step(led_sequencer_t *seq, uint8_t index) {
+    const seq_step_t *step = &seq->active->steps[index];
+
+    seq->step_index = index;
+    seq->ticks_left = duration_to_ticks(step->duration_ms);
+    seq->apply(step->action);
+    seq->steps_run++;
+    seq->steps_since_load++;
+}
+
+// Nothing left to count down - stop ticking until the next load. The stop
+// is posted before held is set, so a load that sees held queues its start
+// behind it; a load that missed held is caught by the pending check.
+static void hold(led_sequencer_t *seq) {
+    xTimerStop(seq->timer, 0);
+    __atomic_store_n(&seq->held, true, __ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&seq->pending, __ATOMIC_SEQ_CST) != NULL &&
+        __atomic_exchange_n(&seq->held, false, __ATOMIC_SEQ_CST)) {
+        xTimerStart(seq->timer, 0);
+    }
+}
+
+// Pattern switch requested - restart at step 0 of the new table
+static bool switch_pattern(led_sequencer_t *seq) {
+    const seq_pattern_t *pending = __atomic_exchange_n(&seq->pending, NULL, __ATOMIC_ACQUIRE);
+    if (pending == NULL) {
+        return false;
+    }
+    seq->active = pending;
+    seq->cycles = 0;
+    seq->steps_since_load = 0;
+    enter_step(seq, 0);
+    if (pending->step_count == 1) {
+        hold(seq);
+    }
+    return true;
+}
+
+static void sequencer_tick(TimerHandle_t timer) {
+    led_sequencer_t *seq = (led_sequencer_t *)pvTimerGetTimerID(timer);
+    seq->ticks++;
+
+    if (switch_pattern(seq)) {
+        return;
+    }
+
+    if (seq->active == NULL || --seq->ticks_left > 0) {
+        return;
+    }
+
+    uint8_t next = seq->step_index + 1;
+    if (next >= seq->active->step_count) {
+        next = 0;
+        seq->cycles++;
+        if (seq->on_cycle) {
+            const seq_pattern_t *finished = seq->active;
+            seq->on_cycle(finished, seq->cycles);
+            // on_cycle may have loaded a new pattern - apply it right away
+            if (switch_pattern(seq)) {
+                return;
+            }
+        }
+    }
+    enter_step(seq, next);
+}
+
+bool led_sequencer_init(led_sequencer_t *seq, seq_apply_fn_t apply, seq_cycle_fn_t on_cycle) {
+    *seq = (led_sequencer_t){0};
+    seq->apply = apply;
+    seq->on_cycle = on_cycle;
+    seq->timer = xTimerCreate("LedSeq",
+                              pdMS_TO_TICKS(SEQ_TICK_MS),
+                              pdTRUE, // Auto-reload, period never changes
+                              seq,
+                              sequencer_tick);
+    return seq->timer != NULL;
+}
+
+bool led_sequencer_start(led_sequencer_t *seq) {
+    return xTimerStart(seq->timer, 0) == pdPASS;
+}
+
+bool led_sequencer_stop(led_sequencer_t *seq) {
+    // An explicit stop is not a hold - loads must not restart it
+    __atomic_store_n(&seq->held, false, __ATOMIC_SEQ_CST);
+    return xTimerStop(seq->timer, 0) == pdPASS;
+}
+
+void led_sequencer_load(led_sequencer_t *seq, const seq_pattern_t *pattern) {
+    // Single pointer store - the callback swaps it in on its next tick
+    __atomic_store_n(&seq->pending, pattern, __ATOMIC_SEQ_CST);
+    __atomic_fetch_add(&seq->pattern_loads, 1, __ATOMIC_RELAXED);
+    if (__atomic_exchange_n(&seq->held, false, __ATOMIC_SEQ_CST)) {
+        xTimerStart(seq->timer, 0);
+    }
+}
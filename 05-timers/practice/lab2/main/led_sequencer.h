@@ -0,0 +1,67 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/timers.h"
+
+// ================ LED SEQUENCER ================
+// Runs a precomputed list of (action, duration) steps from ONE auto-reload
+// timer whose period never changes. Each step's remaining time is counted
+// down in the callback, so advancing a step or switching sequence does not
+// post anything to the timer command queue and never blocks the daemon.
+//
+// A pattern of one step (e.g. all LEDs off) has nothing to count down:
+// the sequencer applies it and stops its timer, so a held pattern costs no
+// wakeups. It reports no cycles while held; the next load restarts the
+// timer and the new pattern starts on its first tick.
+
+// Base resolution - every step duration must be a multiple of this
+#define SEQ_TICK_MS     100
+
+typedef struct {
+    uint8_t action;         // Passed to the apply function (e.g. LED bitmask)
+    uint16_t duration_ms;   // How long the action is held
+} seq_step_t;
+
+typedef struct {
+    const char *name;
+    const seq_step_t *steps;
+    uint8_t step_count;
+} seq_pattern_t;
+
+#define SEQ_PATTERN(label, table) \
+    { (label), (table), (uint8_t)(sizeof(table) / sizeof((table)[0])) }
+
+typedef void (*seq_apply_fn_t)(uint8_t action);
+typedef void (*seq_cycle_fn_t)(const seq_pattern_t *pattern, uint32_t cycles);
+
+typedef struct {
+    TimerHandle_t timer;
+    seq_apply_fn_t apply;
+    seq_cycle_fn_t on_cycle;            // Called each time a pattern wraps (daemon context)
+
+    const seq_pattern_t *active;
+    const seq_pattern_t *volatile pending;  // Picked up on the next tick
+    uint8_t step_index;
+    uint16_t ticks_left;
+    bool held;                          // Timer stopped on a one-step pattern
+
+    // Statistics
+    uint32_t ticks;
+    uint32_t steps_run;
+    uint32_t cycles;                    // Wraps of the active pattern
+    uint32_t steps_since_load;
+    uint32_t pattern_loads;
+} led_sequencer_t;
+
+// Create the sequencer timer (not started)
+bool led_sequencer_init(led_sequencer_t *seq, seq_apply_fn_t apply, seq_cycle_fn_t on_cycle);
+
+// Start/stop ticking - the only calls that use the timer command queue
+bool led_sequencer_start(led_sequencer_t *seq);
+bool led_sequencer_stop(led_sequencer_t *seq);
+
+// Switch pattern; safe from any task or from the sequencer's own callbacks.
+// Restarting a held sequencer is the one case that posts a timer command.
+void led_sequencer_load(led_sequencer_t *seq, const seq_pattern_t *pattern);
@@ -8,10 +8,12 @@
 #include "freertos/semphr.h"
 #include "freertos/queue.h"
 #include "esp_log.h"
-#include "esp_timer.h"
 #include "esp_system.h"
 #include "esp_random.h"
 #include "driver/gpio.h"
+#include "tstamp.h"
+#include "loadgen.h"
+#include "critmode.h"
 
 static const char *TAG = "ADV_TIMERS";
 
@@ -21,6 +23,12 @@ static const char *TAG = "ADV_TIMERS";
 #define PERFORMANCE_BUFFER_SIZE      100
 #define HEALTH_CHECK_INTERVAL        1000
 
+// Overload mode: callback overruns count as deadline misses; under
+// overload the stress/dynamic timers stop, PerfTest and the analysis
+// task slow down x4 and info logs go quiet, so HealthMonitor keeps its
+// 1 s cadence
+#define CRITMODE_ENABLE              1
+
 // LEDs for visual feedback
 #define PERFORMANCE_LED     GPIO_NUM_2
 #define HEALTH_LED         GPIO_NUM_4
@@ -46,7 +54,7 @@ typedef struct {
 
 // Performance Metrics
 typedef struct {
-    uint32_t callback_start_time;
+    ts_t callback_start;            // Cycle timestamp (tstamp)
     uint32_t callback_duration_us;
     uint32_t timer_id;
     BaseType_t service_task_priority;
@@ -182,14 +190,14 @@ void release_to_pool(uint32_t timer_id) {
 
 // ================ PERFORMANCE MONITORING ================
 
-void record_performance_sample(uint32_t timer_id, uint32_t duration_us, bool accuracy_ok) {
+void record_performance_sample(uint32_t timer_id, ts_t start, uint32_t duration_us, bool accuracy_ok) {
     if (xSemaphoreTake(perf_mutex, 0) == pdTRUE) { // Non-blocking
         performance_sample_t* sample = &perf_buffer[perf_buffer_index];
         
         sample->timer_id = timer_id;
         sample->callback_duration_us = duration_us;
         sample->accuracy_ok = accuracy_ok;
-        sample->callback_start_time = esp_timer_get_time() / 1000; // Convert to ms
+        sample->callback_start = start;
         sample->service_task_priority = uxTaskPriorityGet(NULL);
         sample->queue_length = 0; // Would need special access to get this
         
@@ -197,6 +205,7 @@ void record_performance_sample(uint32_t timer_id, uint32_t duration_us, bool acc
         
         if (duration_us > 1000) { // > 1ms is concerning
             health_data.callback_overruns++;
+            crit_deadline_miss();
         }
         
         xSemaphoreGive(perf_mutex);
@@ -259,7 +268,7 @@ void analyze_performance(void) {
 // ================ TIMER CALLBACKS ================
 
 void performance_test_callback(TimerHandle_t timer) {
-    uint32_t start_time = esp_timer_get_time();
+    ts_t start_time = ts_now();
     uint32_t timer_id = (uint32_t)pvTimerGetTimerID(timer);
     
     // Simulate variable processing time
@@ -268,13 +277,12 @@ void performance_test_callback(TimerHandle_t timer) {
         // Simulate work
     }
     
-    uint32_t end_time = esp_timer_get_time();
-    uint32_t duration_us = end_time - start_time;
+    uint32_t duration_us = ts_us32(ts_now() - start_time);
     
     // Check accuracy (simplified)
-    static uint32_t last_callback_time = 0;
+    static ts_t last_callback_time = 0;
     uint32_t expected_interval = pdTICKS_TO_MS(xTimerGetPeriod(timer)) * 1000; // Convert to μs
-    uint32_t actual_interval = start_time - last_callback_time;
+    uint32_t actual_interval = ts_us32(start_time - last_callback_time);
     bool accuracy_ok = true;
     
     if (last_callback_time > 0) {
@@ -284,7 +292,7 @@ void performance_test_callback(TimerHandle_t timer) {
     
     last_callback_time = start_time;
     
-    record_performance_sample(timer_id, duration_us, accuracy_ok);
+    record_performance_sample(timer_id, start_time, duration_us, accuracy_ok);
     
     // Update timer stats
     for (int i = 0; i < TIMER_POOL_SIZE; i++) {
@@ -368,6 +376,7 @@ TimerHandle_t create_dynamic_timer(const char* name, uint32_t period_ms,
 void cleanup_dynamic_timers(void) {
     for (uint32_t i = 0; i < dynamic_timer_count; i++) {
         if (dynamic_timers[i] != NULL) {
+            crit_unregister_timer(dynamic_timers[i]);
             xTimerDelete(dynamic_timers[i], pdMS_TO_TICKS(100));
             dynamic_timers[i] = NULL;
         }
@@ -378,6 +387,31 @@ void cleanup_dynamic_timers(void) {
 
 // ================ STRESS TESTING ================
 
+// Open-loop probe of the timer service while the stress timers run: each
+// request is a function pended to the daemon task through its command
+// queue, timed from when it was due to when the daemon ran it. A full
+// command queue is a reject, not a slower generator
+static lg_t *timer_loadgen;
+static const float timer_loadgen_rates[] = { 50, 100, 200, 400, 800 };
+
+static void timer_service_probe(void *arg, uint32_t intended_low) {
+    lg_complete32((lg_t *)arg, intended_low);
+}
+
+// Pended last: the daemon runs pended calls in order, so once this one
+// has run no probe can still complete against the generator
+static void timer_service_fence(void *arg, uint32_t unused) {
+    xTaskNotifyGive((TaskHandle_t)arg);
+}
+
+static lg_result_t issue_pended_call(void *ctx, const lg_request_t *req) {
+    (void)ctx;
+    if (xTimerPendFunctionCall(timer_service_probe, timer_loadgen, (uint32_t)req->intended, 0) != pdPASS) {
+        return LG_REJECTED;
+    }
+    return LG_ASYNC;
+}
+
 void stress_test_task(void *parameter) {
     ESP_LOGI(TAG, "🔥 Starting stress test...");
     
@@ -394,17 +428,39 @@ void stress_test_task(void *parameter) {
         
         if (stress_timers[i] != NULL) {
             xTimerStart(stress_timers[i]->handle, 0);
+            crit_register_timer(stress_timers[i]->handle, CRIT_LOW);
         }
         
         vTaskDelay(pdMS_TO_TICKS(100)); // Stagger creation
     }
     
-    // Run stress test for 30 seconds
-    vTaskDelay(pdMS_TO_TICKS(30000));
+    // Run stress test for ~30 seconds, sweeping the timer service
+    lg_config_t cfg = LG_CONFIG_DEFAULT();
+    cfg.name = "timer_service";
+    cfg.issue = issue_pended_call;
+    cfg.arrival = LG_POISSON;
+    cfg.rates_hz = timer_loadgen_rates;
+    cfg.steps = sizeof(timer_loadgen_rates) / sizeof(timer_loadgen_rates[0]);
+    cfg.step_ms = 5500;
+    cfg.settle_ms = 500;
+    cfg.seed = 7;
+    if (lg_create(&cfg, &timer_loadgen) == ESP_OK) {
+        lg_run(timer_loadgen);
+        if (xTimerPendFunctionCall(timer_service_fence, xTaskGetCurrentTaskHandle(), 0,
+                                   portMAX_DELAY) == pdPASS) {
+            ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        }
+        lg_destroy(timer_loadgen);
+        timer_loadgen = NULL;
+    } else {
+        ESP_LOGE(TAG, "Failed to create timer service load generator");
+        vTaskDelay(pdMS_TO_TICKS(30000));
+    }
     
     // Clean up stress timers
     for (int i = 0; i < 10; i++) {
         if (stress_timers[i] != NULL) {
+            crit_unregister_timer(stress_timers[i]->handle);    // Before it can be restarted
             xTimerStop(stress_timers[i]->handle, pdMS_TO_TICKS(100));
             release_to_pool(stress_timers[i]->id);
         }
@@ -421,6 +477,7 @@ void stress_test_task(void *parameter) {
                                               true, performance_test_callback);
         if (dt != NULL) {
             xTimerStart(dt, 0);
+            crit_register_timer(dt, CRIT_LOW);
         }
     }
     
@@ -431,9 +488,10 @@ void stress_test_task(void *parameter) {
 
 void performance_analysis_task(void *parameter) {
     ESP_LOGI(TAG, "Performance analysis task started");
+    crit_task_t *crit = crit_task_register("PerfAnalysis", CRIT_MEDIUM);
     
     while (1) {
-        vTaskDelay(pdMS_TO_TICKS(10000)); // Every 10 seconds
+        crit_delay(crit, 10000); // Every 10 seconds
         
         analyze_performance();
         
@@ -446,6 +504,9 @@ void performance_analysis_task(void *parameter) {
         ESP_LOGI(TAG, "Callback Overruns: %lu", health_data.callback_overruns);
         ESP_LOGI(TAG, "Command Failures: %lu", health_data.command_failures);
         ESP_LOGI(TAG, "═════════════════════════\n");
+#if CRITMODE_ENABLE
+        crit_report(stdout);
+#endif
         
         // Memory usage check
         if (health_data.free_heap_bytes < 20000) {
@@ -499,6 +560,7 @@ void create_system_timers(void) {
     if (health_monitor_timer && performance_timer) {
         xTimerStart(health_monitor_timer, 0);
         xTimerStart(performance_timer, 0);
+        crit_register_timer(performance_timer, CRIT_MEDIUM);
         ESP_LOGI(TAG, "System timers started");
     } else {
         ESP_LOGE(TAG, "Failed to create system timers");
@@ -508,6 +570,16 @@ void create_system_timers(void) {
 void app_main(void) {
     ESP_LOGI(TAG, "Advanced Timer Management Lab Starting...");
     
+    // Callback timing uses cycle-counter timestamps
+    ts_init();
+    
+#if CRITMODE_ENABLE
+    // Before anything registers with it
+    if (crit_init(NULL) == ESP_OK) {
+        crit_log_tag(TAG);
+    }
+#endif
+    
     // Initialize components
     init_hardware();
     init_timer_pool();
@@ -519,7 +591,7 @@ void app_main(void) {
     
     // Wait a bit then start stress test
     vTaskDelay(pdMS_TO_TICKS(5000));
-    xTaskCreate(stress_test_task, "StressTest", 2048, NULL, 5, &stress_test_task_handle);
+    xTaskCreate(stress_test_task, "StressTest", 4096, NULL, 5, &stress_test_task_handle);
     
     ESP_LOGI(TAG, "🚀 Advanced Timer Management System Running");
     ESP_LOGI(TAG, "Monitor LEDs for system status:");
@@ -4,9 +4,14 @@
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "freertos/event_groups.h"
+#include "freertos/queue.h"
 #include "esp_log.h"
 #include "esp_random.h"
+#include "esp_timer.h"
 #include "driver/gpio.h"
+#include "tlog.h"
+#include "cfgblob.h"
+#include "lab_config_schema.h"
 
 static const char *TAG = "EVENT_GROUPS";
 
@@ -25,6 +30,7 @@ EventGroupHandle_t system_events;
 #define CONFIG_READY_BIT    (1 << 2)    // BIT2
 #define STORAGE_READY_BIT   (1 << 3)    // BIT3
 #define SYSTEM_READY_BIT    (1 << 4)    // BIT4
+#define STORAGE_NOLOG_BIT   (1 << 5)    // BIT5: storage up, telemetry not persisted
 
 // กลุ่ม Event Bits
 #define BASIC_SYSTEM_BITS   (NETWORK_READY_BIT | CONFIG_READY_BIT)
@@ -44,6 +50,66 @@ typedef struct {
 
 static system_stats_t stats = {0};
 
+// Telemetry storage (log-structured store on the "telemetry" partition)
+#define TELEMETRY_PARTITION     "telemetry"
+#define TELEMETRY_QUEUE_LEN     32
+
+typedef struct {
+    float temperature;
+    float humidity;
+} telemetry_sample_t;
+
+static QueueHandle_t telemetry_queue;
+static tlog_t telemetry_log;
+static uint32_t telemetry_time_base;    // Keeps timestamps increasing across reboots
+
+static uint32_t telemetry_now_ms(void) {
+    return telemetry_time_base + (uint32_t)(esp_timer_get_time() / 1000);
+}
+
+// Runtime configuration (blob on the "config" partition, see tools/cfgblob)
+static const cfg_system_timing_t default_timing = {
+    .network_check_ms  = 5000,
+    .sensor_sample_ms  = 3000,
+    .config_check_ms   = 8000,
+    .storage_flush_ms  = 5000,     // Max time a sample sits in the page buffer
+    .storage_report_ms = 10000,
+    .health_check_ms   = 5000,
+};
+
+static const cfgblob_header_t *config_blob;
+static cfg_system_timing_t timing_scratch;
+// ใช้ค่า default จนกว่า config_load_task จะโหลด blob เสร็จ (สลับ pointer ครั้งเดียว)
+static const cfg_system_timing_t *volatile lab_timing = &default_timing;
+
+// Periods out of [CFG_MS_MIN, CFG_MS_MAX] fall back to their default
+static bool check_period(const char *name, uint32_t *ms, uint32_t def) {
+    if (*ms >= CFG_MS_MIN && *ms <= CFG_MS_MAX) {
+        return true;
+    }
+    ESP_LOGW(TAG, "⚠️ Config %s = %lu ms out of range, using %lu ms", name, *ms, def);
+    *ms = def;
+    return false;
+}
+
+// A good section is still read in place; a bad one is fixed up in timing_scratch
+static const cfg_system_timing_t *checked_timing(const cfg_system_timing_t *t) {
+    cfg_system_timing_t c = *t;
+    bool ok = true;
+    
+    ok &= check_period("network_check_ms", &c.network_check_ms, default_timing.network_check_ms);
+    ok &= check_period("sensor_sample_ms", &c.sensor_sample_ms, default_timing.sensor_sample_ms);
+    ok &= check_period("config_check_ms", &c.config_check_ms, default_timing.config_check_ms);
+    ok &= check_period("storage_flush_ms", &c.storage_flush_ms, default_timing.storage_flush_ms);
+    ok &= check_period("storage_report_ms", &c.storage_report_ms, default_timing.storage_report_ms);
+    ok &= check_period("health_check_ms", &c.health_check_ms, default_timing.health_check_ms);
+    if (ok) {
+        return t;
+    }
+    timing_scratch = c;
+    return &timing_scratch;
+}
+
 // Network initialization task
 void network_init_task(void *pvParameters) {
     ESP_LOGI(TAG, "🌐 Network initialization started");
@@ -88,7 +154,7 @@ void network_init_task(void *pvParameters) {
             ESP_LOGW(TAG, "🔴 Network connection lost");
         }
         
-        vTaskDelay(pdMS_TO_TICKS(5000));
+        vTaskDelay(pdMS_TO_TICKS(lab_timing->network_check_ms));
     }
 }
 
@@ -125,6 +191,10 @@ void sensor_init_task(void *pvParameters) {
         
         ESP_LOGI(TAG, "🌡️ Sensor readings: %.1f°C, %.1f%% RH", temperature, humidity);
         
+        // ส่งค่าไปบันทึกลง storage (ไม่รอถ้า queue เต็ม)
+        telemetry_sample_t sample = {temperature, humidity};
+        xQueueSend(telemetry_queue, &sample, 0);
+        
         // จำลองการตรวจสอบ sensor
         if (temperature > 50.0 || humidity > 90.0) {
             ESP_LOGW(TAG, "⚠️ Sensor values out of range!");
@@ -138,7 +208,7 @@ void sensor_init_task(void *pvParameters) {
             ESP_LOGI(TAG, "🟢 Sensor system recovered");
         }
         
-        vTaskDelay(pdMS_TO_TICKS(3000));
+        vTaskDelay(pdMS_TO_TICKS(lab_timing->sensor_sample_ms));
     }
 }
 
@@ -147,18 +217,27 @@ void config_load_task(void *pvParameters) {
     ESP_LOGI(TAG, "⚙️ Configuration loading started");
     
     uint32_t start_time = xTaskGetTickCount();
+    int64_t load_start = esp_timer_get_time();
+    
+    // mmap + CRC check เท่านั้น ไม่มีการ parse - section อ่านผ่าน struct pointer ได้เลย
+    ESP_LOGI(TAG, "Mapping configuration blob...");
+    esp_err_t err = cfgblob_open_partition(LAB_CONFIG_PARTITION, &config_blob);
+    
+    if (err == ESP_OK) {
+        lab_timing = checked_timing(CFGBLOB_SECTION(config_blob, CFG_SECTION_SYSTEM_TIMING,
+                                                    cfg_system_timing_t, &default_timing,
+                                                    &timing_scratch));
+        ESP_LOGI(TAG, "Configuration blob: %lu bytes, %u sections (loaded in %lld us)",
+                 config_blob->total_size, config_blob->section_count,
+                 esp_timer_get_time() - load_start);
+    } else {
+        ESP_LOGW(TAG, "⚠️ No valid configuration blob (%s), using defaults",
+                 esp_err_to_name(err));
+    }
     
-    ESP_LOGI(TAG, "Reading device configuration...");
-    vTaskDelay(pdMS_TO_TICKS(600));
-    
-    ESP_LOGI(TAG, "Loading network settings...");
-    vTaskDelay(pdMS_TO_TICKS(400));
-    
-    ESP_LOGI(TAG, "Loading sensor parameters...");
-    vTaskDelay(pdMS_TO_TICKS(300));
-    
-    ESP_LOGI(TAG, "Validating configuration...");
-    vTaskDelay(pdMS_TO_TICKS(500));
+    ESP_LOGI(TAG, "Timing: network %lu ms, sensor %lu ms, flush %lu ms, health %lu ms",
+             lab_timing->network_check_ms, lab_timing->sensor_sample_ms,
+             lab_timing->storage_flush_ms, lab_timing->health_check_ms);
     
     stats.config_init_time = (xTaskGetTickCount() - start_time) * portTICK_PERIOD_MS;
     
@@ -167,26 +246,27 @@ void config_load_task(void *pvParameters) {
     
     ESP_LOGI(TAG, "✅ Configuration loaded! (took %lu ms)", stats.config_init_time);
     
-    // จำลองการเฝ้าดู configuration
+    // เฝ้าดู configuration: ตรวจ CRC ของ blob ที่ map ไว้ซ้ำเป็นระยะ
     while (1) {
         ESP_LOGI(TAG, "⚙️ Configuration monitoring - checking integrity");
         
-        // จำลองการตรวจสอบไฟล์ config
-        if ((esp_random() % 100) > 2) { // 98% reliability
+        if (config_blob == NULL ||
+            cfgblob_check(config_blob, config_blob->total_size) == ESP_OK) {
             gpio_set_level(LED_CONFIG_READY, 1);
         } else {
-            ESP_LOGW(TAG, "⚠️ Configuration corruption detected, reloading...");
+            ESP_LOGW(TAG, "⚠️ Configuration corruption detected, falling back to defaults");
             gpio_set_level(LED_CONFIG_READY, 0);
             xEventGroupClearBits(system_events, CONFIG_READY_BIT);
             
-            vTaskDelay(pdMS_TO_TICKS(1000));
+            lab_timing = &default_timing;
+            config_blob = NULL;
             
             gpio_set_level(LED_CONFIG_READY, 1);
             xEventGroupSetBits(system_events, CONFIG_READY_BIT);
-            ESP_LOGI(TAG, "🟢 Configuration reloaded successfully");
+            ESP_LOGI(TAG, "🟢 Running on default configuration");
         }
         
-        vTaskDelay(pdMS_TO_TICKS(8000));
+        vTaskDelay(pdMS_TO_TICKS(lab_timing->config_check_ms));
     }
 }
 
@@ -196,17 +276,31 @@ void storage_init_task(void *pvParameters) {
     
     uint32_t start_time = xTaskGetTickCount();
     
-    ESP_LOGI(TAG, "Mounting filesystem...");
-    vTaskDelay(pdMS_TO_TICKS(1000));
+    ESP_LOGI(TAG, "Mounting telemetry log...");
+    tlog_flash_t flash;
+    esp_err_t err = tlog_flash_partition_init(&flash, TELEMETRY_PARTITION);
+    if (err == ESP_OK) {
+        err = tlog_mount(&telemetry_log, &flash);
+    }
     
-    ESP_LOGI(TAG, "Checking filesystem integrity...");
-    vTaskDelay(pdMS_TO_TICKS(1500));
+    if (err != ESP_OK) {
+        // ไม่มี flash log ก็ยังทำงานต่อได้ - แค่ไม่เก็บ telemetry. READY ยังต้อง
+        // ตั้ง ไม่งั้นทุก task ที่รอ storage จะค้างตลอดไป
+        ESP_LOGE(TAG, "❌ Telemetry storage unavailable: %s - running without it",
+                 esp_err_to_name(err));
+        stats.storage_init_time = (xTaskGetTickCount() - start_time) * portTICK_PERIOD_MS;
+        xEventGroupSetBits(system_events, STORAGE_READY_BIT | STORAGE_NOLOG_BIT);
+        vTaskDelete(NULL);
+        return;
+    }
     
-    ESP_LOGI(TAG, "Creating directories...");
-    vTaskDelay(pdMS_TO_TICKS(300));
+    // ต่อเวลาจากข้อมูลล่าสุดที่บันทึกไว้ เพื่อให้ timestamp เพิ่มขึ้นเสมอหลัง reboot
+    telemetry_time_base = tlog_last_timestamp(&telemetry_log) + 1;
     
-    ESP_LOGI(TAG, "Initializing database...");
-    vTaskDelay(pdMS_TO_TICKS(800));
+    tlog_stats_t log_stats;
+    tlog_get_stats(&telemetry_log, &log_stats);
+    ESP_LOGI(TAG, "Recovered %lu records in %lu segments (torn records: %lu)",
+             log_stats.records_stored, log_stats.segments_used, log_stats.torn_records);
     
     stats.storage_init_time = (xTaskGetTickCount() - start_time) * portTICK_PERIOD_MS;
     
@@ -215,19 +309,39 @@ void storage_init_task(void *pvParameters) {
     
     ESP_LOGI(TAG, "✅ Storage ready! (took %lu ms)", stats.storage_init_time);
     
-    // จำลองการทำงานของ storage
+    // บันทึก telemetry: append ทุก sample, flush เป็นช่วง ๆ
+    TickType_t last_flush = xTaskGetTickCount();
+    TickType_t last_report = last_flush;
+    
     while (1) {
-        ESP_LOGI(TAG, "💾 Storage maintenance - checking space and health");
-        
-        // จำลองการตรวจสอบ storage
-        uint32_t free_space = 1000 + (esp_random() % 9000); // 1-10GB
-        ESP_LOGI(TAG, "Storage free space: %lu MB", free_space);
+        telemetry_sample_t sample;
+        if (xQueueReceive(telemetry_queue, &sample, pdMS_TO_TICKS(1000)) == pdTRUE) {
+            err = tlog_append(&telemetry_log, telemetry_now_ms(), &sample, sizeof(sample));
+            if (err != ESP_OK) {
+                ESP_LOGW(TAG, "⚠️ Telemetry append failed: %s", esp_err_to_name(err));
+            }
+        }
         
-        if (free_space < 500) { // Less than 500MB
-            ESP_LOGW(TAG, "⚠️ Low storage space warning!");
+        TickType_t now = xTaskGetTickCount();
+        if (now - last_flush >= pdMS_TO_TICKS(lab_timing->storage_flush_ms)) {
+            tlog_flush(&telemetry_log);
+            last_flush = now;
         }
         
-        vTaskDelay(pdMS_TO_TICKS(10000));
+        if (now - last_report >= pdMS_TO_TICKS(lab_timing->storage_report_ms)) {
+            last_report = now;
+            tlog_get_stats(&telemetry_log, &log_stats);
+            
+            ESP_LOGI(TAG, "💾 Storage: %lu records stored in %lu/%lu segments",
+                     log_stats.records_stored, log_stats.segments_used,
+                     telemetry_log.segment_count);
+            ESP_LOGI(TAG, "  Appended %lu B, programmed %lu B (%lu ops), erases %lu",
+                     log_stats.bytes_appended, log_stats.bytes_programmed,
+                     log_stats.program_ops, log_stats.erase_ops);
+            ESP_LOGI(TAG, "  Erase count min/max: %lu/%lu, dropped segments: %lu",
+                     log_stats.min_erase_count, log_stats.max_erase_count,
+                     log_stats.segments_dropped);
+        }
     }
 }
 
@@ -301,7 +415,8 @@ void system_coordinator_task(void *pvParameters) {
         ESP_LOGI(TAG, "  Network:  %s", (current_bits & NETWORK_READY_BIT) ? "✅" : "❌");
         ESP_LOGI(TAG, "  Sensor:   %s", (current_bits & SENSOR_READY_BIT) ? "✅" : "❌");
         ESP_LOGI(TAG, "  Config:   %s", (current_bits & CONFIG_READY_BIT) ? "✅" : "❌");
-        ESP_LOGI(TAG, "  Storage:  %s", (current_bits & STORAGE_READY_BIT) ? "✅" : "❌");
+        ESP_LOGI(TAG, "  Storage:  %s%s", (current_bits & STORAGE_READY_BIT) ? "✅" : "❌",
+                 (current_bits & STORAGE_NOLOG_BIT) ? " (telemetry not persisted)" : "");
         ESP_LOGI(TAG, "  System:   %s", (current_bits & SYSTEM_READY_BIT) ? "✅" : "❌");
         
         // ตรวจสอบว่าระบบยังพร้อมใช้งานหรือไม่
@@ -315,7 +430,7 @@ void system_coordinator_task(void *pvParameters) {
             xEventGroupSetBits(system_events, SYSTEM_READY_BIT);
         }
         
-        vTaskDelay(pdMS_TO_TICKS(5000));
+        vTaskDelay(pdMS_TO_TICKS(lab_timing->health_check_ms));
     }
 }
 
@@ -396,11 +511,17 @@ void app_main(void) {
     
     ESP_LOGI(TAG, "Event group created successfully");
     
+    telemetry_queue = xQueueCreate(TELEMETRY_QUEUE_LEN, sizeof(telemetry_sample_t));
+    if (telemetry_queue == NULL) {
+        ESP_LOGE(TAG, "Failed to create telemetry queue!");
+        return;
+    }
+    
     // สร้าง initialization tasks
     xTaskCreate(network_init_task, "NetworkInit", 3072, NULL, 6, NULL);
     xTaskCreate(sensor_init_task, "SensorInit", 2048, NULL, 5, NULL);
     xTaskCreate(config_load_task, "ConfigLoad", 2048, NULL, 4, NULL);
-    xTaskCreate(storage_init_task, "StorageInit", 2048, NULL, 4, NULL);
+    xTaskCreate(storage_init_task, "StorageInit", 4096, NULL, 4, NULL);
     
     // สร้าง system coordinator
     xTaskCreate(system_coordinator_task, "SysCoord", 3072, NULL, 8, NULL);
@@ -11,6 +11,12 @@
 #include "esp_random.h"
 #include "esp_timer.h"
 #include "driver/gpio.h"
+#include "lab_messages.h"
+#include "tstamp.h"
+#include "tzone.h"
+#include "delayq.h"
+#include "streamop.h"
+#include "errstat.h"
 
 static const char *TAG = "EVENT_SYNC";
 
@@ -62,33 +68,58 @@ typedef struct {
     uint32_t stage;
     float processing_data[4];
     uint32_t quality_score;
-    uint64_t stage_timestamps[4];
+    ts_t injected_at;           // Generator hand-off (end-to-end latency)
+    ts_t handed_off_at;         // Last queue hand-off (wait between stages)
 } pipeline_data_t;
 
-typedef struct {
-    uint32_t workflow_id;
-    char description[32];
-    uint32_t priority;
-    uint32_t estimated_duration;
-    bool requires_approval;
-} workflow_item_t;
+// Workflow requests are workflow_msg_t from lab_messages.h; workflow_queue
+// carries the encoded workflow_msg_wire_t (description interned)
 
 // Queues สำหรับ data passing
 QueueHandle_t pipeline_queue;
 QueueHandle_t workflow_queue;
 
+// Failed workflows wait here (backing off) before going back on
+// workflow_queue - the manager moves on to the next request meanwhile
+#define WORKFLOW_MAX_RETRIES    3
+#define WORKFLOW_RETRY_BASE_MS  2000    // 2 s, 4 s, 8 s
+
+static dq_queue_t workflow_retry_queue;
+
 // Statistics
 typedef struct {
     uint32_t barrier_cycles;
     uint32_t pipeline_completions;
     uint32_t workflow_completions;
-    uint32_t synchronization_time_max;
-    uint32_t synchronization_time_avg;
-    uint64_t total_processing_time;
+    uint32_t workflow_retries;
+    uint32_t workflow_abandoned;
 } sync_stats_t;
 
 static sync_stats_t stats = {0};
 
+// Dropped hand-offs only count; the statistics monitor reports them. The
+// retry one fires in the esp_timer task, where a log line holds up every
+// other timer.
+ES_SITE(err_stage_full, "pipeline", "stage hand-off, queue full");
+ES_SITE(err_inject_full, "pipeline", "injection, queue full");
+ES_SITE(err_retry_full, "workflow", "retry, queue full");
+ES_SITE(err_workflow_full, "workflow", "new workflow, queue full");
+
+// Timing zones - barrier.cycle contains barrier.wait, so its self time is
+// the worker's own work; pipeline stages get service time per stage plus
+// the hand-off wait between stages and end-to-end latency
+TZ_DEFINE(zone_barrier_cycle, "barrier.cycle");
+TZ_DEFINE(zone_barrier_wait, "barrier.wait");
+TZ_DEFINE(zone_pipe_handoff, "pipe.handoff");
+TZ_DEFINE(zone_pipe_e2e, "pipe.end_to_end");
+
+static tz_zone_t zone_stage[4] = {
+    TZ_ZONE_INIT("pipe.stage", "Input"),
+    TZ_ZONE_INIT("pipe.stage", "Processing"),
+    TZ_ZONE_INIT("pipe.stage", "Filtering"),
+    TZ_ZONE_INIT("pipe.stage", "Output"),
+};
+
 // Barrier Synchronization Tasks
 void barrier_worker_task(void *pvParameters) {
     uint32_t worker_id = (uint32_t)pvParameters;
@@ -99,6 +130,7 @@ void barrier_worker_task(void *pvParameters) {
     
     while (1) {
         cycle++;
+        TZ_BEGIN(zone_barrier_cycle);
         
         // Phase 1: Independent work
         uint32_t work_duration = 1000 + (esp_random() % 3000); // 1-4 seconds
@@ -108,7 +140,7 @@ void barrier_worker_task(void *pvParameters) {
         vTaskDelay(pdMS_TO_TICKS(work_duration));
         
         // Phase 2: Signal ready for barrier
-        uint64_t barrier_start = esp_timer_get_time();
+        TZ_BEGIN(zone_barrier_wait);
         ESP_LOGI(TAG, "🚧 Worker %lu: Ready for barrier (cycle %lu)", worker_id, cycle);
         xEventGroupSetBits(barrier_events, my_ready_bit);
         
@@ -121,19 +153,10 @@ void barrier_worker_task(void *pvParameters) {
             pdMS_TO_TICKS(10000) // 10 second timeout
         );
         
-        uint64_t barrier_end = esp_timer_get_time();
-        uint32_t barrier_time = (barrier_end - barrier_start) / 1000; // Convert to ms
+        TZ_END(zone_barrier_wait);
         
         if ((bits & ALL_WORKERS_READY) == ALL_WORKERS_READY) {
-            ESP_LOGI(TAG, "🎯 Worker %lu: Barrier passed! (waited %lu ms)", 
-                     worker_id, barrier_time);
-            
-            // Update statistics
-            if (barrier_time > stats.synchronization_time_max) {
-                stats.synchronization_time_max = barrier_time;
-            }
-            stats.synchronization_time_avg = 
-                (stats.synchronization_time_avg + barrier_time) / 2;
+            ESP_LOGI(TAG, "🎯 Worker %lu: Barrier passed!", worker_id);
             
             if (worker_id == 0) { // Only count once per barrier
                 stats.barrier_cycles++;
@@ -152,9 +175,23 @@ void barrier_worker_task(void *pvParameters) {
         
         // Cool down period
         vTaskDelay(pdMS_TO_TICKS(2000));
+        TZ_END(zone_barrier_cycle);
     }
 }
 
+// Filtering stage windows: per-channel statistics over 15 s instead of
+// a log line per pipeline item (owned by the Filtering stage task)
+#define FILTER_WINDOW_MS    15000
+#define FILTER_LATENESS_MS  1000
+#define FILTER_CHANNELS     4
+
+static so_stream_t filter_windows;
+
+static void filter_window(const so_window_t *w, void *ctx) {
+    ESP_LOGI(TAG, "🔍 Channel %lu: avg %.2f ± %.2f (%.2f-%.2f) over %lu items",
+             w->key, w->mean, w->stddev, w->min, w->max, w->count);
+}
+
 // Pipeline Processing Tasks  
 void pipeline_stage_task(void *pvParameters) {
     uint32_t stage_id = (uint32_t)pvParameters;
@@ -188,8 +225,9 @@ void pipeline_stage_task(void *pvParameters) {
                 ESP_LOGI(TAG, "📦 Stage %lu: Processing pipeline ID %lu", 
                          stage_id, pipeline_data.pipeline_id);
                 
-                // Record processing start time
-                pipeline_data.stage_timestamps[stage_id] = esp_timer_get_time();
+                // Time spent waiting between the previous stage and this one
+                TZ_RECORD(zone_pipe_handoff, ts_us32(ts_now() - pipeline_data.handed_off_at));
+                TZ_BEGIN(zone_stage[stage_id]);
                 pipeline_data.stage = stage_id;
                 
                 // Simulate stage-specific processing
@@ -214,12 +252,14 @@ void pipeline_stage_task(void *pvParameters) {
                         
                     case 2: // Filtering stage
                         ESP_LOGI(TAG, "🔍 Stage %lu: Data filtering and validation", stage_id);
+                        uint32_t now_ms = (uint32_t)(esp_timer_get_time() / 1000);
                         float avg = 0;
-                        for (int i = 0; i < 4; i++) {
+                        for (int i = 0; i < FILTER_CHANNELS; i++) {
                             avg += pipeline_data.processing_data[i];
+                            so_push(&filter_windows, i, now_ms, pipeline_data.processing_data[i]);
                         }
-                        avg /= 4.0;
-                        ESP_LOGI(TAG, "Average value: %.2f, Quality: %lu", 
+                        avg /= FILTER_CHANNELS;
+                        ESP_LOGD(TAG, "Average value: %.2f, Quality: %lu", 
                                 avg, pipeline_data.quality_score);
                         break;
                         
@@ -227,25 +267,26 @@ void pipeline_stage_task(void *pvParameters) {
                         ESP_LOGI(TAG, "📤 Stage %lu: Data output and delivery", stage_id);
                         stats.pipeline_completions++;
                         
-                        uint64_t total_time = esp_timer_get_time() - 
-                                            pipeline_data.stage_timestamps[0];
-                        stats.total_processing_time += total_time;
+                        uint32_t total_time = ts_us32(ts_now() - pipeline_data.injected_at);
+                        TZ_RECORD(zone_pipe_e2e, total_time);
                         
-                        ESP_LOGI(TAG, "✅ Pipeline %lu completed in %llu ms (Quality: %lu)", 
+                        ESP_LOGI(TAG, "✅ Pipeline %lu completed in %lu ms (Quality: %lu)", 
                                 pipeline_data.pipeline_id, total_time / 1000, 
                                 pipeline_data.quality_score);
                         break;
                 }
                 
                 vTaskDelay(pdMS_TO_TICKS(processing_time));
+                TZ_END(zone_stage[stage_id]);
                 
                 // Pass data to next stage
                 if (stage_id < 3) {
+                    pipeline_data.handed_off_at = ts_now();
                     if (xQueueSend(pipeline_queue, &pipeline_data, pdMS_TO_TICKS(100)) == pdTRUE) {
                         xEventGroupSetBits(pipeline_events, stage_complete_bit);
                         ESP_LOGI(TAG, "➡️ Stage %lu: Data passed to next stage", stage_id);
                     } else {
-                        ESP_LOGW(TAG, "⚠️ Stage %lu: Queue full, data lost", stage_id);
+                        es_record(&err_stage_full, ESP_ERR_TIMEOUT, pipeline_data.pipeline_id);
                     }
                 }
                 
@@ -278,7 +319,8 @@ void pipeline_data_generator_task(void *pvParameters) {
         pipeline_data_t data = {0};
         data.pipeline_id = ++pipeline_id;
         data.stage = 0;
-        data.stage_timestamps[0] = esp_timer_get_time();
+        data.injected_at = ts_now();
+        data.handed_off_at = data.injected_at;
         
         ESP_LOGI(TAG, "🚀 Generating pipeline data ID: %lu", pipeline_id);
         
@@ -286,7 +328,7 @@ void pipeline_data_generator_task(void *pvParameters) {
             xEventGroupSetBits(pipeline_events, DATA_AVAILABLE_BIT);
             ESP_LOGI(TAG, "✅ Pipeline data %lu injected", pipeline_id);
         } else {
-            ESP_LOGW(TAG, "⚠️ Pipeline queue full, data %lu dropped", pipeline_id);
+            es_record(&err_inject_full, ESP_ERR_TIMEOUT, pipeline_id);
         }
         
         // Generate data at random intervals
@@ -296,14 +338,28 @@ void pipeline_data_generator_task(void *pvParameters) {
 }
 
 // Workflow Management Tasks
+
+// Delay-queue handler (esp_timer task): the retry is due
+static void requeue_workflow(void *item, void *arg) {
+    if (xQueueSend(workflow_queue, item, 0) != pdTRUE) {
+        stats.workflow_abandoned++;
+        es_record(&err_retry_full, ESP_ERR_TIMEOUT, stats.workflow_abandoned);
+    }
+}
+
 void workflow_manager_task(void *pvParameters) {
     ESP_LOGI(TAG, "📋 Workflow manager started");
     
     while (1) {
-        workflow_item_t workflow;
+        workflow_msg_wire_t wire;
+        workflow_msg_t workflow;
         
         // Wait for workflow requests
-        if (xQueueReceive(workflow_queue, &workflow, portMAX_DELAY) == pdTRUE) {
+        if (xQueueReceive(workflow_queue, &wire, portMAX_DELAY) == pdTRUE) {
+            if (workflow_msg_unpack(&wire, &workflow) != ESP_OK) {
+                ESP_LOGW(TAG, "⚠️ Malformed workflow request (%u bytes), skipped", wire.len);
+                continue;
+            }
             ESP_LOGI(TAG, "📝 New workflow: ID %lu - %s (Priority: %lu)", 
                      workflow.workflow_id, workflow.description, workflow.priority);
             
@@ -354,12 +410,25 @@ void workflow_manager_task(void *pvParameters) {
                     stats.workflow_completions++;
                     
                 } else {
-                    ESP_LOGW(TAG, "⚠️ Workflow %lu quality check failed (%lu%%), retrying...", 
-                             workflow.workflow_id, quality);
-                    
-                    // Re-queue for retry
-                    if (xQueueSend(workflow_queue, &workflow, 0) != pdTRUE) {
-                        ESP_LOGE(TAG, "❌ Failed to re-queue workflow %lu", workflow.workflow_id);
+                    if (workflow.retries >= WORKFLOW_MAX_RETRIES) {
+                        stats.workflow_abandoned++;
+                        ESP_LOGE(TAG, "❌ Workflow %lu quality check failed (%lu%%), giving up after %lu retries", 
+                                 workflow.workflow_id, quality, workflow.retries);
+                    } else {
+                        // Re-queue for retry with exponential backoff
+                        uint32_t backoff_ms = WORKFLOW_RETRY_BASE_MS << workflow.retries;
+                        workflow.retries++;
+                        MC_SET(workflow_msg, &workflow, retries);
+                        workflow_msg_pack(&workflow, &wire);
+                        ESP_LOGW(TAG, "⚠️ Workflow %lu quality check failed (%lu%%), retry %lu/%d in %lu ms", 
+                                 workflow.workflow_id, quality, workflow.retries, WORKFLOW_MAX_RETRIES, backoff_ms);
+                        
+                        if (dq_send_after(&workflow_retry_queue, &wire, backoff_ms) == DQ_NO_HANDLE) {
+                            stats.workflow_abandoned++;
+                            ESP_LOGE(TAG, "❌ Failed to schedule retry of workflow %lu", workflow.workflow_id);
+                        } else {
+                            stats.workflow_retries++;
+                        }
                     }
                 }
                 
@@ -451,26 +520,26 @@ void workflow_generator_task(void *pvParameters) {
     ESP_LOGI(TAG, "📋 Workflow generator started");
     
     while (1) {
-        workflow_item_t workflow = {0};
+        workflow_msg_t workflow = {0};
+        workflow_msg_wire_t wire;
         workflow.workflow_id = ++workflow_counter;
         workflow.priority = 1 + (esp_random() % 5); // Priority 1-5
         workflow.estimated_duration = 2000 + (esp_random() % 4000); // 2-6 seconds
         workflow.requires_approval = (esp_random() % 100) > 60; // 40% need approval
+        if (workflow.requires_approval) {
+            MC_SET(workflow_msg, &workflow, requires_approval);   // Optional field: sent only when set
+        }
         
-        // Generate workflow description
-        const char* workflow_types[] = {
-            "Data Processing", "Report Generation", "System Backup",
-            "Quality Analysis", "Performance Test", "Security Scan"
-        };
-        
-        strcpy(workflow.description, workflow_types[esp_random() % 6]);
+        // Generate workflow description (interned in lab_messages.c)
+        workflow.description = workflow_types.strings[esp_random() % workflow_types.count];
+        workflow_msg_pack(&workflow, &wire);
         
         ESP_LOGI(TAG, "🚀 Generated workflow: %s (ID: %lu, Priority: %lu, Approval: %s)", 
                  workflow.description, workflow.workflow_id, workflow.priority,
                  workflow.requires_approval ? "Required" : "Not Required");
         
-        if (xQueueSend(workflow_queue, &workflow, pdMS_TO_TICKS(1000)) != pdTRUE) {
-            ESP_LOGW(TAG, "⚠️ Workflow queue full, dropping workflow %lu", workflow.workflow_id);
+        if (xQueueSend(workflow_queue, &wire, pdMS_TO_TICKS(1000)) != pdTRUE) {
+            es_record(&err_workflow_full, ESP_ERR_TIMEOUT, workflow.workflow_id);
         }
         
         // Generate workflows at random intervals
@@ -482,6 +551,7 @@ void workflow_generator_task(void *pvParameters) {
 // Statistics and monitoring task
 void statistics_monitor_task(void *pvParameters) {
     ESP_LOGI(TAG, "📊 Statistics monitor started");
+    ts_t last_report = ts_now();
     
     while (1) {
         vTaskDelay(pdMS_TO_TICKS(15000)); // Report every 15 seconds
@@ -490,13 +560,19 @@ void statistics_monitor_task(void *pvParameters) {
         ESP_LOGI(TAG, "Barrier cycles:        %lu", stats.barrier_cycles);
         ESP_LOGI(TAG, "Pipeline completions:  %lu", stats.pipeline_completions);
         ESP_LOGI(TAG, "Workflow completions:  %lu", stats.workflow_completions);
-        ESP_LOGI(TAG, "Max sync time:         %lu ms", stats.synchronization_time_max);
-        ESP_LOGI(TAG, "Avg sync time:         %lu ms", stats.synchronization_time_avg);
+        ESP_LOGI(TAG, "Workflow retries:      %lu (%lu abandoned, %lu waiting)", 
+                 stats.workflow_retries, stats.workflow_abandoned, dq_pending(&workflow_retry_queue));
         
-        if (stats.pipeline_completions > 0) {
-            uint32_t avg_pipeline_time = (stats.total_processing_time / 1000) / 
-                                       stats.pipeline_completions;
-            ESP_LOGI(TAG, "Avg pipeline time:     %lu ms", avg_pipeline_time);
+        tz_stats_t t;
+        tz_get_stats(&zone_barrier_wait, &t);
+        if (t.calls > 0) {
+            ESP_LOGI(TAG, "Sync time:             avg %lu ms, p99 %lu ms", 
+                     t.avg_us / 1000, t.p99_us / 1000);
+        }
+        tz_get_stats(&zone_pipe_e2e, &t);
+        if (t.calls > 0) {
+            ESP_LOGI(TAG, "Pipeline time:         avg %lu ms, p99 %lu ms", 
+                     t.avg_us / 1000, t.p99_us / 1000);
         }
         
         ESP_LOGI(TAG, "Free heap:             %d bytes", esp_get_free_heap_size());
@@ -508,12 +584,24 @@ void statistics_monitor_task(void *pvParameters) {
         ESP_LOGI(TAG, "  Barrier events:   0x%08X", xEventGroupGetBits(barrier_events));
         ESP_LOGI(TAG, "  Pipeline events:  0x%08X", xEventGroupGetBits(pipeline_events));
         ESP_LOGI(TAG, "  Workflow events:  0x%08X", xEventGroupGetBits(workflow_events));
+        
+        // Latency breakdown since the last report
+        ESP_LOGI(TAG, "⏱️ Timing zones:");
+        ts_t now = ts_now();
+        tz_report(stdout, ts_us32(now - last_report));
+        last_report = now;
+        dq_report(stdout);
+        so_report(&filter_windows, stdout);
+        es_report_new(stdout, ES_REPORT_LINES, NULL, NULL);
     }
 }
 
 void app_main(void) {
     ESP_LOGI(TAG, "🚀 Event Synchronization Lab Starting...");
     
+    // Cycle-counter timestamps for the timing zones
+    ts_init();
+    
     // Configure GPIO
     gpio_set_direction(LED_BARRIER_SYNC, GPIO_MODE_OUTPUT);
     gpio_set_direction(LED_PIPELINE_STAGE1, GPIO_MODE_OUTPUT);
@@ -540,13 +628,19 @@ void app_main(void) {
     
     // Create Queues
     pipeline_queue = xQueueCreate(5, sizeof(pipeline_data_t));
-    workflow_queue = xQueueCreate(8, sizeof(workflow_item_t));
+    workflow_queue = xQueueCreate(8, sizeof(workflow_msg_wire_t));
+    
+    esp_err_t dq_err = dq_create(&workflow_retry_queue, "workflow_retry", 8,
+                                 sizeof(workflow_msg_wire_t), requeue_workflow, NULL);
     
-    if (!pipeline_queue || !workflow_queue) {
+    if (!pipeline_queue || !workflow_queue || dq_err != ESP_OK) {
         ESP_LOGE(TAG, "Failed to create queues!");
         return;
     }
     
+    so_config_t filter_cfg = { .size_ms = FILTER_WINDOW_MS, .lateness_ms = FILTER_LATENESS_MS };
+    so_init(&filter_windows, "filtering", &filter_cfg, filter_window, NULL);
+    
     ESP_LOGI(TAG, "Event groups and queues created successfully");
     
     // Create Barrier Synchronization Tasks
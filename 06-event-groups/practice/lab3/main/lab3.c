@@ -12,9 +12,28 @@
 #include "esp_random.h"
 #include "esp_timer.h"
 #include "driver/gpio.h"
+#include "cfgblob.h"
+#include "lab_config_schema.h"
+#include "pcprof.h"
+#include "tstamp.h"
+#include "critmode.h"
+#include "logtok.h"
+#include "ingest.h"
 
 static const char *TAG = "COMPLEX_EVENTS";
 
+// Sampling profiler: PCPROF report every 20 s, symbolize with
+//   python3 tools/pcprof/pcprof.py --elf build/lab3.elf --task PatternEngine monitor.log
+// 1 = sample while the lab runs (task names need
+// CONFIG_FREERTOS_USE_TRACE_FACILITY)
+#define PCPROF_ENABLE      0
+#define PCPROF_REPORT_MS   20000
+
+// Overload mode: ระหว่าง Emergency หรือเมื่อ CPU เต็ม งานที่ไม่สำคัญจะถูกพักไว้
+// (Learning/Monitor parked, LightControl/EnvSensors throttled, info logs off)
+// so PatternEngine and StateMachine keep their latency
+#define CRITMODE_ENABLE    1
+
 // GPIO สำหรับ Smart Home System
 #define LED_LIVING_ROOM    GPIO_NUM_2   // Living room light
 #define LED_KITCHEN        GPIO_NUM_4   // Kitchen light  
@@ -96,6 +115,8 @@ typedef struct {
 // Adaptive System Parameters
 typedef struct {
     float motion_sensitivity;
+    float sensitivity_min;
+    float sensitivity_max;
     uint32_t auto_light_timeout;
     uint32_t security_delay;
     bool learning_mode;
@@ -104,6 +125,8 @@ typedef struct {
 
 static adaptive_params_t adaptive_params = {
     .motion_sensitivity = 0.7,
+    .sensitivity_min = 0.3,
+    .sensitivity_max = 1.0,
     .auto_light_timeout = 300000,  // 5 minutes
     .security_delay = 30000,       // 30 seconds
     .learning_mode = true,
@@ -251,6 +274,13 @@ void change_home_state(home_state_t new_state) {
         ESP_LOGI(TAG, "🏠 State changed: %s → %s", 
                  get_state_name(old_state), get_state_name(new_state));
         
+#if CRITMODE_ENABLE
+        // Shed everything non-critical for the length of the emergency
+        if ((new_state == HOME_STATE_EMERGENCY) != (old_state == HOME_STATE_EMERGENCY)) {
+            crit_hold("emergency", new_state == HOME_STATE_EMERGENCY);
+        }
+#endif
+        
         xSemaphoreGive(state_mutex);
     }
 }
@@ -414,6 +444,7 @@ void door_sensor_task(void *pvParameters) {
 
 void light_control_task(void *pvParameters) {
     ESP_LOGI(TAG, "💡 Light control system started");
+    crit_task_t *crit = crit_task_register("LightControl", CRIT_MEDIUM);
     
     while (1) {
         // Simulate manual light operations
@@ -463,35 +494,150 @@ void light_control_task(void *pvParameters) {
             }
         }
         
-        vTaskDelay(pdMS_TO_TICKS(4000 + (esp_random() % 8000))); // 4-12 seconds
+        crit_delay(crit, 4000 + (esp_random() % 8000)); // 4-12 seconds
+    }
+}
+
+// ================ ENVIRONMENT SAMPLING ================
+// Temperature, light and sound are sampled streams, not events. The
+// EnvSensors and SoundSensor tasks read a block of samples every
+// SENSOR_READ_MS into their own ring (no lock, no log); the collector
+// merges them in time order every ENV_COLLECT_MS and raises sensor
+// events only when a threshold is crossed. Sample counters come out
+// with the status report.
+#define ENV_SAMPLE_HZ       40      // Temperature and light
+#define SOUND_SAMPLE_HZ     1000    // Microphone level
+#define SENSOR_READ_MS      50      // Stretched by critmode in overload
+#define ENV_RING            64      // 2 channels x 2 readings per read, with room
+#define SOUND_RING          256     // 50 readings per read
+#define ENV_COLLECT_MS      50
+#define ENV_HOLD_MS         (SENSOR_READ_MS + 10)
+
+#define TEMP_HIGH_C         28.0f
+#define TEMP_LOW_C          22.0f
+#define TEMP_HYSTERESIS_C   0.5f
+#define TEMP_SMOOTHING      0.05f   // EMA weight of a new reading
+#define SOUND_LEVEL_DB      70.0f
+#define SOUND_QUIET_MS      2000    // Below the level this long before the next event
+
+enum { CH_TEMPERATURE, CH_LIGHT, CH_SOUND };
+
+static ingest_t env_ingest;
+static ingest_sample_t env_samples[ENV_RING];
+static ingest_sample_t sound_samples[SOUND_RING];
+
+// Collector state (the Ingest task only)
+typedef struct {
+    bool started;
+    float temperature;              // Smoothed
+    int temp_zone;                  // -1 low, 0 normal, 1 high
+    bool sound_armed;
+    uint32_t last_loud_ms;
+} env_state_t;
+
+static env_state_t env_state = { .sound_armed = true };
+
+static void evaluate_environment(const ingest_sample_t *batch, uint32_t n, void *ctx) {
+    env_state_t *st = (env_state_t *)ctx;
+    for (uint32_t i = 0; i < n; i++) {
+        const ingest_sample_t *s = &batch[i];
+        switch (s->channel) {
+            case CH_TEMPERATURE: {
+                st->temperature = st->started ? st->temperature + TEMP_SMOOTHING * (s->value - st->temperature)
+                                              : s->value;
+                st->started = true;
+                home_status.temperature_celsius = (uint32_t)(st->temperature + 0.5f);
+                
+                int zone = st->temp_zone;
+                if (st->temperature > TEMP_HIGH_C) {
+                    zone = 1;
+                } else if (st->temperature < TEMP_LOW_C) {
+                    zone = -1;
+                } else if (st->temperature < TEMP_HIGH_C - TEMP_HYSTERESIS_C &&
+                           st->temperature > TEMP_LOW_C + TEMP_HYSTERESIS_C) {
+                    zone = 0;
+                }
+                if (zone != st->temp_zone && zone == 1) {
+                    ESP_LOGI(TAG, "🔥 High temperature detected: %.1f°C", st->temperature);
+                    xEventGroupSetBits(sensor_events, TEMPERATURE_HIGH_BIT);
+                } else if (zone != st->temp_zone && zone == -1) {
+                    ESP_LOGI(TAG, "🧊 Low temperature detected: %.1f°C", st->temperature);
+                    xEventGroupSetBits(sensor_events, TEMPERATURE_LOW_BIT);
+                }
+                st->temp_zone = zone;
+                break;
+            }
+            case CH_LIGHT:
+                home_status.light_level_percent = (uint32_t)s->value;
+                break;
+            case CH_SOUND:
+                if (s->value >= SOUND_LEVEL_DB) {
+                    if (st->sound_armed) {
+                        ESP_LOGI(TAG, "🔊 Sound detected (%.0f dB)", s->value);
+                        xEventGroupSetBits(sensor_events, SOUND_DETECTED_BIT);
+                        st->sound_armed = false;
+                    }
+                    st->last_loud_ms = s->t_ms;
+                } else if (!st->sound_armed && s->t_ms - st->last_loud_ms >= SOUND_QUIET_MS) {
+                    st->sound_armed = true;
+                }
+                break;
+        }
     }
 }
 
+// Samples of one read, spaced 1000 / rate_hz ms and ending now
+static uint32_t read_block_start(uint32_t rate_hz, uint32_t *spacing_ms) {
+    *spacing_ms = 1000 / rate_hz;
+    uint32_t readings = rate_hz * SENSOR_READ_MS / 1000;
+    return ingest_now_ms() - (readings - 1) * *spacing_ms;
+}
+
 void environmental_sensor_task(void *pvParameters) {
-    ESP_LOGI(TAG, "🌡️ Environmental sensors started");
+    ingest_ring_t *ring = (ingest_ring_t *)pvParameters;
+    ESP_LOGI(TAG, "🌡️ Environmental sensors started (%d Hz)", ENV_SAMPLE_HZ);
+    crit_task_t *crit = crit_task_register("EnvSensors", CRIT_MEDIUM);
     
+    // Temperature drifts slowly around the room's 20-35°C
+    float temperature = 25.0f;
+    float light = 50.0f;
     while (1) {
-        // Simulate temperature changes
-        home_status.temperature_celsius = 20 + (esp_random() % 15); // 20-35°C
-        
-        if (home_status.temperature_celsius > 28) {
-            ESP_LOGI(TAG, "🔥 High temperature detected: %d°C", home_status.temperature_celsius);
-            xEventGroupSetBits(sensor_events, TEMPERATURE_HIGH_BIT);
-        } else if (home_status.temperature_celsius < 22) {
-            ESP_LOGI(TAG, "🧊 Low temperature detected: %d°C", home_status.temperature_celsius);
-            xEventGroupSetBits(sensor_events, TEMPERATURE_LOW_BIT);
+        uint32_t spacing_ms;
+        uint32_t t_ms = read_block_start(ENV_SAMPLE_HZ, &spacing_ms);
+        for (uint32_t i = 0; i < ENV_SAMPLE_HZ * SENSOR_READ_MS / 1000; i++, t_ms += spacing_ms) {
+            temperature += ((int)(esp_random() % 201) - 100) / 1000.0f;
+            temperature = fminf(fmaxf(temperature, 20.0f), 35.0f);
+            light += ((int)(esp_random() % 21) - 10) / 10.0f;
+            light = fminf(fmaxf(light, 0.0f), 100.0f);
+            ingest_put(ring, t_ms, CH_TEMPERATURE, temperature + ((int)(esp_random() % 41) - 20) / 100.0f);
+            ingest_put(ring, t_ms, CH_LIGHT, light);
         }
-        
-        // Simulate sound detection
-        if ((esp_random() % 100) < 5) { // 5% chance
-            ESP_LOGI(TAG, "🔊 Sound detected");
-            xEventGroupSetBits(sensor_events, SOUND_DETECTED_BIT);
+        crit_delay(crit, SENSOR_READ_MS);
+    }
+}
+
+void sound_sensor_task(void *pvParameters) {
+    ingest_ring_t *ring = (ingest_ring_t *)pvParameters;
+    ESP_LOGI(TAG, "🎤 Sound sensor started (%d Hz)", SOUND_SAMPLE_HZ);
+    crit_task_t *crit = crit_task_register("SoundSensor", CRIT_MEDIUM);
+    
+    // Background around 40 dB; now and then (~5% of seconds) a 200 ms
+    // noise burst
+    uint32_t burst_left = 0;
+    while (1) {
+        uint32_t spacing_ms;
+        uint32_t t_ms = read_block_start(SOUND_SAMPLE_HZ, &spacing_ms);
+        for (uint32_t i = 0; i < SOUND_SAMPLE_HZ * SENSOR_READ_MS / 1000; i++, t_ms += spacing_ms) {
+            if (burst_left == 0 && esp_random() % (20 * SOUND_SAMPLE_HZ) == 0) {
+                burst_left = SOUND_SAMPLE_HZ / 5;
+            }
+            float level = (burst_left > 0 ? 75.0f : 40.0f) + (esp_random() % 100) / 10.0f;
+            if (burst_left > 0) {
+                burst_left--;
+            }
+            ingest_put(ring, t_ms, CH_SOUND, level);
         }
-        
-        // Update light level
-        home_status.light_level_percent = esp_random() % 100;
-        
-        vTaskDelay(pdMS_TO_TICKS(8000 + (esp_random() % 7000))); // 8-15 seconds
+        crit_delay(crit, SENSOR_READ_MS);
     }
 }
 
@@ -570,12 +716,59 @@ void state_machine_task(void *pvParameters) {
     }
 }
 
+// Seed adaptive parameters from the "config" partition (tools/cfgblob)
+static void load_adaptive_config(void) {
+    const cfgblob_header_t *blob;
+    esp_err_t err = cfgblob_open_partition(LAB_CONFIG_PARTITION, &blob);
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "⚠️ No configuration blob (%s) - using built-in parameters",
+                 esp_err_to_name(err));
+        return;
+    }
+    
+    const cfg_adaptive_t defaults = {
+        .motion_sensitivity = adaptive_params.motion_sensitivity,
+        .sensitivity_min = adaptive_params.sensitivity_min,
+        .sensitivity_max = adaptive_params.sensitivity_max,
+        .auto_light_timeout_ms = adaptive_params.auto_light_timeout,
+        .security_delay_ms = adaptive_params.security_delay,
+        .learning_mode = adaptive_params.learning_mode,
+    };
+    cfg_adaptive_t scratch;
+    const cfg_adaptive_t *cfg = CFGBLOB_SECTION(blob, CFG_SECTION_ADAPTIVE, cfg_adaptive_t,
+                                                &defaults, &scratch);
+    
+    // Same limits cfgc.py enforces; written so that NaN fails them too
+    bool valid = cfg->sensitivity_min >= 0.0f && cfg->sensitivity_max <= 1.0f &&
+                 cfg->motion_sensitivity >= cfg->sensitivity_min &&
+                 cfg->motion_sensitivity <= cfg->sensitivity_max &&
+                 cfg->auto_light_timeout_ms >= CFG_MS_MIN && cfg->auto_light_timeout_ms <= CFG_MS_MAX &&
+                 cfg->security_delay_ms >= CFG_MS_MIN && cfg->security_delay_ms <= CFG_MS_MAX;
+    if (!valid) {
+        ESP_LOGW(TAG, "⚠️ Adaptive config out of range - using built-in parameters");
+        return;
+    }
+    
+    // ค่าใน blob เป็นแค่จุดเริ่มต้น - learning task ยังปรับ sensitivity ต่อได้
+    adaptive_params.motion_sensitivity = cfg->motion_sensitivity;
+    adaptive_params.sensitivity_min = cfg->sensitivity_min;
+    adaptive_params.sensitivity_max = cfg->sensitivity_max;
+    adaptive_params.auto_light_timeout = cfg->auto_light_timeout_ms;
+    adaptive_params.security_delay = cfg->security_delay_ms;
+    adaptive_params.learning_mode = cfg->learning_mode;
+    
+    ESP_LOGI(TAG, "⚙️ Adaptive config loaded: sensitivity %.2f (%.2f-%.2f), learning %s",
+             adaptive_params.motion_sensitivity, adaptive_params.sensitivity_min,
+             adaptive_params.sensitivity_max, adaptive_params.learning_mode ? "ON" : "OFF");
+}
+
 // Adaptive Learning Task
 void adaptive_learning_task(void *pvParameters) {
     ESP_LOGI(TAG, "🧠 Adaptive learning system started");
+    crit_task_t *crit = crit_task_register("Learning", CRIT_LOW);
     
     while (1) {
-        vTaskDelay(pdMS_TO_TICKS(30000)); // Update every 30 seconds
+        crit_delay(crit, 30000); // Update every 30 seconds
         
         if (adaptive_params.learning_mode) {
             ESP_LOGI(TAG, "📊 Learning from patterns...");
@@ -620,10 +813,10 @@ void adaptive_learning_task(void *pvParameters) {
             }
             
             // Keep sensitivity in reasonable bounds
-            if (adaptive_params.motion_sensitivity > 1.0) {
-                adaptive_params.motion_sensitivity = 1.0;
-            } else if (adaptive_params.motion_sensitivity < 0.3) {
-                adaptive_params.motion_sensitivity = 0.3;
+            if (adaptive_params.motion_sensitivity > adaptive_params.sensitivity_max) {
+                adaptive_params.motion_sensitivity = adaptive_params.sensitivity_max;
+            } else if (adaptive_params.motion_sensitivity < adaptive_params.sensitivity_min) {
+                adaptive_params.motion_sensitivity = adaptive_params.sensitivity_min;
             }
         }
     }
@@ -632,41 +825,47 @@ void adaptive_learning_task(void *pvParameters) {
 // System Status and Monitoring
 void status_monitor_task(void *pvParameters) {
     ESP_LOGI(TAG, "📊 Status monitor started");
+    crit_task_t *crit = crit_task_register("Monitor", CRIT_LOW);
     
     while (1) {
-        vTaskDelay(pdMS_TO_TICKS(20000)); // Report every 20 seconds
+        crit_delay(crit, 20000); // Report every 20 seconds
         
-        ESP_LOGI(TAG, "\n🏠 ═══ SMART HOME STATUS ═══");
-        ESP_LOGI(TAG, "Current State:     %s", get_state_name(current_home_state));
-        ESP_LOGI(TAG, "Living Room:       %s", home_status.living_room_light ? "ON" : "OFF");
-        ESP_LOGI(TAG, "Kitchen:           %s", home_status.kitchen_light ? "ON" : "OFF");
-        ESP_LOGI(TAG, "Bedroom:           %s", home_status.bedroom_light ? "ON" : "OFF");
-        ESP_LOGI(TAG, "Security:          %s", home_status.security_system ? "ARMED" : "DISARMED");
-        ESP_LOGI(TAG, "Emergency:         %s", home_status.emergency_mode ? "ACTIVE" : "NORMAL");
-        ESP_LOGI(TAG, "Temperature:       %d°C", home_status.temperature_celsius);
-        ESP_LOGI(TAG, "Light Level:       %d%%", home_status.light_level_percent);
+        TLOGI(TAG, "\n🏠 ═══ SMART HOME STATUS ═══");
+        TLOGI(TAG, "Current State:     %s", get_state_name(current_home_state));
+        TLOGI(TAG, "Living Room:       %s", home_status.living_room_light ? "ON" : "OFF");
+        TLOGI(TAG, "Kitchen:           %s", home_status.kitchen_light ? "ON" : "OFF");
+        TLOGI(TAG, "Bedroom:           %s", home_status.bedroom_light ? "ON" : "OFF");
+        TLOGI(TAG, "Security:          %s", home_status.security_system ? "ARMED" : "DISARMED");
+        TLOGI(TAG, "Emergency:         %s", home_status.emergency_mode ? "ACTIVE" : "NORMAL");
+        TLOGI(TAG, "Temperature:       %d°C", home_status.temperature_celsius);
+        TLOGI(TAG, "Light Level:       %d%%", home_status.light_level_percent);
         
-        ESP_LOGI(TAG, "\n📊 Event Group Status:");
-        ESP_LOGI(TAG, "Sensor Events:     0x%08X", xEventGroupGetBits(sensor_events));
-        ESP_LOGI(TAG, "System Events:     0x%08X", xEventGroupGetBits(system_events));
-        ESP_LOGI(TAG, "Pattern Events:    0x%08X", xEventGroupGetBits(pattern_events));
+        TLOGI(TAG, "\n📊 Event Group Status:");
+        TLOGI(TAG, "Sensor Events:     0x%08X", xEventGroupGetBits(sensor_events));
+        TLOGI(TAG, "System Events:     0x%08X", xEventGroupGetBits(system_events));
+        TLOGI(TAG, "Pattern Events:    0x%08X", xEventGroupGetBits(pattern_events));
         
-        ESP_LOGI(TAG, "\n🧠 Adaptive Parameters:");
-        ESP_LOGI(TAG, "Motion Sensitivity: %.2f", adaptive_params.motion_sensitivity);
-        ESP_LOGI(TAG, "Light Timeout:      %lu ms", adaptive_params.auto_light_timeout);
-        ESP_LOGI(TAG, "Security Delay:     %lu ms", adaptive_params.security_delay);
-        ESP_LOGI(TAG, "Learning Mode:      %s", adaptive_params.learning_mode ? "ON" : "OFF");
+        TLOGI(TAG, "\n🧠 Adaptive Parameters:");
+        TLOGI(TAG, "Motion Sensitivity: %.2f", adaptive_params.motion_sensitivity);
+        TLOGI(TAG, "Light Timeout:      %lu ms", adaptive_params.auto_light_timeout);
+        TLOGI(TAG, "Security Delay:     %lu ms", adaptive_params.security_delay);
+        TLOGI(TAG, "Learning Mode:      %s", adaptive_params.learning_mode ? "ON" : "OFF");
         
-        ESP_LOGI(TAG, "\n📈 Pattern Confidence:");
+        TLOGI(TAG, "\n📈 Pattern Confidence:");
         for (int i = 0; i < NUM_PATTERNS; i++) {
             if (adaptive_params.pattern_confidence[i] > 0) {
-                ESP_LOGI(TAG, "  %s: %lu", event_patterns[i].name, 
+                TLOGI(TAG, "  %s: %lu", event_patterns[i].name, 
                         adaptive_params.pattern_confidence[i]);
             }
         }
         
-        ESP_LOGI(TAG, "Free Heap:         %d bytes", esp_get_free_heap_size());
-        ESP_LOGI(TAG, "════════════════════════════════════════\n");
+        TLOGI(TAG, "Free Heap:         %d bytes", esp_get_free_heap_size());
+        TLOGI(TAG, "════════════════════════════════════════\n");
+        logtok_report(stdout);
+        ingest_report(&env_ingest, ingest_now_ms(), stdout);
+#if CRITMODE_ENABLE
+        crit_report(stdout);
+#endif
     }
 }
 
@@ -706,6 +905,16 @@ void app_main(void) {
     
     ESP_LOGI(TAG, "Event groups created successfully");
     
+    load_adaptive_config();
+    
+#if CRITMODE_ENABLE
+    // Before the tasks: they register themselves as they start
+    ts_init();
+    if (crit_init(NULL) == ESP_OK) {
+        crit_log_tag(TAG);
+    }
+#endif
+    
     // Initialize system
     xEventGroupSetBits(system_events, SYSTEM_INIT_BIT);
     change_home_state(HOME_STATE_IDLE);
@@ -723,10 +932,26 @@ void app_main(void) {
     xTaskCreate(motion_sensor_task, "MotionSensor", 2048, NULL, 6, NULL);
     xTaskCreate(door_sensor_task, "DoorSensor", 2048, NULL, 6, NULL);
     xTaskCreate(light_control_task, "LightControl", 2048, NULL, 6, NULL);
-    xTaskCreate(environmental_sensor_task, "EnvSensors", 2048, NULL, 5, NULL);
+    
+    // Sampled sensors: a ring each, merged by one collector
+    ESP_ERROR_CHECK(ingest_init(&env_ingest, "environment", ENV_HOLD_MS, evaluate_environment, &env_state));
+    ingest_ring_t *env_ring = ingest_producer(&env_ingest, "EnvSensors", env_samples, ENV_RING);
+    ingest_ring_t *sound_ring = ingest_producer(&env_ingest, "SoundSensor", sound_samples, SOUND_RING);
+    configASSERT(env_ring != NULL && sound_ring != NULL);
+    xTaskCreate(environmental_sensor_task, "EnvSensors", 2048, env_ring, 5, NULL);
+    xTaskCreate(sound_sensor_task, "SoundSensor", 2048, sound_ring, 5, NULL);
+    ESP_ERROR_CHECK(ingest_start(&env_ingest, ENV_COLLECT_MS, 5));
     
     ESP_LOGI(TAG, "All tasks created successfully");
     
+#if PCPROF_ENABLE
+    pcprof_config_t prof_cfg = PCPROF_CONFIG_DEFAULT();
+    prof_cfg.report_ms = PCPROF_REPORT_MS;
+    if (pcprof_start(&prof_cfg) == ESP_OK) {
+        ESP_LOGI(TAG, "🔬 Profiler sampling (hotspots in PCPROF reports)");
+    }
+#endif
+    
     ESP_LOGI(TAG, "\n🎯 Smart Home LED Indicators:");
     ESP_LOGI(TAG, "  GPIO2  - Living Room Light");
     ESP_LOGI(TAG, "  GPIO4  - Kitchen Light");
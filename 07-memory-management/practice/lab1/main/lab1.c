@@ -12,6 +12,9 @@
 #include "esp_system.h"
 #include "driver/gpio.h"
 #include "esp_random.h"
+#include "integrity.h"
+#include "memacct.h"
+#include "memtrend.h"
 
 static const char *TAG = "HEAP_MGMT";
 
@@ -28,6 +31,17 @@ static const char *TAG = "HEAP_MGMT";
 #define FRAGMENTATION_THRESHOLD 0.3      // 30% fragmentation
 #define MAX_ALLOCATIONS         100
 
+// Per-task quotas (bytes, MA_NO_QUOTA = none)
+#define STRESS_SOFT_QUOTA       16384    // 20 x 100-2100 B averages ~22 KB
+#define STRESS_HARD_QUOTA       32768
+#define POOL_SOFT_QUOTA         16384    // One pool cycle holds ~19.8 KB
+#define LARGE_HARD_QUOTA        120000   // Caps the 50-150 KB requests
+
+// Trend forecasting
+#define MONITOR_PERIOD_S        10
+#define LARGEST_BLOCK_LIMIT     8192     // Fragmentation creep: no 8 KB block left
+#define TREND_HORIZON_S         (7 * 24 * 3600)  // Warn a week ahead
+
 // Memory allocation tracking
 typedef struct {
     void* ptr;
@@ -57,6 +71,21 @@ static memory_stats_t stats = {0};
 static SemaphoreHandle_t memory_mutex;
 static bool memory_monitoring_enabled = true;
 
+// Trend series per region: free, largest block, minimum-ever free
+typedef struct {
+    const char *region;
+    uint32_t caps;
+    mt_series_t free;
+    mt_series_t largest;
+    mt_series_t min_free;
+} region_trend_t;
+
+static region_trend_t trends[] = {
+    { .region = "internal", .caps = MALLOC_CAP_INTERNAL },
+    { .region = "spiram",   .caps = MALLOC_CAP_SPIRAM },
+};
+#define TREND_REGIONS (sizeof(trends) / sizeof(trends[0]))
+
 // Memory monitoring functions
 int find_free_allocation_slot(void) {
     for (int i = 0; i < MAX_ALLOCATIONS; i++) {
@@ -77,7 +106,8 @@ int find_allocation_by_ptr(void* ptr) {
 }
 
 void* tracked_malloc(size_t size, uint32_t caps, const char* description) {
-    void* ptr = heap_caps_malloc(size, caps);
+    // Charged to the calling task; NULL also when its hard quota refuses
+    void* ptr = ma_malloc(size, caps);
     
     if (memory_monitoring_enabled && memory_mutex) {
         if (xSemaphoreTake(memory_mutex, pdMS_TO_TICKS(100)) == pdTRUE) {
@@ -140,7 +170,27 @@ void tracked_free(void* ptr, const char* description) {
         }
     }
     
-    heap_caps_free(ptr);
+    ma_free(ptr);
+}
+
+// Quota breaches, reported from the allocating task
+static void quota_breach(const ma_breach_t *b, void *ctx) {
+    if (b->kind == MA_BREACH_HARD) {
+        ESP_LOGE(TAG, "⛔ %s: %lu bytes refused (holds %lu, hard quota %lu)",
+                 b->task, b->request, b->current, b->quota);
+    } else {
+        ESP_LOGW(TAG, "⚠️ %s: over soft quota %lu (holds %lu + %lu bytes)",
+                 b->task, b->quota, b->current, b->request);
+    }
+}
+
+// Who holds the memory when it runs low
+static void log_top_consumer(void) {
+    ma_account_t top;
+    if (ma_snapshot(&top, 1) == 1) {
+        ESP_LOGW(TAG, "   Top consumer: %s with %lu bytes (peak %lu)",
+                 top.name, top.current, top.peak);
+    }
 }
 
 // Memory analysis functions
@@ -171,12 +221,14 @@ void analyze_memory_status(void) {
         gpio_set_level(LED_MEMORY_OK, 0);
         stats.low_memory_events++;
         ESP_LOGW(TAG, "🚨 CRITICAL: Very low memory!");
+        log_top_consumer();
     } else if (internal_free < LOW_MEMORY_THRESHOLD) {
         gpio_set_level(LED_LOW_MEMORY, 1);
         gpio_set_level(LED_MEMORY_ERROR, 0);
         gpio_set_level(LED_MEMORY_OK, 0);
         stats.low_memory_events++;
         ESP_LOGW(TAG, "⚠️ WARNING: Low memory");
+        log_top_consumer();
     } else {
         gpio_set_level(LED_MEMORY_OK, 1);
         gpio_set_level(LED_LOW_MEMORY, 0);
@@ -268,8 +320,14 @@ void detect_memory_leaks(void) {
     }
 }
 
-// Test tasks
+// Test tasks start at higher priority than app_main; each one waits
+// here until its quota is in place, so no allocation escapes it
+static void wait_for_quota(void) {
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+}
+
 void memory_stress_test_task(void *pvParameters) {
+    wait_for_quota();
     ESP_LOGI(TAG, "🧪 Memory stress test started");
     
     void* test_ptrs[20] = {NULL};
@@ -316,6 +374,7 @@ void memory_stress_test_task(void *pvParameters) {
 }
 
 void memory_pool_test_task(void *pvParameters) {
+    wait_for_quota();
     ESP_LOGI(TAG, "🏊 Memory pool test started");
     
     // Create different sized allocations to test fragmentation
@@ -334,7 +393,7 @@ void memory_pool_test_task(void *pvParameters) {
                                                    MALLOC_CAP_INTERNAL, desc);
                 if (pools[size_idx][i]) {
                     // Initialize with pattern
-                    memset(pools[size_idx][i], 0x55 + size_idx, pool_sizes[size_idx]);
+                    integrity_fill8(pools[size_idx][i], 0x55 + size_idx, pool_sizes[size_idx]);
                 }
             }
         }
@@ -346,6 +405,13 @@ void memory_pool_test_task(void *pvParameters) {
         for (int size_idx = num_pools - 1; size_idx >= 0; size_idx--) {
             for (int i = 9; i >= 0; i--) {
                 if (pools[size_idx][i]) {
+                    size_t bad_offset;
+                    if (!integrity_verify8(pools[size_idx][i], 0x55 + size_idx,
+                                           pool_sizes[size_idx], &bad_offset)) {
+                        ESP_LOGE(TAG, "🚨 Pool%d_%d pattern corrupted at offset %u!",
+                                 size_idx, i, (unsigned)bad_offset);
+                        gpio_set_level(LED_MEMORY_ERROR, 1);
+                    }
                     tracked_free(pools[size_idx][i], "Pool");
                     pools[size_idx][i] = NULL;
                 }
@@ -358,6 +424,7 @@ void memory_pool_test_task(void *pvParameters) {
 }
 
 void large_allocation_test_task(void *pvParameters) {
+    wait_for_quota();
     ESP_LOGI(TAG, "🐘 Large allocation test started");
     
     while (1) {
@@ -399,15 +466,55 @@ void large_allocation_test_task(void *pvParameters) {
     }
 }
 
+static void trend_warning(const mt_series_t *s, const mt_forecast_t *f, void *ctx) {
+    char tte[16];
+    mt_format_duration(f->tte_s, tte, sizeof(tte));
+    if (f->warning) {
+        ESP_LOGW(TAG, "📉 Trend: %s %s reaches %.0f in ~%s (%+.0f bytes/h)",
+                 s->region, s->name, s->limit, tte, f->slope_robust);
+    } else {
+        ESP_LOGI(TAG, "📈 Trend: %s %s no longer heading for %.0f", s->region, s->name, s->limit);
+    }
+}
+
+void init_memory_trends(void) {
+    for (int i = 0; i < TREND_REGIONS; i++) {
+        region_trend_t *r = &trends[i];
+        mt_series_init(&r->free, "free", r->region, MT_FALLING,
+                       CRITICAL_MEMORY_THRESHOLD, MONITOR_PERIOD_S, TREND_HORIZON_S);
+        mt_series_init(&r->largest, "largest", r->region, MT_FALLING,
+                       LARGEST_BLOCK_LIMIT, MONITOR_PERIOD_S, TREND_HORIZON_S);
+        mt_series_init(&r->min_free, "min_free", r->region, MT_FALLING,
+                       CRITICAL_MEMORY_THRESHOLD, MONITOR_PERIOD_S, TREND_HORIZON_S);
+    }
+    mt_set_warning_handler(trend_warning, NULL);
+}
+
+// Sample every region that exists (no SPIRAM: nothing recorded for it)
+void record_memory_trends(void) {
+    for (int i = 0; i < TREND_REGIONS; i++) {
+        region_trend_t *r = &trends[i];
+        if (heap_caps_get_total_size(r->caps) == 0) {
+            continue;
+        }
+        mt_record(&r->free, heap_caps_get_free_size(r->caps));
+        mt_record(&r->largest, heap_caps_get_largest_free_block(r->caps));
+        mt_record(&r->min_free, heap_caps_get_minimum_free_size(r->caps));
+    }
+}
+
 void memory_monitor_task(void *pvParameters) {
     ESP_LOGI(TAG, "📊 Memory monitor started");
     
     while (1) {
-        vTaskDelay(pdMS_TO_TICKS(10000)); // Check every 10 seconds
+        vTaskDelay(pdMS_TO_TICKS(MONITOR_PERIOD_S * 1000)); // Check every 10 seconds
         
         analyze_memory_status();
+        record_memory_trends();
         print_allocation_summary();
         detect_memory_leaks();
+        ma_report(stdout);
+        mt_report(stdout);
         
         // Check heap integrity
         if (!heap_caps_check_integrity_all(true)) {
@@ -470,9 +577,28 @@ void heap_integrity_test_task(void *pvParameters) {
             }
             
             uint64_t read_time = esp_timer_get_time() - start;
+            start = esp_timer_get_time();
+            
+            // Integrity scan test (CRC32 + word-wide pattern verify)
+            for (int i = 0; i < 100; i++) {
+                integrity_crc32(0, test_buf, test_size);
+            }
+            
+            uint64_t crc_time = esp_timer_get_time() - start;
+            start = esp_timer_get_time();
+            
+            integrity_fill8(test_buf, 0x5A, test_size);
+            bool verify_ok = true;
+            for (int i = 0; i < 100; i++) {
+                verify_ok &= integrity_verify8(test_buf, 0x5A, test_size, NULL);
+            }
+            
+            uint64_t verify_time = esp_timer_get_time() - start;
             
             ESP_LOGI(TAG, "🔍 Performance: Write %llu μs, Read %llu μs", 
                      write_time, read_time);
+            ESP_LOGI(TAG, "🔍 Integrity: CRC32 %llu μs, Verify %llu μs (%s)",
+                     crc_time, verify_time, verify_ok ? "OK" : "MISMATCH");
             
             tracked_free(test_buf, "PerfTest");
         }
@@ -505,6 +631,7 @@ void app_main(void) {
     
     // Initialize allocation tracking
     memset(allocations, 0, sizeof(allocations));
+    init_memory_trends();
     
     ESP_LOGI(TAG, "Memory tracking system initialized");
     
@@ -523,12 +650,23 @@ void app_main(void) {
     // Create test tasks
     ESP_LOGI(TAG, "Creating memory test tasks...");
     
-    xTaskCreate(memory_monitor_task, "MemMonitor", 4096, NULL, 6, NULL);
-    xTaskCreate(memory_stress_test_task, "StressTest", 3072, NULL, 5, NULL);
-    xTaskCreate(memory_pool_test_task, "PoolTest", 3072, NULL, 5, NULL);
-    xTaskCreate(large_allocation_test_task, "LargeAlloc", 2048, NULL, 4, NULL);
+    TaskHandle_t stress_task, pool_task, large_task;
+    ma_set_breach_handler(quota_breach, NULL);
+    
+    // Trend fits take ~1 KB of stack on top of the reports
+    xTaskCreate(memory_monitor_task, "MemMonitor", 5120, NULL, 6, NULL);
+    xTaskCreate(memory_stress_test_task, "StressTest", 3072, NULL, 5, &stress_task);
+    xTaskCreate(memory_pool_test_task, "PoolTest", 3072, NULL, 5, &pool_task);
+    xTaskCreate(large_allocation_test_task, "LargeAlloc", 2048, NULL, 4, &large_task);
     xTaskCreate(heap_integrity_test_task, "IntegrityTest", 3072, NULL, 3, NULL);
     
+    ma_set_quota(stress_task, STRESS_SOFT_QUOTA, STRESS_HARD_QUOTA);
+    ma_set_quota(pool_task, POOL_SOFT_QUOTA, MA_NO_QUOTA);
+    ma_set_quota(large_task, MA_NO_QUOTA, LARGE_HARD_QUOTA);
+    xTaskNotifyGive(stress_task);
+    xTaskNotifyGive(pool_task);
+    xTaskNotifyGive(large_task);
+    
     ESP_LOGI(TAG, "All tasks created successfully");
     
     ESP_LOGI(TAG, "\n🎯 LED Indicators:");
@@ -545,6 +683,8 @@ void app_main(void) {
     ESP_LOGI(TAG, "  • Fragmentation Analysis");
     ESP_LOGI(TAG, "  • Heap Integrity Checking");
     ESP_LOGI(TAG, "  • Memory Performance Testing");
+    ESP_LOGI(TAG, "  • Per-task Accounting and Quotas");
+    ESP_LOGI(TAG, "  • Memory Trends and Time-to-Exhaustion");
     
     ESP_LOGI(TAG, "Heap Management System operational!");
 }
\ No newline at end of file
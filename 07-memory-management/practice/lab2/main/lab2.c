@@ -12,6 +12,16 @@
 #include "esp_system.h"
 #include "driver/gpio.h"
 #include "esp_random.h"
+#include "integrity.h"
+#include "cfgblob.h"
+#include "lab_config_schema.h"
+#include "tstamp.h"
+#include "tzone.h"
+#include "logtok.h"
+#include "memacct.h"
+#include "memtrend.h"
+#include "agecensus.h"
+#include "errstat.h"
 
 static const char *TAG = "MEM_POOLS";
 
@@ -22,6 +32,15 @@ static const char *TAG = "MEM_POOLS";
 #define LED_POOL_FULL      GPIO_NUM_18  // Pool exhaustion
 #define LED_POOL_ERROR     GPIO_NUM_19  // Pool error/corruption
 
+// Trend forecasting
+#define POOL_MONITOR_PERIOD_S   15
+#define HEAP_FREE_LIMIT         20000        // Heap fallback running dry
+#define TREND_HORIZON_S         (7 * 24 * 3600)  // Warn a week ahead
+
+// Error paths only count (errstat); the reporter task prints and sets the LEDs
+#define ERROR_REPORT_PERIOD_MS  1000
+#define ERROR_REPORT_PRIORITY   2
+
 // Memory pool configurations
 #define SMALL_POOL_BLOCK_SIZE   64
 #define SMALL_POOL_BLOCK_COUNT  32
@@ -40,6 +59,7 @@ typedef struct memory_block {
     struct memory_block* next;
     uint32_t magic;        // For corruption detection
     uint32_t pool_id;      // Which pool this block belongs to
+    uint32_t owner;        // memacct account charged for it
     uint64_t alloc_time;   // When was this allocated
 } memory_block_t;
 
@@ -60,10 +80,20 @@ typedef struct {
     size_t peak_usage;
     uint64_t total_allocations;
     uint64_t total_deallocations;
-    uint64_t allocation_time_total;
-    uint64_t deallocation_time_total;
     uint32_t allocation_failures;
     
+    // Timing zones (latency histograms) for pool_malloc / pool_free
+    tz_zone_t alloc_zone;
+    tz_zone_t free_zone;
+    
+    // Occupancy history and time-to-exhaustion forecast
+    mt_series_t occupancy_trend;
+    
+    // Error sites, recorded under the mutex - counters only
+    es_site_t corrupt_site;     // Free list handed out a bad header
+    es_site_t exhausted_site;
+    es_site_t bad_free_site;    // Pool block without a live header
+    
     // Synchronization
     SemaphoreHandle_t mutex;
     
@@ -93,13 +123,56 @@ typedef struct {
     gpio_num_t led_pin;
 } pool_config_t;
 
-static const pool_config_t pool_configs[POOL_COUNT] = {
+// ค่า default - ถ้ามี blob บน partition "config" จะถูกแทนที่ด้วย load_pool_config()
+static pool_config_t pool_configs[POOL_COUNT] = {
     {"Small",  SMALL_POOL_BLOCK_SIZE,  SMALL_POOL_BLOCK_COUNT,  MALLOC_CAP_INTERNAL, LED_SMALL_POOL},
     {"Medium", MEDIUM_POOL_BLOCK_SIZE, MEDIUM_POOL_BLOCK_COUNT, MALLOC_CAP_INTERNAL, LED_MEDIUM_POOL},
     {"Large",  LARGE_POOL_BLOCK_SIZE,  LARGE_POOL_BLOCK_COUNT,  MALLOC_CAP_DEFAULT,  LED_LARGE_POOL},
     {"Huge",   HUGE_POOL_BLOCK_SIZE,   HUGE_POOL_BLOCK_COUNT,   MALLOC_CAP_SPIRAM,   LED_POOL_FULL}
 };
 
+// Override pool geometry from the POOLS section of the config blob.
+// Names point straight into the mapped blob; LED pins stay compile-time.
+static void load_pool_config(void) {
+    const cfgblob_header_t *blob;
+    esp_err_t err = cfgblob_open_partition(LAB_CONFIG_PARTITION, &blob);
+    if (err != ESP_OK) {
+        ESP_LOGI(TAG, "No configuration blob (%s) - using built-in pool sizes",
+                 esp_err_to_name(err));
+        return;
+    }
+    
+    const cfg_pools_t *cfg = cfgblob_find(blob, CFG_SECTION_POOLS, NULL, NULL);
+    if (cfg == NULL) {
+        return;
+    }
+    
+    const cfg_pool_entry_t *entries = cfgblob_array(blob, cfg->pools, sizeof(cfg_pool_entry_t));
+    if (entries == NULL || cfg->pools.count != POOL_COUNT) {
+        ESP_LOGW(TAG, "⚠️ Pool config has %lu entries (expected %d) - ignored",
+                 cfg->pools.count, POOL_COUNT);
+        return;
+    }
+    
+    // pool_malloc เลือก pool แรกที่ใหญ่พอ ดังนั้นขนาด block ต้องเรียงจากน้อยไปมาก
+    for (int i = 0; i < POOL_COUNT; i++) {
+        if (entries[i].block_size == 0 || entries[i].block_count == 0 ||
+            (i > 0 && entries[i].block_size <= entries[i - 1].block_size) ||
+            cfgblob_string(blob, entries[i].name) == NULL) {
+            ESP_LOGW(TAG, "⚠️ Pool config entry %d invalid - ignored", i);
+            return;
+        }
+    }
+    
+    for (int i = 0; i < POOL_COUNT; i++) {
+        pool_configs[i].name = cfgblob_string(blob, entries[i].name);
+        pool_configs[i].block_size = entries[i].block_size;
+        pool_configs[i].block_count = entries[i].block_count;
+        pool_configs[i].caps = entries[i].caps;
+    }
+    ESP_LOGI(TAG, "⚙️ Pool geometry loaded from configuration blob");
+}
+
 // Magic numbers for corruption detection
 #define POOL_MAGIC_FREE    0xDEADBEEF
 #define POOL_MAGIC_ALLOC   0xCAFEBABE
@@ -116,6 +189,13 @@ bool init_memory_pool(memory_pool_t* pool, const pool_config_t* config, uint32_t
     pool->alignment = 4; // 4-byte alignment
     pool->caps = config->caps;
     pool->pool_id = pool_id;
+    tz_zone_init(&pool->alloc_zone, "pool_malloc", pool->name);
+    tz_zone_init(&pool->free_zone, "pool_free", pool->name);
+    mt_series_init(&pool->occupancy_trend, "occupancy", pool->name, MT_RISING,
+                   pool->block_count, POOL_MONITOR_PERIOD_S, TREND_HORIZON_S);
+    es_site_init(&pool->corrupt_site, pool->name, "corrupt free block");
+    es_site_init(&pool->exhausted_site, pool->name, "pool exhausted");
+    es_site_init(&pool->bad_free_site, pool->name, "free of a block not allocated");
     
     // Calculate total memory needed (including headers)
     size_t header_size = sizeof(memory_block_t);
@@ -133,8 +213,9 @@ bool init_memory_pool(memory_pool_t* pool, const pool_config_t* config, uint32_t
     ESP_LOGI(TAG, "Memory allocated at address: %p", pool->pool_memory);
 
     ESP_LOGI(TAG, "Allocating usage bitmap for pool: %s", config->name);
-    size_t bitmap_bytes = (config->block_count + 7) / 8;
-    pool->usage_bitmap = heap_caps_calloc(bitmap_bytes, 1, MALLOC_CAP_INTERNAL);
+    // One bit per block, 32 to a word
+    size_t bitmap_words = (config->block_count + 31) / 32;
+    pool->usage_bitmap = heap_caps_calloc(bitmap_words, sizeof(*pool->usage_bitmap), MALLOC_CAP_INTERNAL);
     if (!pool->usage_bitmap) {
         ESP_LOGE(TAG, "Failed to allocate bitmap for %s pool", config->name);
         heap_caps_free(pool->pool_memory);
@@ -151,6 +232,7 @@ bool init_memory_pool(memory_pool_t* pool, const pool_config_t* config, uint32_t
         memory_block_t* block = (memory_block_t*)(memory_ptr + (i * total_block_size));
         block->magic = POOL_MAGIC_FREE;
         block->pool_id = pool_id;
+        block->owner = 0;
         block->alloc_time = 0;
         block->next = pool->free_list;
         pool->free_list = block;
@@ -174,7 +256,7 @@ bool init_memory_pool(memory_pool_t* pool, const pool_config_t* config, uint32_t
 void* pool_malloc(memory_pool_t* pool) {
     if (!pool || !pool->mutex) return NULL;
     
-    uint64_t start_time = esp_timer_get_time();
+    TZ_SCOPE(pool->alloc_zone);     // Every return path, mutex wait included
     void* result = NULL;
     
     if (xSemaphoreTake(pool->mutex, pdMS_TO_TICKS(100)) == pdTRUE) {
@@ -185,15 +267,24 @@ void* pool_malloc(memory_pool_t* pool) {
             
             // Check for corruption
             if (block->magic != POOL_MAGIC_FREE || block->pool_id != pool->pool_id) {
-                ESP_LOGE(TAG, "🚨 Corruption detected in %s pool block %p!", 
-                         pool->name, block);
-                gpio_set_level(LED_POOL_ERROR, 1);
+                es_record(&pool->corrupt_site, ESP_ERR_INVALID_STATE, (uint32_t)(uintptr_t)block);
+                xSemaphoreGive(pool->mutex);
+                return NULL;
+            }
+            
+            // Charge the calling task; over its hard quota the block goes back
+            int owner = ma_charge(MA_SRC_POOL, pool->block_size);
+            if (owner < 0) {
+                block->next = pool->free_list;
+                pool->free_list = block;
+                pool->allocation_failures++;
                 xSemaphoreGive(pool->mutex);
                 return NULL;
             }
             
             // Mark as allocated
             block->magic = POOL_MAGIC_ALLOC;
+            block->owner = owner;
             block->alloc_time = esp_timer_get_time();
             block->next = NULL;
             
@@ -213,7 +304,7 @@ void* pool_malloc(memory_pool_t* pool) {
                                 total_block_size;
             
             if (block_index < pool->block_count) {
-                pool->usage_bitmap[block_index / 8] |= (1 << (block_index % 8));
+                pool->usage_bitmap[block_index / 32] |= (1u << (block_index % 32));
             }
             
             // Return pointer to data area (after header)
@@ -225,88 +316,91 @@ void* pool_malloc(memory_pool_t* pool) {
         } else {
             // Pool exhausted
             pool->allocation_failures++;
-            ESP_LOGW(TAG, "🔴 %s pool exhausted! (%d/%d blocks used)", 
-                     pool->name, pool->allocated_blocks, pool->block_count);
-            gpio_set_level(LED_POOL_FULL, 1);
+            es_record(&pool->exhausted_site, ESP_ERR_NO_MEM, pool->allocated_blocks);
         }
         
         xSemaphoreGive(pool->mutex);
     }
     
-    uint64_t allocation_time = esp_timer_get_time() - start_time;
-    pool->allocation_time_total += allocation_time;
-    
     return result;
 }
 
 bool pool_free(memory_pool_t* pool, void* ptr) {
     if (!pool || !ptr || !pool->mutex) return false;
     
-    uint64_t start_time = esp_timer_get_time();
+    TZ_SCOPE(pool->free_zone);
     bool result = false;
     
+    // Calculate block address from data pointer
+    size_t header_size = sizeof(memory_block_t);
+    memory_block_t* block = (memory_block_t*)((uint8_t*)ptr - header_size);
+    size_t aligned_block_size = (pool->block_size + pool->alignment - 1) & 
+                               ~(pool->alignment - 1);
+    size_t total_block_size = header_size + aligned_block_size;
+    
+    // Bounds first: smart_pool_free asks every pool, so a pointer from
+    // another pool or the heap is normal here - not ours, not an error,
+    // and its "header" is not ours to read
+    if ((uint8_t*)block < (uint8_t*)pool->pool_memory ||
+        (uint8_t*)block >= (uint8_t*)pool->pool_memory + 
+                           (total_block_size * pool->block_count)) {
+        return false;
+    }
+    
     if (xSemaphoreTake(pool->mutex, pdMS_TO_TICKS(100)) == pdTRUE) {
-        // Calculate block address from data pointer
-        size_t header_size = sizeof(memory_block_t);
-        memory_block_t* block = (memory_block_t*)((uint8_t*)ptr - header_size);
-        
-        // Verify block belongs to this pool
-        if (block->magic != POOL_MAGIC_ALLOC || block->pool_id != pool->pool_id) {
-            ESP_LOGE(TAG, "🚨 Invalid block %p for %s pool! Magic: 0x%08X, Pool ID: %lu",
-                     ptr, pool->name, block->magic, block->pool_id);
-            gpio_set_level(LED_POOL_ERROR, 1);
+        size_t offset = (uint8_t*)block - (uint8_t*)pool->pool_memory;
+        
+        // Inside the pool but not a live block: double free, a pointer
+        // into the middle of a block, or an overwritten header
+        if (offset % total_block_size != 0 ||
+            block->magic != POOL_MAGIC_ALLOC || block->pool_id != pool->pool_id) {
+            es_record(&pool->bad_free_site,
+                      offset % total_block_size != 0 ? ESP_ERR_INVALID_ARG : ESP_ERR_INVALID_STATE,
+                      (uint32_t)(uintptr_t)ptr);
             xSemaphoreGive(pool->mutex);
             return false;
         }
         
-        // Check if pointer is within pool bounds
-        size_t aligned_block_size = (pool->block_size + pool->alignment - 1) & 
-                                   ~(pool->alignment - 1);
-        size_t total_block_size = header_size + aligned_block_size;
+        // Calculate block index
+        size_t block_index = offset / total_block_size;
         
-        if ((uint8_t*)block >= (uint8_t*)pool->pool_memory &&
-            (uint8_t*)block < (uint8_t*)pool->pool_memory + 
-                             (total_block_size * pool->block_count)) {
-            
-            // Calculate block index
-            size_t block_index = ((uint8_t*)block - (uint8_t*)pool->pool_memory) / 
-                                total_block_size;
-            
-            // Clear bitmap
-            if (block_index < pool->block_count) {
-                pool->usage_bitmap[block_index / 8] &= ~(1 << (block_index % 8));
-            }
-            
-            // Mark as free and add to free list  
-            block->magic = POOL_MAGIC_FREE;
-            block->next = pool->free_list;
-            pool->free_list = block;
-            
-            // Update statistics
-            pool->allocated_blocks--;
-            pool->total_deallocations++;
-            
-            ESP_LOGD(TAG, "🟢 %s pool: freed block %p (index %d)", 
-                     pool->name, ptr, block_index);
-            
-            result = true;
-            
-        } else {
-            ESP_LOGE(TAG, "🚨 Block %p out of bounds for %s pool!", ptr, pool->name);
-            gpio_set_level(LED_POOL_ERROR, 1);
-        }
+        // Clear bitmap
+        pool->usage_bitmap[block_index / 32] &= ~(1u << (block_index % 32));
+        
+        // Credit whoever allocated it, not necessarily the caller
+        ma_uncharge(block->owner, MA_SRC_POOL, pool->block_size);
+        
+        // Mark as free and add to free list  
+        block->magic = POOL_MAGIC_FREE;
+        block->next = pool->free_list;
+        pool->free_list = block;
+        
+        // Update statistics
+        pool->allocated_blocks--;
+        pool->total_deallocations++;
+        
+        ESP_LOGD(TAG, "🟢 %s pool: freed block %p (index %d)", 
+                 pool->name, ptr, block_index);
+        
+        result = true;
         
         xSemaphoreGive(pool->mutex);
     }
     
-    uint64_t deallocation_time = esp_timer_get_time() - start_time;
-    pool->deallocation_time_total += deallocation_time;
-    
     return result;
 }
 
+// Outer zones: pool_malloc/pool_free nest inside, so self time here is
+// the pool search plus the LED blink
+TZ_DEFINE(zone_smart_malloc, "smart_pool_malloc");
+TZ_DEFINE(zone_smart_free, "smart_pool_free");
+
+ES_SITE(heap_fallback, "smart_pool", "no pool block, heap fallback");
+
 // Smart pool allocator - automatically selects appropriate pool
 void* smart_pool_malloc(size_t size) {
+    TZ_SCOPE(zone_smart_malloc);
+    
     // Add small overhead for metadata if needed
     size_t required_size = size + 16; // Safety margin
     
@@ -327,12 +421,14 @@ void* smart_pool_malloc(size_t size) {
         }
     }
     
-    ESP_LOGW(TAG, "⚠️ No suitable pool for %d bytes, falling back to heap", size);
-    return heap_caps_malloc(size, MALLOC_CAP_DEFAULT);
+    // Every pool full or too small - the stress tests hit this in bursts
+    es_record(&heap_fallback, ESP_ERR_NO_MEM, size);
+    return ma_malloc(size, MALLOC_CAP_DEFAULT);
 }
 
 bool smart_pool_free(void* ptr) {
     if (!ptr) return false;
+    TZ_SCOPE(zone_smart_free);
     
     // Try to free from each pool
     for (int i = 0; i < POOL_COUNT; i++) {
@@ -343,48 +439,52 @@ bool smart_pool_free(void* ptr) {
     
     // If not from any pool, try regular heap free
     ESP_LOGD(TAG, "🎯 Freeing %p from heap (not from pool)", ptr);
-    heap_caps_free(ptr);
+    ma_free(ptr);
     return true;
 }
 
 // Pool statistics and monitoring
 void print_pool_statistics(void) {
-    ESP_LOGI(TAG, "\n📊 ═══ MEMORY POOL STATISTICS ═══");
+    TLOGI(TAG, "\n📊 ═══ MEMORY POOL STATISTICS ═══");
     
     for (int i = 0; i < POOL_COUNT; i++) {
         memory_pool_t* pool = &pools[i];
         
         if (pool->mutex && xSemaphoreTake(pool->mutex, pdMS_TO_TICKS(100)) == pdTRUE) {
-            ESP_LOGI(TAG, "\n%s Pool:", pool->name);
-            ESP_LOGI(TAG, "  Block Size:      %d bytes", pool->block_size);
-            ESP_LOGI(TAG, "  Total Blocks:    %d", pool->block_count);
-            ESP_LOGI(TAG, "  Used Blocks:     %d (%d%%)", 
+            TLOGI(TAG, "\n%s Pool:", pool->name);
+            TLOGI(TAG, "  Block Size:      %d bytes", pool->block_size);
+            TLOGI(TAG, "  Total Blocks:    %d", pool->block_count);
+            TLOGI(TAG, "  Used Blocks:     %d (%d%%)", 
                      pool->allocated_blocks,
                      (pool->allocated_blocks * 100) / pool->block_count);
-            ESP_LOGI(TAG, "  Peak Usage:      %d blocks", pool->peak_usage);
-            ESP_LOGI(TAG, "  Allocations:     %llu", pool->total_allocations);
-            ESP_LOGI(TAG, "  Deallocations:   %llu", pool->total_deallocations);
-            ESP_LOGI(TAG, "  Failures:        %lu", pool->allocation_failures);
-            
-            if (pool->total_allocations > 0) {
-                uint32_t avg_alloc_time = pool->allocation_time_total / pool->total_allocations;
-                ESP_LOGI(TAG, "  Avg Alloc Time:  %lu μs", avg_alloc_time);
+            TLOGI(TAG, "  Peak Usage:      %d blocks", pool->peak_usage);
+            TLOGI(TAG, "  Allocations:     %llu", pool->total_allocations);
+            TLOGI(TAG, "  Deallocations:   %llu", pool->total_deallocations);
+            TLOGI(TAG, "  Failures:        %lu", pool->allocation_failures);
+            
+            tz_stats_t t;
+            tz_get_stats(&pool->alloc_zone, &t);
+            if (t.calls > 0) {
+                TLOGI(TAG, "  Alloc Time:      avg %lu μs, p99 %lu μs", t.avg_us, t.p99_us);
             }
             
-            if (pool->total_deallocations > 0) {
-                uint32_t avg_dealloc_time = pool->deallocation_time_total / pool->total_deallocations;
-                ESP_LOGI(TAG, "  Avg Dealloc Time: %lu μs", avg_dealloc_time);
+            tz_get_stats(&pool->free_zone, &t);
+            if (t.calls > 0) {
+                TLOGI(TAG, "  Dealloc Time:    avg %lu μs, p99 %lu μs", t.avg_us, t.p99_us);
             }
             
             xSemaphoreGive(pool->mutex);
         }
     }
     
-    ESP_LOGI(TAG, "═══════════════════════════════════════");
+    TLOGI(TAG, "═══════════════════════════════════════");
+    logtok_report(stdout);
+    ma_report(stdout);
+    es_report(stdout);
 }
 
 void visualize_pool_usage(void) {
-    ESP_LOGI(TAG, "\n🎨 ═══ POOL USAGE VISUALIZATION ═══");
+    TLOGI(TAG, "\n🎨 ═══ POOL USAGE VISUALIZATION ═══");
     
     for (int i = 0; i < POOL_COUNT; i++) {
         memory_pool_t* pool = &pools[i];
@@ -402,14 +502,14 @@ void visualize_pool_usage(void) {
                 }
             }
             
-            ESP_LOGI(TAG, "%s: [%s] %d/%d", 
+            TLOGI(TAG, "%s: [%s] %d/%d", 
                      pool->name, usage_bar, pool->allocated_blocks, pool->block_count);
             
             xSemaphoreGive(pool->mutex);
         }
     }
     
-    ESP_LOGI(TAG, "═══════════════════════════════════════");
+    TLOGI(TAG, "═══════════════════════════════════════");
 }
 
 bool check_pool_integrity(void) {
@@ -482,7 +582,7 @@ void pool_stress_test_task(void *pvParameters) {
                 test_sizes[allocation_count] = size;
                 
                 // Write test pattern
-                memset(test_ptrs[allocation_count], 0xAA, size);
+                integrity_fill8(test_ptrs[allocation_count], 0xAA, size);
                 
                 allocation_count++;
                 ESP_LOGI(TAG, "🏋️ Allocated %d bytes (%d/100)", size, allocation_count);
@@ -494,15 +594,8 @@ void pool_stress_test_task(void *pvParameters) {
             
             if (test_ptrs[index]) {
                 // Verify test pattern before freeing
-                uint8_t* data = (uint8_t*)test_ptrs[index];
-                bool pattern_ok = true;
-                
-                for (size_t i = 0; i < test_sizes[index]; i++) {
-                    if (data[i] != 0xAA) {
-                        pattern_ok = false;
-                        break;
-                    }
-                }
+                bool pattern_ok = integrity_verify8(test_ptrs[index], 0xAA,
+                                                    test_sizes[index], NULL);
                 
                 if (!pattern_ok) {
                     ESP_LOGE(TAG, "🚨 Data corruption detected in allocation %d!", index);
@@ -629,10 +722,7 @@ void pool_pattern_test_task(void *pvParameters) {
                 tests[i].pattern = pattern;
                 
                 // Fill with pattern
-                uint32_t* data = (uint32_t*)tests[i].ptr;
-                for (size_t j = 0; j < size / sizeof(uint32_t); j++) {
-                    data[j] = pattern;
-                }
+                integrity_fill32(tests[i].ptr, pattern, size);
                 
                 test_count++;
             }
@@ -648,19 +738,14 @@ void pool_pattern_test_task(void *pvParameters) {
         
         for (int i = 0; i < test_count; i++) {
             if (tests[i].ptr) {
-                uint32_t* data = (uint32_t*)tests[i].ptr;
-                bool pattern_ok = true;
-                
-                for (size_t j = 0; j < tests[i].size / sizeof(uint32_t); j++) {
-                    if (data[j] != tests[i].pattern) {
-                        pattern_ok = false;
-                        break;
-                    }
-                }
+                size_t bad_offset;
+                bool pattern_ok = integrity_verify32(tests[i].ptr, tests[i].pattern,
+                                                     tests[i].size, &bad_offset);
                 
                 if (!pattern_ok) {
                     corruptions++;
-                    ESP_LOGE(TAG, "🚨 Pattern corruption in allocation %d!", i);
+                    ESP_LOGE(TAG, "🚨 Pattern corruption in allocation %d at offset %u!",
+                             i, (unsigned)bad_offset);
                 }
             }
         }
@@ -686,15 +771,96 @@ void pool_pattern_test_task(void *pvParameters) {
     }
 }
 
+// Allocation age census: live blocks by pool and age, read from the
+// usage bitmaps and block headers - no tracking table, and one pass over
+// at most the pools' block counts per census
+static ac_census_t age_census;
+
+void run_age_census(void) {
+    uint64_t now = esp_timer_get_time();
+    ac_begin(&age_census);
+    
+    for (int i = 0; i < POOL_COUNT; i++) {
+        memory_pool_t* pool = &pools[i];
+        int cls = ac_class(&age_census, pool->name);
+        
+        if (pool->mutex && xSemaphoreTake(pool->mutex, pdMS_TO_TICKS(100)) == pdTRUE) {
+            size_t header_size = sizeof(memory_block_t);
+            size_t aligned_block_size = (pool->block_size + pool->alignment - 1) & 
+                                       ~(pool->alignment - 1);
+            size_t total_block_size = header_size + aligned_block_size;
+            
+            for (size_t b = 0; b < pool->block_count; b++) {
+                if (!(pool->usage_bitmap[b / 32] & (1u << (b % 32)))) {
+                    continue;
+                }
+                memory_block_t* block = (memory_block_t*)((uint8_t*)pool->pool_memory + 
+                                                          b * total_block_size);
+                uint64_t age_ms = (now - block->alloc_time) / 1000;
+                ac_count(&age_census, cls, age_ms > UINT32_MAX ? UINT32_MAX : (uint32_t)age_ms,
+                         pool->block_size);
+            }
+            
+            xSemaphoreGive(pool->mutex);
+        }
+    }
+    
+    ac_end(&age_census);
+    
+    for (int i = 0; i < POOL_COUNT; i++) {
+        ac_suspect_t suspect;
+        if (ac_suspect(&age_census, i, &suspect)) {
+            ESP_LOGW(TAG, "🕳️ Possible leak: %s pool blocks %s old keep piling up (%d -> %d, %d now)",
+                     pools[i].name, ac_bucket_label(suspect.bucket),
+                     suspect.floor_first, suspect.floor_last, suspect.population);
+        }
+    }
+}
+
+static mt_series_t heap_free_trend;
+
+static void trend_warning(const mt_series_t *s, const mt_forecast_t *f, void *ctx) {
+    char tte[16];
+    mt_format_duration(f->tte_s, tte, sizeof(tte));
+    if (f->warning) {
+        ESP_LOGW(TAG, "📉 Trend: %s %s reaches %.0f in ~%s (%+.1f/h)",
+                 s->region, s->name, s->limit, tte, f->slope_robust);
+    } else {
+        ESP_LOGI(TAG, "📈 Trend: %s %s no longer heading for %.0f", s->region, s->name, s->limit);
+    }
+}
+
 void pool_monitor_task(void *pvParameters) {
     ESP_LOGI(TAG, "📊 Pool monitor started");
+    ts_t last_report = ts_now();
+    
+    mt_series_init(&heap_free_trend, "free", "heap", MT_FALLING,
+                   HEAP_FREE_LIMIT, POOL_MONITOR_PERIOD_S, TREND_HORIZON_S);
+    mt_set_warning_handler(trend_warning, NULL);
+    ac_init(&age_census, POOL_MONITOR_PERIOD_S * 1000);
     
     while (1) {
-        vTaskDelay(pdMS_TO_TICKS(15000)); // Monitor every 15 seconds
+        vTaskDelay(pdMS_TO_TICKS(POOL_MONITOR_PERIOD_S * 1000)); // Monitor every 15 seconds
+        
+        // Occupancy is sampled unlocked: one racy read per pool is fine for a trend
+        for (int i = 0; i < POOL_COUNT; i++) {
+            mt_record(&pools[i].occupancy_trend, pools[i].allocated_blocks);
+        }
+        mt_record(&heap_free_trend, esp_get_free_heap_size());
         
         print_pool_statistics();
+        
+        // Latency breakdown for the last 15 s (self = minus nested zones)
+        ESP_LOGI(TAG, "\n⏱️ ═══ TIMING ZONES ═══");
+        ts_t now = ts_now();
+        tz_report(stdout, ts_us32(now - last_report));
+        last_report = now;
+        
         visualize_pool_usage();
         check_pool_integrity();
+        run_age_census();
+        mt_report(stdout);
+        ac_report(&age_census, stdout);
         
         // Check for pool exhaustion
         bool any_exhausted = false;
@@ -716,9 +882,24 @@ void pool_monitor_task(void *pvParameters) {
     }
 }
 
+// Runs in the errstat reporter for each site with new errors, off the
+// allocation path: the LEDs the error paths used to set themselves
+static void pool_error_leds(const es_site_t *site, uint32_t fresh, void *ctx) {
+    for (int i = 0; i < POOL_COUNT; i++) {
+        if (site == &pools[i].exhausted_site) {
+            gpio_set_level(LED_POOL_FULL, 1);
+        } else if (site == &pools[i].corrupt_site || site == &pools[i].bad_free_site) {
+            gpio_set_level(LED_POOL_ERROR, 1);
+        }
+    }
+}
+
 void app_main(void) {
     ESP_LOGI(TAG, "🚀 Memory Pools Lab Starting...");
     
+    // Cycle-counter timestamps for the timing zones
+    ts_init();
+    
     // Configure GPIO
     gpio_set_direction(LED_SMALL_POOL, GPIO_MODE_OUTPUT);
     gpio_set_direction(LED_MEDIUM_POOL, GPIO_MODE_OUTPUT);
@@ -734,6 +915,7 @@ void app_main(void) {
     gpio_set_level(LED_POOL_ERROR, 0);
     
     // Initialize memory pools
+    load_pool_config();
     ESP_LOGI(TAG, "Initializing memory pools...");
     
     for (int i = 0; i < POOL_COUNT; i++) {
@@ -746,13 +928,17 @@ void app_main(void) {
     pools_initialized = true;
     ESP_LOGI(TAG, "All memory pools initialized successfully");
     
+    // Pool errors are counted where they happen and reported from here
+    es_start(ERROR_REPORT_PERIOD_MS, ERROR_REPORT_PRIORITY, pool_error_leds);
+    
     // Print initial pool status
     print_pool_statistics();
     
     // Create test tasks
     ESP_LOGI(TAG, "Creating memory pool test tasks...");
     
-    xTaskCreate(pool_monitor_task, "PoolMonitor", 4096, NULL, 6, NULL);
+    // Trend fits take ~1 KB of stack on top of the reports
+    xTaskCreate(pool_monitor_task, "PoolMonitor", 5120, NULL, 6, NULL);
     xTaskCreate(pool_stress_test_task, "StressTest", 3072, NULL, 5, NULL);
     xTaskCreate(pool_performance_test_task, "PerfTest", 3072, NULL, 4, NULL);
     xTaskCreate(pool_pattern_test_task, "PatternTest", 3072, NULL, 5, NULL);
@@ -767,18 +953,11 @@ void app_main(void) {
     ESP_LOGI(TAG, "  GPIO19 - Pool Error/Corruption");
     
     ESP_LOGI(TAG, "\n🏊 Pool Configuration:");
-    ESP_LOGI(TAG, "  Small Pool:  %d × %d bytes = %d KB", 
-             SMALL_POOL_BLOCK_COUNT, SMALL_POOL_BLOCK_SIZE,
-             (SMALL_POOL_BLOCK_COUNT * SMALL_POOL_BLOCK_SIZE) / 1024);
-    ESP_LOGI(TAG, "  Medium Pool: %d × %d bytes = %d KB", 
-             MEDIUM_POOL_BLOCK_COUNT, MEDIUM_POOL_BLOCK_SIZE,
-             (MEDIUM_POOL_BLOCK_COUNT * MEDIUM_POOL_BLOCK_SIZE) / 1024);
-    ESP_LOGI(TAG, "  Large Pool:  %d × %d bytes = %d KB", 
-             LARGE_POOL_BLOCK_COUNT, LARGE_POOL_BLOCK_SIZE,
-             (LARGE_POOL_BLOCK_COUNT * LARGE_POOL_BLOCK_SIZE) / 1024);
-    ESP_LOGI(TAG, "  Huge Pool:   %d × %d bytes = %d KB", 
-             HUGE_POOL_BLOCK_COUNT, HUGE_POOL_BLOCK_SIZE,
-             (HUGE_POOL_BLOCK_COUNT * HUGE_POOL_BLOCK_SIZE) / 1024);
+    for (int i = 0; i < POOL_COUNT; i++) {
+        ESP_LOGI(TAG, "  %-6s Pool: %d × %d bytes = %d KB", pool_configs[i].name,
+                 pool_configs[i].block_count, pool_configs[i].block_size,
+                 (pool_configs[i].block_count * pool_configs[i].block_size) / 1024);
+    }
     
     ESP_LOGI(TAG, "\n🧪 Test Features:");
     ESP_LOGI(TAG, "  • Multi-tier Memory Pool System");
@@ -787,6 +966,8 @@ void app_main(void) {
     ESP_LOGI(TAG, "  • Corruption Detection");
     ESP_LOGI(TAG, "  • Usage Visualization");
     ESP_LOGI(TAG, "  • Integrity Checking");
+    ESP_LOGI(TAG, "  • Occupancy Trends and Time-to-Exhaustion");
+    ESP_LOGI(TAG, "  • Allocation Age Census (leak suspects)");
     
     ESP_LOGI(TAG, "Memory Pool System operational!");
 }
\ No newline at end of file
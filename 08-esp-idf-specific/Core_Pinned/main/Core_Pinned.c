@@ -8,6 +8,9 @@
 #include "esp_timer.h"
 #include "esp_log.h"
 #include "esp_task_wdt.h" // Include Task Watchdog Timer header
+#include "uplink.h"
+#include "pcprof.h"
+#include "errstat.h"
 
 static const char *TAG = "REALTIME";
 
@@ -23,11 +26,15 @@ static const char *TAG = "REALTIME";
 #define CTRL_PERIOD_US     (1000000 / CTRL_HZ)  // 1000 us
 #define DAQ_PERIOD_US      (1000000 / DAQ_HZ)   // 2000 us
 
-// Priorities (must be < configMAX_PRIORITIES = 25)
+// Priorities (must be < configMAX_PRIORITIES = 25). Checked against the
+// measured periods/WCETs in tools/prioassign/core_pinned_tasks.toml with
+//   python3 tools/prioassign/prioassign.py --current core_pinned_tasks.toml
+// (drop --current for an order derived from the timing alone)
 #define PRIO_CTRL          24
 #define PRIO_DAQ           22
 #define PRIO_COMM          18
 #define PRIO_BG             5
+#define PRIO_ERRSTAT        4     // Error reporter, whatever is left over
 
 // Stack sizes
 #define STK_CTRL           4096
@@ -47,6 +54,23 @@ typedef struct {
 
 static QueueHandle_t q_ctrl_to_comm;
 
+// A full queue at 1 kHz used to log a line per failed send from the
+// control loop itself; now it only counts, and the errstat reporter
+// prints at most once a second
+ES_SITE(ctrl_queue_full, "Ctrl_1kHz", "queue to Comm full");
+
+// Control samples leave through the uplink batcher: one link send per frame
+#define UPLINK_FRAME_BYTES 512
+#define UPLINK_DELAY_MS    50
+
+// PC-sampling profiler: 997 Hz per core (not 1000, so it can't phase-lock
+// with Ctrl_1kHz), PCPROF report every 30 s. Symbolize a captured log with
+//   python3 tools/pcprof/pcprof.py --elf build/Core_Pinned.elf monitor.log
+// 1 = sample while the lab runs (task names need
+// CONFIG_FREERTOS_USE_TRACE_FACILITY)
+#define PCPROF_ENABLE      0
+#define PCPROF_REPORT_MS   30000
+
 /* ============= Frequency/Jitter Measurement Helpers ============= */
 typedef struct {
     int64_t prev_tick_us;
@@ -145,6 +169,16 @@ static void do_comm_io(void)
     vTaskDelay(pdMS_TO_TICKS(5));
 }
 
+// Uplink transport over the simulated link: the 5 ms cost is paid per frame
+static esp_err_t comm_link_send(void *ctx, const void *frame, size_t len)
+{
+    (void)ctx;
+    (void)frame;
+    (void)len;
+    do_comm_io();
+    return ESP_OK;
+}
+
 static void do_background_work(void)
 {
     // Light background work
@@ -181,7 +215,7 @@ static void control_task_core0(void *arg)
             .ctrl_output = control_output
         };
         if (xQueueSend(q_ctrl_to_comm, &message, 0) != pdPASS) {
-            ESP_LOGW(TAG, "Control Task: Queue send failed");
+            es_record(&ctrl_queue_full, ESP_ERR_TIMEOUT, message.seq);
         }
 
         // Update timing statistics
@@ -243,21 +277,36 @@ static void comm_task_core1(void *arg)
     int64_t last_report_time = esp_timer_get_time();
     double total_latency_ms = 0.0, max_latency_ms = 0.0;
 
+    // Binary samples barely compress - skip LZ4 and keep core 1 free
+    static uplink_t uplink;
+    uplink_transport_t link = { .name = "sim", .send = comm_link_send };
+    uplink_config_t cfg = UPLINK_CONFIG_DEFAULT();
+    cfg.max_frame_bytes = UPLINK_FRAME_BYTES;
+    cfg.max_delay_ms = UPLINK_DELAY_MS;
+    cfg.compress = false;
+    ESP_ERROR_CHECK(uplink_init(&uplink, &cfg, &link));
+    uplink_stats_t prev_uplink = {0};
+
     // Register this task with the Task Watchdog Timer
     esp_task_wdt_add(NULL);
 
     while (1) {
+        // Drain everything queued so far, waiting only for the first message
         ctrl_msg_t received_message;
-        if (xQueueReceive(q_ctrl_to_comm, &received_message, pdMS_TO_TICKS(10)) == pdTRUE) {
+        TickType_t wait = pdMS_TO_TICKS(10);
+        while (xQueueReceive(q_ctrl_to_comm, &received_message, wait) == pdTRUE) {
             int64_t current_time = esp_timer_get_time();
             double latency_ms = (double)(current_time - received_message.t_send_us) / 1000.0;
             total_latency_ms += latency_ms;
             if (latency_ms > max_latency_ms) max_latency_ms = latency_ms;
             received_count++;
+
+            uplink_submit(&uplink, &received_message, sizeof(received_message), current_time);
+            wait = 0;
         }
 
-        // Perform communication I/O
-        do_comm_io();
+        // Perform communication I/O (sends due frames only)
+        uplink_poll(&uplink, esp_timer_get_time());
 
         // Log latency statistics every second
         int64_t now = esp_timer_get_time();
@@ -269,6 +318,15 @@ static void comm_task_core1(void *arg)
             } else {
                 ESP_LOGI(TAG, "Comm Latency: No messages received");
             }
+
+            uplink_stats_t st;
+            uplink_rates_t r;
+            uplink_get_stats(&uplink, &st);
+            uplink_rates(&st, &prev_uplink, (uint32_t)((now - last_report_time) / 1000), &r);
+            ESP_LOGI(TAG, "Uplink: %.1f frames/s, %.1f msgs/frame, %.1f B/msg, queue delay %.1f ms",
+                     r.frames_per_s, r.msgs_per_frame, r.wire_bytes_per_msg, r.avg_queue_delay_ms);
+            prev_uplink = st;
+
             received_count = 0;
             total_latency_ms = 0.0;
             max_latency_ms = 0.0;
@@ -320,4 +378,16 @@ void app_main(void)
 
     ok = xTaskCreate(background_task, "BG", STK_BG, NULL, PRIO_BG, NULL);
     configASSERT(ok == pdPASS);
+
+    ESP_ERROR_CHECK(es_start(REPORT_MS, PRIO_ERRSTAT, NULL));
+
+#if PCPROF_ENABLE
+    // Drain task on Core1 below Comm, so Core0's timing only pays the ISR
+    pcprof_config_t prof_cfg = PCPROF_CONFIG_DEFAULT();
+    prof_cfg.report_ms = PCPROF_REPORT_MS;
+    prof_cfg.drain_core = CORE1;
+    if (pcprof_start(&prof_cfg) != ESP_OK) {
+        ESP_LOGW(TAG, "Profiler not started");
+    }
+#endif
 }
\ No newline at end of file
@@ -1,15 +1,67 @@
 #include <stdio.h>
 #include <stdint.h>
+#include <stdbool.h>
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
-#include "freertos/queue.h"
 #include "esp_log.h"
 #include "esp_system.h"
+#include "esp_timer.h"
+#include "corerpc.h"
 
 static const char *TAG = "DUAL_CORE";
 
-// Queue handle for inter-core communication
-static QueueHandle_t intercore_queue;
+// ================ INTER-CORE RPC ================
+// One channel per direction instead of a raw queue: each side asks the
+// other core to run an operation and (optionally) waits for its result
+
+static rpc_channel_t core0_rpc;     // Served on Core 0: compute
+static rpc_channel_t core1_rpc;     // Served on Core 1: I/O
+
+// Core 0 operations
+enum {
+    OP_COUNT_PRIMES,
+};
+
+// Core 1 operations
+enum {
+    OP_LOG_COUNTER,
+};
+
+typedef struct {
+    uint32_t from;
+    uint32_t to;                    // Exclusive
+} range_t;
+
+#define RPC_SERVER_PRIO     6       // Above the worker tasks on both cores
+#define OFFLOAD_BATCH       4
+#define OFFLOAD_TIMEOUT_MS  500
+
+static esp_err_t count_primes_handler(const void *args, size_t len, void *result, size_t *result_len) {
+    const range_t *r = (const range_t *)args;
+    if (len != sizeof(*r)) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    uint32_t count = 0;
+    for (uint32_t n = r->from < 2 ? 2 : r->from; n < r->to; n++) {
+        bool prime = true;
+        for (uint32_t d = 2; d * d <= n; d++) {
+            if (n % d == 0) {
+                prime = false;
+                break;
+            }
+        }
+        count += prime;
+    }
+    *(uint32_t *)result = count;
+    *result_len = sizeof(count);
+    return ESP_OK;
+}
+
+static esp_err_t log_counter_handler(const void *args, size_t len, void *result, size_t *result_len) {
+    ESP_LOGI(TAG, "Core %d: Received counter = %lu", xPortGetCoreID(), *(const uint32_t *)args);
+    *result_len = 0;
+    return ESP_OK;
+}
 
 // Task running on Core 0: Compute-intensive task
 void compute_task(void *pvParameters) {
@@ -19,20 +71,57 @@ void compute_task(void *pvParameters) {
     while (1) {
         counter++;
         if (counter % 1000000 == 0) {
-            ESP_LOGI(TAG, "Core 0: Counter = %u", counter);
-            xQueueSend(intercore_queue, &counter, portMAX_DELAY);
+            ESP_LOGI(TAG, "Core 0: Counter = %lu", counter);
+            // Fire and forget: Core 1 logs it, nobody waits
+            if (rpc_post(&core1_rpc, OP_LOG_COUNTER, &counter, sizeof(counter)) != ESP_OK) {
+                ESP_LOGW(TAG, "Core 0: RPC slots busy, counter %lu not sent", counter);
+            }
         }
     }
 }
 
-// Task running on Core 1: I/O and communication task
+// Task running on Core 1: I/O and communication task - offloads number
+// crunching to Core 0 and waits for the answers
 void io_task(void *pvParameters) {
     ESP_LOGI(TAG, "I/O task running on Core 1");
-    uint32_t received_counter;
+    uint32_t round = 0;
 
     while (1) {
-        if (xQueueReceive(intercore_queue, &received_counter, portMAX_DELAY)) {
-            ESP_LOGI(TAG, "Core 1: Received counter = %u", received_counter);
+        vTaskDelay(pdMS_TO_TICKS(2000));
+        round++;
+
+        // Submit a batch, wake Core 0 once for all of it
+        rpc_future_t futures[OFFLOAD_BATCH];
+        range_t ranges[OFFLOAD_BATCH];
+        bool submitted[OFFLOAD_BATCH];
+        for (int i = 0; i < OFFLOAD_BATCH; i++) {
+            ranges[i].from = (round * OFFLOAD_BATCH + i) * 5000;
+            ranges[i].to = ranges[i].from + 5000;
+            submitted[i] = rpc_call_async(&core0_rpc, OP_COUNT_PRIMES, &ranges[i], sizeof(ranges[i]),
+                                          &futures[i], false) == ESP_OK;
+        }
+        rpc_kick(&core0_rpc);
+
+        uint32_t total = 0;
+        int64_t start = esp_timer_get_time();
+        for (int i = 0; i < OFFLOAD_BATCH; i++) {
+            uint32_t count = 0;
+            esp_err_t err = submitted[i]
+                ? rpc_wait(&futures[i], &count, sizeof(count), pdMS_TO_TICKS(OFFLOAD_TIMEOUT_MS))
+                : ESP_ERR_NO_MEM;
+            if (err != ESP_OK) {
+                ESP_LOGW(TAG, "Core 1: primes in [%lu, %lu) failed: %s",
+                         ranges[i].from, ranges[i].to, esp_err_to_name(err));
+                continue;
+            }
+            total += count;
+        }
+        ESP_LOGI(TAG, "Core 1: %lu primes in [%lu, %lu), computed on Core 0 in %lu ms",
+                 total, ranges[0].from, ranges[OFFLOAD_BATCH - 1].to,
+                 (uint32_t)((esp_timer_get_time() - start) / 1000));
+
+        if (round % 5 == 0) {
+            rpc_report(stdout);
         }
     }
 }
@@ -40,16 +129,22 @@ void io_task(void *pvParameters) {
 void app_main(void) {
     ESP_LOGI(TAG, "Starting Dual-Core Task Distribution Example");
 
-    // Create the queue for inter-core communication
-    intercore_queue = xQueueCreate(10, sizeof(uint32_t));
-    if (intercore_queue == NULL) {
-        ESP_LOGE(TAG, "Failed to create queue");
+    // Create the RPC channels for inter-core communication
+    if (rpc_channel_create(&core0_rpc, "rpc_core0", 0, RPC_SERVER_PRIO, 3072) != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to create RPC channels");
+        return;
+    }
+    if (rpc_channel_create(&core1_rpc, "rpc_core1", 1, RPC_SERVER_PRIO, 3072) != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to create RPC channels");
+        rpc_channel_destroy(&core0_rpc);
         return;
     }
+    rpc_register(&core0_rpc, OP_COUNT_PRIMES, count_primes_handler);
+    rpc_register(&core1_rpc, OP_LOG_COUNTER, log_counter_handler);
 
     // Create tasks pinned to specific cores
     xTaskCreatePinnedToCore(compute_task, "ComputeTask", 2048, NULL, 5, NULL, 0);
-    xTaskCreatePinnedToCore(io_task, "IOTask", 2048, NULL, 5, NULL, 1);
+    xTaskCreatePinnedToCore(io_task, "IOTask", 3072, NULL, 5, NULL, 1);
 
     ESP_LOGI(TAG, "Tasks created successfully");
 }
@@ -7,11 +7,14 @@
 #include "esp_log.h"
 #include "esp_wifi.h"
 #include "esp_event.h"
+#include "esp_netif.h"
+#include "esp_timer.h"
 #include "nvs_flash.h"
 #include "driver/gpio.h"
 #include "driver/gptimer.h"
 #include "driver/spi_master.h"
 #include "driver/i2c.h"
+#include "uplink.h"
 
 static const char *TAG = "PERIPHERAL_INTEGRATION";
 
@@ -31,10 +34,31 @@ static const char *TAG = "PERIPHERAL_INTEGRATION";
 #define I2C_MASTER_SDA_IO 21
 #define I2C_MASTER_FREQ_HZ 100000
 
+// Telemetry uplink: peripheral events are batched into UDP frames
+#define UPLINK_HOST        "127.0.0.1"
+#define UPLINK_PORT        5005
+#define UPLINK_QUEUE_LEN   32
+#define UPLINK_REPORT_MS   10000
+
+typedef struct {
+    char text[48];
+} telemetry_event_t;
+
+static QueueHandle_t telemetry_queue;
+static volatile bool wifi_connected = false;
+
+// Non-blocking: a full queue drops the event rather than stall a peripheral task
+static void publish_event(const char *source, int value) {
+    telemetry_event_t ev;
+    snprintf(ev.text, sizeof(ev.text), "%s:%d@%lld", source, value, esp_timer_get_time() / 1000);
+    xQueueSend(telemetry_queue, &ev, 0);
+}
+
 // Define a mock timer_task
 void timer_task(void* arg) {
     while (1) {
         ESP_LOGI(TAG, "[SIMULATION] Timer task triggered");
+        publish_event("timer", 1);
         vTaskDelay(pdMS_TO_TICKS(1000)); // Simulate timer event every 1 second
     }
 }
@@ -43,6 +67,7 @@ void timer_task(void* arg) {
 void spi_task(void* arg) {
     while (1) {
         ESP_LOGI(TAG, "[SIMULATION] Performing mock SPI transaction");
+        publish_event("spi", 32);
         vTaskDelay(pdMS_TO_TICKS(500)); // Simulate delay
     }
 }
@@ -50,6 +75,7 @@ void spi_task(void* arg) {
 void i2c_task(void* arg) {
     while (1) {
         ESP_LOGI(TAG, "[SIMULATION] Performing mock I2C transaction");
+        publish_event("i2c", 8);
         vTaskDelay(pdMS_TO_TICKS(1000)); // Simulate delay
     }
 }
@@ -59,6 +85,7 @@ void gpio_task(void* arg) {
     while (1) {
         ESP_LOGI(TAG, "[SIMULATION] Mock GPIO interrupt on pin %d", GPIO_INPUT_PIN);
         gpio_set_level(GPIO_OUTPUT_PIN, !gpio_get_level(GPIO_OUTPUT_PIN));
+        publish_event("gpio", gpio_get_level(GPIO_OUTPUT_PIN));
         vTaskDelay(pdMS_TO_TICKS(2000)); // Simulate GPIO event every 2 seconds
     }
 }
@@ -67,20 +94,79 @@ void gpio_task(void* arg) {
 static void simulate_wifi_events(void* arg) {
     while (1) {
         ESP_LOGI(TAG, "[SIMULATION] WiFi connected");
+        wifi_connected = true;
         vTaskDelay(pdMS_TO_TICKS(5000)); // Simulate connection for 5 seconds
 
         ESP_LOGI(TAG, "[SIMULATION] WiFi disconnected");
+        wifi_connected = false;
         vTaskDelay(pdMS_TO_TICKS(3000)); // Simulate disconnection for 3 seconds
     }
 }
 
+// Owns the uplink: drains peripheral events, follows WiFi state and keeps
+// frames in the backlog while disconnected
+static void uplink_task(void* arg) {
+    static uplink_t uplink;
+    static uplink_udp_t udp;
+    uplink_transport_t transport;
+    uplink_config_t cfg = UPLINK_CONFIG_DEFAULT();
+    cfg.max_delay_ms = 2000;
+
+    if (uplink_udp_open(&udp, UPLINK_HOST, UPLINK_PORT, &transport) != ESP_OK ||
+        uplink_init(&uplink, &cfg, &transport) != ESP_OK) {
+        ESP_LOGE(TAG, "Uplink init failed");
+        vTaskDelete(NULL);
+        return;
+    }
+
+    bool link = false;
+    uplink_set_link(&uplink, link, esp_timer_get_time());
+    uplink_stats_t prev = {0};
+    int64_t last_report = esp_timer_get_time();
+
+    while (1) {
+        telemetry_event_t ev;
+        bool got = xQueueReceive(telemetry_queue, &ev, pdMS_TO_TICKS(200)) == pdTRUE;
+        int64_t now = esp_timer_get_time();
+
+        if (wifi_connected != link) {
+            link = wifi_connected;
+            uplink_set_link(&uplink, link, now);
+            ESP_LOGI(TAG, "[UPLINK] Link %s, %u frames in backlog",
+                     link ? "up" : "down", uplink.backlog_count);
+        }
+        if (got) {
+            uplink_submit(&uplink, ev.text, strlen(ev.text), now);
+        }
+        uplink_poll(&uplink, now);
+
+        if (now - last_report >= UPLINK_REPORT_MS * 1000LL) {
+            uplink_stats_t st;
+            uplink_rates_t r;
+            uplink_get_stats(&uplink, &st);
+            uplink_rates(&st, &prev, (uint32_t)((now - last_report) / 1000), &r);
+            ESP_LOGI(TAG, "[UPLINK] %.2f frames/s, %.1f msgs/frame, %.1f B/msg, delay avg %.0f ms",
+                     r.frames_per_s, r.msgs_per_frame, r.wire_bytes_per_msg, r.avg_queue_delay_ms);
+            ESP_LOGI(TAG, "[UPLINK] backlog %lu, dropped %lu msgs, send failures %lu",
+                     st.backlog, st.messages_dropped, st.send_failures);
+            prev = st;
+            last_report = now;
+        }
+    }
+}
+
 void app_main(void) {
     ESP_LOGI(TAG, "Starting Peripheral Integration Simulation");
 
+    ESP_ERROR_CHECK(esp_netif_init());
+    telemetry_queue = xQueueCreate(UPLINK_QUEUE_LEN, sizeof(telemetry_event_t));
+    configASSERT(telemetry_queue != NULL);
+
     // Create tasks for simulation
     xTaskCreate(gpio_task, "GPIO_Task", 2048, NULL, 10, NULL);
     xTaskCreate(timer_task, "Timer_Task", 2048, NULL, 10, NULL);
     xTaskCreate(spi_task, "SPI_Task", 2048, NULL, 10, NULL);
     xTaskCreate(i2c_task, "I2C_Task", 2048, NULL, 10, NULL);
     xTaskCreate(simulate_wifi_events, "WiFi_Simulation", 2048, NULL, 10, NULL);
+    xTaskCreate(uplink_task, "Uplink_Task", 4096, NULL, 9, NULL);
 }
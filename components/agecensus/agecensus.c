@@ -0,0 +1,167 @@
+#include <string.h>
+#include <inttypes.h>
+#include "agecensus.h"
+
+// ================ AGE BUCKETS ================
+
+static const uint32_t bucket_floor_ms[AC_AGE_BUCKETS] = {
+    0, 1000, 10000, 60000, 600000, 3600000, 21600000, 86400000,
+};
+static const char *const bucket_labels[AC_AGE_BUCKETS] = {
+    "0s+", "1s+", "10s+", "1m+", "10m+", "1h+", "6h+", "1d+",
+};
+
+uint32_t ac_bucket_floor_ms(int bucket) {
+    return bucket_floor_ms[bucket];
+}
+
+const char *ac_bucket_label(int bucket) {
+    return bucket_labels[bucket];
+}
+
+static int age_bucket(uint32_t age_ms) {
+    int b = AC_AGE_BUCKETS - 1;
+    while (b > 0 && age_ms < bucket_floor_ms[b]) {
+        b--;
+    }
+    return b;
+}
+
+// ================ CENSUS ================
+
+void ac_init(ac_census_t *c, uint32_t period_ms) {
+    memset(c, 0, sizeof(*c));
+    uint32_t window_ms = AC_WINDOW * period_ms;
+    c->judged_bucket = AC_AGE_BUCKETS - 1;
+    for (int b = 0; b < AC_AGE_BUCKETS; b++) {
+        if (bucket_floor_ms[b] >= window_ms) {
+            c->judged_bucket = b;
+            break;
+        }
+    }
+}
+
+int ac_class(ac_census_t *c, const char *name) {
+    for (uint32_t i = 0; i < c->class_count; i++) {
+        if (strcmp(c->classes[i].name, name) == 0) {
+            return i;
+        }
+    }
+    if (c->class_count == AC_MAX_CLASSES) {
+        return -1;
+    }
+    ac_class_t *k = &c->classes[c->class_count];
+    k->name = name;
+    memset(k->window_min, 0xFF, sizeof(k->window_min));
+    return c->class_count++;
+}
+
+void ac_begin(ac_census_t *c) {
+    for (uint32_t i = 0; i < c->class_count; i++) {
+        ac_class_t *k = &c->classes[i];
+        memset(k->count, 0, sizeof(k->count));
+        k->live = 0;
+        k->bytes = 0;
+    }
+}
+
+void ac_count(ac_census_t *c, int cls, uint32_t age_ms, uint32_t bytes) {
+    if (cls < 0 || (uint32_t)cls >= c->class_count) {
+        c->uncounted++;
+        return;
+    }
+    ac_class_t *k = &c->classes[cls];
+    int b = age_bucket(age_ms);
+    if (k->count[b] == UINT16_MAX) {
+        c->uncounted++;
+        return;
+    }
+    k->count[b]++;
+    k->live++;
+    k->bytes += bytes;
+}
+
+void ac_end(ac_census_t *c) {
+    c->censuses++;
+    bool window_done = c->censuses % AC_WINDOW == 0;
+
+    for (uint32_t i = 0; i < c->class_count; i++) {
+        ac_class_t *k = &c->classes[i];
+        // Cohort b = every block at least bucket b old
+        uint16_t older = 0;
+        for (int b = AC_AGE_BUCKETS - 1; b >= 0; b--) {
+            older += k->count[b];
+            if (older < k->window_min[b]) {
+                k->window_min[b] = older;
+            }
+        }
+        if (!window_done) {
+            continue;
+        }
+        if (k->floor_count == AC_FLOORS) {
+            for (int b = 0; b < AC_AGE_BUCKETS; b++) {
+                memmove(&k->floors[b][0], &k->floors[b][1], (AC_FLOORS - 1) * sizeof(uint16_t));
+            }
+            k->floor_count--;
+        }
+        for (int b = 0; b < AC_AGE_BUCKETS; b++) {
+            k->floors[b][k->floor_count] = k->window_min[b];
+            k->window_min[b] = UINT16_MAX;
+        }
+        k->floor_count++;
+    }
+}
+
+static bool rising(const uint16_t *f) {
+    if (f[AC_FLOORS - 1] < f[0] + AC_MIN_GROWTH) {
+        return false;
+    }
+    for (int j = 1; j < AC_FLOORS; j++) {
+        if (f[j] < f[j - 1]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool ac_suspect(const ac_census_t *c, int cls, ac_suspect_t *out) {
+    const ac_class_t *k = &c->classes[cls];
+    int b = c->judged_bucket;
+    if (k->floor_count < AC_FLOORS || !rising(k->floors[b])) {
+        return false;
+    }
+    while (b + 1 < AC_AGE_BUCKETS && rising(k->floors[b + 1])) {
+        b++;
+    }
+    uint16_t population = 0;
+    for (int a = b; a < AC_AGE_BUCKETS; a++) {
+        population += k->count[a];
+    }
+    out->cls = cls;
+    out->bucket = b;
+    out->floor_first = k->floors[b][0];
+    out->floor_last = k->floors[b][AC_FLOORS - 1];
+    out->population = population;
+    return true;
+}
+
+void ac_report(const ac_census_t *c, FILE *out) {
+    for (uint32_t i = 0; i < c->class_count; i++) {
+        const ac_class_t *k = &c->classes[i];
+        fprintf(out, "agecensus %-8s live=%" PRIu32 " bytes=%" PRIu32 " ages:", k->name, k->live, k->bytes);
+        for (int b = 0; b < AC_AGE_BUCKETS; b++) {
+            fprintf(out, " %s=%u", bucket_labels[b], k->count[b]);
+        }
+        fputc('\n', out);
+
+        ac_suspect_t s;
+        if (ac_suspect(c, i, &s)) {
+            fprintf(out, "agecensus %-8s SUSPECT: blocks %s old, floor %u -> %u over %d censuses, %u now\n",
+                    k->name, bucket_labels[s.bucket], s.floor_first, s.floor_last,
+                    AC_WINDOW * AC_FLOORS, s.population);
+        }
+    }
+    if (c->uncounted) {
+        fprintf(out, "agecensus uncounted=%" PRIu32 "\n", c->uncounted);
+    }
+}
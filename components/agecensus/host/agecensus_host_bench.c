@@ -0,0 +1,136 @@
+// Host check for the age census: two hours of a lab2-like pool workload
+// (short-lived blocks from the stress test, a cache that fills once and
+// stays) censused every 15 s, with and without one class leaking a block
+// every two minutes. Checks that the leak is flagged within minutes in
+// its own class only, that churn and the settled cache never are, and
+// prints the census cost in blocks visited.
+//
+// Build and run from this directory:
+//   cc -O2 -I../include -I../../../tools/host_include ../agecensus.c agecensus_host_bench.c -o agecensus_bench
+//   ./agecensus_bench
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "agecensus.h"
+#include "host_check.h"
+
+#define BLOCKS          96
+#define STEP_MS         250
+#define CENSUS_MS       15000
+#define RUN_MS          (2 * 3600 * 1000u)
+
+typedef struct {
+    int cls;                        // -1 = free
+    uint32_t alloc_ms;
+    uint32_t free_ms;               // UINT32_MAX = never
+} block_t;
+
+static const char *class_names[] = { "SMALL", "MEDIUM", "LARGE", "HUGE" };
+
+static int place(block_t *blocks, int cls, uint32_t now, uint32_t lifetime) {
+    for (int i = 0; i < BLOCKS; i++) {
+        if (blocks[i].cls < 0) {
+            blocks[i].cls = cls;
+            blocks[i].alloc_ms = now;
+            blocks[i].free_ms = lifetime == UINT32_MAX ? UINT32_MAX : now + lifetime;
+            return i;
+        }
+    }
+    return -1;
+}
+
+// Returns when the leak was first flagged (0 = never); counts flags per class
+static uint32_t run(bool leak, uint32_t flagged[4], uint32_t *visited) {
+    static block_t blocks[BLOCKS];
+    ac_census_t census;
+    int classes[4];
+    ac_init(&census, CENSUS_MS);
+    for (int i = 0; i < 4; i++) {
+        classes[i] = ac_class(&census, class_names[i]);
+        flagged[i] = 0;
+    }
+    for (int i = 0; i < BLOCKS; i++) {
+        blocks[i].cls = -1;
+    }
+    *visited = 0;
+
+    uint32_t first = 0, cache_filled = 0;
+    for (uint32_t now = 0; now < RUN_MS; now += STEP_MS) {
+        // Stress test: a block every ~second, lives 0.1-40 s
+        if (rand() % 4 == 0) {
+            place(blocks, rand() % 4, now, 100 + rand() % 40000);
+        }
+        // A cache in MEDIUM: six entries in the first three minutes, kept
+        if (cache_filled < 6 && now >= cache_filled * 30000) {
+            place(blocks, 1, now, UINT32_MAX);
+            cache_filled++;
+        }
+        // The leak: a LARGE block every two minutes, never freed
+        if (leak && now % 120000 == 0 && now > 0) {
+            place(blocks, 2, now, UINT32_MAX);
+        }
+        for (int i = 0; i < BLOCKS; i++) {
+            if (blocks[i].cls >= 0 && now >= blocks[i].free_ms) {
+                blocks[i].cls = -1;
+            }
+        }
+
+        if (now % CENSUS_MS == 0) {
+            ac_begin(&census);
+            for (int i = 0; i < BLOCKS; i++) {
+                if (blocks[i].cls >= 0) {
+                    ac_count(&census, classes[blocks[i].cls], now - blocks[i].alloc_ms, 64);
+                    (*visited)++;
+                }
+            }
+            ac_end(&census);
+            for (int c = 0; c < 4; c++) {
+                ac_suspect_t s;
+                // The cache may look suspicious while it fills, until the
+                // fill has left the floor history
+                if (ac_suspect(&census, classes[c], &s) && (c != 1 || now > 10 * 60000)) {
+                    flagged[c]++;
+                    if (c == 2 && first == 0) {
+                        first = now;
+                    }
+                }
+            }
+        }
+    }
+    ac_report(&census, stdout);
+    return first;
+}
+
+int main(void) {
+    srand(97);
+    uint32_t flagged[4], visited;
+    uint32_t censuses = RUN_MS / CENSUS_MS;
+
+    printf("without a leak:\n");
+    run(false, flagged, &visited);
+    for (int c = 0; c < 4; c++) {
+        CHECK(flagged[c] == 0, "%s flagged %lu times without a leak", class_names[c],
+              (unsigned long)flagged[c]);
+    }
+
+    printf("with a LARGE block leaked every 2 min:\n");
+    uint32_t first = run(true, flagged, &visited);
+    printf("leak flagged after %.1f min, in %lu of %lu censuses; %.1f blocks visited per census\n",
+           first / 60000.0f, (unsigned long)flagged[2], (unsigned long)censuses,
+           (double)visited / censuses);
+    CHECK(first > 0 && first <= 12 * 60000, "leak first flagged at %lu ms", (unsigned long)first);
+    CHECK(flagged[2] > censuses * 9 / 10, "leak flagged in only %lu censuses", (unsigned long)flagged[2]);
+    CHECK(flagged[0] == 0 && flagged[1] == 0 && flagged[3] == 0, "other classes flagged: %lu %lu %lu",
+          (unsigned long)flagged[0], (unsigned long)flagged[1], (unsigned long)flagged[3]);
+
+    // Blocks of a class the census doesn't know are counted as such
+    ac_census_t c;
+    ac_init(&c, CENSUS_MS);
+    ac_begin(&c);
+    ac_count(&c, 3, 1000, 64);
+    ac_end(&c);
+    CHECK(c.uncounted == 1, "unknown class");
+
+    printf("%s\n", failures ? "FAILURES" : "OK");
+    return failures != 0;
+}
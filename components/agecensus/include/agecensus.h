@@ -0,0 +1,100 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include "esp_err.h"
+
+// ================ ALLOCATION AGE CENSUS ================
+// Leak detection from the headers allocators already keep, instead of a
+// tracking table. Every so often the caller walks the live blocks (pool
+// bitmaps, block headers with their allocation time) and counts each one
+// by class and age:
+//
+//   ac_begin(&census);
+//   for each live block in pool i:
+//       ac_count(&census, pool_class[i], now_ms - block_alloc_ms);
+//   ac_end(&census);
+//   ac_report(&census, stdout);
+//
+// The cost is one pass over the live blocks - bounded by the pools'
+// block counts - plus a fixed table of AC_MAX_CLASSES x AC_AGE_BUCKETS
+// counters; nothing happens on the allocation path.
+//
+// A cohort is "blocks of a class older than an age", e.g. "SMALL pool
+// blocks older than 10 m". Working memory churns through a cohort, so
+// its population goes up and down; a leak never leaves, so the floor
+// under the population rises. Censuses are grouped in windows of
+// AC_WINDOW; the minimum of each window is the cohort's floor, and the
+// last AC_FLOORS floors are kept. A cohort rises when those floors never
+// went down and grew by AC_MIN_GROWTH or more.
+//
+// Only cohorts older than a window are judged - younger ones are all
+// churn. A class is a suspect when its youngest judged cohort rises:
+// every leaked block is in it and keeps it growing. Long-lived blocks
+// that stopped coming (a cache that filled once) make an older cohort
+// rise for a while as they age into it, but not the youngest one.
+// ac_report() names the oldest cohort still rising along with it - the
+// age tells how long the leaked blocks have been held, the class where
+// they came from.
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define AC_MAX_CLASSES      8
+#define AC_AGE_BUCKETS      8       // <1s <10s <1m <10m <1h <6h <1d, then older
+#define AC_WINDOW           4       // Censuses per floor
+#define AC_FLOORS           6       // Floors compared
+#define AC_MIN_GROWTH       2       // Blocks the floor must gain across them
+
+typedef struct {
+    const char *name;
+    uint32_t live;                  // Blocks in the last census
+    uint32_t bytes;
+    uint16_t count[AC_AGE_BUCKETS]; // This census, by age bucket
+    // Per cohort (older than bucket b's lower edge)
+    uint16_t window_min[AC_AGE_BUCKETS];
+    uint16_t floors[AC_AGE_BUCKETS][AC_FLOORS];     // Oldest first
+    uint8_t floor_count;
+} ac_class_t;
+
+typedef struct {
+    ac_class_t classes[AC_MAX_CLASSES];
+    uint32_t class_count;
+    int judged_bucket;              // Youngest cohort older than a window
+    uint32_t censuses;
+    uint32_t uncounted;             // Blocks for unknown classes or beyond 65535
+} ac_census_t;
+
+typedef struct {
+    int cls;
+    int bucket;                     // Blocks older than ac_bucket_floor_ms(bucket)
+    uint16_t floor_first;
+    uint16_t floor_last;
+    uint16_t population;            // In the last census
+} ac_suspect_t;
+
+// period_ms: how often the census runs
+void ac_init(ac_census_t *c, uint32_t period_ms);
+// Index of a class (added on first use), -1 when the table is full
+int ac_class(ac_census_t *c, const char *name);
+
+void ac_begin(ac_census_t *c);
+void ac_count(ac_census_t *c, int cls, uint32_t age_ms, uint32_t bytes);
+void ac_end(ac_census_t *c);
+
+// The class's rising cohorts, oldest reported; false if not a suspect
+bool ac_suspect(const ac_census_t *c, int cls, ac_suspect_t *out);
+
+// Lower edge of an age bucket, and its label ("10m+", ...)
+uint32_t ac_bucket_floor_ms(int bucket);
+const char *ac_bucket_label(int bucket);
+
+// Per class: live blocks by age, then any suspect cohort
+void ac_report(const ac_census_t *c, FILE *out);
+
+#ifdef __cplusplus
+}
+#endif
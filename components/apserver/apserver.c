@@ -0,0 +1,157 @@
+#include <string.h>
+#include "apserver.h"
+
+// ================ ACCOUNTING CORE ================
+
+void aps_core_init(aps_core_t *c, aps_policy_t policy, uint32_t budget_us, uint32_t period_us, int64_t now) {
+    memset(c, 0, sizeof(*c));
+    c->policy = policy;
+    c->budget_us = budget_us;
+    c->period_us = period_us;
+    c->capacity_us = budget_us;
+    c->last = now;
+    c->next_period = now + period_us;
+    c->created = now;
+}
+
+static void add_repl(aps_core_t *c, int64_t at, uint32_t amount_us) {
+    if (c->nrepl == APS_MAX_REPL) {
+        // Out of slots: fold into the latest one, at the later time, so
+        // the budget comes back late rather than early
+        aps_repl_t *last = &c->repl[APS_MAX_REPL - 1];
+        if (at > last->at) {
+            last->at = at;
+        }
+        last->amount_us += amount_us;
+        return;
+    }
+    // Chunks close in time order, so appending keeps the list sorted
+    c->repl[c->nrepl].at = at;
+    c->repl[c->nrepl].amount_us = amount_us;
+    c->nrepl++;
+}
+
+// Sporadic: what the current activation used comes back one period
+// after it started
+static void close_chunk(aps_core_t *c) {
+    if (c->policy == APS_SPORADIC && c->chunk_used_us > 0) {
+        add_repl(c, c->chunk_start + c->period_us, c->chunk_used_us);
+    }
+    c->chunk_used_us = 0;
+}
+
+static void charge(aps_core_t *c, int64_t now) {
+    if (now <= c->last) {
+        return;
+    }
+    uint64_t elapsed = (uint64_t)(now - c->last);
+    c->last = now;
+    if (!c->active) {
+        return;
+    }
+    if (c->capacity_us == 0) {
+        c->low_us += elapsed;
+        return;
+    }
+    uint32_t used = c->capacity_us;
+    if (elapsed < used) {
+        used = (uint32_t)elapsed;
+    } else {
+        // Whatever ran past zero ran before the demotion took effect
+        uint64_t over = elapsed - used;
+        if (over > c->max_overrun_us) {
+            c->max_overrun_us = over > UINT32_MAX ? UINT32_MAX : (uint32_t)over;
+        }
+    }
+    c->capacity_us -= used;
+    c->chunk_used_us += used;
+    c->used_us += used;
+    if (c->capacity_us == 0) {
+        c->exhausted++;
+        close_chunk(c);
+    }
+}
+
+static int64_t next_replenishment(const aps_core_t *c) {
+    if (c->policy == APS_DEFERRABLE) {
+        return c->next_period;
+    }
+    return c->nrepl > 0 ? c->repl[0].at : INT64_MAX;
+}
+
+void aps_core_update(aps_core_t *c, int64_t now) {
+    for (int64_t due = next_replenishment(c); due <= now; due = next_replenishment(c)) {
+        charge(c, due);
+        if (c->policy == APS_DEFERRABLE) {
+            c->capacity_us = c->budget_us;
+            c->next_period += c->period_us;
+        } else {
+            c->capacity_us += c->repl[0].amount_us;
+            if (c->capacity_us > c->budget_us) {
+                c->capacity_us = c->budget_us;
+            }
+            c->nrepl--;
+            memmove(&c->repl[0], &c->repl[1], c->nrepl * sizeof(c->repl[0]));
+            // A running job starts a new activation here, so what it
+            // uses from now on comes back one period from now
+            if (c->active) {
+                close_chunk(c);
+                c->chunk_start = due;
+            }
+        }
+    }
+    charge(c, now);
+}
+
+void aps_core_begin(aps_core_t *c, int64_t now) {
+    aps_core_update(c, now);
+    c->active = true;
+    c->chunk_start = now;
+    c->chunk_used_us = 0;
+    c->job_start = now;
+}
+
+void aps_core_end(aps_core_t *c, int64_t now) {
+    if (!c->active) {
+        return;
+    }
+    aps_core_update(c, now);
+    close_chunk(c);
+    c->active = false;
+
+    uint64_t job = (uint64_t)(now - c->job_start);
+    uint32_t job_us = job > UINT32_MAX ? UINT32_MAX : (uint32_t)job;
+    c->jobs++;
+    c->job_us += job_us;
+    if (job_us > c->max_job_us) {
+        c->max_job_us = job_us;
+    }
+}
+
+int64_t aps_core_next_event(const aps_core_t *c, int64_t now) {
+    if (c->capacity_us > 0) {
+        // Only a running job changes anything: it exhausts the budget
+        return c->active ? now + c->capacity_us : -1;
+    }
+    // Demoted (or will wake demoted): raise it again when budget returns
+    int64_t due = next_replenishment(c);
+    return due == INT64_MAX ? -1 : due;
+}
+
+void aps_core_stats(const aps_core_t *c, int64_t now, aps_stats_t *out) {
+    memset(out, 0, sizeof(*out));
+    out->jobs = c->jobs;
+    out->exhausted = c->exhausted;
+    out->capacity_us = c->capacity_us;
+    out->low_ms = (uint32_t)(c->low_us / 1000);
+    out->avg_job_us = c->jobs ? (uint32_t)(c->job_us / c->jobs) : 0;
+    out->max_job_us = c->max_job_us;
+    out->max_overrun_us = c->max_overrun_us;
+
+    double wall_us = (double)(now - c->created);
+    if (wall_us > 0) {
+        double available = c->budget_us * (1.0 + wall_us / c->period_us);
+        out->budget_used_pct = (float)(100.0 * c->used_us / available);
+        out->cpu_pct = (float)(100.0 * c->used_us / wall_us);
+    }
+}
@@ -0,0 +1,119 @@
+#ifdef ESP_PLATFORM
+
+#include <string.h>
+#include <inttypes.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "esp_timer.h"
+#include "esp_log.h"
+#include "apserver.h"
+
+static const char *TAG = "APSERVER";
+
+static aps_server_t *registry;
+
+// Settle the books and make the task's priority and the enforcement
+// timer match them. Called with the server's lock held.
+static void apply(aps_server_t *srv) {
+    int64_t now = esp_timer_get_time();
+    aps_core_update(&srv->core, now);
+
+    uint8_t want = aps_core_high(&srv->core) ? srv->high_prio : srv->low_prio;
+    if (srv->task != NULL && want != srv->applied_prio) {
+        vTaskPrioritySet((TaskHandle_t)srv->task, want);
+        srv->applied_prio = want;
+    }
+
+    esp_timer_handle_t timer = (esp_timer_handle_t)srv->timer;
+    esp_timer_stop(timer);          // Not running is fine
+    int64_t next = aps_core_next_event(&srv->core, now);
+    if (next >= 0) {
+        esp_timer_start_once(timer, next > now ? (uint64_t)(next - now) : 1);
+    }
+}
+
+// Budget ran out or came back (esp_timer task)
+static void on_timer(void *arg) {
+    aps_server_t *srv = (aps_server_t *)arg;
+    xSemaphoreTake((SemaphoreHandle_t)srv->lock, portMAX_DELAY);
+    apply(srv);
+    xSemaphoreGive((SemaphoreHandle_t)srv->lock);
+}
+
+esp_err_t aps_init(aps_server_t *srv, const char *name, aps_policy_t policy,
+                   uint32_t budget_us, uint32_t period_us, uint8_t high_prio, uint8_t low_prio) {
+    if (budget_us == 0 || period_us == 0 || budget_us > period_us || low_prio > high_prio) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    memset(srv, 0, sizeof(*srv));
+    srv->name = name;
+    srv->high_prio = high_prio;
+    srv->low_prio = low_prio;
+    srv->applied_prio = high_prio;  // Create the served task at high_prio
+    aps_core_init(&srv->core, policy, budget_us, period_us, esp_timer_get_time());
+
+    srv->lock = xSemaphoreCreateMutex();
+    if (srv->lock == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    const esp_timer_create_args_t args = {
+        .callback = on_timer,
+        .arg = srv,
+        .dispatch_method = ESP_TIMER_TASK,
+        .name = name,
+    };
+    esp_timer_handle_t timer;
+    esp_err_t err = esp_timer_create(&args, &timer);
+    if (err != ESP_OK) {
+        vSemaphoreDelete((SemaphoreHandle_t)srv->lock);
+        return err;
+    }
+    srv->timer = timer;
+
+    srv->next = registry;
+    registry = srv;
+    ESP_LOGI(TAG, "🛡️ %s: %s server, %" PRIu32 " us every %" PRIu32 " us, priority %u (%u when spent)",
+             name, policy == APS_SPORADIC ? "sporadic" : "deferrable",
+             budget_us, period_us, high_prio, low_prio);
+    return ESP_OK;
+}
+
+void aps_begin(aps_server_t *srv) {
+    xSemaphoreTake((SemaphoreHandle_t)srv->lock, portMAX_DELAY);
+    if (srv->task == NULL) {
+        srv->task = xTaskGetCurrentTaskHandle();
+    }
+    aps_core_begin(&srv->core, esp_timer_get_time());
+    apply(srv);
+    xSemaphoreGive((SemaphoreHandle_t)srv->lock);
+}
+
+void aps_end(aps_server_t *srv) {
+    xSemaphoreTake((SemaphoreHandle_t)srv->lock, portMAX_DELAY);
+    aps_core_end(&srv->core, esp_timer_get_time());
+    apply(srv);
+    xSemaphoreGive((SemaphoreHandle_t)srv->lock);
+}
+
+void aps_get_stats(aps_server_t *srv, aps_stats_t *out) {
+    xSemaphoreTake((SemaphoreHandle_t)srv->lock, portMAX_DELAY);
+    int64_t now = esp_timer_get_time();
+    aps_core_update(&srv->core, now);
+    aps_core_stats(&srv->core, now, out);
+    xSemaphoreGive((SemaphoreHandle_t)srv->lock);
+}
+
+void aps_report(FILE *out) {
+    for (aps_server_t *srv = registry; srv != NULL; srv = srv->next) {
+        aps_stats_t st;
+        aps_get_stats(srv, &st);
+        fprintf(out, "apserver [%s]: %" PRIu32 " jobs, budget %.1f%% used (%.2f%% CPU), "
+                     "%" PRIu32 " exhausted, %" PRIu32 " ms demoted, job avg %" PRIu32 " us max %" PRIu32 " us, "
+                     "enforcement lag max %" PRIu32 " us, %" PRIu32 " us left\n",
+                srv->name, st.jobs, st.budget_used_pct, st.cpu_pct, st.exhausted, st.low_ms,
+                st.avg_job_us, st.max_job_us, st.max_overrun_us, st.capacity_us);
+    }
+}
+
+#endif // ESP_PLATFORM
@@ -0,0 +1,126 @@
+// Host check for the server accounting, simulated at 1 us resolution: a
+// served task gets bursts of jobs far bigger than its budget, each just
+// before a period boundary, while a mid-priority periodic task keeps the
+// CPU busy 60% of every millisecond.
+// The served task runs at high priority while aps_core_high() says so
+// (re-evaluated only at begin/end and at aps_core_next_event(), like the
+// enforcement timer on the device) and otherwise only in the mid task's
+// idle time. Checks the high-priority time in every sliding window of one
+// period: at most the budget for the sporadic server, up to twice it for
+// the deferrable one - and that the jobs still get done.
+//
+// Build and run from this directory:
+//   cc -O2 -I../include -I../../../tools/host_include ../apserver.c apserver_host_bench.c -o apserver_bench
+//   ./apserver_bench
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "apserver.h"
+#include "host_check.h"
+
+#define SIM_US          2000000
+#define BUDGET_US       5000
+#define PERIOD_US       20000
+#define MID_BUSY_US     600         // Of every 1000
+#define BURST_EVERY_US  100000
+#define BURST_LEAD_US   3000        // Bursts land this long before a period boundary
+#define BURST_JOBS      8
+#define JOB_US          2000
+
+static uint8_t high_run[SIM_US];
+
+static void simulate(aps_policy_t policy, const char *label, uint32_t max_window_allowed, bool expect_over_budget) {
+    aps_core_t c;
+    aps_core_init(&c, policy, BUDGET_US, PERIOD_US, 0);
+    bool high = true;
+    int64_t next_event = -1;
+    uint32_t queued = 0, remaining = 0, finished = 0, released = 0;
+
+    for (int64_t t = 0; t < SIM_US; t++) {
+        if ((t + BURST_LEAD_US) % BURST_EVERY_US == 0) {
+            queued += BURST_JOBS;
+            released += BURST_JOBS;
+        }
+        // Enforcement timer
+        if (next_event >= 0 && t >= next_event) {
+            aps_core_update(&c, t);
+            high = aps_core_high(&c);
+            next_event = aps_core_next_event(&c, t);
+        }
+        if (!c.active && queued > 0) {
+            queued--;
+            remaining = JOB_US;
+            aps_core_begin(&c, t);
+            high = aps_core_high(&c);
+            next_event = aps_core_next_event(&c, t);
+        }
+        high_run[t] = 0;
+        if (c.active) {
+            bool mid_busy = t % 1000 < MID_BUSY_US;
+            if (high) {
+                high_run[t] = 1;
+                remaining--;
+            } else if (!mid_busy) {
+                remaining--;
+            }
+            if (remaining == 0) {
+                aps_core_end(&c, t + 1);
+                high = aps_core_high(&c);
+                next_event = aps_core_next_event(&c, t + 1);
+                finished++;
+            }
+        }
+    }
+
+    // Largest high-priority time in any window of one period
+    uint32_t window = 0, max_window = 0;
+    for (int64_t t = 0; t < SIM_US; t++) {
+        window += high_run[t];
+        if (t >= PERIOD_US) {
+            window -= high_run[t - PERIOD_US];
+        }
+        if (window > max_window) {
+            max_window = window;
+        }
+    }
+
+    aps_stats_t st;
+    aps_core_stats(&c, SIM_US, &st);
+    printf("%-11s jobs %u/%u, max high time per %u us window %u us (budget %u), "
+           "budget %.1f%% used, %.1f%% CPU, %u exhausted, %u ms demoted, job max %u us\n",
+           label, finished, released, PERIOD_US, max_window, BUDGET_US,
+           st.budget_used_pct, st.cpu_pct, st.exhausted, st.low_ms, st.max_job_us);
+
+    CHECK(max_window <= max_window_allowed, "%s: %u us in one window", label, max_window);
+    if (expect_over_budget) {
+        CHECK(max_window > BUDGET_US, "%s: back-to-back budgets never showed", label);
+    }
+    CHECK(finished + (c.active ? 1 : 0) + queued == released, "%s: jobs lost", label);
+    CHECK(finished >= released - BURST_JOBS, "%s: only %u of %u jobs done", label, finished, released);
+    CHECK(st.exhausted > 0, "%s: bursts never exhausted the budget", label);
+}
+
+int main(void) {
+    simulate(APS_SPORADIC, "sporadic", BUDGET_US, false);
+    simulate(APS_DEFERRABLE, "deferrable", 2 * BUDGET_US, true);
+
+    // Replenishment list overflow folds late, never early
+    aps_core_t c;
+    aps_core_init(&c, APS_SPORADIC, 1000, 10000, 0);
+    int64_t t = 0;
+    for (int i = 0; i < 3 * APS_MAX_REPL; i++, t += 20) {
+        aps_core_begin(&c, t);
+        aps_core_end(&c, t + 10);
+    }
+    CHECK(c.nrepl == APS_MAX_REPL, "%u replenishments pending", c.nrepl);
+    uint32_t pending = c.capacity_us;
+    for (int i = 0; i < c.nrepl; i++) {
+        pending += c.repl[i].amount_us;
+    }
+    CHECK(pending == 1000, "budget not conserved: %u", pending);
+    aps_core_update(&c, 10000 + t);
+    CHECK(c.capacity_us == 1000, "budget not fully back: %u", c.capacity_us);
+
+    printf("\n%s\n", failures ? "FAILURES" : "OK");
+    return failures != 0;
+}
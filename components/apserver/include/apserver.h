@@ -0,0 +1,151 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include "esp_err.h"
+
+// ================ APERIODIC SERVERS ================
+// Gives an event-driven task a CPU budget: while it has budget left it
+// runs at a high priority (so events are handled promptly), and once the
+// budget is spent it drops to a background priority until the budget is
+// replenished. Tasks above the background priority therefore lose at
+// most `budget_us` per `period_us` to it, however the events bunch up.
+//
+//   static aps_server_t srv_button;
+//   aps_init(&srv_button, "button", APS_SPORADIC, 20000, 1000000, 4, 1);
+//
+//   for (;;) {
+//       xSemaphoreTake(sem, portMAX_DELAY);
+//       aps_begin(&srv_button);        // job starts: charged from here
+//       ... handle the event ...
+//       aps_end(&srv_button);
+//   }
+//
+// Policies:
+//   APS_SPORADIC    Budget used from an activation at time t comes back
+//                   at t + period. Interference in any window of one
+//                   period is at most the budget - the server behaves
+//                   like a periodic task of (budget, period) in a
+//                   rate-monotonic analysis.
+//   APS_DEFERRABLE  The full budget comes back at every period boundary.
+//                   Simpler, but budget spent at the end of one period
+//                   and again at the start of the next can hit a lower
+//                   task with up to 2 x budget back to back.
+//
+// Time between begin and end is charged as wall-clock time, including
+// any time the job spends preempted or blocked, so the accounting errs
+// towards demoting early - the guarantee to the other tasks holds, the
+// served task just gets less than its nominal budget when it's
+// interrupted. Keep blocking calls outside begin/end.
+//
+// Exhaustion is enforced by a one-shot esp_timer that lowers the task's
+// priority; how late that lands is reported as the enforcement lag.
+// One task per server (the one calling aps_begin()).
+//
+// aps_core_* is only the budget arithmetic, on times it is handed;
+// priorities and the enforcement timer are aps_init()/aps_begin()/aps_end().
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define APS_MAX_REPL        8       // Pending sporadic replenishments
+
+typedef enum {
+    APS_SPORADIC,
+    APS_DEFERRABLE,
+} aps_policy_t;
+
+typedef struct {
+    int64_t at;
+    uint32_t amount_us;
+} aps_repl_t;
+
+typedef struct {
+    aps_policy_t policy;
+    uint32_t budget_us;
+    uint32_t period_us;
+
+    uint32_t capacity_us;           // Budget left
+    bool active;                    // Between begin and end
+    int64_t last;                   // Charged up to here
+    int64_t chunk_start;            // Sporadic: activation the open chunk replenishes from
+    uint32_t chunk_used_us;
+    aps_repl_t repl[APS_MAX_REPL];  // Sorted by time
+    uint8_t nrepl;
+    int64_t next_period;            // Deferrable
+    int64_t job_start;
+    int64_t created;
+
+    // Statistics
+    uint32_t jobs;
+    uint32_t exhausted;             // Jobs that ran out of budget
+    uint64_t used_us;               // Charged at the high priority
+    uint64_t low_us;                // Spent demoted
+    uint64_t job_us;                // Sum of job response times
+    uint32_t max_job_us;
+    uint32_t max_overrun_us;        // Ran on past exhaustion (enforcement lag)
+} aps_core_t;
+
+typedef struct {
+    uint32_t jobs;
+    uint32_t exhausted;
+    uint32_t capacity_us;
+    float budget_used_pct;          // Of the budget made available so far
+    float cpu_pct;                  // Of wall time, at the high priority
+    uint32_t low_ms;
+    uint32_t avg_job_us;
+    uint32_t max_job_us;
+    uint32_t max_overrun_us;
+} aps_stats_t;
+
+// ---- Accounting core (times in microseconds, any monotonic clock) ----
+
+void aps_core_init(aps_core_t *c, aps_policy_t policy, uint32_t budget_us, uint32_t period_us, int64_t now);
+
+// Bring the books up to `now`: charge, replenish, exhaust
+void aps_core_update(aps_core_t *c, int64_t now);
+
+void aps_core_begin(aps_core_t *c, int64_t now);
+void aps_core_end(aps_core_t *c, int64_t now);
+
+// Should the served task be at its high priority right now?
+static inline bool aps_core_high(const aps_core_t *c) {
+    return c->capacity_us > 0;
+}
+
+// When the answer to aps_core_high() may change next (budget runs out
+// or comes back); -1 if nothing is due
+int64_t aps_core_next_event(const aps_core_t *c, int64_t now);
+
+void aps_core_stats(const aps_core_t *c, int64_t now, aps_stats_t *out);
+
+// ---- Device ----
+
+typedef struct aps_server {
+    aps_core_t core;
+    const char *name;
+    uint8_t high_prio;
+    uint8_t low_prio;
+    uint8_t applied_prio;
+    void *task;                     // TaskHandle_t of the served task
+    void *timer;                    // esp_timer_handle_t
+    void *lock;                     // SemaphoreHandle_t
+    struct aps_server *next;
+} aps_server_t;
+
+esp_err_t aps_init(aps_server_t *srv, const char *name, aps_policy_t policy,
+                   uint32_t budget_us, uint32_t period_us, uint8_t high_prio, uint8_t low_prio);
+
+void aps_begin(aps_server_t *srv);
+void aps_end(aps_server_t *srv);
+
+void aps_get_stats(aps_server_t *srv, aps_stats_t *out);
+
+// One line per server: jobs, budget consumption, demotions, response
+void aps_report(FILE *out);
+
+#ifdef __cplusplus
+}
+#endif
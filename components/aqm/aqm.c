@@ -0,0 +1,61 @@
+#include <math.h>
+#include "aqm.h"
+
+// ================ CODEL ================
+
+void aqm_codel_init(aqm_codel_t *c, uint32_t target_us, uint32_t interval_us) {
+    *c = (aqm_codel_t){ .target_us = target_us, .interval_us = interval_us };
+}
+
+static bool reached(uint32_t now_us, uint32_t when) {
+    return (int32_t)(now_us - when) >= 0;
+}
+
+// Drops get closer together as interval / sqrt(count): a standing queue
+// that survives one drop per interval gets two, then three, ...
+static uint32_t control_law(const aqm_codel_t *c, uint32_t t) {
+    return t + (uint32_t)(c->interval_us / sqrtf((float)c->count));
+}
+
+// Has the sojourn been over target for at least an interval?
+static bool over_target(aqm_codel_t *c, uint32_t sojourn_us, uint32_t now_us, uint32_t backlog) {
+    if (sojourn_us < c->target_us || backlog == 0) {
+        c->above = false;
+        return false;
+    }
+    if (!c->above) {
+        c->above = true;
+        c->first_above = now_us + c->interval_us;
+        return false;
+    }
+    return reached(now_us, c->first_above);
+}
+
+bool aqm_codel_drop(aqm_codel_t *c, uint32_t sojourn_us, uint32_t now_us, uint32_t backlog) {
+    bool over = over_target(c, sojourn_us, now_us, backlog);
+
+    if (c->dropping) {
+        if (!over) {
+            c->dropping = false;
+            return false;
+        }
+        if (!reached(now_us, c->drop_next)) {
+            return false;
+        }
+        c->count++;
+        c->drop_next = control_law(c, c->drop_next);
+        return true;
+    }
+    if (!over) {
+        return false;
+    }
+
+    // Enter dropping. Back soon after leaving it: resume near the old
+    // drop rate instead of starting again from one per interval
+    c->dropping = true;
+    uint32_t delta = c->count - c->lastcount;
+    c->count = delta > 1 && !reached(now_us, c->drop_next + 16 * c->interval_us) ? delta : 1;
+    c->lastcount = c->count;
+    c->drop_next = control_law(c, now_us);
+    return true;
+}
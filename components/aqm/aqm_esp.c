@@ -0,0 +1,128 @@
+#ifdef ESP_PLATFORM
+
+#include <string.h>
+#include <inttypes.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "esp_timer.h"
+#include "esp_log.h"
+#include "aqm.h"
+
+static const char *TAG = "AQM";
+
+static aqm_queue_t *registry;
+
+// What actually travels through the FreeRTOS queue
+typedef struct {
+    uint32_t stamp_us;
+    uint8_t data[AQM_MAX_ITEM];
+} slot_t;
+
+static uint32_t now_us(void) {
+    return (uint32_t)esp_timer_get_time();
+}
+
+esp_err_t aqm_create(aqm_queue_t *q, const char *name, uint32_t length, size_t item_size,
+                     const aqm_config_t *cfg) {
+    aqm_config_t defaults = AQM_CONFIG_DEFAULT();
+    if (cfg == NULL) {
+        cfg = &defaults;
+    }
+    if (item_size == 0 || item_size > AQM_MAX_ITEM || cfg->target_us == 0 || cfg->interval_us < cfg->target_us) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    memset(q, 0, sizeof(*q));
+    q->queue = xQueueCreate(length, offsetof(slot_t, data) + item_size);
+    if (q->queue == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    q->name = name;
+    q->cfg = *cfg;
+    q->item_size = item_size;
+    aqm_codel_init(&q->codel, cfg->target_us, cfg->interval_us);
+    portMUX_INITIALIZE(&q->lock);
+
+    q->next = registry;
+    registry = q;
+    static const char *modes[] = { "tail drop", "CoDel drop", "CoDel mark" };
+    ESP_LOGI(TAG, "📥 %s: %lu x %u B, %s, target %lu ms / interval %lu ms",
+             name, length, (unsigned)item_size, modes[cfg->mode],
+             cfg->target_us / 1000, cfg->interval_us / 1000);
+    return ESP_OK;
+}
+
+BaseType_t aqm_send(aqm_queue_t *q, const void *item, TickType_t wait) {
+    slot_t slot;
+    memcpy(slot.data, item, q->item_size);
+    slot.stamp_us = now_us();
+    if (xQueueSend(q->queue, &slot, wait) != pdPASS) {
+        __atomic_fetch_add(&q->tail_drops, 1, __ATOMIC_RELAXED);
+        return errQUEUE_FULL;
+    }
+    __atomic_fetch_add(&q->enqueued, 1, __ATOMIC_RELAXED);
+    return pdPASS;
+}
+
+BaseType_t aqm_receive(aqm_queue_t *q, void *item, TickType_t wait, bool *marked) {
+    slot_t slot;
+    bool mark = false;
+    for (;;) {
+        if (xQueueReceive(q->queue, &slot, wait) != pdPASS) {
+            return pdFAIL;
+        }
+        wait = 0;                   // Only the first receive waits
+        uint32_t now = now_us();
+        uint32_t sojourn = now - slot.stamp_us;
+        uint32_t backlog = uxQueueMessagesWaiting(q->queue);
+
+        taskENTER_CRITICAL(&q->lock);
+        bool drop = q->cfg.mode != AQM_TAIL_DROP && aqm_codel_drop(&q->codel, sojourn, now, backlog);
+        if (drop && q->cfg.mode == AQM_CODEL_DROP) {
+            q->aqm_drops++;
+            taskEXIT_CRITICAL(&q->lock);
+            if (q->cfg.on_drop != NULL) {
+                q->cfg.on_drop(slot.data, q->cfg.drop_ctx);
+            }
+            continue;               // Head drop: try the next one
+        }
+        if (drop) {
+            q->marks++;
+            mark = true;
+        }
+        q->delivered++;
+        q->sojourn_sum_us += sojourn;
+        if (sojourn > q->sojourn_max_us) {
+            q->sojourn_max_us = sojourn;
+        }
+        taskEXIT_CRITICAL(&q->lock);
+        break;
+    }
+    memcpy(item, slot.data, q->item_size);
+    if (marked != NULL) {
+        *marked = mark;
+    }
+    return pdPASS;
+}
+
+void aqm_report(FILE *out) {
+    for (aqm_queue_t *q = registry; q != NULL; q = q->next) {
+        taskENTER_CRITICAL(&q->lock);
+        uint32_t delivered = q->delivered, aqm_drops = q->aqm_drops, marks = q->marks;
+        uint32_t max_us = q->sojourn_max_us;
+        uint64_t sum_us = q->sojourn_sum_us;
+        bool dropping = q->codel.dropping;
+        taskEXIT_CRITICAL(&q->lock);
+        uint32_t enqueued = __atomic_load_n(&q->enqueued, __ATOMIC_RELAXED);
+        uint32_t tail = __atomic_load_n(&q->tail_drops, __ATOMIC_RELAXED);
+        uint32_t offered = enqueued + tail;
+
+        fprintf(out, "aqm [%s]: %" PRIu32 " in, %" PRIu32 " out, %" PRIu32 " tail drops, %" PRIu32 " head drops, "
+                     "%" PRIu32 " marked (%.1f%% of offered shed), sojourn avg %" PRIu32 " ms max %" PRIu32 " ms%s\n",
+                q->name, enqueued, delivered, tail, aqm_drops, marks,
+                offered ? 100.0 * (tail + aqm_drops + marks) / offered : 0.0,
+                delivered ? (uint32_t)(sum_us / delivered / 1000) : 0, max_us / 1000,
+                dropping ? ", dropping" : "");
+    }
+}
+
+#endif // ESP_PLATFORM
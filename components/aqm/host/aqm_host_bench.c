@@ -0,0 +1,117 @@
+// Host check for the CoDel state machine, in virtual time: Poisson
+// arrivals into one FIFO server with exponential service (1 ms mean).
+// At 120% load a tail-drop queue with a deep buffer fills and every item
+// waits ~buffer / rate; CoDel on the same buffer must keep the sojourn
+// far below that, independent of the buffer, while still delivering the
+// server's full throughput. These arrivals don't slow down when dropped
+// (open loop), so CoDel's drop rate - ramping with sqrt(count) - holds
+// the sojourn around an interval rather than at target.
+// At 70% load (bursty but not overloaded) CoDel must leave it alone.
+//
+// Build and run from this directory:
+//   cc -O2 -I../include -I../../../tools/host_include ../aqm.c aqm_host_bench.c -lm -o aqm_bench
+//   ./aqm_bench
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include "aqm.h"
+#include "host_check.h"
+
+#define SERVICE_US      1000
+#define BUFFER          1000
+#define DURATION_US     200000000u  // 200 s virtual
+#define TARGET_US       5000
+#define INTERVAL_US     100000
+
+typedef struct {
+    uint32_t offered, tail_drops, head_drops, delivered;
+    uint32_t p50_us, p99_us, max_us;
+    double goodput;                 // Delivered per second
+} result_t;
+
+static uint64_t rng = 88172645463325252ull;
+
+static uint32_t exp_us(double mean_us) {
+    rng ^= rng << 13;
+    rng ^= rng >> 7;
+    rng ^= rng << 17;
+    double u = ((rng >> 11) + 1) * (1.0 / 9007199254740992.0);
+    return (uint32_t)(-log(u) * mean_us) + 1;
+}
+
+static int cmp_u32(const void *a, const void *b) {
+    uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+    return x < y ? -1 : x > y;
+}
+
+static result_t simulate(double load, bool codel) {
+    static uint32_t queue[BUFFER];
+    static uint32_t sojourns[DURATION_US / SERVICE_US * 2];
+    uint32_t head = 0, len = 0;
+    aqm_codel_t c;
+    aqm_codel_init(&c, TARGET_US, INTERVAL_US);
+    result_t r = { 0 };
+
+    uint32_t now = 0, next_arrival = exp_us(SERVICE_US / load), free_at = 0;
+    bool busy = false;
+    while (now < DURATION_US) {
+        if (busy && free_at <= next_arrival) {
+            now = free_at;
+            busy = false;
+        } else {
+            now = next_arrival;
+            next_arrival += exp_us(SERVICE_US / load);
+            r.offered++;
+            if (len == BUFFER) {
+                r.tail_drops++;
+            } else {
+                queue[(head + len++) % BUFFER] = now;
+            }
+        }
+        while (!busy && len > 0) {
+            uint32_t sojourn = now - queue[head];
+            head = (head + 1) % BUFFER;
+            len--;
+            if (codel && aqm_codel_drop(&c, sojourn, now, len)) {
+                r.head_drops++;
+                continue;
+            }
+            sojourns[r.delivered++] = sojourn;
+            free_at = now + exp_us(SERVICE_US);
+            busy = true;
+        }
+    }
+    qsort(sojourns, r.delivered, sizeof(sojourns[0]), cmp_u32);
+    r.p50_us = sojourns[r.delivered / 2];
+    r.p99_us = sojourns[(uint32_t)(r.delivered * 0.99)];
+    r.max_us = sojourns[r.delivered - 1];
+    r.goodput = r.delivered / (DURATION_US / 1e6);
+    printf("  %-10s load %.1f: %6u offered, %6u tail drops, %6u head drops, %7.0f/s out, "
+           "sojourn p50 %6.1f ms p99 %6.1f ms max %6.1f ms\n",
+           codel ? "CoDel" : "tail drop", load, r.offered, r.tail_drops, r.head_drops, r.goodput,
+           r.p50_us / 1000.0, r.p99_us / 1000.0, r.max_us / 1000.0);
+    return r;
+}
+
+int main(void) {
+    printf("overload:\n");
+    result_t tail = simulate(1.2, false);
+    result_t codel = simulate(1.2, true);
+    CHECK(tail.p50_us > 500000, "tail drop p50 %u us - buffer never filled?", tail.p50_us);
+    CHECK(codel.p50_us < 2 * INTERVAL_US && codel.p50_us < tail.p50_us / 4,
+          "CoDel p50 %u us vs tail drop %u us", codel.p50_us, tail.p50_us);
+    CHECK(codel.max_us < 5 * INTERVAL_US, "CoDel max sojourn %u us", codel.max_us);
+    CHECK(codel.tail_drops == 0, "CoDel still filled the buffer (%u tail drops)", codel.tail_drops);
+    CHECK(codel.goodput > 0.95 * 1e6 / SERVICE_US, "CoDel goodput %.0f/s, server does %u/s",
+          codel.goodput, 1000000 / SERVICE_US);
+
+    printf("normal load:\n");
+    simulate(0.7, false);
+    result_t light = simulate(0.7, true);
+    CHECK(light.head_drops < light.offered / 500, "CoDel dropped %u of %u at 70%% load",
+          light.head_drops, light.offered);
+
+    printf("\n%s\n", failures ? "FAILURES" : "OK");
+    return failures != 0;
+}
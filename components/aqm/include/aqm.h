@@ -0,0 +1,143 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include "esp_err.h"
+
+#ifdef ESP_PLATFORM
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#endif
+
+// ================ ACTIVE QUEUE MANAGEMENT ================
+// A FreeRTOS queue that keeps its queueing delay bounded under overload
+// instead of filling up and making every item wait through a full
+// buffer. Modelled on CoDel (RFC 8289):
+//
+//   - every item is stamped on the way in; its sojourn time is measured
+//     on the way out
+//   - once the sojourn has stayed above `target` for a whole `interval`
+//     (so a burst that drains on its own is left alone), items are
+//     dropped at the head, the next one after interval / sqrt(count),
+//     until the sojourn falls under target again
+//
+// Dropping at the head discards the stalest work first and tells the
+// consumer about the overload as early as possible. Modes, per queue:
+//
+//   AQM_TAIL_DROP   plain queue: refuse new items only when full
+//   AQM_CODEL_DROP  CoDel drops at the head (and tail drop when full)
+//   AQM_CODEL_MARK  CoDel decides, but the item is delivered with
+//                   *marked = true for the consumer to shed cheaply
+//
+// A head drop happens inside aqm_receive(), where the producer can't see
+// it; on_drop (may be NULL) gets each dropped item there, in the
+// consumer's task, to settle whatever the item stood for.
+//
+// target should sit a little above one item's normal service time and
+// interval a few times that; the defaults are CoDel's network values.
+// Producers that don't back off when their items are dropped (open
+// loop) hold the sojourn nearer one interval than target - still
+// bounded, whatever the queue length.
+//
+//   static aqm_queue_t products;
+//   aqm_config_t cfg = AQM_CONFIG_DEFAULT();
+//   cfg.target_us = 2500000;
+//   aqm_create(&products, "products", 10, sizeof(item_t), &cfg);
+//
+//   aqm_send(&products, &item, pdMS_TO_TICKS(100));
+//   aqm_receive(&products, &item, portMAX_DELAY, &marked);
+//
+// Times are microseconds (low 32 bits of esp_timer_get_time(); sojourns
+// over ~35 min are out of range). aqm_codel_drop() is handed the sojourn
+// and the clock instead of reading them, so the drop law can be replayed
+// against a simulated queue.
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define AQM_MAX_ITEM        120     // Largest item aqm_send() can carry
+
+typedef enum {
+    AQM_TAIL_DROP,
+    AQM_CODEL_DROP,
+    AQM_CODEL_MARK,
+} aqm_mode_t;
+
+typedef void (*aqm_drop_fn)(const void *item, void *ctx);
+
+typedef struct {
+    aqm_mode_t mode;
+    uint32_t target_us;             // Acceptable standing sojourn
+    uint32_t interval_us;           // How long it must persist before acting
+    aqm_drop_fn on_drop;            // AQM_CODEL_DROP head drops, may be NULL
+    void *drop_ctx;
+} aqm_config_t;
+
+#define AQM_CONFIG_DEFAULT() {      \
+    .mode = AQM_CODEL_DROP,         \
+    .target_us = 5000,              \
+    .interval_us = 100000,          \
+}
+
+// ---- CoDel state machine (portable) ----
+
+typedef struct {
+    uint32_t target_us;
+    uint32_t interval_us;
+    bool above;                     // Sojourn over target since first_above
+    uint32_t first_above;           // When "above" may turn into dropping
+    bool dropping;
+    uint32_t drop_next;
+    uint32_t count;                 // Drops in this dropping state
+    uint32_t lastcount;
+} aqm_codel_t;
+
+void aqm_codel_init(aqm_codel_t *c, uint32_t target_us, uint32_t interval_us);
+
+// For each dequeued item: should it be dropped (or marked)? `backlog`
+// is what is left in the queue behind it - an item that empties the
+// queue is never dropped.
+bool aqm_codel_drop(aqm_codel_t *c, uint32_t sojourn_us, uint32_t now_us, uint32_t backlog);
+
+// ---- Device ----
+
+#ifdef ESP_PLATFORM
+typedef struct aqm_queue {
+    const char *name;
+    aqm_config_t cfg;
+    QueueHandle_t queue;            // The underlying queue (for uxQueueMessagesWaiting())
+    size_t item_size;
+    aqm_codel_t codel;
+    portMUX_TYPE lock;              // codel and the sojourn stats
+
+    // Statistics
+    uint32_t enqueued;
+    uint32_t tail_drops;            // Refused when full
+    uint32_t aqm_drops;
+    uint32_t marks;
+    uint32_t delivered;
+    uint64_t sojourn_sum_us;        // Of delivered items
+    uint32_t sojourn_max_us;
+    struct aqm_queue *next;
+} aqm_queue_t;
+
+esp_err_t aqm_create(aqm_queue_t *q, const char *name, uint32_t length, size_t item_size,
+                     const aqm_config_t *cfg);
+
+// pdPASS, or errQUEUE_FULL after `wait` (a tail drop)
+BaseType_t aqm_send(aqm_queue_t *q, const void *item, TickType_t wait);
+
+// Next item that survives the AQM; `wait` applies to the first receive
+// only. marked may be NULL (AQM_CODEL_MARK needs it to mean anything).
+BaseType_t aqm_receive(aqm_queue_t *q, void *item, TickType_t wait, bool *marked);
+
+// One line per queue: drops by cause, marks, sojourn avg/max
+void aqm_report(FILE *out);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,133 @@
+#include <string.h>
+#include "cfgblob.h"
+#include "integrity.h"
+
+#ifdef ESP_PLATFORM
+#include "esp_partition.h"
+#endif
+
+_Static_assert(sizeof(cfgblob_header_t) == 16, "cfgblob header layout");
+_Static_assert(sizeof(cfgblob_section_t) == 12, "cfgblob section layout");
+
+static inline const cfgblob_section_t *section_table(const cfgblob_header_t *blob) {
+    return (const cfgblob_section_t *)(blob + 1);
+}
+
+static inline bool in_bounds(const cfgblob_header_t *blob, uint32_t offset, uint64_t len) {
+    return (uint64_t)offset + len <= blob->total_size;
+}
+
+esp_err_t cfgblob_check(const void *data, size_t available) {
+    const cfgblob_header_t *blob = (const cfgblob_header_t *)data;
+
+    if (data == NULL || ((uintptr_t)data & (CFGBLOB_ALIGN - 1)) ||
+        available < sizeof(cfgblob_header_t)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (blob->magic != CFGBLOB_MAGIC) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    if (blob->format_version != CFGBLOB_FORMAT_VERSION) {
+        return ESP_ERR_INVALID_VERSION;
+    }
+
+    size_t table_end = sizeof(cfgblob_header_t) +
+                       (size_t)blob->section_count * sizeof(cfgblob_section_t);
+    if (blob->total_size > available || blob->total_size < table_end) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    uint32_t crc = integrity_crc32(0, (const uint8_t *)data + sizeof(cfgblob_header_t),
+                                   blob->total_size - sizeof(cfgblob_header_t));
+    if (crc != blob->crc32) {
+        return ESP_ERR_INVALID_CRC;
+    }
+
+    const cfgblob_section_t *table = section_table(blob);
+    for (uint16_t i = 0; i < blob->section_count; i++) {
+        if ((table[i].offset & (CFGBLOB_ALIGN - 1)) || table[i].offset < table_end ||
+            !in_bounds(blob, table[i].offset, table[i].size)) {
+            return ESP_ERR_INVALID_SIZE;
+        }
+    }
+    return ESP_OK;
+}
+
+const void *cfgblob_find(const cfgblob_header_t *blob, uint16_t id,
+                         uint16_t *version, uint32_t *size) {
+    if (blob == NULL) {
+        return NULL;
+    }
+
+    const cfgblob_section_t *table = section_table(blob);
+    for (uint16_t i = 0; i < blob->section_count; i++) {
+        if (table[i].id == id) {
+            if (version) *version = table[i].version;
+            if (size) *size = table[i].size;
+            return (const uint8_t *)blob + table[i].offset;
+        }
+    }
+    return NULL;
+}
+
+const void *cfgblob_section_get(const cfgblob_header_t *blob, uint16_t id, size_t size,
+                                const void *defaults, void *scratch) {
+    uint32_t have = 0;
+    const void *section = cfgblob_find(blob, id, NULL, &have);
+
+    if (section == NULL) {
+        return defaults;
+    }
+    if (have >= size) {
+        return section;
+    }
+
+    // Older blob: fields it predates keep their compiled-in defaults
+    memcpy(scratch, defaults, size);
+    memcpy(scratch, section, have);
+    return scratch;
+}
+
+const char *cfgblob_string(const cfgblob_header_t *blob, cfgblob_str_t ref) {
+    if (blob == NULL || !in_bounds(blob, ref.offset, (uint64_t)ref.length + 1)) {
+        return NULL;
+    }
+    const char *str = (const char *)blob + ref.offset;
+    return str[ref.length] == '\0' ? str : NULL;
+}
+
+const void *cfgblob_array(const cfgblob_header_t *blob, cfgblob_array_t ref, size_t elem_size) {
+    if (blob == NULL || (ref.offset & (CFGBLOB_ALIGN - 1)) ||
+        !in_bounds(blob, ref.offset, (uint64_t)ref.count * elem_size)) {
+        return NULL;
+    }
+    return (const uint8_t *)blob + ref.offset;
+}
+
+#ifdef ESP_PLATFORM
+esp_err_t cfgblob_open_partition(const char *label, const cfgblob_header_t **blob) {
+    const esp_partition_t *part = esp_partition_find_first(ESP_PARTITION_TYPE_DATA,
+                                                           ESP_PARTITION_SUBTYPE_ANY,
+                                                           label);
+    if (part == NULL) {
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    const void *mapped;
+    esp_partition_mmap_handle_t handle;
+    esp_err_t err = esp_partition_mmap(part, 0, part->size, ESP_PARTITION_MMAP_DATA,
+                                       &mapped, &handle);
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    err = cfgblob_check(mapped, part->size);
+    if (err != ESP_OK) {
+        esp_partition_munmap(handle);
+        return err;
+    }
+
+    *blob = (const cfgblob_header_t *)mapped;
+    return ESP_OK;
+}
+#endif
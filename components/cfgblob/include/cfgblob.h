@@ -0,0 +1,86 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include "esp_err.h"
+
+// ================ CONFIG BLOB ================
+// Fixed-layout binary configuration that is used in place: after one CRC
+// check, sections are read through plain struct pointers into the blob
+// (memory-mapped flash on the device). No parsing, no copies.
+//
+//   | header (16) | section table (12 x n) | section data ... | strings |
+//
+// Every section has an id, a version and a size. Sections only grow by
+// appending fields; a reader that knows a newer layout than the blob
+// carries gets the blob's prefix merged over its defaults (see
+// cfgblob_section_get). Variable-length data (strings, arrays) lives after
+// the fixed sections and is referenced by blob-relative offsets.
+//
+// Blobs are produced on the host by tools/cfgblob/cfgc.py.
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define CFGBLOB_MAGIC           0x31474643u     // "CFG1"
+#define CFGBLOB_FORMAT_VERSION  1
+#define CFGBLOB_ALIGN           4
+
+typedef struct {
+    uint32_t magic;
+    uint16_t format_version;
+    uint16_t section_count;
+    uint32_t total_size;        // Header + table + data
+    uint32_t crc32;             // CRC-32 of bytes [sizeof(header), total_size)
+} cfgblob_header_t;
+
+typedef struct {
+    uint16_t id;
+    uint16_t version;
+    uint32_t offset;            // From start of blob, CFGBLOB_ALIGN aligned
+    uint32_t size;
+} cfgblob_section_t;
+
+// Variable-length field references (offsets from start of blob)
+typedef struct {
+    uint32_t offset;
+    uint32_t length;            // Excluding the terminating NUL
+} cfgblob_str_t;
+
+typedef struct {
+    uint32_t offset;
+    uint32_t count;
+} cfgblob_array_t;
+
+// Validate magic, format version, size, CRC and section bounds.
+// Everything below assumes the blob passed this check.
+esp_err_t cfgblob_check(const void *blob, size_t available);
+
+// Locate a section. Returns NULL if absent; version/size are optional outputs.
+const void *cfgblob_find(const cfgblob_header_t *blob, uint16_t id,
+                         uint16_t *version, uint32_t *size);
+
+// Section as a 'size'-byte struct:
+//  - blob section at least that large -> pointer into the blob (zero copy)
+//  - older, shorter section           -> prefix copied over 'defaults' into 'scratch'
+//  - section or blob missing          -> 'defaults'
+const void *cfgblob_section_get(const cfgblob_header_t *blob, uint16_t id, size_t size,
+                                const void *defaults, void *scratch);
+
+#define CFGBLOB_SECTION(blob, id, type, defaults, scratch) \
+    ((const type *)cfgblob_section_get((blob), (id), sizeof(type), (defaults), (scratch)))
+
+// Resolve references; NULL if the reference points outside the blob
+const char *cfgblob_string(const cfgblob_header_t *blob, cfgblob_str_t ref);
+const void *cfgblob_array(const cfgblob_header_t *blob, cfgblob_array_t ref, size_t elem_size);
+
+#ifdef ESP_PLATFORM
+// Memory-map a data partition and check the blob inside it. The mapping
+// stays for the life of the program, so returned pointers never dangle.
+esp_err_t cfgblob_open_partition(const char *label, const cfgblob_header_t **blob);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
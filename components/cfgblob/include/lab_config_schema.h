@@ -0,0 +1,62 @@
+#pragma once
+
+#include <stdint.h>
+#include "cfgblob.h"
+
+// ================ LAB CONFIG SCHEMA ================
+// Section layouts shared by the labs and tools/cfgblob/cfgc.py.
+// Rules: never reorder or resize a field; append new fields at the end
+// and bump the section version in both this file and cfgc.py.
+
+#define LAB_CONFIG_PARTITION    "config"
+
+// Accepted range of every *_ms field. cfgc.py refuses blobs outside it and
+// the labs check again on load: a hand-edited or old blob must not turn a
+// period into 0 (a task spinning on vTaskDelay(0)) or into hours.
+#define CFG_MS_MIN              100
+#define CFG_MS_MAX              3600000     // 1 h
+
+typedef enum {
+    CFG_SECTION_SYSTEM_TIMING = 1,  // 06-event-groups/lab1
+    CFG_SECTION_ADAPTIVE      = 2,  // 06-event-groups/lab3
+    CFG_SECTION_POOLS         = 3,  // 07-memory-management/lab2
+} cfg_section_id_t;
+
+// Section 1, version 1
+typedef struct {
+    uint32_t network_check_ms;
+    uint32_t sensor_sample_ms;
+    uint32_t config_check_ms;
+    uint32_t storage_flush_ms;
+    uint32_t storage_report_ms;
+    uint32_t health_check_ms;
+} cfg_system_timing_t;
+
+// Section 2, version 1
+typedef struct {
+    float motion_sensitivity;
+    float sensitivity_min;
+    float sensitivity_max;
+    uint32_t auto_light_timeout_ms;
+    uint32_t security_delay_ms;
+    uint8_t learning_mode;
+    uint8_t reserved[3];
+} cfg_adaptive_t;
+
+// Element of cfg_pools_t.pools
+typedef struct {
+    cfgblob_str_t name;
+    uint32_t block_size;
+    uint32_t block_count;
+    uint32_t caps;              // MALLOC_CAP_* bits
+} cfg_pool_entry_t;
+
+// Section 3, version 1
+typedef struct {
+    cfgblob_array_t pools;      // cfg_pool_entry_t[], ascending block_size
+} cfg_pools_t;
+
+_Static_assert(sizeof(cfg_system_timing_t) == 24, "keep in sync with cfgc.py");
+_Static_assert(sizeof(cfg_adaptive_t) == 24, "keep in sync with cfgc.py");
+_Static_assert(sizeof(cfg_pool_entry_t) == 20, "keep in sync with cfgc.py");
+_Static_assert(sizeof(cfg_pools_t) == 8, "keep in sync with cfgc.py");
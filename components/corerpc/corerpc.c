@@ -0,0 +1,156 @@
+#include <string.h>
+#include "corerpc.h"
+
+// ================ SLOTS AND RING ================
+// Slot life cycle:
+//
+//   FREE -alloc-> (filled in) -push-> QUEUED -pop-> RUNNING -complete-> DONE -release-> FREE
+//                                       |               |
+//                                       +---abandon-----+--> ABANDONED -> freed by the server
+//
+// The ring only ever holds slots that are QUEUED or ABANDONED-while-
+// queued, so it can't hold more than RPC_MAX_INFLIGHT entries.
+
+#define LOAD(p, order)          __atomic_load_n(p, order)
+#define STORE(p, v, order)      __atomic_store_n(p, v, order)
+#define CAS(p, expect, want)    __atomic_compare_exchange_n(p, expect, want, false, \
+                                                            __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)
+#define COUNT(p)                __atomic_fetch_add(p, 1, __ATOMIC_RELAXED)
+
+static void lat_add(rpc_lat_t *l, uint32_t us) {
+    l->count++;
+    l->sum_us += us;
+    if (us > l->max_us) {
+        l->max_us = us;
+    }
+    int b = 0;
+    while (b < RPC_LAT_BUCKETS - 1 && us >= (16u << b)) {
+        b++;
+    }
+    l->hist[b]++;
+}
+
+uint32_t rpc_lat_percentile(const rpc_lat_t *l, uint32_t pct) {
+    if (l->count == 0) {
+        return 0;
+    }
+    uint64_t want = ((uint64_t)l->count * pct + 99) / 100;
+    uint64_t seen = 0;
+    for (int b = 0; b < RPC_LAT_BUCKETS - 1; b++) {
+        seen += l->hist[b];
+        if (seen >= want) {
+            return 16u << b;
+        }
+    }
+    return l->max_us;
+}
+
+void rpc_core_init(rpc_core_t *c) {
+    memset(c, 0, sizeof(*c));
+    c->free_mask = RPC_MAX_INFLIGHT == 32 ? UINT32_MAX : (1u << RPC_MAX_INFLIGHT) - 1;
+}
+
+static void free_slot(rpc_core_t *c, int slot) {
+    STORE(&c->slots[slot].state, RPC_FREE, __ATOMIC_RELAXED);
+    __atomic_fetch_or(&c->free_mask, 1u << slot, __ATOMIC_RELEASE);
+}
+
+int rpc_core_alloc(rpc_core_t *c) {
+    uint32_t mask = LOAD(&c->free_mask, __ATOMIC_ACQUIRE);
+    while (mask != 0) {
+        int slot = __builtin_ctz(mask);
+        if (CAS(&c->free_mask, &mask, mask & ~(1u << slot))) {
+            c->slots[slot].detached = false;
+            return slot;
+        }
+    }
+    COUNT(&c->busy);
+    return -1;
+}
+
+void rpc_core_push(rpc_core_t *c, int slot, uint32_t now_us) {
+    rpc_slot_t *s = &c->slots[slot];
+    s->submit_us = now_us;
+    STORE(&s->state, RPC_QUEUED, __ATOMIC_RELAXED);
+    COUNT(s->detached ? &c->posts : &c->calls);
+
+    uint32_t head = LOAD(&c->head, __ATOMIC_RELAXED);
+    c->ring[head % RPC_MAX_INFLIGHT] = (uint8_t)slot;
+    STORE(&c->head, head + 1, __ATOMIC_SEQ_CST);    // Publishes the slot; ordered before wake()
+}
+
+bool rpc_core_wake(rpc_core_t *c) {
+    return __atomic_exchange_n(&c->idle, 0, __ATOMIC_SEQ_CST) != 0;
+}
+
+bool rpc_core_idle(rpc_core_t *c) {
+    STORE(&c->idle, 1, __ATOMIC_SEQ_CST);
+    // A push that landed before the flag was up didn't see it: look again
+    if (LOAD(&c->head, __ATOMIC_SEQ_CST) != LOAD(&c->tail, __ATOMIC_RELAXED)) {
+        STORE(&c->idle, 0, __ATOMIC_SEQ_CST);
+        return false;
+    }
+    return true;
+}
+
+int rpc_core_pop(rpc_core_t *c, uint32_t now_us) {
+    for (;;) {
+        uint32_t tail = LOAD(&c->tail, __ATOMIC_RELAXED);
+        if (tail == LOAD(&c->head, __ATOMIC_ACQUIRE)) {
+            return -1;
+        }
+        int slot = c->ring[tail % RPC_MAX_INFLIGHT];
+        STORE(&c->tail, tail + 1, __ATOMIC_RELEASE);
+
+        rpc_slot_t *s = &c->slots[slot];
+        uint32_t expect = RPC_QUEUED;
+        if (CAS(&s->state, &expect, RPC_RUNNING)) {
+            s->start_us = now_us;
+            lat_add(&c->queued, now_us - s->submit_us);
+            return slot;
+        }
+        free_slot(c, slot);         // Abandoned before it started
+    }
+}
+
+bool rpc_core_complete(rpc_core_t *c, int slot, uint32_t now_us) {
+    rpc_slot_t *s = &c->slots[slot];
+    lat_add(&c->service, now_us - s->start_us);
+    if (s->err != ESP_OK) {
+        COUNT(&c->failed);
+    }
+    if (s->detached) {
+        free_slot(c, slot);
+        return false;
+    }
+    uint32_t expect = RPC_RUNNING;
+    if (CAS(&s->state, &expect, RPC_DONE)) {
+        return true;
+    }
+    free_slot(c, slot);             // Caller timed out while it ran
+    return false;
+}
+
+void rpc_core_batch(rpc_core_t *c, uint32_t n) {
+    c->wakeups++;
+    if (n > c->max_batch) {
+        c->max_batch = n;
+    }
+}
+
+bool rpc_core_abandon(rpc_core_t *c, int slot) {
+    rpc_slot_t *s = &c->slots[slot];
+    uint32_t state = LOAD(&s->state, __ATOMIC_ACQUIRE);
+    while (state == RPC_QUEUED || state == RPC_RUNNING) {
+        if (CAS(&s->state, &state, RPC_ABANDONED)) {
+            COUNT(&c->timeouts);
+            return true;
+        }
+    }
+    return false;                   // DONE after all
+}
+
+void rpc_core_release(rpc_core_t *c, int slot, uint32_t now_us) {
+    lat_add(&c->rtt, now_us - c->slots[slot].submit_us);
+    free_slot(c, slot);
+}
@@ -0,0 +1,204 @@
+#ifdef ESP_PLATFORM
+
+#include <string.h>
+#include <inttypes.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "esp_timer.h"
+#include "esp_log.h"
+#include "corerpc.h"
+
+static const char *TAG = "CORERPC";
+
+static rpc_channel_t *registry;
+
+static uint32_t now_us(void) {
+    return (uint32_t)esp_timer_get_time();
+}
+
+// Pinned to the channel's core: drain everything queued, then sleep
+// until a client finds us idle
+static void server_task(void *arg) {
+    rpc_channel_t *ch = (rpc_channel_t *)arg;
+    rpc_core_t *c = &ch->core_state;
+    for (;;) {
+        uint32_t batch = 0;
+        int slot;
+        while ((slot = rpc_core_pop(c, now_us())) >= 0) {
+            rpc_slot_t *s = &c->slots[slot];
+            size_t len = RPC_MAX_RESULT;
+            rpc_handler_t fn = s->op < RPC_MAX_OPS ? ch->handlers[s->op] : NULL;
+            s->err = fn ? fn(s->args, s->arg_len, s->result, &len) : ESP_ERR_NOT_SUPPORTED;
+            s->result_len = (uint16_t)(len < RPC_MAX_RESULT ? len : RPC_MAX_RESULT);
+            if (rpc_core_complete(c, slot, now_us())) {
+                xSemaphoreGive((SemaphoreHandle_t)s->done);
+            }
+            batch++;
+        }
+        if (batch > 0) {
+            rpc_core_batch(c, batch);
+        }
+        if (rpc_core_idle(c)) {
+            ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        }
+    }
+}
+
+static void delete_slots(rpc_channel_t *ch) {
+    for (int i = 0; i < RPC_MAX_INFLIGHT; i++) {
+        if (ch->core_state.slots[i].done != NULL) {
+            vSemaphoreDelete(ch->core_state.slots[i].done);
+            ch->core_state.slots[i].done = NULL;
+        }
+    }
+}
+
+esp_err_t rpc_channel_create(rpc_channel_t *ch, const char *name, int core, uint8_t priority, uint32_t stack) {
+    memset(ch, 0, sizeof(*ch));
+    rpc_core_init(&ch->core_state);
+    ch->name = name;
+    ch->core = core;
+    portMUX_INITIALIZE(&ch->push_lock);
+    for (int i = 0; i < RPC_MAX_INFLIGHT; i++) {
+        ch->core_state.slots[i].done = xSemaphoreCreateBinary();
+        if (ch->core_state.slots[i].done == NULL) {
+            delete_slots(ch);
+            return ESP_ERR_NO_MEM;
+        }
+    }
+    TaskHandle_t server;
+    if (xTaskCreatePinnedToCore(server_task, name, stack, ch, priority, &server, core) != pdPASS) {
+        delete_slots(ch);
+        return ESP_ERR_NO_MEM;
+    }
+    ch->server = server;
+
+    ch->next = registry;
+    registry = ch;
+    ESP_LOGI(TAG, "📡 %s: served on core %d at priority %u, %d calls in flight",
+             name, core, priority, RPC_MAX_INFLIGHT);
+    return ESP_OK;
+}
+
+void rpc_channel_destroy(rpc_channel_t *ch) {
+    for (rpc_channel_t **p = &registry; *p != NULL; p = &(*p)->next) {
+        if (*p == ch) {
+            *p = ch->next;
+            break;
+        }
+    }
+    vTaskDelete((TaskHandle_t)ch->server);
+    ch->server = NULL;
+    delete_slots(ch);
+}
+
+esp_err_t rpc_register(rpc_channel_t *ch, uint16_t op, rpc_handler_t fn) {
+    if (op >= RPC_MAX_OPS) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    ch->handlers[op] = fn;
+    return ESP_OK;
+}
+
+void rpc_kick(rpc_channel_t *ch) {
+    if (rpc_core_wake(&ch->core_state)) {
+        xTaskNotifyGive((TaskHandle_t)ch->server);
+    }
+}
+
+static esp_err_t submit(rpc_channel_t *ch, uint16_t op, const void *args, size_t len,
+                        bool detached, bool kick, int *slot_out) {
+    if (len > RPC_MAX_ARGS) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    rpc_core_t *c = &ch->core_state;
+    int slot = rpc_core_alloc(c);
+    if (slot < 0) {
+        return ESP_ERR_NO_MEM;
+    }
+    rpc_slot_t *s = &c->slots[slot];
+    s->op = op;
+    s->arg_len = (uint16_t)len;
+    s->detached = detached;
+    memcpy(s->args, args, len);
+    xSemaphoreTake((SemaphoreHandle_t)s->done, 0);      // A late give from the slot's last call
+
+    taskENTER_CRITICAL(&ch->push_lock);
+    rpc_core_push(c, slot, now_us());
+    taskEXIT_CRITICAL(&ch->push_lock);
+    if (kick) {
+        rpc_kick(ch);
+    }
+    *slot_out = slot;
+    return ESP_OK;
+}
+
+esp_err_t rpc_call_async(rpc_channel_t *ch, uint16_t op, const void *args, size_t len,
+                         rpc_future_t *f, bool kick) {
+    f->ch = ch;
+    return submit(ch, op, args, len, false, kick, &f->slot);
+}
+
+esp_err_t rpc_post(rpc_channel_t *ch, uint16_t op, const void *args, size_t len) {
+    int slot;
+    return submit(ch, op, args, len, true, true, &slot);
+}
+
+esp_err_t rpc_wait(rpc_future_t *f, void *result, size_t result_size, TickType_t timeout) {
+    rpc_core_t *c = &f->ch->core_state;
+    rpc_slot_t *s = &c->slots[f->slot];
+    TimeOut_t start;
+    vTaskSetTimeOutState(&start);
+    // The semaphore may hold a stale give: DONE is what counts
+    while (__atomic_load_n(&s->state, __ATOMIC_ACQUIRE) != RPC_DONE) {
+        if (xTaskCheckForTimeOut(&start, &timeout) == pdTRUE ||
+            xSemaphoreTake((SemaphoreHandle_t)s->done, timeout) != pdTRUE) {
+            if (rpc_core_abandon(c, f->slot)) {
+                return ESP_ERR_TIMEOUT;
+            }
+            break;                  // Finished just in time
+        }
+    }
+    esp_err_t err = s->err;
+    if (result != NULL) {
+        memcpy(result, s->result, s->result_len < result_size ? s->result_len : result_size);
+    }
+    taskENTER_CRITICAL(&f->ch->push_lock);
+    rpc_core_release(c, f->slot, now_us());
+    taskEXIT_CRITICAL(&f->ch->push_lock);
+    return err;
+}
+
+esp_err_t rpc_call(rpc_channel_t *ch, uint16_t op, const void *args, size_t len,
+                   void *result, size_t result_size, TickType_t timeout) {
+    rpc_future_t f;
+    esp_err_t err = rpc_call_async(ch, op, args, len, &f, true);
+    if (err != ESP_OK) {
+        return err;
+    }
+    return rpc_wait(&f, result, result_size, timeout);
+}
+
+void rpc_report(FILE *out) {
+    for (rpc_channel_t *ch = registry; ch != NULL; ch = ch->next) {
+        rpc_core_t *c = &ch->core_state;
+        taskENTER_CRITICAL(&ch->push_lock);
+        rpc_lat_t rtt = c->rtt;
+        taskEXIT_CRITICAL(&ch->push_lock);
+        rpc_lat_t queued = c->queued, service = c->service;   // Server's own; a torn read is one sample off
+
+        fprintf(out, "corerpc [%s -> core %d]: %" PRIu32 " calls, %" PRIu32 " posts, %" PRIu32 " timeouts, "
+                     "%" PRIu32 " failed, %" PRIu32 " busy, %.1f calls/wakeup (max %" PRIu32 ")\n",
+                ch->name, ch->core, c->calls, c->posts, c->timeouts, c->failed, c->busy,
+                c->wakeups ? (double)(queued.count) / c->wakeups : 0.0, c->max_batch);
+        fprintf(out, "    round trip avg %" PRIu32 " us p50 <%" PRIu32 " p99 <%" PRIu32 " max %" PRIu32 " us | "
+                     "queued avg %" PRIu32 " us max %" PRIu32 " | handler avg %" PRIu32 " us max %" PRIu32 "\n",
+                rtt.count ? (uint32_t)(rtt.sum_us / rtt.count) : 0,
+                rpc_lat_percentile(&rtt, 50), rpc_lat_percentile(&rtt, 99), rtt.max_us,
+                queued.count ? (uint32_t)(queued.sum_us / queued.count) : 0, queued.max_us,
+                service.count ? (uint32_t)(service.sum_us / service.count) : 0, service.max_us);
+    }
+}
+
+#endif // ESP_PLATFORM
@@ -0,0 +1,193 @@
+// Host check for the RPC slot/ring state machine with real threads: a
+// server thread draining the ring and two client threads submitting
+// bursts of calls (plus fire-and-forget posts) with deadlines short
+// enough that some calls are abandoned while queued or running. Every
+// completed call must carry its own answer, no call may complete twice,
+// and when the dust settles every slot must be free again - abandoned
+// and posted calls included. Also reports calls per wakeup, which the
+// idle flag should keep well above one under bursts.
+//
+// Build and run from this directory:
+//   cc -O2 -pthread -I../include -I../../../tools/host_include ../corerpc.c corerpc_host_bench.c -o corerpc_bench
+//   ./corerpc_bench
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include <sched.h>
+#include <semaphore.h>
+#include "corerpc.h"
+#include "host_check.h"
+
+#define CLIENTS         2
+#define ROUNDS          20000
+#define BURST           4
+
+static rpc_core_t core;
+static pthread_mutex_t push_lock = PTHREAD_MUTEX_INITIALIZER;
+static sem_t server_wake;
+static volatile int stop;
+static uint32_t posts_run;
+static uint32_t completed[CLIENTS], abandoned[CLIENTS], wrong[CLIENTS];
+
+static uint32_t now_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)(ts.tv_sec * 1000000ull + ts.tv_nsec / 1000);
+}
+
+static void spin_us(uint32_t us) {
+    uint32_t start = now_us();
+    while (now_us() - start < us) {
+    }
+}
+
+static void *server(void *arg) {
+    (void)arg;
+    while (!stop) {
+        uint32_t batch = 0;
+        int slot;
+        while ((slot = rpc_core_pop(&core, now_us())) >= 0) {
+            rpc_slot_t *s = &core.slots[slot];
+            uint32_t x;
+            memcpy(&x, s->args, sizeof(x));
+            if (s->detached) {
+                __atomic_fetch_add(&posts_run, 1, __ATOMIC_RELAXED);
+            }
+            spin_us(rand() % 40);   // Handler time
+            x = x * 3 + 1;
+            memcpy(s->result, &x, sizeof(x));
+            s->result_len = sizeof(x);
+            s->err = ESP_OK;
+            rpc_core_complete(&core, slot, now_us());
+            batch++;
+        }
+        if (batch > 0) {
+            rpc_core_batch(&core, batch);
+        }
+        if (rpc_core_idle(&core)) {
+            struct timespec ts;
+            clock_gettime(CLOCK_REALTIME, &ts);
+            ts.tv_nsec += 10000000;             // Bounded, so stop is seen
+            if (ts.tv_nsec >= 1000000000) {
+                ts.tv_sec++;
+                ts.tv_nsec -= 1000000000;
+            }
+            sem_timedwait(&server_wake, &ts);
+        }
+    }
+    return NULL;
+}
+
+static bool submit(uint32_t x, bool detached, int *slot_out) {
+    int slot = rpc_core_alloc(&core);
+    if (slot < 0) {
+        return false;
+    }
+    core.slots[slot].detached = detached;
+    core.slots[slot].arg_len = sizeof(x);
+    memcpy(core.slots[slot].args, &x, sizeof(x));
+    pthread_mutex_lock(&push_lock);
+    rpc_core_push(&core, slot, now_us());
+    pthread_mutex_unlock(&push_lock);
+    *slot_out = slot;
+    return true;
+}
+
+static void *client(void *arg) {
+    int id = (int)(intptr_t)arg;
+    for (uint32_t round = 0; round < ROUNDS; round++) {
+        int slots[BURST];
+        uint32_t args[BURST];
+        int n = 0;
+        for (int i = 0; i < BURST; i++) {
+            args[n] = (uint32_t)(id << 24 | round << 2 | i);
+            if (submit(args[n], false, &slots[n])) {
+                n++;
+            }
+        }
+        if (n == 0) {
+            sched_yield();          // All slots taken: let the server catch up
+        }
+        int posted;
+        if (round % 8 == 0) {
+            submit(round, true, &posted);
+        }
+        if (rpc_core_wake(&core)) {             // One kick for the burst
+            sem_post(&server_wake);
+        }
+
+        uint32_t deadline = now_us() + rand() % 150;
+        for (int i = 0; i < n; i++) {
+            rpc_slot_t *s = &core.slots[slots[i]];
+            while (__atomic_load_n(&s->state, __ATOMIC_ACQUIRE) != RPC_DONE &&
+                   (int32_t)(now_us() - deadline) < 0) {
+            }
+            if (__atomic_load_n(&s->state, __ATOMIC_ACQUIRE) != RPC_DONE && rpc_core_abandon(&core, slots[i])) {
+                abandoned[id]++;
+                continue;
+            }
+            uint32_t r;
+            memcpy(&r, s->result, sizeof(r));
+            wrong[id] += r != args[i] * 3 + 1;
+            pthread_mutex_lock(&push_lock);
+            rpc_core_release(&core, slots[i], now_us());
+            pthread_mutex_unlock(&push_lock);
+            completed[id]++;
+        }
+    }
+    return NULL;
+}
+
+int main(void) {
+    rpc_core_init(&core);
+    sem_init(&server_wake, 0, 0);
+    pthread_t srv, cli[CLIENTS];
+    pthread_create(&srv, NULL, server, NULL);
+    for (int i = 0; i < CLIENTS; i++) {
+        pthread_create(&cli[i], NULL, client, (void *)(intptr_t)i);
+    }
+    for (int i = 0; i < CLIENTS; i++) {
+        pthread_join(cli[i], NULL);
+    }
+    // Let the server finish abandoned and posted calls
+    sem_post(&server_wake);
+    for (int i = 0; i < 200 && core.free_mask != (1u << RPC_MAX_INFLIGHT) - 1; i++) {
+        spin_us(1000);
+    }
+    stop = 1;
+    sem_post(&server_wake);
+    pthread_join(srv, NULL);
+
+    uint32_t done = 0, lost = 0, bad = 0;
+    for (int i = 0; i < CLIENTS; i++) {
+        done += completed[i];
+        lost += abandoned[i];
+        bad += wrong[i];
+    }
+    printf("%lu calls: %lu completed, %lu abandoned, %lu refused (busy); %lu posts run of %lu\n",
+           (unsigned long)core.calls, (unsigned long)done, (unsigned long)lost, (unsigned long)core.busy,
+           (unsigned long)posts_run, (unsigned long)core.posts);
+    printf("%.1f calls per wakeup (max %lu), round trip avg %lu us p99 <%lu us, queued avg %lu us\n",
+           core.wakeups ? (double)core.queued.count / core.wakeups : 0.0, (unsigned long)core.max_batch,
+           (unsigned long)(core.rtt.count ? core.rtt.sum_us / core.rtt.count : 0),
+           (unsigned long)rpc_lat_percentile(&core.rtt, 99),
+           (unsigned long)(core.queued.count ? core.queued.sum_us / core.queued.count : 0));
+
+    CHECK(bad == 0, "%lu calls got someone else's result", (unsigned long)bad);
+    CHECK(done + lost == core.calls, "calls %lu != completed %lu + abandoned %lu",
+          (unsigned long)core.calls, (unsigned long)done, (unsigned long)lost);
+    CHECK(lost == core.timeouts, "abandoned %lu, core counted %lu", (unsigned long)lost, (unsigned long)core.timeouts);
+    CHECK(done == core.rtt.count, "round trips recorded %lu", (unsigned long)core.rtt.count);
+    CHECK(posts_run == core.posts, "posts run %lu of %lu", (unsigned long)posts_run, (unsigned long)core.posts);
+    CHECK(core.free_mask == (1u << RPC_MAX_INFLIGHT) - 1, "slots leaked: free mask %08lx",
+          (unsigned long)core.free_mask);
+    CHECK(lost > 0 && done > 0, "deadlines should abandon some calls and not all");
+    CHECK(core.wakeups < core.queued.count, "no batching: %lu wakeups for %lu calls",
+          (unsigned long)core.wakeups, (unsigned long)core.queued.count);
+
+    printf("%s\n", failures ? "FAILURES" : "OK");
+    return failures != 0;
+}
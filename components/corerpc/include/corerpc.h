@@ -0,0 +1,212 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include "esp_err.h"
+
+#ifdef ESP_PLATFORM
+#include "freertos/FreeRTOS.h"
+#endif
+
+// ================ CROSS-CORE RPC ================
+// "Ask the other core to do X and give me the answer" without a pair of
+// ad-hoc queues per operation. A channel is one direction: clients on
+// any core submit calls, a server task pinned to the channel's core runs
+// the registered handler for each and completes the caller's future.
+// Two channels make a bidirectional link.
+//
+//   static rpc_channel_t to_core0;
+//   rpc_channel_create(&to_core0, "core0", 0, 6, 3072);
+//   rpc_register(&to_core0, OP_PRIMES, primes_handler);
+//
+//   // Synchronous: typed args and result, copied by value
+//   prime_args_t args = { 1, 50000 };
+//   uint32_t count;
+//   esp_err_t err = RPC_CALL(&to_core0, OP_PRIMES, &args, &count, pdMS_TO_TICKS(500));
+//
+//   // Asynchronous: several calls, one wakeup of the server
+//   rpc_future_t f[4];
+//   for (int i = 0; i < 4; i++) rpc_call_async(&to_core0, OP_PRIMES, &a[i], sizeof(a[i]), &f[i], false);
+//   rpc_kick(&to_core0);
+//   for (int i = 0; i < 4; i++) rpc_wait(&f[i], &count[i], sizeof(count[i]), pdMS_TO_TICKS(500));
+//
+//   // Fire and forget: nobody waits, the server frees the call
+//   rpc_post(&to_core1, OP_LOG, &counter, sizeof(counter));
+//
+// Every call lives in one of RPC_MAX_INFLIGHT slots of the channel
+// (arguments and result inline, no allocation). The slot index goes
+// through a single-producer/single-consumer ring sized to the pool, so
+// a call that got a slot can always be queued; clients serialize on a
+// spinlock for the push only, and the server side takes no lock at all.
+// The server drains everything queued per wakeup, and clients only
+// notify it when it has gone idle - a burst of calls costs one
+// cross-core interrupt.
+//
+// A call that times out is abandoned, not cancelled: the server still
+// runs it if it's already queued or running, then frees the slot itself.
+// The caller must not touch the future after ESP_ERR_TIMEOUT.
+//
+// Latency is reported per channel: round trip (submit to result seen
+// by the caller), queueing before the server picks the call up, handler
+// time, and calls per wakeup. Times are the low 32 bits of
+// esp_timer_get_time(). Slots and the submission ring are plain state in
+// rpc_core_*, with no FreeRTOS calls; the server task and the semaphores
+// that wake waiting clients are wrapped around them.
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define RPC_MAX_INFLIGHT    16      // Calls pending per channel (<= 32)
+#define RPC_MAX_OPS         16
+#define RPC_MAX_ARGS        32      // Bytes
+#define RPC_MAX_RESULT      32
+#define RPC_LAT_BUCKETS     12      // < 16 us, < 32 us, ... < 16 ms, longer
+
+typedef enum {
+    RPC_FREE,
+    RPC_QUEUED,
+    RPC_RUNNING,
+    RPC_DONE,
+    RPC_ABANDONED,                  // Caller gave up; the server frees it
+} rpc_state_t;
+
+// Runs on the server's core. *result_len starts at RPC_MAX_RESULT.
+typedef esp_err_t (*rpc_handler_t)(const void *args, size_t arg_len, void *result, size_t *result_len);
+
+// ---- Slots and ring (portable) ----
+
+typedef struct {
+    uint32_t state;                 // rpc_state_t (atomic)
+    bool detached;                  // rpc_post(): freed by the server
+    uint16_t op;
+    uint16_t arg_len;
+    uint16_t result_len;
+    esp_err_t err;
+    uint32_t submit_us;
+    uint32_t start_us;
+    uint8_t args[RPC_MAX_ARGS];
+    uint8_t result[RPC_MAX_RESULT];
+    void *done;                     // SemaphoreHandle_t on the device
+} rpc_slot_t;
+
+typedef struct {
+    uint32_t count;
+    uint64_t sum_us;
+    uint32_t max_us;
+    uint32_t hist[RPC_LAT_BUCKETS];
+} rpc_lat_t;
+
+typedef struct {
+    rpc_slot_t slots[RPC_MAX_INFLIGHT];
+    uint32_t free_mask;             // Bit set = slot free (atomic)
+    uint8_t ring[RPC_MAX_INFLIGHT];
+    uint32_t head;                  // Written by the producer (atomic)
+    uint32_t tail;                  // Written by the server (atomic)
+    uint32_t idle;                  // Server is about to sleep (atomic)
+
+    // Statistics
+    uint32_t calls;
+    uint32_t posts;
+    uint32_t busy;                  // No free slot
+    uint32_t timeouts;
+    uint32_t failed;                // Handler error or unknown op
+    uint32_t wakeups;
+    uint32_t max_batch;
+    rpc_lat_t rtt;                  // Caller side (clients serialize on release)
+    rpc_lat_t queued;               // Server side
+    rpc_lat_t service;
+} rpc_core_t;
+
+void rpc_core_init(rpc_core_t *c);
+
+// Client: a free slot, or -1
+int rpc_core_alloc(rpc_core_t *c);
+
+// Client: queue a filled-in slot (one producer at a time)
+void rpc_core_push(rpc_core_t *c, int slot, uint32_t now_us);
+
+// Client: true if the server has gone idle and must be notified (only
+// one caller gets true per idle period)
+bool rpc_core_wake(rpc_core_t *c);
+
+// Server: next queued call (now RUNNING), or -1. Abandoned calls still
+// queued are freed on the way.
+int rpc_core_pop(rpc_core_t *c, uint32_t now_us);
+
+// Server: the call has its result. true if a caller is waiting for it.
+bool rpc_core_complete(rpc_core_t *c, int slot, uint32_t now_us);
+
+// Server: about to sleep; false if there is more work (don't sleep)
+bool rpc_core_idle(rpc_core_t *c);
+
+// Server: calls handled in one wakeup
+void rpc_core_batch(rpc_core_t *c, uint32_t n);
+
+// Client gave up. false if the call completed meanwhile - collect it.
+bool rpc_core_abandon(rpc_core_t *c, int slot);
+
+// Client: result taken, record the round trip and free the slot (one
+// client at a time, like rpc_core_push())
+void rpc_core_release(rpc_core_t *c, int slot, uint32_t now_us);
+
+// Upper bound of the bucket holding the pct-th percentile
+uint32_t rpc_lat_percentile(const rpc_lat_t *l, uint32_t pct);
+
+// ---- Device ----
+
+#ifdef ESP_PLATFORM
+typedef struct rpc_channel {
+    const char *name;
+    int core;
+    rpc_core_t core_state;
+    rpc_handler_t handlers[RPC_MAX_OPS];
+    portMUX_TYPE push_lock;
+    void *server;                   // TaskHandle_t
+    struct rpc_channel *next;
+} rpc_channel_t;
+
+typedef struct {
+    rpc_channel_t *ch;
+    int slot;
+} rpc_future_t;
+
+// Server task pinned to `core`
+esp_err_t rpc_channel_create(rpc_channel_t *ch, const char *name, int core, uint8_t priority, uint32_t stack);
+
+// Stops the server and frees what rpc_channel_create() made. Only for a
+// channel with no calls in flight and no clients left.
+void rpc_channel_destroy(rpc_channel_t *ch);
+
+esp_err_t rpc_register(rpc_channel_t *ch, uint16_t op, rpc_handler_t fn);
+
+// Submit without waiting. kick = false leaves the server asleep until
+// rpc_kick() (or the next kicked call), to batch several calls.
+// ESP_ERR_NO_MEM if all slots are busy.
+esp_err_t rpc_call_async(rpc_channel_t *ch, uint16_t op, const void *args, size_t len,
+                         rpc_future_t *f, bool kick);
+void rpc_kick(rpc_channel_t *ch);
+
+// The handler's result and return value, or ESP_ERR_TIMEOUT (the future
+// is then gone). Not from the channel's own server task.
+esp_err_t rpc_wait(rpc_future_t *f, void *result, size_t result_size, TickType_t timeout);
+
+esp_err_t rpc_call(rpc_channel_t *ch, uint16_t op, const void *args, size_t len,
+                   void *result, size_t result_size, TickType_t timeout);
+
+#define RPC_CALL(ch, op, args, result, timeout) \
+    rpc_call((ch), (op), (args), sizeof(*(args)), (result), sizeof(*(result)), (timeout))
+
+// No result, no waiting
+esp_err_t rpc_post(rpc_channel_t *ch, uint16_t op, const void *args, size_t len);
+
+// Per channel: calls, timeouts, round trip avg/p50/p99/max, queueing,
+// handler time, calls per wakeup
+void rpc_report(FILE *out);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,72 @@
+#include <string.h>
+#include <stdio.h>
+#include "critmode.h"
+
+// ================ MODE LOGIC ================
+
+void crit_detector_init(crit_detector_t *d, const crit_config_t *cfg) {
+    memset(d, 0, sizeof(*d));
+    d->cfg = *cfg;
+    d->mode = CRIT_MODE_NORMAL;
+}
+
+// Name the signals over their enter thresholds
+static void describe(crit_detector_t *d, const crit_sample_t *s) {
+    const crit_config_t *c = &d->cfg;
+    size_t n = 0;
+    d->reason[0] = '\0';
+    if (s->hold != NULL) {
+        n += snprintf(d->reason + n, sizeof(d->reason) - n, "%s, ", s->hold);
+    }
+    if (n < sizeof(d->reason) && s->cpu_pct >= c->cpu_enter_pct) {
+        n += snprintf(d->reason + n, sizeof(d->reason) - n, "cpu %u%%, ", s->cpu_pct);
+    }
+    if (n < sizeof(d->reason) && s->misses >= c->miss_enter) {
+        n += snprintf(d->reason + n, sizeof(d->reason) - n, "%lu deadline misses, ", (unsigned long)s->misses);
+    }
+    if (n < sizeof(d->reason) && s->queue_pct >= c->queue_enter_pct) {
+        n += snprintf(d->reason + n, sizeof(d->reason) - n, "queue %u%% full, ", s->queue_pct);
+    }
+    if (n >= 2 && n < sizeof(d->reason)) {
+        d->reason[n - 2] = '\0';    // Trailing ", "
+    }
+}
+
+bool crit_detector_step(crit_detector_t *d, const crit_sample_t *s) {
+    const crit_config_t *c = &d->cfg;
+    bool hot = s->hold != NULL ||
+               s->cpu_pct >= c->cpu_enter_pct ||
+               s->misses >= c->miss_enter ||
+               s->queue_pct >= c->queue_enter_pct;
+    bool calm = s->hold == NULL &&
+                s->cpu_pct <= c->cpu_exit_pct &&
+                s->misses <= c->miss_exit &&
+                s->queue_pct <= c->queue_exit_pct;
+
+    d->in_mode_ms += s->elapsed_ms;
+    if (d->mode == CRIT_MODE_NORMAL) {
+        if (!hot) {
+            return false;
+        }
+        describe(d, s);
+        d->mode = CRIT_MODE_OVERLOAD;
+        d->calm = 0;
+        d->in_mode_ms = 0;
+        d->switches++;
+        return true;
+    }
+
+    // OVERLOAD: anything short of calm (including a load sitting between
+    // the two thresholds) restarts the streak
+    d->overload_ms += s->elapsed_ms;
+    d->calm = calm ? d->calm + 1 : 0;
+    if (d->calm < c->calm_windows || d->in_mode_ms < c->min_overload_ms) {
+        return false;
+    }
+    snprintf(d->reason, sizeof(d->reason), "calm for %lu windows", (unsigned long)d->calm);
+    d->mode = CRIT_MODE_NORMAL;
+    d->calm = 0;
+    d->in_mode_ms = 0;
+    d->switches++;
+    return true;
+}
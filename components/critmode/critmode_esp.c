@@ -0,0 +1,437 @@
+#ifdef ESP_PLATFORM
+
+#include <string.h>
+#include <inttypes.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "freertos/event_groups.h"
+#include "esp_freertos_hooks.h"
+#include "esp_log.h"
+#include "tstamp.h"
+#include "critmode.h"
+
+static const char *TAG = "CRITMODE";
+
+#define NORMAL_BIT          (1 << 0)
+#define IDLE_GAP_US         20      // Longer between idle-hook calls = something else ran
+#define CMD_WAIT_MS         10      // Timer command queue
+
+static const char *level_names[] = { "high", "medium", "low" };
+
+struct crit_task {
+    const char *name;
+    crit_level_t level;
+    uint32_t parked;                // Times it waited out an OVERLOAD
+    uint32_t throttled;
+};
+
+typedef enum {
+    TIMER_NORMAL,
+    TIMER_STOPPED,
+    TIMER_SLOWED,
+} timer_state_t;
+
+typedef struct {
+    TimerHandle_t timer;
+    crit_level_t level;
+    TickType_t period;
+    timer_state_t applied;
+    bool was_active;                // Only restart what we stopped
+} timer_entry_t;
+
+typedef struct {
+    QueueHandle_t queue;
+    const char *name;
+    UBaseType_t size;
+    uint8_t peak_pct;
+} queue_entry_t;
+
+typedef struct {
+    const char *tag;
+    esp_log_level_t saved;
+} tag_entry_t;
+
+static struct {
+    bool ready;
+    crit_detector_t det;
+    SemaphoreHandle_t lock;         // Registries and det
+    EventGroupHandle_t events;
+    TaskHandle_t task;
+    volatile crit_mode_t mode;
+
+    struct crit_task tasks[CRIT_MAX_TASKS];
+    uint8_t ntasks;
+    timer_entry_t timers[CRIT_MAX_TIMERS];
+    uint8_t ntimers;
+    queue_entry_t queues[CRIT_MAX_QUEUES];
+    uint8_t nqueues;
+    tag_entry_t tags[CRIT_MAX_TAGS];
+    uint8_t ntags;
+
+    uint32_t misses;                // This window (atomic)
+    uint32_t total_misses;
+    const char *hold;               // Atomic
+    ts_t idle_gap;
+    ts_t idle_last[portNUM_PROCESSORS];
+    uint32_t idle_ticks[portNUM_PROCESSORS];
+    uint8_t peak_cpu;
+    uint32_t cmd_failures;
+    ts_t mode_since;
+} cm;
+
+// ================ SIGNALS ================
+
+// Runs over and over while the core is idle: short gaps between calls
+// are idle time, a long one means a task or ISR had the core
+static bool idle_hook(void) {
+    int core = xPortGetCoreID();
+    ts_t now = ts_now();
+    ts_t gap = now - cm.idle_last[core];
+    cm.idle_last[core] = now;
+    if (gap < cm.idle_gap) {
+        __atomic_fetch_add(&cm.idle_ticks[core], (uint32_t)gap, __ATOMIC_RELAXED);
+    }
+    return false;                   // Keep spinning (no WAITI) so the gaps stay short
+}
+
+void crit_deadline_miss(void) {
+    __atomic_fetch_add(&cm.misses, 1, __ATOMIC_RELAXED);
+}
+
+void crit_hold(const char *reason, bool on) {
+    __atomic_store_n(&cm.hold, on ? reason : NULL, __ATOMIC_RELEASE);
+    if (cm.ready) {
+        xTaskNotifyGive(cm.task);   // Switch now, not at the end of the window
+    }
+}
+
+// Busiest core over the last dt ticks
+static uint8_t sample_cpu(ts_t dt) {
+    uint8_t busiest = 0;
+    for (int c = 0; c < portNUM_PROCESSORS; c++) {
+        uint64_t idle = __atomic_exchange_n(&cm.idle_ticks[c], 0, __ATOMIC_RELAXED);
+        uint64_t idle_pct = dt ? idle * 100 / dt : 100;
+        uint8_t busy = idle_pct >= 100 ? 0 : (uint8_t)(100 - idle_pct);
+        if (busy > busiest) {
+            busiest = busy;
+        }
+    }
+    return busiest;
+}
+
+static uint8_t sample_queues(void) {
+    uint8_t fullest = 0;
+    for (int i = 0; i < cm.nqueues; i++) {
+        queue_entry_t *q = &cm.queues[i];
+        uint8_t pct = (uint8_t)(uxQueueMessagesWaiting(q->queue) * 100 / q->size);
+        if (pct > q->peak_pct) {
+            q->peak_pct = pct;
+        }
+        if (pct > fullest) {
+            fullest = pct;
+        }
+    }
+    return fullest;
+}
+
+// ================ SHEDDING ================
+
+static timer_state_t wanted(const timer_entry_t *t) {
+    if (cm.mode == CRIT_MODE_NORMAL || t->level == CRIT_HIGH) {
+        return TIMER_NORMAL;
+    }
+    return t->level == CRIT_LOW ? TIMER_STOPPED : TIMER_SLOWED;
+}
+
+// Move each timer towards what the mode wants. A command that doesn't
+// fit in the timer queue (likely, under overload) is retried next window.
+static void sync_timers(void) {
+    TickType_t wait = pdMS_TO_TICKS(CMD_WAIT_MS);
+    for (int i = 0; i < cm.ntimers; i++) {
+        timer_entry_t *t = &cm.timers[i];
+        timer_state_t want = wanted(t);
+        if (t->applied == want) {
+            continue;
+        }
+        BaseType_t ok = pdPASS;
+        if (want == TIMER_NORMAL) {
+            if (t->was_active) {
+                ok = t->applied == TIMER_STOPPED ? xTimerStart(t->timer, wait)
+                                                 : xTimerChangePeriod(t->timer, t->period, wait);
+            }
+        } else {
+            // Dormant timers stay dormant (xTimerChangePeriod would start them)
+            t->was_active = xTimerIsTimerActive(t->timer) != pdFALSE;
+            if (t->was_active) {
+                ok = want == TIMER_STOPPED ? xTimerStop(t->timer, wait)
+                                           : xTimerChangePeriod(t->timer, t->period * cm.det.cfg.throttle, wait);
+            }
+        }
+        if (ok == pdPASS) {
+            t->applied = want;
+        } else {
+            cm.cmd_failures++;
+        }
+    }
+}
+
+static void quiet_logs(bool quiet) {
+    for (int i = 0; i < cm.ntags; i++) {
+        tag_entry_t *t = &cm.tags[i];
+        if (quiet) {
+            t->saved = esp_log_level_get(t->tag);
+            if (t->saved > ESP_LOG_WARN) {
+                esp_log_level_set(t->tag, ESP_LOG_WARN);
+            }
+        } else {
+            esp_log_level_set(t->tag, t->saved);
+        }
+    }
+}
+
+static void count_levels(uint32_t *tasks, uint32_t *timers) {
+    for (int i = 0; i < cm.ntasks; i++) {
+        tasks[cm.tasks[i].level]++;
+    }
+    for (int i = 0; i < cm.ntimers; i++) {
+        timers[cm.timers[i].level]++;
+    }
+}
+
+// Called with the lock held, right after the detector switched
+static void enter_mode(crit_mode_t mode, uint32_t stayed_ms) {
+    cm.mode = mode;
+    cm.mode_since = ts_now();
+    uint32_t tasks[3] = { 0 }, timers[3] = { 0 };
+    count_levels(tasks, timers);
+
+    if (mode == CRIT_MODE_OVERLOAD) {
+        xEventGroupClearBits(cm.events, NORMAL_BIT);
+        quiet_logs(true);
+        sync_timers();
+        ESP_LOGW(TAG, "🔥 OVERLOAD (%s): parking %lu low tasks, throttling %lu medium x%u, "
+                      "stopping %lu timers, slowing %lu, %u log tags to warnings",
+                 cm.det.reason, tasks[CRIT_LOW], tasks[CRIT_MEDIUM], cm.det.cfg.throttle,
+                 timers[CRIT_LOW], timers[CRIT_MEDIUM], cm.ntags);
+    } else {
+        sync_timers();
+        quiet_logs(false);
+        xEventGroupSetBits(cm.events, NORMAL_BIT);
+        ESP_LOGW(TAG, "✅ NORMAL again after %lu ms (%s): %lu tasks, %lu timers restored",
+                 stayed_ms, cm.det.reason, tasks[CRIT_LOW] + tasks[CRIT_MEDIUM],
+                 timers[CRIT_LOW] + timers[CRIT_MEDIUM]);
+    }
+}
+
+static void detector_task(void *arg) {
+    TickType_t window = pdMS_TO_TICKS(cm.det.cfg.window_ms);
+    ts_t last = ts_now();
+    for (;;) {
+        ulTaskNotifyTake(pdTRUE, window);
+        ts_t now = ts_now();
+        ts_t dt = now - last;
+        last = now;
+
+        crit_sample_t s = {
+            .elapsed_ms = (uint32_t)(ts_to_us(dt) / 1000),
+            .cpu_pct = sample_cpu(dt),
+            .misses = __atomic_exchange_n(&cm.misses, 0, __ATOMIC_RELAXED),
+            .hold = __atomic_load_n(&cm.hold, __ATOMIC_ACQUIRE),
+        };
+
+        xSemaphoreTake(cm.lock, portMAX_DELAY);
+        s.queue_pct = sample_queues();
+        cm.total_misses += s.misses;
+        if (s.cpu_pct > cm.peak_cpu) {
+            cm.peak_cpu = s.cpu_pct;
+        }
+        uint32_t stayed_ms = cm.det.in_mode_ms + s.elapsed_ms;
+        if (crit_detector_step(&cm.det, &s)) {
+            enter_mode(cm.det.mode, stayed_ms);
+        } else {
+            sync_timers();          // Retries, and timers registered mid-mode
+        }
+        xSemaphoreGive(cm.lock);
+    }
+}
+
+// ================ API ================
+
+esp_err_t crit_init(const crit_config_t *cfg) {
+    if (cm.ready) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    crit_config_t defaults = CRIT_CONFIG_DEFAULT();
+    if (cfg == NULL) {
+        cfg = &defaults;
+    }
+    if (cfg->cpu_exit_pct >= cfg->cpu_enter_pct || cfg->queue_exit_pct >= cfg->queue_enter_pct ||
+        cfg->miss_exit >= cfg->miss_enter || cfg->throttle < 1 || cfg->window_ms == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    crit_detector_init(&cm.det, cfg);
+    cm.idle_gap = ts_from_us(IDLE_GAP_US);
+
+    cm.lock = xSemaphoreCreateMutex();
+    cm.events = xEventGroupCreate();
+    if (cm.lock == NULL || cm.events == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    xEventGroupSetBits(cm.events, NORMAL_BIT);
+
+    for (int c = 0; c < portNUM_PROCESSORS; c++) {
+        cm.idle_last[c] = ts_now();
+        esp_err_t err = esp_register_freertos_idle_hook_for_cpu(idle_hook, c);
+        if (err != ESP_OK) {
+            return err;
+        }
+    }
+    if (xTaskCreate(detector_task, "CritMode", 3072, NULL, cfg->priority, &cm.task) != pdPASS) {
+        return ESP_ERR_NO_MEM;
+    }
+    cm.mode_since = ts_now();
+    cm.ready = true;
+    ESP_LOGI(TAG, "🚦 Overload detector: cpu %u/%u%%, misses %lu/%lu, queues %u/%u%% (enter/exit), "
+                  "%lu ms windows, restore after %lu calm and %lu ms",
+             cfg->cpu_enter_pct, cfg->cpu_exit_pct, cfg->miss_enter, cfg->miss_exit,
+             cfg->queue_enter_pct, cfg->queue_exit_pct, cfg->window_ms,
+             cfg->calm_windows, cfg->min_overload_ms);
+    return ESP_OK;
+}
+
+crit_task_t *crit_task_register(const char *name, crit_level_t level) {
+    if (!cm.ready) {
+        return NULL;                // crit_delay() then acts as vTaskDelay()
+    }
+    crit_task_t *t = NULL;
+    xSemaphoreTake(cm.lock, portMAX_DELAY);
+    if (cm.ntasks < CRIT_MAX_TASKS) {
+        t = &cm.tasks[cm.ntasks++];
+        t->name = name;
+        t->level = level;
+    }
+    xSemaphoreGive(cm.lock);
+    if (t == NULL) {
+        ESP_LOGE(TAG, "❌ No room for task %s", name);
+    }
+    return t;
+}
+
+void crit_delay(crit_task_t *task, uint32_t ms) {
+    vTaskDelay(pdMS_TO_TICKS(ms));
+    if (task == NULL || task->level == CRIT_HIGH || cm.mode == CRIT_MODE_NORMAL) {
+        return;
+    }
+    // Wait for NORMAL: forever if shed, up to (throttle - 1) x ms more if
+    // throttled - either way it runs again as soon as the mode is back
+    TickType_t extra = portMAX_DELAY;
+    if (task->level == CRIT_MEDIUM) {
+        task->throttled++;
+        extra = pdMS_TO_TICKS(ms * (cm.det.cfg.throttle - 1));
+    } else {
+        task->parked++;
+    }
+    xEventGroupWaitBits(cm.events, NORMAL_BIT, pdFALSE, pdTRUE, extra);
+}
+
+esp_err_t crit_register_timer(TimerHandle_t timer, crit_level_t level) {
+    if (!cm.ready) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    esp_err_t err = ESP_ERR_NO_MEM;
+    xSemaphoreTake(cm.lock, portMAX_DELAY);
+    if (cm.ntimers < CRIT_MAX_TIMERS) {
+        cm.timers[cm.ntimers++] = (timer_entry_t){
+            .timer = timer,
+            .level = level,
+            .period = xTimerGetPeriod(timer),
+            .applied = TIMER_NORMAL,
+        };
+        err = ESP_OK;
+    }
+    xSemaphoreGive(cm.lock);
+    return err;
+}
+
+void crit_unregister_timer(TimerHandle_t timer) {
+    if (!cm.ready) {
+        return;
+    }
+    xSemaphoreTake(cm.lock, portMAX_DELAY);
+    for (int i = 0; i < cm.ntimers; i++) {
+        if (cm.timers[i].timer == timer) {
+            cm.timers[i] = cm.timers[--cm.ntimers];
+            break;
+        }
+    }
+    xSemaphoreGive(cm.lock);
+}
+
+esp_err_t crit_watch_queue(QueueHandle_t queue, const char *name) {
+    if (!cm.ready) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    esp_err_t err = ESP_ERR_NO_MEM;
+    xSemaphoreTake(cm.lock, portMAX_DELAY);
+    if (cm.nqueues < CRIT_MAX_QUEUES) {
+        cm.queues[cm.nqueues++] = (queue_entry_t){
+            .queue = queue,
+            .name = name,
+            .size = uxQueueMessagesWaiting(queue) + uxQueueSpacesAvailable(queue),
+        };
+        err = ESP_OK;
+    }
+    xSemaphoreGive(cm.lock);
+    return err;
+}
+
+esp_err_t crit_log_tag(const char *tag) {
+    if (!cm.ready) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    esp_err_t err = ESP_ERR_NO_MEM;
+    xSemaphoreTake(cm.lock, portMAX_DELAY);
+    if (cm.ntags < CRIT_MAX_TAGS) {
+        cm.tags[cm.ntags++] = (tag_entry_t){ .tag = tag, .saved = esp_log_level_get(tag) };
+        err = ESP_OK;
+    }
+    xSemaphoreGive(cm.lock);
+    return err;
+}
+
+crit_mode_t crit_get_mode(void) {
+    return cm.mode;
+}
+
+bool crit_shed(crit_level_t level) {
+    return cm.mode == CRIT_MODE_OVERLOAD && level != CRIT_HIGH;
+}
+
+void crit_report(FILE *out) {
+    if (!cm.ready) {
+        return;
+    }
+    xSemaphoreTake(cm.lock, portMAX_DELAY);
+    uint32_t here_ms = (uint32_t)(ts_to_us(ts_now() - cm.mode_since) / 1000);
+    uint64_t overload_ms = cm.det.overload_ms;
+    if (cm.mode == CRIT_MODE_OVERLOAD) {
+        overload_ms = overload_ms - cm.det.in_mode_ms + here_ms;
+    }
+    fprintf(out, "critmode: %s for %" PRIu32 " ms, %" PRIu32 " switches, %" PRIu64 " ms overloaded, "
+                 "last: %s; peak cpu %u%%, %" PRIu32 " deadline misses, %" PRIu32 " timer commands retried\n",
+            cm.mode == CRIT_MODE_OVERLOAD ? "OVERLOAD" : "normal", here_ms, cm.det.switches,
+            overload_ms, cm.det.switches ? cm.det.reason : "-", cm.peak_cpu,
+            cm.total_misses, cm.cmd_failures);
+    for (int i = 0; i < cm.ntasks; i++) {
+        const struct crit_task *t = &cm.tasks[i];
+        fprintf(out, "  task %-14s %-6s parked %" PRIu32 " throttled %" PRIu32 "\n",
+                t->name, level_names[t->level], t->parked, t->throttled);
+    }
+    for (int i = 0; i < cm.nqueues; i++) {
+        fprintf(out, "  queue %-13s peak %u%%\n", cm.queues[i].name, cm.queues[i].peak_pct);
+    }
+    xSemaphoreGive(cm.lock);
+}
+
+#endif // ESP_PLATFORM
@@ -0,0 +1,95 @@
+// Host check for the overload detector's mode logic: a load spike
+// switches at once, a load hovering between the thresholds doesn't flap,
+// recovery waits for the calm streak and the minimum stay, a hold forces
+// the mode, and a bursty trace produces one switch per real episode.
+//
+// Build and run from this directory:
+//   cc -O2 -I../include -I../../../tools/host_include ../critmode.c critmode_host_bench.c -o critmode_bench
+//   ./critmode_bench
+
+#include <stdio.h>
+#include <string.h>
+#include "critmode.h"
+#include "host_check.h"
+
+static crit_detector_t det;
+static uint32_t now_ms;
+
+static void reset(void) {
+    crit_config_t cfg = CRIT_CONFIG_DEFAULT();
+    crit_detector_init(&det, &cfg);
+    now_ms = 0;
+}
+
+// n windows of the same sample; returns the number of switches
+static uint32_t feed(int n, uint8_t cpu, uint32_t misses, uint8_t queue, const char *hold) {
+    uint32_t switches = 0;
+    for (int i = 0; i < n; i++) {
+        crit_sample_t s = {
+            .elapsed_ms = det.cfg.window_ms,
+            .cpu_pct = cpu,
+            .misses = misses,
+            .queue_pct = queue,
+            .hold = hold,
+        };
+        now_ms += s.elapsed_ms;
+        if (crit_detector_step(&det, &s)) {
+            switches++;
+            printf("  %6.1f s  %-8s (%s)\n", now_ms / 1000.0,
+                   det.mode == CRIT_MODE_OVERLOAD ? "OVERLOAD" : "normal", det.reason);
+        }
+    }
+    return switches;
+}
+
+int main(void) {
+    printf("spike, then idle:\n");
+    reset();
+    CHECK(feed(10, 40, 0, 10, NULL) == 0, "quiet load switched");
+    CHECK(feed(1, 95, 0, 10, NULL) == 1 && det.mode == CRIT_MODE_OVERLOAD, "cpu spike didn't switch");
+    CHECK(strstr(det.reason, "cpu 95%") != NULL, "reason '%s' doesn't name the cpu", det.reason);
+    // Calm at once, but min_overload_ms (5 s = 10 windows) holds it
+    CHECK(feed(9, 30, 0, 0, NULL) == 0, "left OVERLOAD before the minimum stay");
+    CHECK(feed(1, 30, 0, 0, NULL) == 1 && det.mode == CRIT_MODE_NORMAL, "didn't restore after calm + stay");
+
+    printf("hovering between the thresholds:\n");
+    reset();
+    feed(1, 92, 0, 0, NULL);
+    // 85/75 alternate: never hot enough to re-enter, never calm enough to leave
+    uint32_t flaps = 0;
+    for (int i = 0; i < 100; i++) {
+        flaps += feed(1, i & 1 ? 85 : 75, 0, 0, NULL);
+    }
+    CHECK(flaps == 0 && det.mode == CRIT_MODE_OVERLOAD, "hovering load switched %u times", flaps);
+    // One non-calm window restarts the streak
+    feed(5, 50, 0, 0, NULL);
+    CHECK(feed(1, 75, 0, 0, NULL) == 0, "restored with a broken streak");
+    CHECK(feed(5, 50, 0, 0, NULL) == 0 && det.mode == CRIT_MODE_OVERLOAD, "streak not restarted");
+    CHECK(feed(1, 50, 0, 0, NULL) == 1, "didn't restore after 6 calm windows");
+
+    printf("each signal and a hold:\n");
+    reset();
+    CHECK(feed(1, 10, 3, 0, NULL) == 1, "3 deadline misses didn't switch");
+    feed(20, 10, 0, 0, NULL);
+    CHECK(feed(1, 10, 0, 85, NULL) == 1 && strstr(det.reason, "queue 85%") != NULL, "queue growth didn't switch");
+    feed(20, 10, 0, 0, NULL);
+    CHECK(feed(1, 10, 0, 0, "emergency") == 1 && strcmp(det.reason, "emergency") == 0, "hold didn't switch");
+    CHECK(feed(40, 10, 0, 0, "emergency") == 0, "left OVERLOAD while held");
+    CHECK(feed(5, 10, 0, 0, NULL) == 0 && feed(1, 10, 0, 0, NULL) == 1, "release didn't go through the calm streak");
+    CHECK(det.mode == CRIT_MODE_NORMAL, "still overloaded after release");
+
+    printf("bursty trace (3 s bursts every 20 s, jitter around the exit threshold):\n");
+    reset();
+    uint32_t total = 0;
+    for (int episode = 0; episode < 5; episode++) {
+        total += feed(6, 96, 2, 30, NULL);
+        for (int i = 0; i < 34; i++) {
+            total += feed(1, i < 12 ? (i & 1 ? 72 : 68) : 40, 0, 0, NULL);
+        }
+    }
+    CHECK(total == 10, "%u switches for 5 bursts, expected 10", total);
+    CHECK(det.overload_ms >= 5 * 5000, "overload time %llu ms under 5 x minimum stay", (unsigned long long)det.overload_ms);
+
+    printf("\n%s\n", failures ? "FAILURES" : "OK");
+    return failures != 0;
+}
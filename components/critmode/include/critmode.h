@@ -0,0 +1,168 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include "esp_err.h"
+
+#ifdef ESP_PLATFORM
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/timers.h"
+#endif
+
+// ================ MIXED-CRITICALITY OVERLOAD MODE ================
+// Tags tasks, timers and log output with a criticality level and, when
+// the system is overloaded, sheds the low ones so the critical ones keep
+// their latency:
+//
+//   CRIT_HIGH     untouched
+//   CRIT_MEDIUM   throttled: task delays and timer periods x `throttle`
+//   CRIT_LOW      parked: tasks wait at their next crit_delay(), timers
+//                 are stopped; registered log tags drop to warnings
+//
+// A detector task samples every window_ms:
+//   - CPU utilization of the busiest core (idle-hook timing),
+//   - deadline misses reported with crit_deadline_miss(),
+//   - the fill level of watched queues,
+//   - holds placed with crit_hold() (e.g. an emergency state).
+// Any signal over its "enter" threshold switches to OVERLOAD at once.
+// Going back needs every signal under its (lower) "exit" threshold for
+// calm_windows windows in a row and at least min_overload_ms in the
+// mode, so a load hovering near a threshold can't make it flap. Every
+// switch is logged with its cause.
+//
+//   crit_init(NULL);                               // defaults
+//   crit_log_tag(TAG);
+//   crit_register_timer(stats_timer, CRIT_LOW);
+//
+//   void learning_task(void *arg) {
+//       crit_task_t *ct = crit_task_register("Learning", CRIT_LOW);
+//       for (;;) {
+//           crit_delay(ct, 30000);                 // instead of vTaskDelay
+//           ...
+//       }
+//   }
+//
+// Tasks are parked cooperatively at crit_delay(), never suspended from
+// outside, so a shed task can't be stopped while holding a mutex. The
+// idle hooks return false to keep the idle loop spinning for the CPU
+// measurement, which keeps the cores out of WAITI (no light sleep).
+//
+// crit_detector_step() has no clock of its own: it decides the mode one
+// sample at a time from what it is given, so recorded load can be fed
+// back through it.
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define CRIT_MAX_TASKS      16
+#define CRIT_MAX_TIMERS     24
+#define CRIT_MAX_QUEUES     4
+#define CRIT_MAX_TAGS       4
+
+typedef enum {
+    CRIT_HIGH,
+    CRIT_MEDIUM,
+    CRIT_LOW,
+} crit_level_t;
+
+typedef enum {
+    CRIT_MODE_NORMAL,
+    CRIT_MODE_OVERLOAD,
+} crit_mode_t;
+
+typedef struct {
+    uint32_t window_ms;             // Detector period
+    uint8_t cpu_enter_pct;
+    uint8_t cpu_exit_pct;
+    uint8_t queue_enter_pct;
+    uint8_t queue_exit_pct;
+    uint32_t miss_enter;            // Deadline misses in one window
+    uint32_t miss_exit;
+    uint32_t calm_windows;          // Calm in a row before restoring
+    uint32_t min_overload_ms;       // Shortest stay in OVERLOAD
+    uint8_t throttle;               // CRIT_MEDIUM slowdown factor
+    uint8_t priority;               // Detector task
+} crit_config_t;
+
+#define CRIT_CONFIG_DEFAULT() {     \
+    .window_ms = 500,               \
+    .cpu_enter_pct = 90,            \
+    .cpu_exit_pct = 70,             \
+    .queue_enter_pct = 80,          \
+    .queue_exit_pct = 40,           \
+    .miss_enter = 3,                \
+    .miss_exit = 0,                 \
+    .calm_windows = 6,              \
+    .min_overload_ms = 5000,        \
+    .throttle = 4,                  \
+    .priority = 20,                 \
+}
+
+// ---- Mode logic (portable) ----
+
+typedef struct {
+    uint32_t elapsed_ms;            // Since the previous sample
+    uint8_t cpu_pct;                // Busiest core
+    uint32_t misses;
+    uint8_t queue_pct;              // Fullest watched queue
+    const char *hold;               // Reason of an active hold, or NULL
+} crit_sample_t;
+
+typedef struct {
+    crit_config_t cfg;
+    crit_mode_t mode;
+    uint32_t calm;                  // Calm windows in a row
+    uint32_t in_mode_ms;
+    uint32_t switches;
+    uint64_t overload_ms;
+    char reason[64];                // What triggered the last switch
+} crit_detector_t;
+
+void crit_detector_init(crit_detector_t *d, const crit_config_t *cfg);
+
+// Feed one window; true if the mode changed (d->reason says why)
+bool crit_detector_step(crit_detector_t *d, const crit_sample_t *s);
+
+// ---- Device ----
+
+typedef struct crit_task crit_task_t;
+
+// Start the detector (cfg NULL = CRIT_CONFIG_DEFAULT())
+esp_err_t crit_init(const crit_config_t *cfg);
+
+// Called by the task itself
+crit_task_t *crit_task_register(const char *name, crit_level_t level);
+
+// vTaskDelay() that parks (CRIT_LOW) or stretches (CRIT_MEDIUM) in
+// OVERLOAD. Parked tasks resume when the mode returns to NORMAL.
+void crit_delay(crit_task_t *task, uint32_t ms);
+
+#ifdef ESP_PLATFORM
+esp_err_t crit_register_timer(TimerHandle_t timer, crit_level_t level);
+void crit_unregister_timer(TimerHandle_t timer);
+esp_err_t crit_watch_queue(QueueHandle_t queue, const char *name);
+#endif
+
+// Log tag whose info output is dropped in OVERLOAD
+esp_err_t crit_log_tag(const char *tag);
+
+// Any context, including ISRs and timer callbacks
+void crit_deadline_miss(void);
+
+// Force OVERLOAD while held; releasing goes through the usual hysteresis
+void crit_hold(const char *reason, bool on);
+
+crit_mode_t crit_get_mode(void);
+
+// Is `level` shed or throttled right now? For work that isn't a task
+// loop (LED patterns in a callback, optional logging)
+bool crit_shed(crit_level_t level);
+
+void crit_report(FILE *out);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,160 @@
+#include <stdlib.h>
+#include <string.h>
+#include "delayq.h"
+
+// ================ HEAP ================
+
+static const uint32_t late_bounds_us[DQ_LATE_BUCKETS - 1] = { 1000, 10000, 100000, 1000000 };
+
+esp_err_t dq_core_init(dq_core_t *c, uint32_t capacity, size_t item_size) {
+    if (capacity == 0 || capacity > DQ_MAX_CAPACITY || item_size == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    memset(c, 0, sizeof(*c));
+    c->heap = calloc(capacity, sizeof(dq_entry_t));
+    c->pos = calloc(capacity, sizeof(uint16_t));
+    c->gen = calloc(capacity, sizeof(uint16_t));
+    c->free_slots = calloc(capacity, sizeof(uint16_t));
+    c->items = calloc(capacity, item_size);
+    if (!c->heap || !c->pos || !c->gen || !c->free_slots || !c->items) {
+        dq_core_free(c);
+        return ESP_ERR_NO_MEM;
+    }
+    c->capacity = capacity;
+    c->item_size = item_size;
+    for (uint32_t i = 0; i < capacity; i++) {
+        c->free_slots[i] = (uint16_t)(capacity - 1 - i);   // Slot 0 on top
+        c->gen[i] = 1;
+    }
+    return ESP_OK;
+}
+
+void dq_core_free(dq_core_t *c) {
+    free(c->heap);
+    free(c->pos);
+    free(c->gen);
+    free(c->free_slots);
+    free(c->items);
+    memset(c, 0, sizeof(*c));
+}
+
+// Earlier due time first (wrap-safe), then send order
+static bool before(const dq_entry_t *a, const dq_entry_t *b) {
+    int32_t d = (int32_t)(a->due_us - b->due_us);
+    return d < 0 || (d == 0 && (int32_t)(a->seq - b->seq) < 0);
+}
+
+static void place(dq_core_t *c, uint32_t i, const dq_entry_t *e) {
+    c->heap[i] = *e;
+    c->pos[e->slot] = (uint16_t)i;
+}
+
+static void sift_up(dq_core_t *c, uint32_t i) {
+    dq_entry_t e = c->heap[i];
+    while (i > 0) {
+        uint32_t parent = (i - 1) / 2;
+        if (!before(&e, &c->heap[parent])) {
+            break;
+        }
+        place(c, i, &c->heap[parent]);
+        i = parent;
+    }
+    place(c, i, &e);
+}
+
+static void sift_down(dq_core_t *c, uint32_t i) {
+    dq_entry_t e = c->heap[i];
+    for (;;) {
+        uint32_t child = 2 * i + 1;
+        if (child >= c->count) {
+            break;
+        }
+        if (child + 1 < c->count && before(&c->heap[child + 1], &c->heap[child])) {
+            child++;
+        }
+        if (!before(&c->heap[child], &e)) {
+            break;
+        }
+        place(c, i, &c->heap[child]);
+        i = child;
+    }
+    place(c, i, &e);
+}
+
+// Take heap entry i out and give its slot back; the handle goes stale
+static void remove_at(dq_core_t *c, uint32_t i) {
+    uint16_t slot = c->heap[i].slot;
+    c->count--;
+    if (i < c->count) {
+        place(c, i, &c->heap[c->count]);
+        if (i > 0 && before(&c->heap[i], &c->heap[(i - 1) / 2])) {
+            sift_up(c, i);
+        } else {
+            sift_down(c, i);
+        }
+    }
+    if (++c->gen[slot] == 0) {
+        c->gen[slot] = 1;           // Keep handles non-zero
+    }
+    c->free_slots[c->capacity - c->count - 1] = slot;
+}
+
+dq_handle_t dq_core_push(dq_core_t *c, const void *item, uint32_t due_us) {
+    if (c->count == c->capacity) {
+        c->refused++;
+        return DQ_NO_HANDLE;
+    }
+    uint16_t slot = c->free_slots[c->capacity - c->count - 1];
+    memcpy(c->items + (size_t)slot * c->item_size, item, c->item_size);
+    dq_entry_t e = { .due_us = due_us, .seq = c->seq++, .slot = slot };
+    c->heap[c->count] = e;
+    sift_up(c, c->count++);
+    c->scheduled++;
+    return (dq_handle_t)c->gen[slot] << 16 | slot;
+}
+
+bool dq_core_cancel(dq_core_t *c, dq_handle_t h) {
+    uint32_t slot = h & 0xFFFF;
+    if (h == DQ_NO_HANDLE || slot >= c->capacity || c->gen[slot] != (h >> 16)) {
+        return false;               // Delivered or cancelled already
+    }
+    uint32_t i = c->pos[slot];
+    if (i >= c->count || c->heap[i].slot != slot) {
+        return false;               // Free slot whose generation wrapped around
+    }
+    remove_at(c, i);
+    c->cancelled++;
+    return true;
+}
+
+bool dq_core_next_due(const dq_core_t *c, uint32_t *due_us) {
+    if (c->count == 0) {
+        return false;
+    }
+    *due_us = c->heap[0].due_us;
+    return true;
+}
+
+bool dq_core_pop(dq_core_t *c, uint32_t now_us, void *item) {
+    if (c->count == 0) {
+        return false;
+    }
+    uint32_t late = now_us - c->heap[0].due_us;
+    if ((int32_t)late < 0) {
+        return false;
+    }
+    memcpy(item, c->items + (size_t)c->heap[0].slot * c->item_size, c->item_size);
+    remove_at(c, 0);
+
+    c->delivered++;
+    c->late_sum_us += late;
+    if (late > c->late_max_us) {
+        c->late_max_us = late;
+    }
+    int b = 0;
+    while (b < DQ_LATE_BUCKETS - 1 && late >= late_bounds_us[b]) {
+        b++;
+    }
+    c->late_hist[b]++;
+    return true;
+}
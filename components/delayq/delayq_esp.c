@@ -0,0 +1,189 @@
+#ifdef ESP_PLATFORM
+
+#include <string.h>
+#include <inttypes.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "esp_timer.h"
+#include "esp_log.h"
+#include "delayq.h"
+
+static const char *TAG = "DELAYQ";
+
+static dq_queue_t *registry;
+
+static uint32_t now_us(void) {
+    return (uint32_t)esp_timer_get_time();
+}
+
+// Push mode: point the timer at the earliest item. Serialized, so a
+// slower caller can't overwrite a newer, earlier deadline.
+static void rearm(dq_queue_t *q) {
+    xSemaphoreTake((SemaphoreHandle_t)q->arm_lock, portMAX_DELAY);
+    uint32_t due;
+    taskENTER_CRITICAL(&q->lock);
+    bool pending = dq_core_next_due(&q->core, &due);
+    taskEXIT_CRITICAL(&q->lock);
+
+    esp_timer_handle_t timer = (esp_timer_handle_t)q->timer;
+    esp_timer_stop(timer);          // Not running is fine
+    if (pending) {
+        int32_t in = (int32_t)(due - now_us());
+        esp_timer_start_once(timer, in > 0 ? (uint64_t)in : 1);
+    }
+    xSemaphoreGive((SemaphoreHandle_t)q->arm_lock);
+}
+
+// Push mode: run everything that's due, then wait for the next one
+static void on_timer(void *arg) {
+    dq_queue_t *q = (dq_queue_t *)arg;
+    uint8_t item[q->core.item_size];
+    for (;;) {
+        taskENTER_CRITICAL(&q->lock);
+        bool got = dq_core_pop(&q->core, now_us(), item);
+        taskEXIT_CRITICAL(&q->lock);
+        if (!got) {
+            break;
+        }
+        q->handler(item, q->arg);
+    }
+    rearm(q);
+}
+
+esp_err_t dq_create(dq_queue_t *q, const char *name, uint32_t capacity, size_t item_size,
+                    dq_handler_t handler, void *arg) {
+    memset(q, 0, sizeof(*q));
+    esp_err_t err = dq_core_init(&q->core, capacity, item_size);
+    if (err != ESP_OK) {
+        return err;
+    }
+    q->name = name;
+    q->handler = handler;
+    q->arg = arg;
+    portMUX_INITIALIZE(&q->lock);
+
+    if (handler == NULL) {
+        q->wake = xSemaphoreCreateBinary();
+        if (q->wake == NULL) {
+            dq_core_free(&q->core);
+            return ESP_ERR_NO_MEM;
+        }
+    } else {
+        q->arm_lock = xSemaphoreCreateMutex();
+        if (q->arm_lock == NULL) {
+            dq_core_free(&q->core);
+            return ESP_ERR_NO_MEM;
+        }
+        const esp_timer_create_args_t args = {
+            .callback = on_timer,
+            .arg = q,
+            .dispatch_method = ESP_TIMER_TASK,
+            .name = name,
+        };
+        esp_timer_handle_t timer;
+        err = esp_timer_create(&args, &timer);
+        if (err != ESP_OK) {
+            vSemaphoreDelete((SemaphoreHandle_t)q->arm_lock);
+            dq_core_free(&q->core);
+            return err;
+        }
+        q->timer = timer;
+    }
+
+    q->next = registry;
+    registry = q;
+    ESP_LOGI(TAG, "⏲️ %s: %lu x %u B, %s", name, capacity, (unsigned)item_size,
+             handler ? "dispatched by esp_timer" : "pull (dq_receive)");
+    return ESP_OK;
+}
+
+dq_handle_t dq_send_at(dq_queue_t *q, const void *item, uint32_t due_us) {
+    taskENTER_CRITICAL(&q->lock);
+    dq_handle_t h = dq_core_push(&q->core, item, due_us);
+    bool new_head = h != DQ_NO_HANDLE && q->core.heap[0].slot == (h & 0xFFFF);
+    taskEXIT_CRITICAL(&q->lock);
+
+    // Only an item that moved up to the head changes when anyone wakes
+    if (new_head) {
+        if (q->handler != NULL) {
+            rearm(q);
+        } else {
+            xSemaphoreGive((SemaphoreHandle_t)q->wake);
+        }
+    }
+    return h;
+}
+
+dq_handle_t dq_send_after(dq_queue_t *q, const void *item, uint32_t delay_ms) {
+    return dq_send_at(q, item, now_us() + delay_ms * 1000);
+}
+
+bool dq_cancel(dq_queue_t *q, dq_handle_t h) {
+    taskENTER_CRITICAL(&q->lock);
+    bool cancelled = dq_core_cancel(&q->core, h);
+    taskEXIT_CRITICAL(&q->lock);
+    // A timer or receiver aimed at the cancelled item wakes early, finds
+    // nothing due and goes back to sleep until the new head
+    return cancelled;
+}
+
+BaseType_t dq_receive(dq_queue_t *q, void *item, TickType_t wait) {
+    if (q->handler != NULL) {
+        return pdFAIL;              // Push mode: the handler gets everything
+    }
+    TimeOut_t timeout;
+    vTaskSetTimeOutState(&timeout);
+    for (;;) {
+        uint32_t now = now_us(), due;
+        taskENTER_CRITICAL(&q->lock);
+        bool got = dq_core_pop(&q->core, now, item);
+        bool pending = dq_core_next_due(&q->core, &due);
+        taskEXIT_CRITICAL(&q->lock);
+
+        if (got) {
+            if (pending && (int32_t)(due - now) <= 0) {
+                xSemaphoreGive((SemaphoreHandle_t)q->wake);     // More due: pass it on
+            }
+            return pdPASS;
+        }
+        if (xTaskCheckForTimeOut(&timeout, &wait) == pdTRUE) {
+            return pdFAIL;
+        }
+        // Sleep until the head is due (rounded up to a tick), the wait
+        // runs out, or a send puts an earlier item at the head
+        TickType_t sleep = wait;
+        if (pending) {
+            uint32_t in_ms = ((uint32_t)(due - now) + 999) / 1000;
+            TickType_t ticks = pdMS_TO_TICKS(in_ms) + 1;
+            if (ticks < sleep) {
+                sleep = ticks;
+            }
+        }
+        xSemaphoreTake((SemaphoreHandle_t)q->wake, sleep);
+    }
+}
+
+uint32_t dq_pending(dq_queue_t *q) {
+    taskENTER_CRITICAL(&q->lock);
+    uint32_t n = q->core.count;
+    taskEXIT_CRITICAL(&q->lock);
+    return n;
+}
+
+void dq_report(FILE *out) {
+    for (dq_queue_t *q = registry; q != NULL; q = q->next) {
+        taskENTER_CRITICAL(&q->lock);
+        dq_core_t c = q->core;      // Counters only; the arrays stay put
+        taskEXIT_CRITICAL(&q->lock);
+
+        fprintf(out, "delayq [%s]: %" PRIu32 " scheduled, %" PRIu32 " delivered, %" PRIu32 " cancelled, "
+                     "%" PRIu32 " refused, %" PRIu32 " pending, late avg %" PRIu32 " us max %" PRIu32 " us "
+                     "(<1ms %" PRIu32 " | <10ms %" PRIu32 " | <100ms %" PRIu32 " | <1s %" PRIu32 " | more %" PRIu32 ")\n",
+                q->name, c.scheduled, c.delivered, c.cancelled, c.refused, c.count,
+                c.delivered ? (uint32_t)(c.late_sum_us / c.delivered) : 0, c.late_max_us,
+                c.late_hist[0], c.late_hist[1], c.late_hist[2], c.late_hist[3], c.late_hist[4]);
+    }
+}
+
+#endif // ESP_PLATFORM
@@ -0,0 +1,139 @@
+// Host check for the delay-queue heap: a long random mix of sends,
+// cancels and pops against a plain array kept in order, on a clock that
+// starts just short of the 32-bit wrap. Items must come out exactly when
+// due, in due-time order and FIFO among equal times; cancelled items
+// never come out; stale handles (delivered, cancelled, slot reused)
+// cancel nothing; a full queue refuses; lateness lands in the right
+// histogram bucket.
+//
+// Build and run from this directory:
+//   cc -O2 -I../include -I../../../tools/host_include ../delayq.c delayq_host_bench.c -o delayq_bench
+//   ./delayq_bench
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "delayq.h"
+#include "host_check.h"
+
+#define CAPACITY        64
+#define STEPS           200000
+
+typedef struct {
+    uint32_t id;
+    uint32_t due_us;
+} item_t;
+
+// Reference: pending items in send order
+typedef struct {
+    item_t item;
+    dq_handle_t h;
+} ref_t;
+
+static ref_t ref[CAPACITY];
+static int ref_n;
+
+// Earliest due (wrap-safe), first sent among equals
+static int ref_head(void) {
+    int best = -1;
+    for (int i = 0; i < ref_n; i++) {
+        if (best < 0 || (int32_t)(ref[i].item.due_us - ref[best].item.due_us) < 0) {
+            best = i;
+        }
+    }
+    return best;
+}
+
+static void ref_remove(int i) {
+    memmove(&ref[i], &ref[i + 1], (ref_n - i - 1) * sizeof(ref[0]));
+    ref_n--;
+}
+
+static void random_mix(void) {
+    dq_core_t c;
+    CHECK(dq_core_init(&c, CAPACITY, sizeof(item_t)) == ESP_OK, "init");
+    dq_handle_t stale[256];
+    int stale_n = 0;
+    uint32_t now = 0xFFFFFFFFu - 5000000u;      // Wraps 5 s in
+    uint32_t next_id = 1, delivered = 0, cancelled = 0, refused = 0;
+
+    for (int step = 0; step < STEPS; step++) {
+        int op = rand() % 10;
+        if (op < 5) {
+            // Coarse due times so equal ones are common
+            item_t it = { .id = next_id++, .due_us = now + (uint32_t)(rand() % 50) * 1000 };
+            dq_handle_t h = dq_core_push(&c, &it, it.due_us);
+            if (ref_n == CAPACITY) {
+                CHECK(h == DQ_NO_HANDLE, "full queue accepted an item");
+                refused++;
+            } else {
+                CHECK(h != DQ_NO_HANDLE, "push refused with %d pending", ref_n);
+                ref[ref_n++] = (ref_t){ it, h };
+            }
+        } else if (op < 7 && ref_n > 0) {
+            int i = rand() % ref_n;
+            CHECK(dq_core_cancel(&c, ref[i].h), "cancel of pending item %lu failed", (unsigned long)ref[i].item.id);
+            stale[stale_n++ % 256] = ref[i].h;
+            ref_remove(i);
+            cancelled++;
+        } else if (op < 8 && stale_n > 0) {
+            dq_handle_t h = stale[rand() % (stale_n < 256 ? stale_n : 256)];
+            CHECK(!dq_core_cancel(&c, h), "stale handle %08lx cancelled something", (unsigned long)h);
+        } else {
+            now += rand() % 3000;
+            item_t it;
+            while (dq_core_pop(&c, now, &it)) {
+                int i = ref_head();
+                CHECK(i >= 0, "popped %lu from an empty queue", (unsigned long)it.id);
+                if (i < 0) {
+                    break;
+                }
+                CHECK(it.id == ref[i].item.id, "popped %lu, expected %lu", (unsigned long)it.id,
+                      (unsigned long)ref[i].item.id);
+                CHECK((int32_t)(now - it.due_us) >= 0, "item %lu popped early", (unsigned long)it.id);
+                stale[stale_n++ % 256] = ref[i].h;
+                ref_remove(i);
+                delivered++;
+            }
+            int i = ref_head();
+            CHECK(i < 0 || (int32_t)(ref[i].item.due_us - now) > 0, "due item %lu left in the queue",
+                  (unsigned long)ref[i].item.id);
+        }
+        CHECK(c.count == (uint32_t)ref_n, "count %lu, expected %d", (unsigned long)c.count, ref_n);
+    }
+
+    CHECK(c.delivered == delivered && c.cancelled == cancelled && c.refused == refused,
+          "stats %lu/%lu/%lu, expected %lu/%lu/%lu", (unsigned long)c.delivered, (unsigned long)c.cancelled,
+          (unsigned long)c.refused, (unsigned long)delivered, (unsigned long)cancelled, (unsigned long)refused);
+    printf("random mix: %lu delivered, %lu cancelled, %lu refused, late avg %lu us max %lu us\n",
+           (unsigned long)delivered, (unsigned long)cancelled, (unsigned long)refused,
+           (unsigned long)(c.delivered ? c.late_sum_us / c.delivered : 0), (unsigned long)c.late_max_us);
+    dq_core_free(&c);
+}
+
+static void lateness(void) {
+    dq_core_t c;
+    dq_core_init(&c, 8, sizeof(uint32_t));
+    static const uint32_t late[] = { 0, 999, 1000, 9999, 50000, 500000, 1000000, 7000000 };
+    static const uint32_t expect[DQ_LATE_BUCKETS] = { 2, 2, 1, 1, 2 };
+    for (int i = 0; i < 8; i++) {
+        uint32_t v = i, out;
+        dq_core_push(&c, &v, 1000);
+        CHECK(!dq_core_pop(&c, 999, &out), "popped before due");
+        CHECK(dq_core_pop(&c, 1000 + late[i], &out) && out == v, "pop %d", i);
+    }
+    for (int b = 0; b < DQ_LATE_BUCKETS; b++) {
+        CHECK(c.late_hist[b] == expect[b], "bucket %d: %lu, expected %lu", b,
+              (unsigned long)c.late_hist[b], (unsigned long)expect[b]);
+    }
+    CHECK(c.late_max_us == 7000000, "late max %lu", (unsigned long)c.late_max_us);
+    dq_core_free(&c);
+}
+
+int main(void) {
+    srand(91);
+    random_mix();
+    lateness();
+    printf("%s\n", failures ? "FAILURES" : "OK");
+    return failures != 0;
+}
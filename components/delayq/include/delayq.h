@@ -0,0 +1,142 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include "esp_err.h"
+
+#ifdef ESP_PLATFORM
+#include "freertos/FreeRTOS.h"
+#endif
+
+// ================ DELAY QUEUE ================
+// A queue whose items carry a due time and can only be taken out once
+// it has passed - for "do this in 8 s", retries with backoff, an LED to
+// switch off again - without a one-shot timer or a sleeping task per
+// item. Items come out in due-time order (FIFO among equal times), and
+// each send returns a handle that cancels the item while it's pending.
+//
+// Two ways to get items out:
+//
+//   pull   dq_receive() blocks until the earliest item is due (or a
+//          new, earlier one arrives) - a task that consumes them
+//   push   give dq_create() a handler; one esp_timer, re-armed to the
+//          earliest due time, calls it for each item as it falls due
+//          (in the esp_timer task: keep it short, don't block)
+//
+//   static dq_queue_t actions;
+//   dq_create(&actions, "actions", 8, sizeof(action_t), run_action, NULL);
+//
+//   dq_handle_t h = dq_send_after(&actions, &(action_t){ RESUME_FEEDS }, 8000);
+//   ...
+//   dq_cancel(&actions, h);            // false if it already ran
+//
+// Every delivery records how late it came out (now - due): pull-mode
+// lateness is mostly the consumer being busy, push-mode lateness the
+// esp_timer task's. dq_report() prints it as avg / max and a histogram.
+//
+// Items live in a binary min-heap with a slot per item, so send, cancel
+// and receive are O(log n) with no allocation after dq_create(). Handles
+// carry a generation count: cancelling an item that already came out
+// (or a handle from before its slot was reused) is a harmless no-op.
+//
+// Times are the low 32 bits of esp_timer_get_time() in microseconds;
+// everything pending must be due within ~35 min of now. The heap
+// underneath (dq_core_*) never reads a clock: it is given due and
+// current times and only keeps items in order.
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define DQ_MAX_CAPACITY     65535
+#define DQ_LATE_BUCKETS     5       // < 1 ms, < 10 ms, < 100 ms, < 1 s, longer
+
+typedef uint32_t dq_handle_t;       // Generation << 16 | slot; never 0
+#define DQ_NO_HANDLE        0
+
+// ---- Heap (portable) ----
+
+typedef struct {
+    uint32_t due_us;
+    uint32_t seq;                   // Send order, for FIFO among equal due times
+    uint16_t slot;
+} dq_entry_t;
+
+typedef struct {
+    uint32_t capacity;
+    size_t item_size;
+    uint32_t count;
+    uint32_t seq;
+    dq_entry_t *heap;
+    uint16_t *pos;                  // Slot -> heap index
+    uint16_t *gen;                  // Slot generation (handles)
+    uint16_t *free_slots;           // Stack of unused slots
+    uint8_t *items;                 // capacity x item_size
+
+    // Statistics
+    uint32_t scheduled;
+    uint32_t cancelled;
+    uint32_t refused;               // Full
+    uint32_t delivered;
+    uint64_t late_sum_us;
+    uint32_t late_max_us;
+    uint32_t late_hist[DQ_LATE_BUCKETS];
+} dq_core_t;
+
+esp_err_t dq_core_init(dq_core_t *c, uint32_t capacity, size_t item_size);
+void dq_core_free(dq_core_t *c);
+
+// DQ_NO_HANDLE if full
+dq_handle_t dq_core_push(dq_core_t *c, const void *item, uint32_t due_us);
+
+// true if the item was still pending
+bool dq_core_cancel(dq_core_t *c, dq_handle_t h);
+
+// Due time of the earliest item; false if empty
+bool dq_core_next_due(const dq_core_t *c, uint32_t *due_us);
+
+// Take the earliest item if it's due at now_us (and record its lateness)
+bool dq_core_pop(dq_core_t *c, uint32_t now_us, void *item);
+
+// ---- Device ----
+
+#ifdef ESP_PLATFORM
+typedef void (*dq_handler_t)(void *item, void *arg);
+
+typedef struct dq_queue {
+    const char *name;
+    dq_core_t core;
+    portMUX_TYPE lock;              // core
+    void *wake;                     // Pull: SemaphoreHandle_t, given when the head moves up
+    void *timer;                    // Push: esp_timer_handle_t
+    void *arm_lock;                 // Push: SemaphoreHandle_t around re-arming
+    dq_handler_t handler;
+    void *arg;
+    struct dq_queue *next;
+} dq_queue_t;
+
+// handler NULL = pull mode (dq_receive())
+esp_err_t dq_create(dq_queue_t *q, const char *name, uint32_t capacity, size_t item_size,
+                    dq_handler_t handler, void *arg);
+
+// From tasks and timer callbacks (not ISRs). DQ_NO_HANDLE if full.
+dq_handle_t dq_send_at(dq_queue_t *q, const void *item, uint32_t due_us);
+dq_handle_t dq_send_after(dq_queue_t *q, const void *item, uint32_t delay_ms);
+
+bool dq_cancel(dq_queue_t *q, dq_handle_t h);
+
+// Pull mode: the earliest item once it's due; pdFAIL if none fell due
+// within `wait`
+BaseType_t dq_receive(dq_queue_t *q, void *item, TickType_t wait);
+
+uint32_t dq_pending(dq_queue_t *q);
+
+// One line per queue: counts, pending, lateness avg/max and histogram
+void dq_report(FILE *out);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,129 @@
+#include <string.h>
+#include <inttypes.h>
+#include "errstat.h"
+
+static es_site_t *registry;
+static uint32_t next_id;
+
+// ================ RECORDING ================
+
+void es_site_init(es_site_t *site, const char *where, const char *what) {
+    memset(site, 0, sizeof(*site));
+    site->where = where;
+    site->what = what;
+}
+
+static void enlist(es_site_t *site) {
+    uint8_t expected = 0;
+    if (!__atomic_compare_exchange_n(&site->registered, &expected, 1, false,
+                                     __ATOMIC_ACQ_REL, __ATOMIC_RELAXED)) {
+        return;
+    }
+    site->id = __atomic_add_fetch(&next_id, 1, __ATOMIC_RELAXED);
+    es_site_t *head = __atomic_load_n(&registry, __ATOMIC_ACQUIRE);
+    do {
+        site->next = head;
+    } while (!__atomic_compare_exchange_n(&registry, &head, site, true,
+                                          __ATOMIC_RELEASE, __ATOMIC_ACQUIRE));
+}
+
+static void count_code(es_site_t *site, int32_t code) {
+    for (int i = 0; i < ES_CODES; i++) {
+        es_code_t *c = &site->codes[i];
+        int32_t seen = __atomic_load_n(&c->code, __ATOMIC_RELAXED);
+        if (seen == 0) {
+            // Claim the free slot; a racing writer may take it with
+            // another code first
+            __atomic_compare_exchange_n(&c->code, &seen, code, false,
+                                        __ATOMIC_RELAXED, __ATOMIC_RELAXED);
+        }
+        if (seen == code || seen == 0) {
+            __atomic_fetch_add(&c->count, 1, __ATOMIC_RELAXED);
+            return;
+        }
+    }
+    __atomic_fetch_add(&site->other_codes, 1, __ATOMIC_RELAXED);
+}
+
+void es_record_at(es_site_t *site, int32_t code, uint32_t arg, uint32_t now_ms) {
+    if (__atomic_fetch_add(&site->count, 1, __ATOMIC_RELAXED) == 0) {
+        __atomic_store_n(&site->first_ms, now_ms, __ATOMIC_RELAXED);
+        enlist(site);
+    }
+    __atomic_store_n(&site->last_ms, now_ms, __ATOMIC_RELAXED);
+    __atomic_store_n(&site->last_arg, arg, __ATOMIC_RELAXED);
+    count_code(site, code ? code : ESP_FAIL);
+}
+
+es_site_t *es_sites(void) {
+    return __atomic_load_n(&registry, __ATOMIC_ACQUIRE);
+}
+
+uint32_t es_total(void) {
+    uint32_t total = 0;
+    for (es_site_t *s = es_sites(); s != NULL; s = s->next) {
+        total += __atomic_load_n(&s->count, __ATOMIC_RELAXED);
+    }
+    return total;
+}
+
+// ================ REPORTS ================
+
+// fresh: errors since the last es_report_new(), 0 to leave it out
+static void print_site(FILE *out, const es_site_t *s, uint32_t count, uint32_t fresh) {
+    fprintf(out, "errstat #%" PRIu32 " %s: %s x%" PRIu32, s->id, s->where, s->what, count);
+    if (fresh) {
+        fprintf(out, " (+%" PRIu32 ")", fresh);
+    }
+    fprintf(out, ", codes");
+    for (int i = 0; i < ES_CODES; i++) {
+        int32_t code = __atomic_load_n(&s->codes[i].code, __ATOMIC_RELAXED);
+        if (code != 0) {
+            fprintf(out, " 0x%" PRIx32 "x%" PRIu32, (uint32_t)code, __atomic_load_n(&s->codes[i].count, __ATOMIC_RELAXED));
+        }
+    }
+    if (s->other_codes) {
+        fprintf(out, " otherx%" PRIu32, s->other_codes);
+    }
+    fprintf(out, ", first %.1f s, last %.1f s, arg 0x%08" PRIx32 "\n",
+            s->first_ms / 1000.0f, __atomic_load_n(&s->last_ms, __ATOMIC_RELAXED) / 1000.0f,
+            __atomic_load_n(&s->last_arg, __ATOMIC_RELAXED));
+}
+
+uint32_t es_report_new(FILE *out, uint32_t max_lines, es_new_fn on_new, void *ctx) {
+    uint32_t sites = 0, quiet_sites = 0, quiet_errors = 0;
+    for (es_site_t *s = es_sites(); s != NULL; s = s->next) {
+        uint32_t count = __atomic_load_n(&s->count, __ATOMIC_RELAXED);
+        uint32_t fresh = count - s->reported;
+        if (fresh == 0) {
+            continue;
+        }
+        s->reported = count;
+        sites++;
+        if (on_new != NULL) {
+            on_new(s, fresh, ctx);
+        }
+        if (max_lines != 0 && sites > max_lines) {
+            quiet_sites++;
+            quiet_errors += fresh;
+            continue;
+        }
+        print_site(out, s, count, fresh);
+    }
+    if (quiet_sites) {
+        fprintf(out, "errstat ... and %" PRIu32 " more sites with %" PRIu32 " new errors (es_report() for all)\n",
+                quiet_sites, quiet_errors);
+    }
+    return sites;
+}
+
+void es_report(FILE *out) {
+    uint32_t sites = 0;
+    for (const es_site_t *s = es_sites(); s != NULL; s = s->next) {
+        print_site(out, s, __atomic_load_n(&s->count, __ATOMIC_RELAXED), 0);
+        sites++;
+    }
+    if (sites == 0) {
+        fprintf(out, "errstat: no errors\n");
+    }
+}
@@ -0,0 +1,38 @@
+#ifdef ESP_PLATFORM
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_timer.h"
+#include "esp_log.h"
+#include "errstat.h"
+
+static const char *TAG = "ERRSTAT";
+
+static uint32_t report_period_ms;
+static es_new_fn report_on_new;
+
+void es_record(es_site_t *site, int32_t code, uint32_t arg) {
+    es_record_at(site, code, arg, (uint32_t)(esp_timer_get_time() / 1000));
+}
+
+static void reporter_task(void *arg) {
+    TickType_t period = pdMS_TO_TICKS(report_period_ms) > 0 ? pdMS_TO_TICKS(report_period_ms) : 1;
+    TickType_t last_wake = xTaskGetTickCount();
+    while (1) {
+        vTaskDelayUntil(&last_wake, period);
+        // Quiet periods print nothing
+        es_report_new(stdout, ES_REPORT_LINES, report_on_new, NULL);
+    }
+}
+
+esp_err_t es_start(uint32_t period_ms, UBaseType_t priority, es_new_fn on_new) {
+    report_period_ms = period_ms;
+    report_on_new = on_new;
+    if (xTaskCreate(reporter_task, "ErrStat", 3072, NULL, priority, NULL) != pdPASS) {
+        return ESP_ERR_NO_MEM;
+    }
+    ESP_LOGI(TAG, "🧾 Error reporter: every %lu ms, up to %d lines", period_ms, ES_REPORT_LINES);
+    return ESP_OK;
+}
+
+#endif // ESP_PLATFORM
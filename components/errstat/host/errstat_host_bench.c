@@ -0,0 +1,163 @@
+// Host check for the error counters: four threads hammer shared sites
+// with a mix of codes (more codes than slots) and the totals must come
+// out exact; then the cost of one record against formatting a log line
+// the way the old error paths did; then the reporter's line cap and its
+// "new since last time" marks.
+//
+// Build and run from this directory:
+//   cc -O2 -I../include -I../../../tools/host_include ../errstat.c errstat_host_bench.c -o errstat_bench -lpthread
+//   ./errstat_bench
+
+#include <stdio.h>
+#include <string.h>
+#include <pthread.h>
+#include <time.h>
+#include "errstat.h"
+#include "host_check.h"
+
+#define THREADS         4
+#define PER_THREAD      200000
+
+ES_SITE(shared, "storm", "shared site");
+ES_SITE(mixed, "storm", "six codes");
+static es_site_t own[THREADS];
+
+static void *storm(void *arg) {
+    int t = (int)(long)arg;
+    for (uint32_t i = 0; i < PER_THREAD; i++) {
+        es_record_at(&shared, 0x101, i, i / 1000);
+        es_record_at(&mixed, 0x100 + (int32_t)(i % 6), i, i / 1000);
+        es_record_at(&own[t], 0x103, i, i / 1000);
+    }
+    return NULL;
+}
+
+static void concurrent(void) {
+    pthread_t threads[THREADS];
+    for (int t = 0; t < THREADS; t++) {
+        es_site_init(&own[t], "thread", "own site");
+        pthread_create(&threads[t], NULL, storm, (void *)(long)t);
+    }
+    for (int t = 0; t < THREADS; t++) {
+        pthread_join(threads[t], NULL);
+    }
+    CHECK(shared.count == THREADS * PER_THREAD, "shared count %lu", (unsigned long)shared.count);
+    CHECK(shared.codes[0].code == 0x101 && shared.codes[0].count == shared.count, "shared code slot");
+
+    uint32_t in_slots = 0;
+    for (int i = 0; i < ES_CODES; i++) {
+        in_slots += mixed.codes[i].count;
+        CHECK(mixed.codes[i].code != 0, "slot %d unclaimed", i);
+        for (int j = 0; j < i; j++) {
+            CHECK(mixed.codes[i].code != mixed.codes[j].code, "code 0x%lx in two slots",
+                  (unsigned long)mixed.codes[i].code);
+        }
+    }
+    CHECK(in_slots + mixed.other_codes == mixed.count, "codes %lu + other %lu != %lu",
+          (unsigned long)in_slots, (unsigned long)mixed.other_codes, (unsigned long)mixed.count);
+
+    uint32_t sites = 0;
+    for (es_site_t *s = es_sites(); s != NULL; s = s->next) {
+        sites++;
+    }
+    CHECK(sites == 2 + THREADS, "%lu sites registered", (unsigned long)sites);
+    CHECK(es_total() == 3u * THREADS * PER_THREAD, "total %lu", (unsigned long)es_total());
+    es_report(stdout);
+}
+
+// ================ COST ================
+
+static double now_s(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+ES_SITE(timed, "bench", "record cost");
+
+static void cost(void) {
+    const uint32_t n = 2000000;
+    double t0 = now_s();
+    for (uint32_t i = 0; i < n; i++) {
+        es_record_at(&timed, 0x101, i, i);
+    }
+    double record_ns = (now_s() - t0) / n * 1e9;
+
+    // What a logging error path does before the UART even sees it
+    static char line[128];
+    const uint32_t m = 200000;
+    t0 = now_s();
+    for (uint32_t i = 0; i < m; i++) {
+        snprintf(line, sizeof(line), "E (%lu) POOL: Memory corruption detected in pool %s (block %p)",
+                 (unsigned long)i, "small", (void *)line);
+        __asm__ volatile("" ::: "memory");
+    }
+    double log_ns = (now_s() - t0) / m * 1e9;
+    printf("cost: %.1f ns per record, %.1f ns per formatted log line (x%.0f)\n",
+           record_ns, log_ns, log_ns / record_ns);
+    CHECK(timed.count == n, "timed count");
+}
+
+// ================ REPORTER ================
+
+static uint32_t new_sites, new_errors;
+
+static void on_new(const es_site_t *site, uint32_t fresh, void *ctx) {
+    (void)site;
+    (void)ctx;
+    new_sites++;
+    new_errors += fresh;
+}
+
+static void rate_limited(void) {
+    static es_site_t many[20];
+    // Drain what the earlier parts left
+    FILE *sink = fopen("/dev/null", "w");
+    es_report_new(sink, 0, NULL, NULL);
+    fclose(sink);
+
+    for (int i = 0; i < 20; i++) {
+        es_site_init(&many[i], "many", "site");
+        for (int k = 0; k <= i; k++) {
+            es_record_at(&many[i], 0x105, k, 5000);
+        }
+    }
+    char buf[4096];
+    FILE *out = fmemopen(buf, sizeof(buf), "w");
+    uint32_t sites = es_report_new(out, 5, on_new, NULL);
+    fclose(out);
+    uint32_t lines = 0;
+    for (char *p = buf; (p = strchr(p, '\n')) != NULL; p++) {
+        lines++;
+    }
+    printf("reporter, 20 new sites, 5 lines:\n%s", buf);
+    CHECK(sites == 20 && new_sites == 20, "%lu sites, %lu callbacks", (unsigned long)sites, (unsigned long)new_sites);
+    CHECK(new_errors == 20 * 21 / 2, "%lu new errors", (unsigned long)new_errors);
+    CHECK(lines == 6, "%lu lines", (unsigned long)lines);
+    CHECK(strstr(buf, "15 more sites with") != NULL, "summary line");
+
+    // Nothing new: nothing printed
+    out = fmemopen(buf, sizeof(buf), "w");
+    sites = es_report_new(out, 5, on_new, NULL);
+    long size = ftell(out);
+    fclose(out);
+    CHECK(sites == 0 && size == 0, "quiet pass printed %ld bytes", size);
+
+    // One site fires again: one line with just its new errors
+    es_record_at(&many[3], 0x106, 0, 6000);
+    new_errors = 0;
+    out = fmemopen(buf, sizeof(buf), "w");
+    sites = es_report_new(out, 5, on_new, NULL);
+    fclose(out);
+    printf("%s", buf);
+    CHECK(sites == 1 && new_errors == 1, "re-fire: %lu sites, %lu new", (unsigned long)sites, (unsigned long)new_errors);
+    CHECK(strstr(buf, "x5 (+1)") != NULL, "re-fire line");
+}
+
+int main(void) {
+    concurrent();
+    cost();
+    rate_limited();
+    printf("%s\n", failures ? "FAILURES" : "OK");
+    return failures != 0;
+}
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include "esp_err.h"
+
+#ifdef ESP_PLATFORM
+#include "freertos/FreeRTOS.h"
+#endif
+
+// ================ ERROR COUNTERS ================
+// Error paths that only count: a call site records an error code and a
+// detail word into its own counters and returns. No log line, no GPIO,
+// no lock - a few atomic operations, safe under a mutex, in a 1 kHz
+// loop or in an ISR - so a storm of failures costs the struggling path
+// next to nothing. A background reporter prints what changed since its
+// last pass, a bounded number of lines per period:
+//
+//   ES_SITE(queue_full, "control", "queue send failed");
+//
+//   if (xQueueSend(q, &msg, 0) != pdPASS) {
+//       es_record(&queue_full, ESP_ERR_TIMEOUT, seq);    // hot path: count only
+//   }
+//
+//   es_start(1000, 2, NULL);                             // reporter task
+//
+//   errstat #1 control: queue send failed x412 (+388), codes 0x107x412,
+//     first 12.0 s, last 15.2 s, arg 0x000004d1
+//
+// A site is a call-site ID: where ("control", a pool name...) plus
+// what went wrong. Sites are static, or embedded in the object they
+// watch and set up with es_site_init(). Each keeps a total, the first
+// and last time, the last detail word and up to ES_CODES error codes
+// with their own counts (more go into "other"). It joins the registry
+// the first time it fires, lock-free, so quiet sites cost nothing.
+//
+// The reporter owns the "already reported" marks. Counters are read
+// without stopping writers, so a line may be off by the errors that
+// landed while it was being printed; the next pass shows them. Times
+// are 32-bit ms since boot.
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define ES_CODES            4
+
+typedef struct {
+    int32_t code;                   // 0 = free slot
+    uint32_t count;
+} es_code_t;
+
+typedef struct es_site {
+    const char *where;
+    const char *what;
+    uint32_t count;
+    uint32_t first_ms;
+    uint32_t last_ms;
+    uint32_t last_arg;
+    es_code_t codes[ES_CODES];
+    uint32_t other_codes;           // Codes beyond ES_CODES
+
+    // Registry
+    uint32_t id;                    // Order of first error, from 1
+    uint8_t registered;
+    struct es_site *next;
+    uint32_t reported;              // count at the last es_report_new()
+} es_site_t;
+
+#define ES_SITE_INIT(where_, what_) { .where = (where_), .what = (what_) }
+#define ES_SITE(var, where, what)   static es_site_t var = ES_SITE_INIT(where, what)
+
+void es_site_init(es_site_t *site, const char *where, const char *what);
+
+// Hot path: count one error at now_ms
+void es_record_at(es_site_t *site, int32_t code, uint32_t arg, uint32_t now_ms);
+
+// Sites that have fired, newest registration first
+es_site_t *es_sites(void);
+uint32_t es_total(void);
+
+// Sites with errors since the last call, at most max_lines of them (0 =
+// all) and one line for the rest; marks them reported. Returns the
+// number of sites with new errors. For each one, on_new (may be NULL)
+// gets the site and its new errors.
+typedef void (*es_new_fn)(const es_site_t *site, uint32_t fresh, void *ctx);
+uint32_t es_report_new(FILE *out, uint32_t max_lines, es_new_fn on_new, void *ctx);
+
+// Every site that fired: totals, codes, first/last
+void es_report(FILE *out);
+
+#ifdef ESP_PLATFORM
+// es_record_at() with esp_timer's clock
+void es_record(es_site_t *site, int32_t code, uint32_t arg);
+
+// Reporter task: es_report_new() every period_ms, up to ES_REPORT_LINES
+// lines each time; on_new runs in it (LEDs, alarms), may be NULL
+#define ES_REPORT_LINES     8
+esp_err_t es_start(uint32_t period_ms, UBaseType_t priority, es_new_fn on_new);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,180 @@
+// Host check for sample ingestion: three simulated sensors at different
+// rates, each stamping a sample up to 3 ms before putting it, collected
+// every 20 ms - checks the merge comes out in time order with nothing
+// lost, and that a full ring drops and counts. Then three producer
+// threads against a collector thread, to check the rings under real
+// concurrency and print the throughput.
+//
+// Build and run from this directory:
+//   cc -O2 -I../include -I../../../tools/host_include ../ingest.c ingest_host_bench.c -o ingest_bench -lpthread
+//   ./ingest_bench
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <time.h>
+#include <sched.h>
+#include "ingest.h"
+#include "host_check.h"
+
+#define PRODUCERS       3
+#define RING            256
+
+static ingest_sample_t storage[PRODUCERS][RING];
+
+typedef struct {
+    uint32_t samples;
+    uint32_t calls;
+    uint32_t max_batch;
+    uint32_t last_ms;
+    uint32_t inversions;
+    uint32_t next_seq[PRODUCERS];
+    uint32_t gaps;
+} sink_check_t;
+
+static void check_sink(const ingest_sample_t *batch, uint32_t n, void *ctx) {
+    sink_check_t *c = ctx;
+    c->calls++;
+    if (n > c->max_batch) {
+        c->max_batch = n;
+    }
+    for (uint32_t i = 0; i < n; i++) {
+        if (c->samples > 0 && batch[i].t_ms < c->last_ms) {
+            c->inversions++;
+        }
+        c->last_ms = batch[i].t_ms;
+        // value carries the producer's sequence number
+        if ((uint32_t)batch[i].value != c->next_seq[batch[i].source]) {
+            c->gaps++;
+        }
+        c->next_seq[batch[i].source] = (uint32_t)batch[i].value + 1;
+        c->samples++;
+    }
+}
+
+static void simulated(void) {
+    ingest_t in;
+    sink_check_t c = {0};
+    ingest_init(&in, "sim", 5, check_sink, &c);
+    ingest_ring_t *rings[PRODUCERS];
+    for (int p = 0; p < PRODUCERS; p++) {
+        rings[p] = ingest_producer(&in, "sensor", storage[p], RING);
+    }
+    CHECK(ingest_producer(&in, "odd", storage[0], 100) == NULL, "capacity 100 accepted");
+
+    // Sensors at 1000, 700 and 50 samples/s; a sample is put 0-3 ms
+    // after its stamp, in stamp order per sensor
+    const uint32_t period_us[PRODUCERS] = { 1000, 1429, 20000 };
+    uint64_t next_us[PRODUCERS] = {0};
+    uint32_t seq[PRODUCERS] = {0}, pending_t[PRODUCERS], pending_put[PRODUCERS];
+    bool pending[PRODUCERS] = {false};
+    uint32_t put = 0;
+    for (uint32_t now = 0; now < 60000; now++) {
+        for (int p = 0; p < PRODUCERS; p++) {
+            if (pending[p] && now >= pending_put[p]) {
+                ingest_put(rings[p], pending_t[p], 0, (float)seq[p]++);
+                pending[p] = false;
+                put++;
+            }
+            if (!pending[p] && (uint64_t)now * 1000 >= next_us[p]) {
+                pending_t[p] = now;
+                pending_put[p] = now + rand() % 4;
+                pending[p] = true;
+                next_us[p] += period_us[p];
+            }
+        }
+        if (now % 20 == 0) {
+            ingest_poll(&in, now);
+        }
+    }
+    ingest_poll(&in, 60000 + 100);
+    ingest_report(&in, 60000, stdout);
+    printf("simulated: %lu samples in %lu sink calls, largest batch %lu\n",
+           (unsigned long)c.samples, (unsigned long)c.calls, (unsigned long)c.max_batch);
+    CHECK(c.samples == put, "delivered %lu of %lu", (unsigned long)c.samples, (unsigned long)put);
+    CHECK(c.inversions == 0 && in.out_of_order == 0, "%lu samples out of order", (unsigned long)c.inversions);
+    CHECK(c.gaps == 0, "%lu sequence gaps", (unsigned long)c.gaps);
+    CHECK(c.max_batch <= INGEST_BATCH, "batch of %lu", (unsigned long)c.max_batch);
+
+    // Nobody collecting: the ring fills and the rest is dropped
+    ingest_init(&in, "full", 5, check_sink, &c);
+    ingest_ring_t *r = ingest_producer(&in, "sensor", storage[0], 16);
+    uint32_t accepted = 0;
+    for (int i = 0; i < 20; i++) {
+        accepted += ingest_put(r, i, 0, 0);
+    }
+    CHECK(accepted == 16 && r->drops == 4 && r->high_water == 16, "full ring: %lu accepted, %lu dropped",
+          (unsigned long)accepted, (unsigned long)r->drops);
+}
+
+// ================ THREADS ================
+
+#define PER_PRODUCER    100000
+
+static ingest_t threaded_in;
+static ingest_ring_t *threaded_rings[PRODUCERS];
+static volatile int producers_done;
+
+static uint32_t clock_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)(ts.tv_sec * 1000 + ts.tv_nsec / 1000000);
+}
+
+static void *producer(void *arg) {
+    ingest_ring_t *r = arg;
+    for (uint32_t i = 0; i < PER_PRODUCER; i++) {
+        // Full: the bench wants every sample, so wait for the collector
+        // instead of putting into a full ring (which counts a drop)
+        while (ingest_backlog(r) > r->mask) {
+            sched_yield();
+        }
+        ingest_put(r, clock_ms(), 0, (float)i);
+    }
+    __atomic_fetch_add(&producers_done, 1, __ATOMIC_RELEASE);
+    return NULL;
+}
+
+static void threaded(void) {
+    sink_check_t c = {0};
+    // Threads get preempted between stamp and put for a whole time slice
+    ingest_init(&threaded_in, "threads", 50, check_sink, &c);
+    for (int p = 0; p < PRODUCERS; p++) {
+        threaded_rings[p] = ingest_producer(&threaded_in, "thread", storage[p], RING);
+    }
+    pthread_t threads[PRODUCERS];
+    struct timespec t0, t1;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for (int p = 0; p < PRODUCERS; p++) {
+        pthread_create(&threads[p], NULL, producer, threaded_rings[p]);
+    }
+    while (__atomic_load_n(&producers_done, __ATOMIC_ACQUIRE) < PRODUCERS) {
+        if (ingest_poll(&threaded_in, clock_ms()) == 0) {
+            sched_yield();
+        }
+    }
+    for (int p = 0; p < PRODUCERS; p++) {
+        pthread_join(threads[p], NULL);
+    }
+    ingest_poll(&threaded_in, clock_ms() + 1000);
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    double s = (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) / 1e9;
+
+    ingest_report(&threaded_in, clock_ms(), stdout);
+    printf("threads: %lu samples in %.2f s (%.0f k/s), %lu out of order\n",
+           (unsigned long)c.samples, s, c.samples / s / 1e3, (unsigned long)threaded_in.out_of_order);
+    // Float sequence numbers are exact up to 2^24
+    CHECK(c.samples == PRODUCERS * PER_PRODUCER, "delivered %lu", (unsigned long)c.samples);
+    CHECK(c.gaps == 0, "%lu sequence gaps", (unsigned long)c.gaps);
+    for (int p = 0; p < PRODUCERS; p++) {
+        CHECK(threaded_rings[p]->drops == 0, "thread %d: %lu drops", p, (unsigned long)threaded_rings[p]->drops);
+    }
+}
+
+int main(void) {
+    srand(99);
+    simulated();
+    threaded();
+    printf("%s\n", failures ? "FAILURES" : "OK");
+    return failures != 0;
+}
@@ -0,0 +1,136 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include "esp_err.h"
+
+#ifdef ESP_PLATFORM
+#include "freertos/FreeRTOS.h"
+#endif
+
+// ================ SAMPLE INGESTION ================
+// Front end for many sensor producers feeding one consumer at thousands
+// of samples per second. Every producer gets its own single-producer /
+// single-consumer ring, so a put is a slot write and an index store - no
+// lock, no queue call, no log line, fine from a timer callback. A
+// collector drains all rings, merges them in timestamp order and hands
+// the samples to a sink in batches:
+//
+//   producer 0 -> ring 0 --+
+//   producer 1 -> ring 1 --+--> collector (merge by time) -> sink(batch[])
+//   producer 2 -> ring 2 --+
+//
+//   static ingest_t sensors;
+//   static ingest_sample_t ring0[256];
+//   ingest_init(&sensors, "sensors", 20, on_batch, NULL);
+//   ingest_ring_t *r = ingest_producer(&sensors, "Sensor1", ring0, 256);
+//
+//   ingest_put(r, now_ms, CH_TEMPERATURE, t);     // producer, per sample
+//   ingest_start(&sensors, 20, 5);                // collector task, or
+//   ingest_poll(&sensors, now_ms);                // from the consumer
+//
+// Each ring is in time order (its producer stamps samples as it puts
+// them). Across rings a sample may show up a little after a newer one
+// from another producer was collected, so the collector only takes the
+// oldest head when every ring has something queued - nothing older can
+// still arrive - or once it is hold_ms old. hold_ms covers the gap
+// between a producer's stamp and its put (preemption, a FIFO read). An
+// empty ring whose producer hasn't put anything stamped in the last
+// hold_ms (idle, or finished) isn't waited for, so one quiet producer
+// doesn't hold the others back by hold_ms. Samples that still come in
+// behind the merge are delivered and counted as out of order.
+//
+// A full ring drops the new sample and counts it; nothing blocks. Sizes
+// are powers of two; storage is the caller's. Timestamps are 32-bit ms
+// on a clock all producers share (esp_timer ms on the device, see
+// ingest_now_ms()). Counters are for ingest_report(), which the owner
+// calls periodically - nothing here logs per sample.
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define INGEST_MAX_PRODUCERS    8
+#define INGEST_BATCH            32      // Samples per sink call, at most
+
+typedef struct {
+    uint32_t t_ms;
+    uint16_t source;                // Producer index, set by the collector
+    uint16_t channel;               // Producer's own (quantity, sensor...)
+    float value;
+} ingest_sample_t;
+
+typedef struct {
+    const char *name;
+    ingest_sample_t *slots;
+    uint32_t mask;
+    uint32_t head;                  // Written by the producer only
+    uint32_t tail;                  // Written by the collector only
+
+    // Producer side
+    uint32_t last_ms;               // Stamp of the newest put
+    uint32_t puts;
+    uint32_t drops;                 // Ring full
+    uint32_t high_water;
+} ingest_ring_t;
+
+// n samples, oldest first; the array is only valid during the call
+typedef void (*ingest_sink_fn)(const ingest_sample_t *batch, uint32_t n, void *ctx);
+
+typedef struct {
+    const char *name;
+    uint32_t hold_ms;
+    ingest_sink_fn sink;
+    void *ctx;
+    ingest_ring_t rings[INGEST_MAX_PRODUCERS];
+    uint32_t producer_count;
+
+    ingest_sample_t batch[INGEST_BATCH];
+    uint32_t last_ms;               // Newest timestamp collected
+    bool started;
+    uint32_t period_ms;             // ingest_start()'s poll period
+
+    // Collector side
+    uint32_t collected;
+    uint32_t batches;
+    uint32_t out_of_order;
+    uint32_t report_ms;             // Last ingest_report() (or first poll), for its rates
+    uint32_t report_collected;
+    bool report_started;            // report_ms is set
+} ingest_t;
+
+esp_err_t ingest_init(ingest_t *in, const char *name, uint32_t hold_ms, ingest_sink_fn sink, void *ctx);
+
+// A ring over storage[capacity] (a power of two) for one producer; NULL
+// when the producer table is full or capacity is wrong. Add producers
+// before collection starts.
+ingest_ring_t *ingest_producer(ingest_t *in, const char *name, ingest_sample_t *storage, uint32_t capacity);
+
+// Producer side; false (and counted) when the ring is full
+bool ingest_put(ingest_ring_t *r, uint32_t t_ms, uint16_t channel, float value);
+
+// Collector side: merge what is ready at now_ms into the sink. Returns
+// the samples delivered.
+uint32_t ingest_poll(ingest_t *in, uint32_t now_ms);
+
+// Samples queued in a ring right now
+uint32_t ingest_backlog(const ingest_ring_t *r);
+
+// Collector totals and rate since the last report, then one line per
+// producer: puts, drops, backlog, high water
+void ingest_report(ingest_t *in, uint32_t now_ms, FILE *out);
+
+#ifdef ESP_PLATFORM
+// esp_timer_get_time() in ms - the clock ingest_start() polls with
+uint32_t ingest_now_ms(void);
+
+// Collector task calling ingest_poll() every period_ms; the sink runs
+// in it
+esp_err_t ingest_start(ingest_t *in, uint32_t period_ms, UBaseType_t priority);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
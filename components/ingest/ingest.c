@@ -0,0 +1,141 @@
+#include <string.h>
+#include <inttypes.h>
+#include "ingest.h"
+
+// ================ PRODUCERS ================
+
+esp_err_t ingest_init(ingest_t *in, const char *name, uint32_t hold_ms, ingest_sink_fn sink, void *ctx) {
+    if (sink == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    memset(in, 0, sizeof(*in));
+    in->name = name;
+    in->hold_ms = hold_ms;
+    in->sink = sink;
+    in->ctx = ctx;
+    return ESP_OK;
+}
+
+ingest_ring_t *ingest_producer(ingest_t *in, const char *name, ingest_sample_t *storage, uint32_t capacity) {
+    if (in->producer_count == INGEST_MAX_PRODUCERS || storage == NULL ||
+        capacity < 2 || (capacity & (capacity - 1)) != 0) {
+        return NULL;
+    }
+    ingest_ring_t *r = &in->rings[in->producer_count++];
+    memset(r, 0, sizeof(*r));
+    r->name = name;
+    r->slots = storage;
+    r->mask = capacity - 1;
+    return r;
+}
+
+bool ingest_put(ingest_ring_t *r, uint32_t t_ms, uint16_t channel, float value) {
+    uint32_t head = r->head;
+    uint32_t used = head - __atomic_load_n(&r->tail, __ATOMIC_ACQUIRE);
+    if (used > r->mask) {
+        r->drops++;
+        return false;
+    }
+    ingest_sample_t *s = &r->slots[head & r->mask];
+    s->t_ms = t_ms;
+    s->channel = channel;
+    s->value = value;
+    __atomic_store_n(&r->last_ms, t_ms, __ATOMIC_RELAXED);
+    // Slot first, then the index that publishes it
+    __atomic_store_n(&r->head, head + 1, __ATOMIC_RELEASE);
+    r->puts++;
+    if (used + 1 > r->high_water) {
+        r->high_water = used + 1;
+    }
+    return true;
+}
+
+uint32_t ingest_backlog(const ingest_ring_t *r) {
+    return __atomic_load_n(&r->head, __ATOMIC_ACQUIRE) - __atomic_load_n(&r->tail, __ATOMIC_ACQUIRE);
+}
+
+// ================ COLLECTOR ================
+
+// a before b, across 32-bit wrap
+static bool before(uint32_t a, uint32_t b) {
+    return (int32_t)(a - b) < 0;
+}
+
+uint32_t ingest_poll(ingest_t *in, uint32_t now_ms) {
+    uint32_t delivered = 0, n = 0;
+    if (!in->report_started) {
+        // First rate is from here, not from boot
+        in->report_ms = now_ms;
+        in->report_started = true;
+    }
+    for (;;) {
+        // Oldest head across the rings
+        ingest_ring_t *oldest = NULL;
+        const ingest_sample_t *head = NULL;
+        bool all_queued = true;
+        for (uint32_t i = 0; i < in->producer_count; i++) {
+            ingest_ring_t *r = &in->rings[i];
+            uint32_t tail = r->tail;
+            if (__atomic_load_n(&r->head, __ATOMIC_ACQUIRE) == tail) {
+                // Empty: only worth waiting for while its producer is active
+                uint32_t quiet = now_ms - __atomic_load_n(&r->last_ms, __ATOMIC_RELAXED);
+                if ((int32_t)quiet <= (int32_t)in->hold_ms) {
+                    all_queued = false;
+                }
+                continue;
+            }
+            const ingest_sample_t *s = &r->slots[tail & r->mask];
+            if (head == NULL || before(s->t_ms, head->t_ms)) {
+                oldest = r;
+                head = s;
+            }
+        }
+        if (head == NULL || (!all_queued && (int32_t)(now_ms - head->t_ms) < (int32_t)in->hold_ms)) {
+            break;
+        }
+
+        ingest_sample_t *out = &in->batch[n++];
+        *out = *head;
+        out->source = (uint16_t)(oldest - in->rings);
+        __atomic_store_n(&oldest->tail, oldest->tail + 1, __ATOMIC_RELEASE);
+
+        if (in->started && before(out->t_ms, in->last_ms)) {
+            in->out_of_order++;
+        } else {
+            in->last_ms = out->t_ms;
+            in->started = true;
+        }
+        if (n == INGEST_BATCH) {
+            in->sink(in->batch, n, in->ctx);
+            in->batches++;
+            delivered += n;
+            n = 0;
+        }
+    }
+    if (n > 0) {
+        in->sink(in->batch, n, in->ctx);
+        in->batches++;
+        delivered += n;
+    }
+    in->collected += delivered;
+    return delivered;
+}
+
+// ================ REPORT ================
+
+void ingest_report(ingest_t *in, uint32_t now_ms, FILE *out) {
+    uint32_t elapsed = now_ms - in->report_ms;
+    uint32_t fresh = in->collected - in->report_collected;
+    fprintf(out, "ingest %s: %" PRIu32 " samples (%.0f/s), %" PRIu32 " batches (%.1f/batch), %" PRIu32 " out of order\n",
+            in->name, in->collected, elapsed ? fresh * 1000.0f / elapsed : 0.0f, in->batches,
+            in->batches ? (float)in->collected / in->batches : 0.0f, in->out_of_order);
+    for (uint32_t i = 0; i < in->producer_count; i++) {
+        const ingest_ring_t *r = &in->rings[i];
+        fprintf(out, "ingest %s/%-10s puts=%" PRIu32 " drops=%" PRIu32 " backlog=%" PRIu32 "/%" PRIu32
+                " high=%" PRIu32 "\n", in->name, r->name, r->puts, r->drops, ingest_backlog(r),
+                r->mask + 1, r->high_water);
+    }
+    in->report_ms = now_ms;
+    in->report_collected = in->collected;
+    in->report_started = true;
+}
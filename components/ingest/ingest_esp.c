@@ -0,0 +1,37 @@
+#ifdef ESP_PLATFORM
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_timer.h"
+#include "esp_log.h"
+#include "ingest.h"
+
+static const char *TAG = "INGEST";
+
+uint32_t ingest_now_ms(void) {
+    return (uint32_t)(esp_timer_get_time() / 1000);
+}
+
+static void collector_task(void *arg) {
+    ingest_t *in = (ingest_t *)arg;
+    TickType_t period = pdMS_TO_TICKS(in->period_ms) > 0 ? pdMS_TO_TICKS(in->period_ms) : 1;
+    TickType_t last_wake = xTaskGetTickCount();
+    while (1) {
+        vTaskDelayUntil(&last_wake, period);
+        ingest_poll(in, ingest_now_ms());
+    }
+}
+
+esp_err_t ingest_start(ingest_t *in, uint32_t period_ms, UBaseType_t priority) {
+    in->period_ms = period_ms;
+    in->report_ms = ingest_now_ms();
+    in->report_started = true;
+    if (xTaskCreate(collector_task, "Ingest", 3072, in, priority, NULL) != pdPASS) {
+        return ESP_ERR_NO_MEM;
+    }
+    ESP_LOGI(TAG, "📥 %s: %lu producers, collected every %lu ms (hold %lu ms)",
+             in->name, in->producer_count, period_ms, in->hold_ms);
+    return ESP_OK;
+}
+
+#endif // ESP_PLATFORM
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+// ================ INTEGRITY LIBRARY ================
+// Shared checksum, hash and buffer fill/verify routines for the labs.
+// Everything here is plain C with no RTOS dependency, so the same file
+// builds for ESP32 (ESP-IDF component) and for host benchmarks.
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// ---- CRC ----
+// Both CRCs are reflected, init 0xFFFFFFFF, final XOR 0xFFFFFFFF, and
+// chainable: pass 0 for the first block, then the previous result.
+//   crc = integrity_crc32(0, a, len_a);
+//   crc = integrity_crc32(crc, b, len_b);
+
+// CRC-32 (IEEE 802.3, zlib) - slicing-by-8, const tables in flash
+uint32_t integrity_crc32(uint32_t crc, const void *data, size_t len);
+
+// CRC-32C (Castagnoli) - uses SSE4.2 / ARMv8 CRC instructions when the
+// compiler targets them, slicing-by-8 tables otherwise
+uint32_t integrity_crc32c(uint32_t crc, const void *data, size_t len);
+
+// ---- Hash ----
+// Fast non-cryptographic 32-bit hash (xxHash32 algorithm). Not chainable.
+uint32_t integrity_hash32(const void *data, size_t len, uint32_t seed);
+
+// ---- Fill / verify ----
+// Word-wide fill and compare. Buffers may have any alignment and length;
+// the 32-bit pattern is laid out in memory order starting at buf[0].
+
+void integrity_fill32(void *buf, uint32_t pattern, size_t len);
+
+// Returns true if every byte matches. On mismatch, *bad_offset (if not
+// NULL) receives the offset of the first differing byte.
+bool integrity_verify32(const void *buf, uint32_t pattern, size_t len, size_t *bad_offset);
+
+// Byte-pattern variants (e.g. 0xAA guard fill)
+static inline void integrity_fill8(void *buf, uint8_t value, size_t len) {
+    integrity_fill32(buf, value * 0x01010101u, len);
+}
+
+static inline bool integrity_verify8(const void *buf, uint8_t value, size_t len, size_t *bad_offset) {
+    return integrity_verify32(buf, value * 0x01010101u, len, bad_offset);
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,264 @@
+#include <string.h>
+#include "integrity.h"
+
+#if defined(__SSE4_2__)
+#include <nmmintrin.h>
+#define INTEGRITY_HW_CRC32C 1
+#elif defined(__ARM_FEATURE_CRC32)
+#include <arm_acle.h>
+#define INTEGRITY_HW_CRC32C 1
+#endif
+
+// Word-at-a-time CRC folding below assumes little-endian loads (ESP32, x86, ARM)
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+#define INTEGRITY_LE_WORDS 1
+#endif
+
+// ================ CRC TABLES ================
+// Slicing-by-8: 8 x 256 entries (8 KB) per polynomial, const in flash
+// (crc_tables.h). Eight table lookups per 8 bytes instead of one per
+// byte; it still does more work per byte than an additive checksum, and
+// that is the price of catching every burst error up to 32 bits.
+
+#include "crc_tables.h"
+
+static uint32_t crc_sliced(const uint32_t t[8][256], uint32_t crc, const uint8_t *p, size_t len) {
+    crc = ~crc;
+
+#ifdef INTEGRITY_LE_WORDS
+    // Byte steps until 4-byte aligned, then one table round per 8 bytes
+    while (len && ((uintptr_t)p & 3)) {
+        crc = t[0][(crc ^ *p++) & 0xFF] ^ (crc >> 8);
+        len--;
+    }
+    while (len >= 8) {
+        uint32_t lo, hi;
+        memcpy(&lo, p, sizeof(lo));
+        memcpy(&hi, p + 4, sizeof(hi));
+        lo ^= crc;
+        crc = t[7][lo & 0xFF] ^
+              t[6][(lo >> 8) & 0xFF] ^
+              t[5][(lo >> 16) & 0xFF] ^
+              t[4][lo >> 24] ^
+              t[3][hi & 0xFF] ^
+              t[2][(hi >> 8) & 0xFF] ^
+              t[1][(hi >> 16) & 0xFF] ^
+              t[0][hi >> 24];
+        p += 8;
+        len -= 8;
+    }
+#endif
+
+    while (len--) {
+        crc = t[0][(crc ^ *p++) & 0xFF] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+uint32_t integrity_crc32(uint32_t crc, const void *data, size_t len) {
+    return crc_sliced(crc32_table, crc, (const uint8_t *)data, len);
+}
+
+#ifdef INTEGRITY_HW_CRC32C
+uint32_t integrity_crc32c(uint32_t crc, const void *data, size_t len) {
+    const uint8_t *p = (const uint8_t *)data;
+    crc = ~crc;
+
+#if defined(__SSE4_2__) && defined(__x86_64__)
+    uint64_t c64 = crc;
+    while (len >= 8) {
+        uint64_t w;
+        memcpy(&w, p, sizeof(w));
+        c64 = _mm_crc32_u64(c64, w);
+        p += 8;
+        len -= 8;
+    }
+    crc = (uint32_t)c64;
+    while (len--) {
+        crc = _mm_crc32_u8(crc, *p++);
+    }
+#elif defined(__SSE4_2__)
+    while (len >= 4) {
+        uint32_t w;
+        memcpy(&w, p, sizeof(w));
+        crc = _mm_crc32_u32(crc, w);
+        p += 4;
+        len -= 4;
+    }
+    while (len--) {
+        crc = _mm_crc32_u8(crc, *p++);
+    }
+#else
+    while (len >= 8) {
+        uint64_t w;
+        memcpy(&w, p, sizeof(w));
+        crc = __crc32cd(crc, w);
+        p += 8;
+        len -= 8;
+    }
+    while (len--) {
+        crc = __crc32cb(crc, *p++);
+    }
+#endif
+
+    return ~crc;
+}
+#else
+uint32_t integrity_crc32c(uint32_t crc, const void *data, size_t len) {
+    return crc_sliced(crc32c_table, crc, (const uint8_t *)data, len);
+}
+#endif
+
+// ================ HASH ================
+
+#define XXH_P1  2654435761u
+#define XXH_P2  2246822519u
+#define XXH_P3  3266489917u
+#define XXH_P4  668265263u
+#define XXH_P5  374761393u
+
+static inline uint32_t rotl32(uint32_t x, int r) {
+    return (x << r) | (x >> (32 - r));
+}
+
+static inline uint32_t read32(const uint8_t *p) {
+    uint32_t w;
+    memcpy(&w, p, sizeof(w));
+    return w;
+}
+
+static inline uint32_t xxh_round(uint32_t acc, uint32_t input) {
+    acc += input * XXH_P2;
+    acc = rotl32(acc, 13);
+    return acc * XXH_P1;
+}
+
+uint32_t integrity_hash32(const void *data, size_t len, uint32_t seed) {
+    const uint8_t *p = (const uint8_t *)data;
+    const uint8_t *end = p + len;
+    uint32_t h;
+
+    if (len >= 16) {
+        uint32_t v1 = seed + XXH_P1 + XXH_P2;
+        uint32_t v2 = seed + XXH_P2;
+        uint32_t v3 = seed;
+        uint32_t v4 = seed - XXH_P1;
+        const uint8_t *limit = end - 16;
+
+        do {
+            v1 = xxh_round(v1, read32(p));
+            v2 = xxh_round(v2, read32(p + 4));
+            v3 = xxh_round(v3, read32(p + 8));
+            v4 = xxh_round(v4, read32(p + 12));
+            p += 16;
+        } while (p <= limit);
+
+        h = rotl32(v1, 1) + rotl32(v2, 7) + rotl32(v3, 12) + rotl32(v4, 18);
+    } else {
+        h = seed + XXH_P5;
+    }
+
+    h += (uint32_t)len;
+
+    while (p + 4 <= end) {
+        h += read32(p) * XXH_P3;
+        h = rotl32(h, 17) * XXH_P4;
+        p += 4;
+    }
+    while (p < end) {
+        h += (*p++) * XXH_P5;
+        h = rotl32(h, 11) * XXH_P1;
+    }
+
+    h ^= h >> 15;
+    h *= XXH_P2;
+    h ^= h >> 13;
+    h *= XXH_P3;
+    h ^= h >> 16;
+    return h;
+}
+
+// ================ FILL / VERIFY ================
+
+// Pattern word as seen by an aligned store that starts 'phase' bytes into it
+static inline uint32_t phased_pattern(uint32_t pattern, size_t phase) {
+    uint8_t bytes[8];
+    uint32_t word;
+    memcpy(bytes, &pattern, 4);
+    memcpy(bytes + 4, &pattern, 4);
+    memcpy(&word, bytes + (phase & 3), 4);
+    return word;
+}
+
+void integrity_fill32(void *buf, uint32_t pattern, size_t len) {
+    uint8_t *p = (uint8_t *)buf;
+    uint8_t bytes[4];
+    size_t i = 0;
+
+    // Byte-replicated patterns (0xAA, 0x55...) go to the C library memset
+    if (pattern == (pattern & 0xFF) * 0x01010101u) {
+        memset(buf, pattern & 0xFF, len);
+        return;
+    }
+
+    memcpy(bytes, &pattern, 4);
+
+    while (i < len && ((uintptr_t)(p + i) & 3)) {
+        p[i] = bytes[i & 3];
+        i++;
+    }
+
+    uint32_t word = phased_pattern(pattern, i);
+    uint32_t *w = (uint32_t *)(p + i);
+    size_t words = (len - i) / 4;
+    for (size_t k = 0; k < words; k++) {
+        w[k] = word;
+    }
+    i += words * 4;
+
+    while (i < len) {
+        p[i] = bytes[i & 3];
+        i++;
+    }
+}
+
+bool integrity_verify32(const void *buf, uint32_t pattern, size_t len, size_t *bad_offset) {
+    const uint8_t *p = (const uint8_t *)buf;
+    uint8_t bytes[4];
+    size_t i = 0;
+
+    memcpy(bytes, &pattern, 4);
+
+    while (i < len && ((uintptr_t)(p + i) & 3)) {
+        if (p[i] != bytes[i & 3]) goto mismatch;
+        i++;
+    }
+
+    {
+        // OR-accumulate differences over 8-word blocks so the inner loop is
+        // branch-free; only a dirty block is rescanned byte by byte
+        uint32_t word = phased_pattern(pattern, i);
+        const uint32_t *w = (const uint32_t *)(p + i);
+        size_t words = (len - i) / 4;
+        size_t k = 0;
+
+        for (; k + 8 <= words; k += 8) {
+            uint32_t diff = (w[k] ^ word) | (w[k + 1] ^ word) |
+                            (w[k + 2] ^ word) | (w[k + 3] ^ word) |
+                            (w[k + 4] ^ word) | (w[k + 5] ^ word) |
+                            (w[k + 6] ^ word) | (w[k + 7] ^ word);
+            if (diff) break;
+        }
+        i += k * 4;
+    }
+
+    while (i < len) {
+        if (p[i] != bytes[i & 3]) goto mismatch;
+        i++;
+    }
+    return true;
+
+mismatch:
+    if (bad_offset) *bad_offset = i;
+    return false;
+}
@@ -0,0 +1,105 @@
+// Host check for the latency profiler: an "ISR" thread spins for known
+// times in each stage (masked before entry, ISR body) and hands events
+// to a handler thread through a semaphore; the handler spins for a known
+// time too. The report should put each injected delay in its own stage,
+// split dispatch by the woken flag and count coalesced interrupts.
+//
+// Build and run from this directory:
+//   cc -O2 -pthread -I../include -I../../tstamp/include -I../../../tools/host_include
+//      ../irqlat.c ../../tstamp/tstamp.c irqlat_host_bench.c -o irqlat_bench
+//   ./irqlat_bench
+
+#include <stdio.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include "irqlat.h"
+#include "host_check.h"
+
+#define EVENTS          2000
+#define COALESCED       10
+#define MASK_NS         5000        // Raise to ISR entry
+#define ISR_NS          1000        // ISR entry to give
+#define HANDLER_NS      10000
+
+static irqlat_source_t src_probe;
+static sem_t irq_sem, done_sem;
+static volatile int stop;
+static void spin_ns(uint32_t ns) {
+    ts_t until = ts_now() + (ts_t)((uint64_t)ns * ts_hz() / 1000000000u);
+    while (ts_now() < until) {
+    }
+}
+
+static void *handler_task(void *arg) {
+    (void)arg;
+    for (;;) {
+        sem_wait(&irq_sem);
+        if (stop) {
+            break;
+        }
+        if (irqlat_task_run(&src_probe)) {
+            spin_ns(HANDLER_NS);
+            irqlat_task_done(&src_probe);
+        }
+        sem_post(&done_sem);
+    }
+    return NULL;
+}
+
+// One interrupt: optionally without waking the handler, to pile up a
+// second one behind it
+static void fire(int woken, int notify) {
+    ts_t raise = ts_now();
+    spin_ns(MASK_NS);
+    irqlat_isr_enter_at(&src_probe, raise);
+    spin_ns(ISR_NS);
+    irqlat_isr_give(&src_probe);
+    if (notify) {
+        sem_post(&irq_sem);
+    }
+    irqlat_isr_exit(&src_probe, woken);
+}
+
+int main(void) {
+    ts_init();
+    irqlat_source_init(&src_probe, "probe");
+    sem_init(&irq_sem, 0, 0);
+    sem_init(&done_sem, 0, 0);
+    pthread_t handler;
+    pthread_create(&handler, NULL, handler_task, NULL);
+
+    for (int i = 0; i < EVENTS; i++) {
+        fire(i % 2, 1);
+        sem_wait(&done_sem);
+    }
+    for (int i = 0; i < COALESCED; i++) {
+        fire(1, 0);
+        fire(1, 1);                 // Arrives while the first is pending
+        sem_wait(&done_sem);
+    }
+    stop = 1;
+    sem_post(&irq_sem);
+    pthread_join(handler, NULL);
+
+    irqlat_report(stdout);
+
+    irqlat_stats_t st[IRQLAT_STAGES];
+    for (int s = 0; s < IRQLAT_STAGES; s++) {
+        irqlat_get_stats(&src_probe, (irqlat_stage_t)s, &st[s]);
+    }
+    printf("\n");
+    CHECK(st[IRQLAT_TOTAL].events == EVENTS + COALESCED, "events %u", st[IRQLAT_TOTAL].events);
+    CHECK(st[IRQLAT_TOTAL].coalesced == COALESCED, "coalesced %u", st[IRQLAT_TOTAL].coalesced);
+    CHECK(st[IRQLAT_MASKED].avg_ns >= MASK_NS, "masked avg %u ns", st[IRQLAT_MASKED].avg_ns);
+    CHECK(st[IRQLAT_ISR].avg_ns >= ISR_NS, "isr avg %u ns", st[IRQLAT_ISR].avg_ns);
+    CHECK(st[IRQLAT_HANDLER].avg_ns >= HANDLER_NS, "handler avg %u ns", st[IRQLAT_HANDLER].avg_ns);
+    CHECK(st[IRQLAT_MASKED].avg_ns < 2 * MASK_NS && st[IRQLAT_HANDLER].avg_ns < 2 * HANDLER_NS,
+          "injected delays leaked into the wrong stage");
+    CHECK(st[IRQLAT_SCHED].count + st[IRQLAT_PREEMPTED].count == EVENTS + COALESCED,
+          "dispatch split %u + %u", st[IRQLAT_SCHED].count, st[IRQLAT_PREEMPTED].count);
+    CHECK(st[IRQLAT_SCHED].count >= EVENTS / 2, "woken events counted as preempted");
+    CHECK(src_probe.worst.ns[IRQLAT_TOTAL] == st[IRQLAT_TOTAL].max_ns, "worst event is not the max");
+
+    printf("%s\n", failures ? "FAILURES" : "OK");
+    return failures != 0;
+}
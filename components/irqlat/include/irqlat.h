@@ -0,0 +1,188 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include "tstamp.h"
+
+#ifdef ESP_PLATFORM
+#include "esp_cpu.h"
+#endif
+
+// ================ INTERRUPT RESPONSE LATENCY ================
+// Follows each interrupt through to the task that handles it and splits
+// the reaction time into stages:
+//
+//   raise ──masked──▶ ISR entry ──isr──▶ give ──sched/preempted──▶ run ──handler──▶ done
+//
+//   masked     Hardware event to first ISR instruction: interrupts
+//              masked by critical sections or a higher-priority ISR.
+//              Only for sources that know when the event happened
+//              (a timer alarm does; a GPIO edge doesn't).
+//   isr        ISR body up to the FromISR give/notify.
+//   sched      Give to handler running, when the give woke a task of
+//              higher priority than the one interrupted (or a task on
+//              the other core): the scheduler and the context switch.
+//   preempted  Same span when it didn't (xHigherPriorityTaskWoken
+//              false on the same core): the handler waited behind
+//              higher-priority work.
+//   handler    Handler running to done.
+//
+// In the ISR:
+//
+//   irqlat_isr_enter(&src_button);             // first thing
+//   irqlat_isr_give(&src_button);              // just before the give
+//   vTaskNotifyGiveFromISR(handler, &woken);
+//   irqlat_isr_exit(&src_button, woken);
+//   portYIELD_FROM_ISR(woken);
+//
+// In the handler task:
+//
+//   ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+//   irqlat_task_run(&src_button);              // right after waking
+//   ... react ...
+//   irqlat_task_done(&src_button);
+//
+// "run" is stamped when the blocking call returns, so it includes the
+// return path out of the kernel. The give is stamped before the FromISR
+// call so a handler on the other core can't wake before the event is
+// published. Interrupts that arrive before the handler has picked up
+// the previous one are counted as coalesced and keep the first one's
+// timestamps - the latency that matters is the oldest unhandled event's.
+//
+// ISR side is inline and lock-free (one pending flag per source);
+// statistics are written by the handler task only. Durations are in
+// nanoseconds and saturate at ~4.29 s. Call ts_init() first.
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define IRQLAT_BUCKETS      124     // 4 per power of two (~19% wide), up to 2^32 ns
+#define IRQLAT_WOKEN_UNKNOWN 0xFF
+
+typedef enum {
+    IRQLAT_MASKED,
+    IRQLAT_ISR,
+    IRQLAT_SCHED,
+    IRQLAT_PREEMPTED,
+    IRQLAT_HANDLER,
+    IRQLAT_TOTAL,                   // Raise (or ISR entry) to done
+    IRQLAT_STAGES
+} irqlat_stage_t;
+
+typedef struct {
+    ts_t at;                        // ISR entry
+    uint32_t ns[IRQLAT_STAGES];     // 0 for stages the event didn't have
+    bool has_raise;
+    bool woken;
+} irqlat_event_t;
+
+typedef struct irqlat_source {
+    const char *name;
+    struct irqlat_source *next;
+
+    // ISR side: filled while pending == 0, published by setting it
+    ts_t raise;
+    ts_t isr;
+    ts_t give;
+    uint8_t woken;                  // IRQLAT_WOKEN_UNKNOWN until irqlat_isr_exit()
+    uint8_t core;                   // Core the ISR ran on
+    uint8_t skip;                   // This interrupt was coalesced
+    uint32_t pending;
+    uint32_t coalesced;
+    uint32_t discarded;
+
+    // Handler task side
+    irqlat_event_t current;
+    bool active;
+    ts_t run;
+    uint32_t events;
+    uint32_t count[IRQLAT_STAGES];
+    uint64_t sum_ns[IRQLAT_STAGES];
+    uint32_t max_ns[IRQLAT_STAGES];
+    uint32_t hist[IRQLAT_STAGES][IRQLAT_BUCKETS];
+    irqlat_event_t worst;           // Breakdown of the slowest reaction
+} irqlat_source_t;
+
+typedef struct {
+    uint32_t events;
+    uint32_t coalesced;
+    uint32_t count;                 // Events that had this stage
+    uint32_t p50_ns;                // Bucket upper bound (never understated)
+    uint32_t p99_ns;
+    uint32_t max_ns;
+    uint32_t avg_ns;
+} irqlat_stats_t;
+
+// Register a source for reports (task context, before its ISR is enabled)
+void irqlat_source_init(irqlat_source_t *src, const char *name);
+
+// ---- ISR side ----
+
+static inline uint8_t irqlat_core_id(void) {
+#ifdef ESP_PLATFORM
+    return (uint8_t)esp_cpu_get_core_id();
+#else
+    return 0;
+#endif
+}
+
+static inline void irqlat_isr_enter_at(irqlat_source_t *src, ts_t raise) {
+    ts_t now = ts_now();
+    if (__atomic_load_n(&src->pending, __ATOMIC_ACQUIRE)) {
+        src->coalesced++;
+        src->skip = 1;
+        return;
+    }
+    src->skip = 0;
+    src->isr = now;
+    src->raise = raise;
+    src->core = irqlat_core_id();
+}
+
+// Event time unknown (GPIO edge, UART, ...): no masked stage
+static inline void irqlat_isr_enter(irqlat_source_t *src) {
+    irqlat_isr_enter_at(src, 0);
+}
+
+static inline void irqlat_isr_give(irqlat_source_t *src) {
+    if (src->skip) {
+        return;
+    }
+    src->give = ts_now();
+    src->woken = IRQLAT_WOKEN_UNKNOWN;
+    __atomic_store_n(&src->pending, 1, __ATOMIC_RELEASE);
+}
+
+// `woken` as returned by the FromISR call
+static inline void irqlat_isr_exit(irqlat_source_t *src, int woken) {
+    if (src->skip) {
+        return;
+    }
+    __atomic_store_n(&src->woken, (uint8_t)(woken != 0), __ATOMIC_RELEASE);
+}
+
+// ---- Handler task side ----
+
+// False if the task woke without a pending interrupt from this source
+bool irqlat_task_run(irqlat_source_t *src);
+
+// Returns the reaction time in ns (0 if irqlat_task_run() found nothing)
+uint32_t irqlat_task_done(irqlat_source_t *src);
+
+// Drop a pending interrupt that isn't a real event (contact bounce
+// during a hold-off), so the next real one isn't counted as coalesced
+void irqlat_task_discard(irqlat_source_t *src);
+
+// ---- Reporting ----
+
+void irqlat_get_stats(const irqlat_source_t *src, irqlat_stage_t stage, irqlat_stats_t *out);
+
+// Every registered source since boot: per-stage distribution, each
+// stage's share of the total reaction time, and the worst reaction
+void irqlat_report(FILE *out);
+
+#ifdef __cplusplus
+}
+#endif
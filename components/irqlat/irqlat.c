@@ -0,0 +1,196 @@
+#include <string.h>
+#include <inttypes.h>
+#include "irqlat.h"
+
+static irqlat_source_t *registry;
+
+static const char *const stage_names[IRQLAT_STAGES] = {
+    "masked", "isr", "sched", "preempted", "handler", "total",
+};
+
+void irqlat_source_init(irqlat_source_t *src, const char *name) {
+    bool listed = false;
+    for (irqlat_source_t *s = registry; s != NULL; s = s->next) {
+        listed |= s == src;
+    }
+    irqlat_source_t *next = src->next;
+    memset(src, 0, sizeof(*src));
+    src->name = name;
+    if (listed) {
+        src->next = next;
+    } else {
+        src->next = registry;
+        registry = src;
+    }
+}
+
+// ================ HANDLER SIDE ================
+
+static uint32_t ns_between(ts_t from, ts_t to) {
+    // Stamps from two cores can be out of order by the calibration error
+    if (to <= from) {
+        return 0;
+    }
+    uint64_t ns = ts_to_ns(to - from);
+    return ns > UINT32_MAX ? UINT32_MAX : (uint32_t)ns;
+}
+
+// Buckets 0..3 hold 0..3 ns; above that each power of two [2^e, 2^e+1)
+// is split in four, so a bucket spans at most a quarter of its value
+static inline uint8_t bucket_of(uint32_t ns) {
+    if (ns < 4) {
+        return (uint8_t)ns;
+    }
+    uint32_t e = 31 - __builtin_clz(ns);
+    return (uint8_t)(4 + (e - 2) * 4 + ((ns >> (e - 2)) & 3));
+}
+
+static inline uint32_t bucket_low(uint8_t b) {
+    if (b < 4) {
+        return b;
+    }
+    uint32_t e = (b - 4) / 4 + 2;
+    return (4u + (b - 4) % 4) << (e - 2);
+}
+
+static void record(irqlat_source_t *src, irqlat_stage_t stage, uint32_t ns) {
+    src->count[stage]++;
+    src->sum_ns[stage] += ns;
+    src->hist[stage][bucket_of(ns)]++;
+    if (ns > src->max_ns[stage]) {
+        src->max_ns[stage] = ns;
+    }
+}
+
+bool irqlat_task_run(irqlat_source_t *src) {
+    if (!__atomic_load_n(&src->pending, __ATOMIC_ACQUIRE)) {
+        return false;
+    }
+    ts_t run = ts_now();
+
+    irqlat_event_t *e = &src->current;
+    memset(e, 0, sizeof(*e));
+    e->at = src->isr;
+    e->has_raise = src->raise != 0;
+    // Still unknown: the handler is up before its ISR even returned
+    uint8_t woken = __atomic_load_n(&src->woken, __ATOMIC_ACQUIRE);
+    e->woken = woken != 0 || src->core != irqlat_core_id();
+    if (e->has_raise) {
+        e->ns[IRQLAT_MASKED] = ns_between(src->raise, src->isr);
+    }
+    e->ns[IRQLAT_ISR] = ns_between(src->isr, src->give);
+    e->ns[e->woken ? IRQLAT_SCHED : IRQLAT_PREEMPTED] = ns_between(src->give, run);
+
+    src->run = run;
+    src->active = true;
+    // Snapshot taken: the ISR may stamp the next event
+    __atomic_store_n(&src->pending, 0, __ATOMIC_RELEASE);
+    return true;
+}
+
+uint32_t irqlat_task_done(irqlat_source_t *src) {
+    if (!src->active) {
+        return 0;
+    }
+    src->active = false;
+
+    irqlat_event_t *e = &src->current;
+    e->ns[IRQLAT_HANDLER] = ns_between(src->run, ts_now());
+    uint64_t total = 0;
+    for (int s = 0; s < IRQLAT_TOTAL; s++) {
+        total += e->ns[s];
+    }
+    e->ns[IRQLAT_TOTAL] = total > UINT32_MAX ? UINT32_MAX : (uint32_t)total;
+
+    src->events++;
+    if (e->has_raise) {
+        record(src, IRQLAT_MASKED, e->ns[IRQLAT_MASKED]);
+    }
+    record(src, IRQLAT_ISR, e->ns[IRQLAT_ISR]);
+    record(src, e->woken ? IRQLAT_SCHED : IRQLAT_PREEMPTED,
+           e->ns[e->woken ? IRQLAT_SCHED : IRQLAT_PREEMPTED]);
+    record(src, IRQLAT_HANDLER, e->ns[IRQLAT_HANDLER]);
+    record(src, IRQLAT_TOTAL, e->ns[IRQLAT_TOTAL]);
+
+    if (e->ns[IRQLAT_TOTAL] >= src->worst.ns[IRQLAT_TOTAL]) {
+        src->worst = *e;
+    }
+    return e->ns[IRQLAT_TOTAL];
+}
+
+void irqlat_task_discard(irqlat_source_t *src) {
+    if (__atomic_exchange_n(&src->pending, 0, __ATOMIC_ACQ_REL)) {
+        src->discarded++;
+    }
+}
+
+// ================ REPORTING ================
+
+static uint32_t percentile(const uint32_t *hist, uint32_t count, uint32_t pct) {
+    if (count == 0) {
+        return 0;
+    }
+    uint32_t rank = (uint32_t)(((uint64_t)count * pct + 99) / 100);
+    uint32_t seen = 0;
+    for (uint8_t b = 0; b < IRQLAT_BUCKETS; b++) {
+        if (seen + hist[b] >= rank) {
+            // Top of the bucket: a percentile may overstate by a bucket
+            // width but never understates, which is the safe side for a
+            // reaction-time bound
+            uint32_t width = b < 4 ? 1 : 1u << ((b - 4) / 4);
+            return bucket_low(b) + (width - 1);
+        }
+        seen += hist[b];
+    }
+    return UINT32_MAX;
+}
+
+void irqlat_get_stats(const irqlat_source_t *src, irqlat_stage_t stage, irqlat_stats_t *out) {
+    out->events = src->events;
+    out->coalesced = src->coalesced;
+    out->count = src->count[stage];
+    out->max_ns = src->max_ns[stage];
+    out->avg_ns = out->count ? (uint32_t)(src->sum_ns[stage] / out->count) : 0;
+    out->p50_ns = percentile(src->hist[stage], out->count, 50);
+    out->p99_ns = percentile(src->hist[stage], out->count, 99);
+    // The bucket top can lie above the largest sample actually seen
+    if (out->p50_ns > out->max_ns) out->p50_ns = out->max_ns;
+    if (out->p99_ns > out->max_ns) out->p99_ns = out->max_ns;
+}
+
+void irqlat_report(FILE *out) {
+    for (irqlat_source_t *src = registry; src != NULL; src = src->next) {
+        fprintf(out, "irqlat [%s]: %" PRIu32 " events, %" PRIu32 " coalesced, %" PRIu32 " discarded\n",
+                src->name, src->events, src->coalesced, src->discarded);
+        if (src->events == 0) {
+            continue;
+        }
+        fprintf(out, "  %-10s %8s %9s %9s %9s %9s %7s\n",
+                "stage", "count", "avg_us", "p50_us", "p99_us", "max_us", "share%");
+        for (int s = 0; s < IRQLAT_STAGES; s++) {
+            irqlat_stats_t st;
+            irqlat_get_stats(src, (irqlat_stage_t)s, &st);
+            if (st.count == 0) {
+                fprintf(out, "  %-10s %8d\n", stage_names[s], 0);
+                continue;
+            }
+            fprintf(out, "  %-10s %8" PRIu32 " %9.2f %9.2f %9.2f %9.2f %7.1f\n",
+                    stage_names[s], st.count, st.avg_ns / 1000.0, st.p50_ns / 1000.0,
+                    st.p99_ns / 1000.0, st.max_ns / 1000.0,
+                    src->sum_ns[IRQLAT_TOTAL] ? 100.0 * src->sum_ns[s] / src->sum_ns[IRQLAT_TOTAL] : 0.0);
+        }
+
+        const irqlat_event_t *w = &src->worst;
+        fprintf(out, "  worst %.2f us at %.3f s:", w->ns[IRQLAT_TOTAL] / 1000.0,
+                ts_to_us(w->at) / 1e6);
+        for (int s = 0; s < IRQLAT_TOTAL; s++) {
+            bool had = s == IRQLAT_MASKED ? w->has_raise :
+                       s == IRQLAT_SCHED ? w->woken :
+                       s == IRQLAT_PREEMPTED ? !w->woken : true;
+            if (had) {
+                fprintf(out, " %s %.2f", stage_names[s], w->ns[s] / 1000.0);
+            }
+        }
+        fputc('\n', out);
+    }
+}
@@ -0,0 +1,178 @@
+// Host check for the load generator, in virtual time: arrivals are
+// drawn from the real schedule code and fed to a simulated single-server
+// queue with exponential service (M/M/1), whose mean response time is
+// known exactly: S / (1 - rho). The open-loop numbers should match it;
+// a closed-loop client timing from its own send against the same server
+// should see only the service time - the coordinated-omission gap.
+// Also checks seeding, constant spacing, bursty off-periods and
+// lg_complete32().
+//
+// Build and run from this directory:
+//   cc -O2 -I../include -I../../tstamp/include -I../../../tools/host_include
+//      ../loadgen.c ../../tstamp/tstamp.c loadgen_host_bench.c -lm -o loadgen_bench
+//   ./loadgen_bench
+
+#include <stdio.h>
+#include <math.h>
+#include "loadgen.h"
+#include "host_check.h"
+
+#define SERVICE_US      1000        // Mean service time
+#define STEP_MS         600000      // Virtual: ten minutes per step
+
+static lg_result_t never_called(void *ctx, const lg_request_t *req) {
+    (void)ctx;
+    (void)req;
+    return LG_DONE;
+}
+
+static lg_config_t base_config(lg_arrival_t arrival, const float *rates, uint8_t steps) {
+    lg_config_t cfg = LG_CONFIG_DEFAULT();
+    cfg.name = "mm1";
+    cfg.issue = never_called;
+    cfg.arrival = arrival;
+    cfg.rates_hz = rates;
+    cfg.steps = steps;
+    cfg.step_ms = STEP_MS;
+    return cfg;
+}
+
+static uint64_t service_rng = 12345;
+
+static ts_t service_time(void) {
+    service_rng = service_rng * 6364136223846793005ull + 1442695040888963407ull;
+    double u = ((service_rng >> 11) + 1) * (1.0 / 9007199254740992.0);
+    return ts_from_us((uint64_t)(-log(u) * SERVICE_US));
+}
+
+// Every step through one FIFO server
+static void run_mm1(lg_t *lg) {
+    ts_t t = ts_from_us(1000000);
+    for (uint8_t s = 0; s < lg->cfg.steps; s++) {
+        lg_step_begin(lg, s, t);
+        ts_t free_at = t;
+        lg_request_t req;
+        while (lg_next(lg, &req)) {
+            ts_t begin = req.intended > free_at ? req.intended : free_at;
+            free_at = begin + service_time();
+            lg_complete_at(lg, req.intended, free_at);
+        }
+        t = (free_at > lg->step[s].end ? free_at : lg->step[s].end) + ts_from_us(1000000);
+    }
+}
+
+// Closed loop at the same nominal rate: wait for the reply, then wait
+// out the rest of the period, and time from the actual send
+static double closed_loop_mean_us(double rate_hz) {
+    ts_t period = ts_from_us((uint64_t)(1e6 / rate_hz));
+    ts_t t = 0;
+    double sum = 0;
+    int n = 0;
+    for (ts_t end = ts_from_us((uint64_t)STEP_MS * 1000); t < end; n++) {
+        ts_t service = service_time();
+        sum += ts_to_us(service);
+        t += service > period ? service : period;
+    }
+    return sum / n;
+}
+
+static void check_schedules(void) {
+    static const float rate[] = { 100 };
+    lg_config_t cfg = base_config(LG_POISSON, rate, 1);
+    cfg.step_ms = 10000;
+
+    // Same seed, same arrivals; another seed, other arrivals
+    lg_t a, b, c;
+    lg_init(&a, &cfg);
+    lg_init(&b, &cfg);
+    cfg.seed = 2;
+    lg_init(&c, &cfg);
+    lg_step_begin(&a, 0, 1000);
+    lg_step_begin(&b, 0, 1000);
+    lg_step_begin(&c, 0, 1000);
+    lg_request_t ra, rb, rc;
+    int same = 1, differ = 0;
+    while (lg_next(&a, &ra)) {
+        same &= lg_next(&b, &rb) && ra.intended == rb.intended;
+        differ |= !lg_next(&c, &rc) || ra.intended != rc.intended;
+    }
+    CHECK(same, "same seed gave different arrivals");
+    CHECK(differ, "different seeds gave the same arrivals");
+    // 1000 expected; 4 sigma is ~126
+    CHECK(fabs(a.step[0].offered - 1000.0) < 130, "poisson offered %u, expected ~1000", a.step[0].offered);
+
+    // Constant: exactly rate x duration, evenly spaced
+    cfg = base_config(LG_CONSTANT, rate, 1);
+    cfg.step_ms = 10000;
+    lg_init(&a, &cfg);
+    lg_step_begin(&a, 0, 1000);
+    ts_t prev = 0;
+    int even = 1;
+    while (lg_next(&a, &ra)) {
+        if (prev) {
+            int64_t gap_us = (int64_t)ts_to_us(ra.intended - prev);
+            even &= gap_us >= 9999 && gap_us <= 10001;
+        }
+        prev = ra.intended;
+    }
+    CHECK(a.step[0].offered == 1000, "constant offered %u, expected 1000", a.step[0].offered);
+    CHECK(even, "constant arrivals not 10 ms apart");
+
+    // Bursty: the same mean rate, nothing during the off-periods
+    cfg = base_config(LG_BURSTY, rate, 1);
+    cfg.step_ms = 100000;
+    lg_init(&a, &cfg);
+    ts_t start = 1000;
+    lg_step_begin(&a, 0, start);
+    ts_t period = ts_from_us((uint64_t)(cfg.on_ms + cfg.off_ms) * 1000);
+    ts_t on = ts_from_us((uint64_t)cfg.on_ms * 1000);
+    uint32_t in_off = 0;
+    while (lg_next(&a, &ra)) {
+        in_off += (ra.intended - start) % period >= on;
+    }
+    CHECK(in_off == 0, "%u bursty arrivals in off-periods", in_off);
+    CHECK(fabs(a.step[0].offered - 10000.0) < 400, "bursty offered %u, expected ~10000", a.step[0].offered);
+}
+
+int main(void) {
+    ts_init();
+
+    check_schedules();
+
+    // rho = 0.5, 0.8 and an overload at 1.2
+    static const float rates[] = { 500, 800, 1200 };
+    static lg_t lg;
+    lg_config_t cfg = base_config(LG_POISSON, rates, 3);
+    lg_init(&lg, &cfg);
+    run_mm1(&lg);
+    lg_report(&lg, stdout);
+
+    printf("\n  %8s %14s %14s %14s\n", "rate/s", "open_mean_us", "theory_us", "closed_mean_us");
+    for (int s = 0; s < 2; s++) {
+        double rho = rates[s] * SERVICE_US / 1e6;
+        double theory = SERVICE_US / (1 - rho);
+        double open = (double)lg.step[s].sum_us / lg.step[s].done;
+        double closed = closed_loop_mean_us(rates[s]);
+        printf("  %8.0f %14.1f %14.1f %14.1f\n", rates[s], open, theory, closed);
+        CHECK(fabs(open - theory) < 0.1 * theory, "rate %.0f: mean %.1f us vs M/M/1 %.1f us", rates[s], open, theory);
+        CHECK(closed < 1.1 * SERVICE_US, "closed loop saw queueing (%.1f us)", closed);
+    }
+    // Overloaded: throughput is the server's, not the offered rate
+    double tput = lg.step[2].done_in_window / (STEP_MS / 1000.0);
+    CHECK(tput > 950 && tput < 1050, "overload throughput %.0f/s, server does 1000/s", tput);
+    CHECK(lg.step[2].done == lg.step[2].offered, "overload step lost arrivals");
+    CHECK(lg.step[2].max_us > 1000000, "overload step didn't build a backlog");
+
+    // Narrow carrier: 5 ms old, low 32 bits only
+    static const float one[] = { 1 };
+    cfg = base_config(LG_CONSTANT, one, 1);
+    lg_init(&lg, &cfg);
+    lg_step_begin(&lg, 0, 1);
+    ts_t intended = ts_now() - ts_from_us(5000);
+    lg_complete32(&lg, (uint32_t)intended);
+    CHECK(lg.step[0].max_us >= 5000 && lg.step[0].max_us < 6000,
+          "lg_complete32 latency %u us", lg.step[0].max_us);
+
+    printf("\n%s\n", failures ? "FAILURES" : "OK");
+    return failures != 0;
+}
@@ -0,0 +1,197 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include "esp_err.h"
+#include "tstamp.h"
+
+// ================ OPEN-LOOP LOAD GENERATOR ================
+// Sends requests to a target on a schedule drawn from an arrival
+// process, whether or not earlier requests have finished, and measures
+// each one's latency from the time it was *supposed* to be sent. A
+// closed-loop client that waits for a reply before sending again (or
+// times itself from the actual send) slows down exactly when the target
+// does, so its numbers leave out the queueing it caused - "coordinated
+// omission". Here a slow target shows up as latency, overflow or
+// rejects, never as fewer arrivals.
+//
+//   static const float rates[] = { 50, 100, 200, 400 };
+//   lg_config_t cfg = LG_CONFIG_DEFAULT();
+//   cfg.name = "timer_svc";
+//   cfg.issue = issue_pend_call;           // non-blocking with workers = 0
+//   cfg.rates_hz = rates;
+//   cfg.steps = 4;
+//   lg_t *lg;
+//   lg_create(&cfg, &lg);
+//   lg_run(lg);                            // one step per rate, then a table
+//   lg_destroy(lg);
+//
+// Each step offers one rate for step_ms, then idles for settle_ms so its
+// backlog drains before the next. The report is a throughput-vs-latency
+// table: offered rate, achieved throughput, p50/p90/p99/p99.9/max and
+// how far behind schedule requests were issued (the generator sleeps in
+// ticks, so sub-tick arrivals go out in batches; that lag is part of the
+// latency and reported so it can be told apart).
+//
+// Targets:
+//   - issue() returns LG_DONE when the request finished inside the call
+//     (blocking targets: run them with workers > 0 so the generator
+//     never waits on them);
+//   - LG_ASYNC when something else finishes it later and calls
+//     lg_complete() with the request's intended time (e.g. a consumer
+//     that takes the item off a queue);
+//   - LG_REJECTED when the target refused it (queue full, no token);
+//     an LG_ASYNC request the target throws away later (shed from its
+//     queue) is settled with lg_reject() instead of lg_complete().
+//
+// Schedules are seeded per step, so a seed replays the same arrivals.
+// The portable core (schedule, stats, report) also runs on the host; the
+// device adds lg_create()/lg_start()/lg_run().
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define LG_MAX_STEPS        12
+#define LG_BUCKETS          124     // 4 per power of two of microseconds
+
+typedef enum {
+    LG_CONSTANT,                    // Evenly spaced
+    LG_POISSON,                     // Exponential gaps
+    LG_BURSTY,                      // Poisson during on_ms, silent for off_ms; same mean rate
+} lg_arrival_t;
+
+typedef enum {
+    LG_DONE,
+    LG_ASYNC,
+    LG_REJECTED,
+} lg_result_t;
+
+typedef struct {
+    uint32_t seq;
+    uint8_t step;
+    ts_t intended;                  // When the schedule said to send it
+} lg_request_t;
+
+typedef lg_result_t (*lg_issue_fn)(void *ctx, const lg_request_t *req);
+
+typedef struct {
+    const char *name;               // Target, for the report
+    lg_issue_fn issue;
+    void *ctx;
+    lg_arrival_t arrival;
+    const float *rates_hz;          // One step per rate
+    uint8_t steps;
+    uint32_t step_ms;
+    uint32_t settle_ms;             // Idle after each step
+    uint32_t on_ms;                 // LG_BURSTY
+    uint32_t off_ms;
+    uint64_t seed;
+    uint8_t workers;                // Issuing tasks (0 = issue from the generator)
+    uint16_t backlog;               // Arrivals waiting for a worker before overflow
+    uint8_t priority;               // Workers; lg_start()'s generator runs one above
+    uint32_t stack_size;
+} lg_config_t;
+
+#define LG_CONFIG_DEFAULT() {       \
+    .arrival = LG_POISSON,          \
+    .step_ms = 10000,               \
+    .settle_ms = 2000,              \
+    .on_ms = 1000,                  \
+    .off_ms = 4000,                 \
+    .seed = 1,                      \
+    .workers = 0,                   \
+    .backlog = 32,                  \
+    .priority = 5,                  \
+    .stack_size = 3072,             \
+}
+
+typedef struct {
+    float rate_hz;
+    ts_t start;                     // Arrival window [start, end)
+    ts_t end;
+    uint32_t offered;
+    uint32_t overflow;              // No worker free and the backlog full
+    uint32_t rejected;
+    uint32_t done;
+    uint32_t done_in_window;        // Completed before `end`: the throughput
+    uint64_t sum_us;
+    uint32_t max_us;
+    uint32_t max_lag_us;            // Furthest behind schedule at issue
+    uint32_t hist[LG_BUCKETS];
+} lg_step_t;
+
+typedef struct {
+    lg_config_t cfg;
+    lg_step_t step[LG_MAX_STEPS];
+    uint8_t cur;                    // Step arrivals are being drawn for
+    uint32_t seq;
+
+    // Arrival process of the current step
+    uint64_t rng;
+    uint64_t payload_rng;
+    double on_time;                 // Seconds of "on" time elapsed in the step
+    ts_t on_ticks;                  // Burst geometry in ts ticks (0 = always on)
+    ts_t period_ticks;
+
+    void *impl;                     // Device: queue and worker tasks
+} lg_t;
+
+// ---- Portable core (also what a custom driver or host bench uses) ----
+
+esp_err_t lg_init(lg_t *lg, const lg_config_t *cfg);
+
+// Start drawing arrivals for `step` from `start`
+void lg_step_begin(lg_t *lg, uint8_t step, ts_t start);
+
+// Next arrival of the current step; false once past the step's end
+bool lg_next(lg_t *lg, lg_request_t *req);
+
+// Outcome of handing `req` to the target, which started at `issued_at`;
+// LG_DONE counts as completed now, when the call has returned
+void lg_issued(lg_t *lg, const lg_request_t *req, lg_result_t result, ts_t issued_at);
+
+// The generator couldn't hand `req` to a worker
+void lg_overflow(lg_t *lg, const lg_request_t *req);
+
+// Completion of an LG_ASYNC request (any task; lock-free)
+void lg_complete(lg_t *lg, ts_t intended);
+void lg_complete_at(lg_t *lg, ts_t intended, ts_t done);
+
+// Same, when only the low 32 bits of the intended time could be carried
+// (a pended function's uint32_t argument); fine for latencies up to
+// 2^32 ticks (~17 s at 240 MHz)
+void lg_complete32(lg_t *lg, uint32_t intended_low);
+
+// An LG_ASYNC request the target dropped after accepting it: counted as
+// rejected, in the step it was intended for (any task; lock-free)
+void lg_reject(lg_t *lg, ts_t intended);
+
+// Seeded random numbers for payloads (thread-safe, separate stream from
+// the arrivals so drawing them doesn't shift the schedule)
+uint32_t lg_rand32(lg_t *lg);
+
+void lg_report(const lg_t *lg, FILE *out);
+void lg_report_step(const lg_t *lg, uint8_t step, FILE *out);
+
+// ---- Device ----
+
+// Allocate and check the config; nothing runs yet
+esp_err_t lg_create(const lg_config_t *cfg, lg_t **out);
+
+// Free what lg_create() allocated. Only once lg_run() has returned and
+// no LG_ASYNC completion can still arrive - lg_complete() on a destroyed
+// generator writes to freed memory
+void lg_destroy(lg_t *lg);
+
+// Run every step in the calling task, then print the table. The caller
+// should outrank the workers so a busy target can't delay the schedule
+void lg_run(lg_t *lg);
+
+// Same, in a task of its own
+esp_err_t lg_start(lg_t *lg);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,253 @@
+#include <string.h>
+#include <math.h>
+#include <inttypes.h>
+#include "loadgen.h"
+
+static const char *const arrival_names[] = { "constant", "poisson", "bursty" };
+
+// ================ RANDOM NUMBERS ================
+
+// splitmix64: the state is a plain counter, so a stream can be advanced
+// with one atomic add and shared between tasks
+static inline uint64_t mix64(uint64_t z) {
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+#define GOLDEN  0x9E3779B97F4A7C15ull
+
+static inline uint64_t next64(uint64_t *state) {
+    return mix64(*state += GOLDEN);
+}
+
+// Uniform in (0, 1]: never 0, so -log() stays finite
+static inline double next_unit(uint64_t *state) {
+    return ((next64(state) >> 11) + 1) * (1.0 / 9007199254740992.0);
+}
+
+uint32_t lg_rand32(lg_t *lg) {
+    return (uint32_t)(mix64(__atomic_add_fetch(&lg->payload_rng, GOLDEN, __ATOMIC_RELAXED)) >> 32);
+}
+
+// ================ ARRIVALS ================
+
+esp_err_t lg_init(lg_t *lg, const lg_config_t *cfg) {
+    if (cfg->steps == 0 || cfg->steps > LG_MAX_STEPS || cfg->rates_hz == NULL ||
+        cfg->issue == NULL || cfg->step_ms == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    for (uint8_t s = 0; s < cfg->steps; s++) {
+        if (!(cfg->rates_hz[s] > 0)) {
+            return ESP_ERR_INVALID_ARG;
+        }
+    }
+    if (cfg->arrival == LG_BURSTY && cfg->on_ms == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    memset(lg, 0, sizeof(*lg));
+    lg->cfg = *cfg;
+    lg->payload_rng = mix64(cfg->seed ^ 0x5A5A5A5A5A5A5A5Aull);
+    for (uint8_t s = 0; s < cfg->steps; s++) {
+        lg->step[s].rate_hz = cfg->rates_hz[s];
+    }
+    return ESP_OK;
+}
+
+void lg_step_begin(lg_t *lg, uint8_t step, ts_t start) {
+    const lg_config_t *cfg = &lg->cfg;
+    lg_step_t *st = &lg->step[step];
+    st->start = start;
+    st->end = start + ts_from_us((uint64_t)cfg->step_ms * 1000);
+
+    // Each step gets its own stream, so changing one rate doesn't move
+    // the arrivals of the others
+    lg->rng = mix64(cfg->seed + GOLDEN * (step + 1));
+    lg->on_time = 0;
+    if (cfg->arrival == LG_BURSTY) {
+        lg->on_ticks = ts_from_us((uint64_t)cfg->on_ms * 1000);
+        lg->period_ticks = ts_from_us((uint64_t)(cfg->on_ms + cfg->off_ms) * 1000);
+    } else {
+        lg->on_ticks = 0;
+        lg->period_ticks = 0;
+    }
+    __atomic_store_n(&lg->cur, step, __ATOMIC_RELEASE);
+}
+
+bool lg_next(lg_t *lg, lg_request_t *req) {
+    const lg_config_t *cfg = &lg->cfg;
+    lg_step_t *st = &lg->step[lg->cur];
+
+    if (cfg->arrival == LG_CONSTANT) {
+        // Multiplied, not summed, so rounding can't drift the grid; the
+        // first arrival goes out at the start of the step
+        lg->on_time = st->offered / (double)st->rate_hz;
+    } else {
+        double rate = st->rate_hz;
+        if (cfg->arrival == LG_BURSTY) {
+            // Same mean rate, squeezed into the on-periods
+            rate *= (double)(cfg->on_ms + cfg->off_ms) / cfg->on_ms;
+        }
+        lg->on_time += -log(next_unit(&lg->rng)) / rate;
+    }
+
+    // Arrivals are a Poisson process in "on" time; map that onto the wall
+    // clock by inserting an off-period after every on_ms of it
+    ts_t offset = (ts_t)(lg->on_time * (double)ts_hz());
+    if (lg->on_ticks) {
+        offset = (offset / lg->on_ticks) * lg->period_ticks + offset % lg->on_ticks;
+    }
+    ts_t at = st->start + offset;
+    if (at >= st->end) {
+        return false;
+    }
+
+    req->seq = lg->seq++;
+    req->step = lg->cur;
+    req->intended = at;
+    st->offered++;
+    return true;
+}
+
+// ================ RESULTS ================
+
+// Same histogram as irqlat, in microseconds: buckets 0..3 exact, then
+// each power of two split in four
+static inline uint8_t bucket_of(uint32_t us) {
+    if (us < 4) {
+        return (uint8_t)us;
+    }
+    uint32_t e = 31 - __builtin_clz(us);
+    return (uint8_t)(4 + (e - 2) * 4 + ((us >> (e - 2)) & 3));
+}
+
+static inline uint32_t bucket_top(uint8_t b) {
+    if (b < 4) {
+        return b;
+    }
+    uint32_t e = (b - 4) / 4 + 2;
+    uint32_t low = (4u + (b - 4) % 4) << (e - 2);
+    return low + ((1u << (e - 2)) - 1);
+}
+
+static inline void atomic_max(uint32_t *p, uint32_t v) {
+    uint32_t cur = __atomic_load_n(p, __ATOMIC_RELAXED);
+    while (v > cur && !__atomic_compare_exchange_n(p, &cur, v, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+    }
+}
+
+// Step whose arrival window holds `intended`
+static lg_step_t *step_of(lg_t *lg, ts_t intended) {
+    int s = __atomic_load_n(&lg->cur, __ATOMIC_ACQUIRE);
+    while (s > 0 && intended < lg->step[s].start) {
+        s--;
+    }
+    return &lg->step[s];
+}
+
+void lg_complete_at(lg_t *lg, ts_t intended, ts_t done) {
+    lg_step_t *st = step_of(lg, intended);
+    // Completion stamped on the other core can be a hair early
+    uint32_t us = done > intended ? ts_us32(done - intended) : 0;
+    __atomic_add_fetch(&st->done, 1, __ATOMIC_RELAXED);
+    if (done < st->end) {
+        __atomic_add_fetch(&st->done_in_window, 1, __ATOMIC_RELAXED);
+    }
+    __atomic_add_fetch(&st->sum_us, us, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&st->hist[bucket_of(us)], 1, __ATOMIC_RELAXED);
+    atomic_max(&st->max_us, us);
+}
+
+void lg_complete(lg_t *lg, ts_t intended) {
+    lg_complete_at(lg, intended, ts_now());
+}
+
+void lg_complete32(lg_t *lg, uint32_t intended_low) {
+    ts_t now = ts_now();
+    // Age in ticks, assuming under 2^32 of them
+    uint32_t age = (uint32_t)now - intended_low;
+    lg_complete_at(lg, now - age, now);
+}
+
+void lg_reject(lg_t *lg, ts_t intended) {
+    __atomic_add_fetch(&step_of(lg, intended)->rejected, 1, __ATOMIC_RELAXED);
+}
+
+void lg_issued(lg_t *lg, const lg_request_t *req, lg_result_t result, ts_t issued_at) {
+    lg_step_t *st = &lg->step[req->step];
+    if (issued_at > req->intended) {
+        atomic_max(&st->max_lag_us, ts_us32(issued_at - req->intended));
+    }
+    if (result == LG_REJECTED) {
+        __atomic_add_fetch(&st->rejected, 1, __ATOMIC_RELAXED);
+    } else if (result == LG_DONE) {
+        lg_complete_at(lg, req->intended, ts_now());
+    }
+}
+
+void lg_overflow(lg_t *lg, const lg_request_t *req) {
+    __atomic_add_fetch(&lg->step[req->step].overflow, 1, __ATOMIC_RELAXED);
+}
+
+// ================ REPORTING ================
+
+static uint32_t percentile(const lg_step_t *st, uint32_t per_mille) {
+    if (st->done == 0) {
+        return 0;
+    }
+    uint32_t rank = (uint32_t)(((uint64_t)st->done * per_mille + 999) / 1000);
+    uint32_t seen = 0;
+    for (uint8_t b = 0; b < LG_BUCKETS; b++) {
+        seen += st->hist[b];
+        if (seen >= rank) {
+            // Bucket top, capped by the real max: overstates by at most a
+            // quarter, never understates
+            uint32_t top = bucket_top(b);
+            return top < st->max_us ? top : st->max_us;
+        }
+    }
+    return st->max_us;
+}
+
+static void print_header(const lg_t *lg, FILE *out) {
+    const lg_config_t *cfg = &lg->cfg;
+    fprintf(out, "loadgen [%s]: %s arrivals", cfg->name ? cfg->name : "?", arrival_names[cfg->arrival]);
+    if (cfg->arrival == LG_BURSTY) {
+        fprintf(out, " (%" PRIu32 " ms on / %" PRIu32 " ms off)", cfg->on_ms, cfg->off_ms);
+    }
+    fprintf(out, ", seed %" PRIu64 ", %" PRIu32 " ms per step, %u worker(s)\n",
+            cfg->seed, cfg->step_ms, cfg->workers);
+    fprintf(out, "  %8s %7s %7s %5s %5s %5s %8s %9s %9s %9s %9s %9s %8s\n",
+            "rate/s", "offered", "done", "rej", "ovf", "pend", "tput/s",
+            "p50_ms", "p90_ms", "p99_ms", "p99.9_ms", "max_ms", "lag_ms");
+}
+
+void lg_report_step(const lg_t *lg, uint8_t step, FILE *out) {
+    const lg_step_t *st = &lg->step[step];
+    if (st->start == 0) {
+        return;
+    }
+    uint32_t done = st->done;
+    uint32_t settled = done + st->rejected + st->overflow;
+    uint32_t pending = st->offered > settled ? st->offered - settled : 0;
+    double window_s = (double)(st->end - st->start) / (double)ts_hz();
+    // Only completions inside the arrival window count towards
+    // throughput, so an overloaded target reads as tput < rate even
+    // though its backlog finishes during the settle time
+    fprintf(out, "  %8.2f %7" PRIu32 " %7" PRIu32 " %5" PRIu32 " %5" PRIu32 " %5" PRIu32
+                 " %8.2f %9.2f %9.2f %9.2f %9.2f %9.2f %8.2f%s\n",
+            st->rate_hz, st->offered, done, st->rejected, st->overflow, pending,
+            st->done_in_window / window_s,
+            percentile(st, 500) / 1000.0, percentile(st, 900) / 1000.0,
+            percentile(st, 990) / 1000.0, percentile(st, 999) / 1000.0,
+            st->max_us / 1000.0, st->max_lag_us / 1000.0,
+            pending ? "  (pending: lower bounds)" : "");
+}
+
+void lg_report(const lg_t *lg, FILE *out) {
+    print_header(lg, out);
+    for (uint8_t s = 0; s < lg->cfg.steps; s++) {
+        lg_report_step(lg, s, out);
+    }
+}
@@ -0,0 +1,149 @@
+#ifdef ESP_PLATFORM
+
+#include <stdlib.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "esp_log.h"
+#include "loadgen.h"
+
+static const char *TAG = "LOADGEN";
+
+#define STOP_STEP           0xFF    // Request that tells a worker to exit
+
+typedef struct {
+    QueueHandle_t backlog;
+    TaskHandle_t caller;
+} lg_impl_t;
+
+esp_err_t lg_create(const lg_config_t *cfg, lg_t **out) {
+    lg_t *lg = calloc(1, sizeof(lg_t));
+    lg_impl_t *impl = calloc(1, sizeof(lg_impl_t));
+    if (lg == NULL || impl == NULL) {
+        free(lg);
+        free(impl);
+        return ESP_ERR_NO_MEM;
+    }
+    esp_err_t err = lg_init(lg, cfg);
+    if (err != ESP_OK) {
+        free(lg);
+        free(impl);
+        return err;
+    }
+    lg->impl = impl;
+    *out = lg;
+    return ESP_OK;
+}
+
+void lg_destroy(lg_t *lg) {
+    if (lg == NULL) {
+        return;
+    }
+    free(lg->impl);
+    free(lg);
+}
+
+// Workers take arrivals off the backlog so a blocking target holds up
+// a worker, not the schedule
+static void worker_task(void *arg) {
+    lg_t *lg = (lg_t *)arg;
+    lg_impl_t *impl = (lg_impl_t *)lg->impl;
+    lg_request_t req;
+    for (;;) {
+        xQueueReceive(impl->backlog, &req, portMAX_DELAY);
+        if (req.step == STOP_STEP) {
+            break;
+        }
+        ts_t issued_at = ts_now();
+        lg_result_t result = lg->cfg.issue(lg->cfg.ctx, &req);
+        lg_issued(lg, &req, result, issued_at);
+    }
+    xTaskNotifyGive(impl->caller);
+    vTaskDelete(NULL);
+}
+
+// Sleep until `t`: whole ticks while far away, then one tick at a time,
+// so the wake-up is at most a tick late and never early
+static void sleep_until(ts_t t) {
+    const uint64_t tick_us = portTICK_PERIOD_MS * 1000;
+    for (;;) {
+        ts_t now = ts_now();
+        if (now >= t) {
+            return;
+        }
+        uint64_t ticks = ts_to_us(t - now) / tick_us;
+        vTaskDelay(ticks >= 2 ? (TickType_t)(ticks - 1) : 1);
+    }
+}
+
+void lg_run(lg_t *lg) {
+    const lg_config_t *cfg = &lg->cfg;
+    lg_impl_t *impl = (lg_impl_t *)lg->impl;
+    impl->caller = xTaskGetCurrentTaskHandle();
+
+    uint8_t workers = 0;
+    if (cfg->workers > 0) {
+        impl->backlog = xQueueCreate(cfg->backlog ? cfg->backlog : 1, sizeof(lg_request_t));
+        if (impl->backlog == NULL) {
+            ESP_LOGE(TAG, "❌ No memory for a %u-deep backlog", cfg->backlog);
+            return;
+        }
+        for (; workers < cfg->workers; workers++) {
+            char name[16];
+            snprintf(name, sizeof(name), "lg_worker%u", workers);
+            if (xTaskCreate(worker_task, name, cfg->stack_size, lg, cfg->priority, NULL) != pdPASS) {
+                ESP_LOGW(TAG, "⚠️ Only %u of %u workers started", workers, cfg->workers);
+                break;
+            }
+        }
+    }
+
+    ESP_LOGI(TAG, "🚀 [%s] %u steps of %lu ms, seed %llu",
+             cfg->name, cfg->steps, cfg->step_ms, (unsigned long long)cfg->seed);
+    for (uint8_t s = 0; s < cfg->steps; s++) {
+        ESP_LOGI(TAG, "📈 [%s] step %u: %.2f req/s", cfg->name, s + 1, cfg->rates_hz[s]);
+        lg_step_begin(lg, s, ts_now());
+        lg_request_t req;
+        while (lg_next(lg, &req)) {
+            sleep_until(req.intended);
+            if (workers == 0) {
+                ts_t issued_at = ts_now();
+                lg_issued(lg, &req, cfg->issue(cfg->ctx, &req), issued_at);
+            } else if (xQueueSend(impl->backlog, &req, 0) != pdPASS) {
+                lg_overflow(lg, &req);
+            }
+        }
+        sleep_until(lg->step[s].end);
+        vTaskDelay(pdMS_TO_TICKS(cfg->settle_ms));
+    }
+
+    // Let the workers finish what they hold, then stop them
+    lg_request_t stop = { .step = STOP_STEP };
+    for (uint8_t w = 0; w < workers; w++) {
+        xQueueSend(impl->backlog, &stop, portMAX_DELAY);
+    }
+    for (uint8_t w = 0; w < workers; w++) {
+        ulTaskNotifyTake(pdFALSE, portMAX_DELAY);
+    }
+    if (impl->backlog != NULL) {
+        vQueueDelete(impl->backlog);
+        impl->backlog = NULL;
+    }
+
+    lg_report(lg, stdout);
+}
+
+static void generator_task(void *arg) {
+    lg_run((lg_t *)arg);
+    vTaskDelete(NULL);
+}
+
+esp_err_t lg_start(lg_t *lg) {
+    if (xTaskCreate(generator_task, "loadgen", lg->cfg.stack_size, lg,
+                    lg->cfg.priority + 1, NULL) != pdPASS) {
+        return ESP_ERR_NO_MEM;
+    }
+    return ESP_OK;
+}
+
+#endif // ESP_PLATFORM
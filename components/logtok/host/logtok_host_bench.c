@@ -0,0 +1,160 @@
+// Host check for tokenized logging: logs the pool statistics and status
+// monitor lines of the labs (plus argument edge cases) through the TLOGx
+// path, and checks that the compile-time token equals logtok_hash() of
+// the format, that every call site left an entry in logtok_entries, and
+// how many bytes a frame takes against the text line ESP_LOGx would have
+// printed. It writes the "$<base64>" capture and the text it stands for,
+// so the detokenizer can be checked against the real thing.
+//
+// Build and run from this directory (the two files default to /tmp):
+//   cc -O2 -I../include -I../../../tools/host_include ../logtok.c logtok_host_bench.c -o logtok_bench
+//   ./logtok_bench [capture.log expected.txt]
+//   python3 ../../../tools/logtok/logtok.py --elf logtok_bench /tmp/logtok_host.log | diff - /tmp/logtok_host.txt
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include "logtok.h"
+#include "host_check.h"
+
+// ESP log levels
+#define LEVEL_ERROR     1
+#define LEVEL_WARN      2
+#define LEVEL_INFO      3
+
+static const char *TAG = "MEM_POOLS";
+static const char *TAG2 = "SYSTEM_STATUS";
+
+static FILE *capture, *expected;
+static uint32_t clock_ms = 1000;
+static uint32_t last_token;
+static uint32_t frames, frame_bytes, line_bytes, text_bytes;
+
+// Device side, host edition: pack, base64, one line per frame
+void logtok_log(int level, const char *tag, uint32_t token, uint32_t types, ...) {
+    uint8_t frame[LOGTOK_MAX_FRAME];
+    char text[4 * ((LOGTOK_MAX_FRAME + 2) / 3) + 1];
+    va_list ap;
+    va_start(ap, types);
+    size_t len = logtok_pack(frame, sizeof(frame), level, clock_ms, logtok_hash(tag, strlen(tag)),
+                             token, types, ap);
+    va_end(ap);
+    size_t n = logtok_base64(frame, len, text);
+    fprintf(capture, "$%s\n", text);
+    last_token = token;
+    frames++;
+    frame_bytes += len;
+    line_bytes += n + 2;
+}
+
+// What ESP_LOGx prints for the same call, next to the tokenized call so
+// both see the same arguments. The byte count includes the color codes
+// (CONFIG_LOG_COLORS, on by default) the file leaves out.
+#define BENCH_LOG(level, tag, fmt, ...) do {                                        \
+        char line[512];                                                             \
+        int n = snprintf(line, sizeof(line), "%c (%lu) %s: " fmt "\n",              \
+                         "?EWI"[level], (unsigned long)clock_ms, tag, ##__VA_ARGS__);  \
+        fputs(line, expected);                                                      \
+        text_bytes += n + 11;                                                       \
+        LOGTOK_LOG(level, tag, fmt, ##__VA_ARGS__);                                 \
+        CHECK(last_token == logtok_hash(fmt, sizeof(fmt) - 1), "token of \"%s\"", fmt); \
+        clock_ms += 7 + rand() % 400;                                               \
+    } while (0)
+
+static void pool_statistics(void) {
+    static const char *names[] = { "SMALL", "MEDIUM", "LARGE", "HUGE" };
+    static const int sizes[] = { 64, 256, 1024, 4096 };
+    BENCH_LOG(LEVEL_INFO, TAG, "\n📊 ═══ MEMORY POOL STATISTICS ═══");
+    for (int i = 0; i < 4; i++) {
+        int count = 8 << (3 - i), used = rand() % count, failed = rand() % 3;
+        unsigned long long allocs = 1000000ull * i + rand();
+        BENCH_LOG(LEVEL_INFO, TAG, "\n%s Pool:", names[i]);
+        BENCH_LOG(LEVEL_INFO, TAG, "  Block Size:      %d bytes", sizes[i]);
+        BENCH_LOG(LEVEL_INFO, TAG, "  Total Blocks:    %d", count);
+        BENCH_LOG(LEVEL_INFO, TAG, "  Used Blocks:     %d (%d%%)", used, used * 100 / count);
+        BENCH_LOG(LEVEL_INFO, TAG, "  Allocations:     %llu", allocs);
+        BENCH_LOG(LEVEL_INFO, TAG, "  Failures:        %d", failed);
+        BENCH_LOG(LEVEL_INFO, TAG, "  Alloc Time:      avg %u μs, p99 %u μs", 3u + i, 40u + i * 7);
+    }
+    BENCH_LOG(LEVEL_INFO, TAG, "═══════════════════════════════════════");
+}
+
+static void status_monitor(void) {
+    float temperature = 24.5f + (rand() % 100) / 8.0f;
+    BENCH_LOG(LEVEL_INFO, TAG2, "🔄 ═══ SYSTEM STATUS ═══");
+    BENCH_LOG(LEVEL_INFO, TAG2, "Uptime: %u sec, temperature %.2f°C", clock_ms / 1000, temperature);
+    BENCH_LOG(LEVEL_WARN, TAG2, "⚠️ Sensor %d offline for %d ms (code %x)", 3, -250, 0xBEEFu);
+    BENCH_LOG(LEVEL_ERROR, TAG2, "🚨 %s failed: %c%c %5.1f%% [%-6s] %08X %lld %u",
+              "network", 'O', 'K', 99.5f, "ab", 0xC0FFEEu, -1234567890123ll, 4000000000u);
+    BENCH_LOG(LEVEL_INFO, TAG2, "Free heap: %d bytes", 123456);
+}
+
+// A frame without a call site: header of 8 bytes (timestamp 0)
+static size_t pack(uint8_t *frame, uint32_t types, ...) {
+    va_list ap;
+    va_start(ap, types);
+    size_t len = logtok_pack(frame, LOGTOK_MAX_FRAME, LEVEL_INFO, 0, 0, 0, types, ap);
+    va_end(ap);
+    return len;
+}
+
+#define PACK(frame, ...) pack(frame, LOGTOK_TYPES(__VA_ARGS__) | LOGTOK_NARGS(__VA_ARGS__), __VA_ARGS__)
+
+static void truncation(void) {
+    uint8_t frame[LOGTOK_MAX_FRAME];
+    char big[200];
+    memset(big, 'x', sizeof(big) - 1);
+    big[sizeof(big) - 1] = '\0';
+
+    // One long string: cut to LOGTOK_MAX_STRING and flagged in its length byte
+    size_t len = PACK(frame, big);
+    CHECK(!(frame[0] & LOGTOK_TRUNCATED) && len == 8 + 1 + LOGTOK_MAX_STRING && frame[8] & 0x80,
+          "long string: %zu bytes", len);
+    // Several: the frame fills up and is flagged
+    len = PACK(frame, big, big, big, big);
+    CHECK((frame[0] & LOGTOK_TRUNCATED) && len == LOGTOK_MAX_FRAME, "full frame: %zu bytes, flags %02x",
+          len, frame[0]);
+}
+
+int main(int argc, char **argv) {
+    srand(94);
+    const char *capture_path = argc > 2 ? argv[1] : "/tmp/logtok_host.log";
+    const char *expected_path = argc > 2 ? argv[2] : "/tmp/logtok_host.txt";
+    capture = fopen(capture_path, "w");
+    expected = fopen(expected_path, "w");
+    if (capture == NULL || expected == NULL) {
+        printf("can't write the capture files\n");
+        return 1;
+    }
+    for (int round = 0; round < 20; round++) {
+        pool_statistics();
+        status_monitor();
+        fprintf(capture, "plain text lines pass through\n");
+        fprintf(expected, "plain text lines pass through\n");
+    }
+    truncation();
+    fclose(capture);
+    fclose(expected);
+
+    // Every call site left one entry for the tool (the section is loaded
+    // on the host, so it can be walked here)
+    extern const uint8_t __start_logtok_entries[], __stop_logtok_entries[];
+    uint32_t entries = 0;
+    for (const uint8_t *p = __start_logtok_entries; p + 8 <= __stop_logtok_entries; p += 4) {
+        uint32_t magic;
+        memcpy(&magic, p, sizeof(magic));
+        entries += magic == LOGTOK_ENTRY_MAGIC;
+    }
+    uint32_t distinct_sites = 9 + 5;    // BENCH_LOG call sites
+    CHECK(entries == distinct_sites, "%lu entries in logtok_entries, expected %lu",
+          (unsigned long)entries, (unsigned long)distinct_sites);
+
+    printf("%lu messages: text %lu bytes, frames %lu bytes (%.1fx), base64 lines %lu bytes (%.1fx)\n",
+           (unsigned long)frames, (unsigned long)text_bytes, (unsigned long)frame_bytes,
+           (double)text_bytes / frame_bytes, (unsigned long)line_bytes, (double)text_bytes / line_bytes);
+    CHECK(text_bytes > 4 * frame_bytes, "frames should be several times smaller than the text");
+    printf("Wrote %s and %s\n", capture_path, expected_path);
+    printf("%s\n", failures ? "FAILURES" : "OK");
+    return failures != 0;
+}
@@ -0,0 +1,195 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include "esp_err.h"
+#ifdef ESP_PLATFORM
+#include "esp_log.h"
+#endif
+
+// ================ TOKENIZED LOGGING ================
+// Drop-in for ESP_LOGx that keeps format strings off the device:
+//
+//   TLOGI(TAG, "  Used Blocks:     %d (%d%%)", used, pct);
+//
+// At compile time the format literal is hashed into a 32-bit token and
+// copied into the "logtok_entries" section, which logtok.ld marks INFO:
+// it stays in the ELF but is never loaded, so the string costs no flash.
+// At run time the call packs a frame
+//
+//   | level u8 | timestamp ms varint | tag hash u16 | token u32 | args |
+//
+// with integers as zigzag varints, floats as 4-byte IEEE and strings as
+// a length byte plus bytes, and writes it through the log output as one
+// "$<base64>" line - typically 12-20 bytes packed, 20-30 characters as
+// text, where the ESP_LOGx line was 40-150. No formatting happens on the
+// device.
+//
+// tools/logtok/logtok.py turns captures back into ESP-IDF style text,
+// reading tokens from the app ELF (or a saved database, so logs from
+// older builds still decode):
+//
+//   python3 tools/logtok/logtok.py --elf build/lab2.elf monitor.log
+//   idf.py monitor | python3 tools/logtok/logtok.py --elf build/lab2.elf
+//
+// Build with -DLOGTOK_TEXT=1 (idf.py -DLOGTOK_TEXT=1 build) to turn the
+// TLOGx macros back into plain ESP_LOGx while debugging on a bare
+// terminal.
+//
+// Limits: at most LOGTOK_MAX_ARGS arguments, no '*' widths, and only
+// the first LOGTOK_HASH_LEN bytes of a format feed the hash - the tool
+// reports formats that collide. The tag is hashed at run time (tags are
+// variables, not literals); the tool finds tag strings in the ELF's
+// read-only data.
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define LOGTOK_MAX_ARGS     8
+#define LOGTOK_MAX_FRAME    96      // Packed bytes per message, args truncated beyond
+#define LOGTOK_MAX_STRING   48      // Bytes kept of each %s argument
+#define LOGTOK_HASH_LEN     96      // Format bytes hashed
+#define LOGTOK_ENTRY_MAGIC  0x4B4F544Cu     // "LTOK"
+
+// Frame level byte: ESP log level in bits 0-2
+#define LOGTOK_TRUNCATED    0x80    // Arguments didn't all fit
+
+// Argument classes, 3 bits each in the types word (count in bits 0-3)
+enum {
+    LOGTOK_ARG_NONE = 0,
+    LOGTOK_ARG_INT,                 // int and smaller, 32-bit long, pointers on 32-bit
+    LOGTOK_ARG_INT64,
+    LOGTOK_ARG_DOUBLE,              // float promotes
+    LOGTOK_ARG_STRING,
+};
+
+typedef struct {
+    uint32_t frames;
+    uint32_t bytes;                 // Packed bytes, before base64
+    uint32_t truncated;
+    uint32_t max_frame;
+} logtok_stats_t;
+
+// Where finished frames go. The default writes "$<base64>\n" through
+// esp_log_write(); set a sink to send raw frames elsewhere (UDP uplink,
+// flash log). Called from the logging task, keep it short.
+typedef void (*logtok_sink_fn)(const uint8_t *frame, size_t len, void *ctx);
+
+// ---- Portable core ----
+
+// The token of a format string: the same hash LOGTOK_TOKEN() folds at
+// compile time and tools/logtok/logtok.py computes
+uint32_t logtok_hash(const char *s, size_t len);
+
+// Packs one frame; returns its length (the header always fits). The
+// tag hash is folded to 16 bits.
+size_t logtok_pack(uint8_t *buf, size_t cap, int level, uint32_t ts_ms, uint32_t tag_hash,
+                   uint32_t token, uint32_t types, va_list ap);
+
+// Standard base64 with padding; out needs 4 * ((len + 2) / 3) + 1 bytes
+size_t logtok_base64(const uint8_t *in, size_t len, char *out);
+
+// ---- Device ----
+
+void logtok_log(int level, const char *tag, uint32_t token, uint32_t types, ...);
+void logtok_set_sink(logtok_sink_fn sink, void *ctx);
+void logtok_get_stats(logtok_stats_t *out);
+void logtok_report(FILE *out);
+
+// ---- Compile-time token ----
+// 65599 hash over the first LOGTOK_HASH_LEN bytes, seeded with the full
+// length: token = len + sum(s[i] * 65599^(i+1)). Unrolled so the compiler
+// folds it to a constant - the literal never reaches the binary.
+
+#define LOGTOK_K            65599u
+#define LOGTOK_K4           (LOGTOK_K * LOGTOK_K * LOGTOK_K * LOGTOK_K)
+#define LOGTOK_K16          (LOGTOK_K4 * LOGTOK_K4 * LOGTOK_K4 * LOGTOK_K4)
+
+#define LOGTOK_CH(s, i) \
+    ((i) < sizeof(s) - 1 ? (uint32_t)(uint8_t)(s)[(i) < sizeof(s) - 1 ? (i) : 0] : 0u)
+#define LOGTOK_H4(s, i, k) \
+    (LOGTOK_CH(s, i) * (k) + LOGTOK_CH(s, (i) + 1) * ((k) * LOGTOK_K) + \
+     LOGTOK_CH(s, (i) + 2) * ((k) * LOGTOK_K * LOGTOK_K) + \
+     LOGTOK_CH(s, (i) + 3) * ((k) * LOGTOK_K * LOGTOK_K * LOGTOK_K))
+#define LOGTOK_H16(s, i, k) \
+    (LOGTOK_H4(s, i, k) + LOGTOK_H4(s, (i) + 4, (k) * LOGTOK_K4) + \
+     LOGTOK_H4(s, (i) + 8, (k) * LOGTOK_K4 * LOGTOK_K4) + \
+     LOGTOK_H4(s, (i) + 12, (k) * LOGTOK_K4 * LOGTOK_K4 * LOGTOK_K4))
+
+#define LOGTOK_TOKEN(s) ((uint32_t)(sizeof(s) - 1 + \
+    LOGTOK_H16(s, 0, LOGTOK_K) + \
+    LOGTOK_H16(s, 16, LOGTOK_K * LOGTOK_K16) + \
+    LOGTOK_H16(s, 32, LOGTOK_K * LOGTOK_K16 * LOGTOK_K16) + \
+    LOGTOK_H16(s, 48, LOGTOK_K * LOGTOK_K16 * LOGTOK_K16 * LOGTOK_K16) + \
+    LOGTOK_H16(s, 64, LOGTOK_K * LOGTOK_K16 * LOGTOK_K16 * LOGTOK_K16 * LOGTOK_K16) + \
+    LOGTOK_H16(s, 80, LOGTOK_K * LOGTOK_K16 * LOGTOK_K16 * LOGTOK_K16 * LOGTOK_K16 * LOGTOK_K16)))
+
+// Database entry for the host tool; only ever lives in the ELF
+#define LOGTOK_ENTRY(s) \
+    static const struct { uint32_t magic; uint32_t len; char str[sizeof(s)]; } logtok_entry_ \
+        __attribute__((section("logtok_entries"), used, aligned(4))) = \
+        { LOGTOK_ENTRY_MAGIC, sizeof(s) - 1, s }
+
+// ---- Argument types ----
+
+typedef struct { char unused; } logtok_pad_t;
+#define LOGTOK_PAD ((logtok_pad_t){ 0 })
+
+#define LOGTOK_ARG_TYPE(x) _Generic((x),                                           \
+    logtok_pad_t: LOGTOK_ARG_NONE,                                                  \
+    float: LOGTOK_ARG_DOUBLE,                                                       \
+    double: LOGTOK_ARG_DOUBLE,                                                      \
+    long: (sizeof(long) == 8 ? LOGTOK_ARG_INT64 : LOGTOK_ARG_INT),                  \
+    unsigned long: (sizeof(long) == 8 ? LOGTOK_ARG_INT64 : LOGTOK_ARG_INT),         \
+    long long: LOGTOK_ARG_INT64,                                                    \
+    unsigned long long: LOGTOK_ARG_INT64,                                           \
+    char *: LOGTOK_ARG_STRING,                                                      \
+    const char *: LOGTOK_ARG_STRING,                                                \
+    default: LOGTOK_ARG_INT)
+
+#define LOGTOK_NARGS(...) LOGTOK_NARGS_(0, ##__VA_ARGS__, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0)
+#define LOGTOK_NARGS_(z, a1, a2, a3, a4, a5, a6, a7, a8, a9, n, ...) n
+
+#define LOGTOK_TYPES(...) LOGTOK_TYPES_(0, ##__VA_ARGS__, LOGTOK_PAD, LOGTOK_PAD, LOGTOK_PAD, \
+    LOGTOK_PAD, LOGTOK_PAD, LOGTOK_PAD, LOGTOK_PAD, LOGTOK_PAD)
+#define LOGTOK_TYPES_(z, a1, a2, a3, a4, a5, a6, a7, a8, ...) ((uint32_t)(             \
+    LOGTOK_ARG_TYPE(a1) << 4 | LOGTOK_ARG_TYPE(a2) << 7 | LOGTOK_ARG_TYPE(a3) << 10 |  \
+    LOGTOK_ARG_TYPE(a4) << 13 | LOGTOK_ARG_TYPE(a5) << 16 | LOGTOK_ARG_TYPE(a6) << 19 | \
+    LOGTOK_ARG_TYPE(a7) << 22 | LOGTOK_ARG_TYPE(a8) << 25))
+
+// ---- Logging macros ----
+
+#define LOGTOK_LOG(level, tag, fmt, ...) do {                                      \
+        _Static_assert(LOGTOK_NARGS(__VA_ARGS__) <= LOGTOK_MAX_ARGS,               \
+                       "too many arguments for a tokenized log");                   \
+        LOGTOK_ENTRY(fmt);                                                          \
+        logtok_log((level), (tag), LOGTOK_TOKEN(fmt),                               \
+                   LOGTOK_TYPES(__VA_ARGS__) | LOGTOK_NARGS(__VA_ARGS__),           \
+                   ##__VA_ARGS__);                                                  \
+    } while (0)
+
+#ifdef ESP_PLATFORM
+#if LOGTOK_TEXT
+#define TLOGE(tag, fmt, ...) ESP_LOGE(tag, fmt, ##__VA_ARGS__)
+#define TLOGW(tag, fmt, ...) ESP_LOGW(tag, fmt, ##__VA_ARGS__)
+#define TLOGI(tag, fmt, ...) ESP_LOGI(tag, fmt, ##__VA_ARGS__)
+#define TLOGD(tag, fmt, ...) ESP_LOGD(tag, fmt, ##__VA_ARGS__)
+#else
+#define LOGTOK_LEVEL(level, tag, fmt, ...) do {                                    \
+        if (LOG_LOCAL_LEVEL >= (level)) {                                           \
+            LOGTOK_LOG(level, tag, fmt, ##__VA_ARGS__);                             \
+        }                                                                           \
+    } while (0)
+#define TLOGE(tag, fmt, ...) LOGTOK_LEVEL(ESP_LOG_ERROR, tag, fmt, ##__VA_ARGS__)
+#define TLOGW(tag, fmt, ...) LOGTOK_LEVEL(ESP_LOG_WARN, tag, fmt, ##__VA_ARGS__)
+#define TLOGI(tag, fmt, ...) LOGTOK_LEVEL(ESP_LOG_INFO, tag, fmt, ##__VA_ARGS__)
+#define TLOGD(tag, fmt, ...) LOGTOK_LEVEL(ESP_LOG_DEBUG, tag, fmt, ##__VA_ARGS__)
+#endif
+#endif // ESP_PLATFORM
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,139 @@
+#include <stdbool.h>
+#include <string.h>
+#include "logtok.h"
+
+// ================ TOKENS ================
+
+uint32_t logtok_hash(const char *s, size_t len) {
+    uint32_t hash = (uint32_t)len;
+    uint32_t k = LOGTOK_K;
+    for (size_t i = 0; i < len && i < LOGTOK_HASH_LEN; i++) {
+        hash += (uint8_t)s[i] * k;
+        k *= LOGTOK_K;
+    }
+    return hash;
+}
+
+// ================ FRAME PACKING ================
+
+typedef struct {
+    uint8_t *buf;
+    size_t cap;
+    size_t len;
+    bool full;
+} writer_t;
+
+static bool put(writer_t *w, const void *src, size_t n) {
+    if (w->full || w->len + n > w->cap) {
+        w->full = true;
+        return false;
+    }
+    memcpy(w->buf + w->len, src, n);
+    w->len += n;
+    return true;
+}
+
+static bool put_varint(writer_t *w, uint64_t v) {
+    uint8_t tmp[10];
+    size_t n = 0;
+    do {
+        tmp[n] = (uint8_t)(v & 0x7F);
+        v >>= 7;
+        tmp[n] |= v ? 0x80 : 0;
+        n++;
+    } while (v);
+    return put(w, tmp, n);
+}
+
+static bool put_u32(writer_t *w, uint32_t v) {
+    uint8_t b[4] = { (uint8_t)v, (uint8_t)(v >> 8), (uint8_t)(v >> 16), (uint8_t)(v >> 24) };
+    return put(w, b, sizeof(b));
+}
+
+// Signed zigzag: small magnitudes of either sign stay short. The decoder
+// reinterprets by the conversion (%u, %x... mask to 32 or 64 bits).
+static bool put_int(writer_t *w, int64_t v) {
+    return put_varint(w, ((uint64_t)v << 1) ^ (uint64_t)(v >> 63));
+}
+
+static bool put_string(writer_t *w, const char *s) {
+    if (s == NULL) {
+        s = "(null)";
+    }
+    size_t n = strnlen(s, LOGTOK_MAX_STRING + 1);
+    bool cut = n > LOGTOK_MAX_STRING;
+    if (cut) {
+        n = LOGTOK_MAX_STRING;
+    }
+    // Whatever fits of the string, rather than nothing
+    if (!w->full && w->len + 1 + n > w->cap && w->len + 1 < w->cap) {
+        n = w->cap - w->len - 1;
+        cut = true;
+    }
+    uint8_t head = (uint8_t)(n | (cut ? 0x80 : 0));
+    return put(w, &head, 1) && put(w, s, n);
+}
+
+size_t logtok_pack(uint8_t *buf, size_t cap, int level, uint32_t ts_ms, uint32_t tag_hash,
+                   uint32_t token, uint32_t types, va_list ap) {
+    writer_t w = { .buf = buf, .cap = cap };
+    uint8_t head = (uint8_t)(level & 0x07);
+    put(&w, &head, 1);
+    put_varint(&w, ts_ms);
+    uint32_t tag16 = (tag_hash ^ tag_hash >> 16) & 0xFFFF;
+    uint8_t tag_bytes[2] = { (uint8_t)tag16, (uint8_t)(tag16 >> 8) };
+    put(&w, tag_bytes, sizeof(tag_bytes));
+    put_u32(&w, token);
+
+    uint32_t count = types & 0x0F;
+    for (uint32_t i = 0; i < count; i++) {
+        // va_arg even when full: the list has to stay in step
+        switch ((types >> (4 + 3 * i)) & 0x07) {
+            case LOGTOK_ARG_INT:
+                put_int(&w, va_arg(ap, int));
+                break;
+            case LOGTOK_ARG_INT64:
+                put_int(&w, va_arg(ap, long long));
+                break;
+            case LOGTOK_ARG_DOUBLE: {
+                float f = (float)va_arg(ap, double);
+                uint32_t bits;
+                memcpy(&bits, &f, sizeof(bits));
+                put_u32(&w, bits);
+                break;
+            }
+            case LOGTOK_ARG_STRING:
+                put_string(&w, va_arg(ap, const char *));
+                break;
+            default:
+                w.full = true;
+                break;
+        }
+    }
+    if (w.full) {
+        buf[0] |= LOGTOK_TRUNCATED;
+    }
+    return w.len;
+}
+
+// ================ BASE64 ================
+
+size_t logtok_base64(const uint8_t *in, size_t len, char *out) {
+    static const char digits[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    size_t o = 0;
+    for (size_t i = 0; i < len; i += 3) {
+        uint32_t v = (uint32_t)in[i] << 16;
+        if (i + 1 < len) {
+            v |= (uint32_t)in[i + 1] << 8;
+        }
+        if (i + 2 < len) {
+            v |= in[i + 2];
+        }
+        out[o++] = digits[(v >> 18) & 0x3F];
+        out[o++] = digits[(v >> 12) & 0x3F];
+        out[o++] = i + 1 < len ? digits[(v >> 6) & 0x3F] : '=';
+        out[o++] = i + 2 < len ? digits[v & 0x3F] : '=';
+    }
+    out[o] = '\0';
+    return o;
+}
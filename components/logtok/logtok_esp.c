@@ -0,0 +1,67 @@
+#ifdef ESP_PLATFORM
+
+#include <string.h>
+#include <inttypes.h>
+#include "logtok.h"
+#include "esp_log.h"
+
+// ================ OUTPUT ================
+
+static logtok_sink_fn sink;
+static void *sink_ctx;
+static logtok_stats_t stats;
+
+void logtok_set_sink(logtok_sink_fn fn, void *ctx) {
+    sink_ctx = ctx;
+    sink = fn;
+}
+
+// One console line per frame; esp_log_write keeps the per-tag level
+// filter and whatever vprintf redirection the app installed
+static void write_base64(int level, const char *tag, const uint8_t *frame, size_t len) {
+    char text[4 * ((LOGTOK_MAX_FRAME + 2) / 3) + 1];
+    logtok_base64(frame, len, text);
+    esp_log_write((esp_log_level_t)level, tag, "$%s\n", text);
+}
+
+void logtok_log(int level, const char *tag, uint32_t token, uint32_t types, ...) {
+    uint8_t frame[LOGTOK_MAX_FRAME];
+    va_list ap;
+    va_start(ap, types);
+    size_t len = logtok_pack(frame, sizeof(frame), level, esp_log_timestamp(),
+                             logtok_hash(tag, strlen(tag)), token, types, ap);
+    va_end(ap);
+
+    __atomic_fetch_add(&stats.frames, 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&stats.bytes, len, __ATOMIC_RELAXED);
+    if (frame[0] & LOGTOK_TRUNCATED) {
+        __atomic_fetch_add(&stats.truncated, 1, __ATOMIC_RELAXED);
+    }
+    if (len > stats.max_frame) {
+        stats.max_frame = len;      // Racy max, good enough for a report
+    }
+
+    logtok_sink_fn fn = sink;
+    if (fn != NULL) {
+        fn(frame, len, sink_ctx);
+    } else {
+        write_base64(level, tag, frame, len);
+    }
+}
+
+void logtok_get_stats(logtok_stats_t *out) {
+    out->frames = __atomic_load_n(&stats.frames, __ATOMIC_RELAXED);
+    out->bytes = __atomic_load_n(&stats.bytes, __ATOMIC_RELAXED);
+    out->truncated = __atomic_load_n(&stats.truncated, __ATOMIC_RELAXED);
+    out->max_frame = stats.max_frame;
+}
+
+void logtok_report(FILE *out) {
+    logtok_stats_t st;
+    logtok_get_stats(&st);
+    fprintf(out, "logtok: %" PRIu32 " frames, %" PRIu32 " bytes (avg %" PRIu32 ", max %" PRIu32 "), "
+                 "%" PRIu32 " truncated\n",
+            st.frames, st.bytes, st.frames ? st.bytes / st.frames : 0, st.max_frame, st.truncated);
+}
+
+#endif // ESP_PLATFORM
@@ -0,0 +1,180 @@
+// Host check for per-task accounting: several fake tasks charge and
+// credit random heap and pool blocks, and every account is compared with
+// a reference tally (current, peak, per source). Then the quota rules:
+// a soft quota reports once per excursion, a hard quota refuses without
+// charging, tasks beyond the table share the overflow account, and a
+// deleted task's account is reclaimed instead of inherited.
+//
+// Build and run from this directory:
+//   cc -O2 -I../include -I../../../tools/host_include ../memacct.c memacct_host_bench.c -o memacct_bench
+//   ./memacct_bench
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "memacct.h"
+#include "host_check.h"
+
+#define TASKS       6
+#define BLOCKS      400
+
+typedef struct {
+    int account;                // -1 = free slot
+    ma_source_t src;
+    uint32_t size;
+} block_t;
+
+static void random_traffic(void) {
+    static ma_table_t t;
+    static block_t blocks[BLOCKS];
+    static const char *names[TASKS] = { "MemMonitor", "StressTest", "PoolTest", "LargeAlloc",
+                                        "IntegrityTest", "main" };
+    int owners[TASKS];
+    uint32_t cur[TASKS][MA_SRC_COUNT] = { { 0 } }, peak[TASKS] = { 0 };
+
+    ma_core_init(&t);
+    for (int i = 0; i < BLOCKS; i++) {
+        blocks[i].account = -1;
+    }
+    for (int i = 0; i < TASKS; i++) {
+        owners[i] = ma_core_account(&t, &owners[i], names[i]);
+        CHECK(owners[i] == i, "task %d got account %d", i, owners[i]);
+    }
+
+    for (int step = 0; step < 200000; step++) {
+        block_t *b = &blocks[rand() % BLOCKS];
+        if (b->account < 0) {
+            int task = rand() % TASKS;
+            b->src = rand() % 3 == 0 ? MA_SRC_POOL : MA_SRC_HEAP;
+            b->size = b->src == MA_SRC_POOL ? 64u << (rand() % 4) : 1u + (uint32_t)(rand() % 4096);
+            CHECK(ma_core_charge(&t, owners[task], b->src, b->size) == MA_OK, "charge without quota");
+            b->account = owners[task];
+            cur[task][b->src] += b->size;
+            uint32_t total = cur[task][MA_SRC_HEAP] + cur[task][MA_SRC_POOL];
+            if (total > peak[task]) {
+                peak[task] = total;
+            }
+        } else {
+            ma_core_uncharge(&t, b->account, b->src, b->size);
+            cur[b->account][b->src] -= b->size;
+            b->account = -1;
+        }
+    }
+
+    ma_account_t snap[MA_MAX_ACCOUNTS];
+    size_t n = ma_core_snapshot(&t, snap, MA_MAX_ACCOUNTS);
+    CHECK(n == TASKS, "snapshot has %zu accounts", n);
+    for (size_t i = 0; i < n; i++) {
+        int task = -1;
+        for (int k = 0; k < TASKS; k++) {
+            if (strcmp(snap[i].name, names[k]) == 0) {
+                task = k;
+            }
+        }
+        CHECK(task >= 0, "unknown account %s", snap[i].name);
+        if (task < 0) {
+            continue;
+        }
+        uint32_t total = cur[task][MA_SRC_HEAP] + cur[task][MA_SRC_POOL];
+        CHECK(snap[i].current == total && snap[i].peak == peak[task] &&
+              snap[i].by_source[MA_SRC_HEAP] == cur[task][MA_SRC_HEAP] &&
+              snap[i].by_source[MA_SRC_POOL] == cur[task][MA_SRC_POOL],
+              "%s: cur %lu peak %lu, expected %lu / %lu", snap[i].name, (unsigned long)snap[i].current,
+              (unsigned long)snap[i].peak, (unsigned long)total, (unsigned long)peak[task]);
+        CHECK(i == 0 || snap[i - 1].current >= snap[i].current, "snapshot not sorted at %zu", i);
+    }
+    CHECK(t.bad_credits == 0, "%lu bad credits", (unsigned long)t.bad_credits);
+
+    // A credit nobody was charged for is counted, not applied
+    ma_core_uncharge(&t, owners[0], MA_SRC_ARENA, 100);
+    CHECK(t.bad_credits == 1, "arena credit without a charge");
+
+    ma_core_report(snap, n, stdout);
+}
+
+static void quotas(void) {
+    static ma_table_t t;
+    int task;
+    ma_core_init(&t);
+    int a = ma_core_account(&t, &task, "StressTest");
+    ma_core_set_quota(&t, a, 1000, 2000);
+
+    CHECK(ma_core_charge(&t, a, MA_SRC_HEAP, 900) == MA_OK, "under soft");
+    CHECK(ma_core_charge(&t, a, MA_SRC_HEAP, 200) == MA_SOFT_CROSSED, "crossing soft");
+    CHECK(ma_core_charge(&t, a, MA_SRC_HEAP, 200) == MA_OK, "still over soft: no second event");
+    CHECK(ma_core_charge(&t, a, MA_SRC_HEAP, 800) == MA_DENIED, "crossing hard");
+    CHECK(t.accounts[a].current == 1300 && t.accounts[a].denied == 1, "denied request charged: %lu",
+          (unsigned long)t.accounts[a].current);
+    CHECK(ma_core_charge(&t, a, MA_SRC_HEAP, 700) == MA_OK, "exactly at hard is allowed");
+
+    ma_core_uncharge(&t, a, MA_SRC_HEAP, 1500);     // Back under soft: re-armed
+    CHECK(ma_core_charge(&t, a, MA_SRC_HEAP, 600) == MA_SOFT_CROSSED, "re-armed soft");
+    CHECK(t.accounts[a].soft_breaches == 2, "%lu soft breaches", (unsigned long)t.accounts[a].soft_breaches);
+
+    // Setting a quota below current usage counts as already over it
+    int b = ma_core_account(&t, &b, "PoolTest");
+    ma_core_charge(&t, b, MA_SRC_POOL, 5000);
+    ma_core_set_quota(&t, b, 4000, MA_NO_QUOTA);
+    CHECK(ma_core_charge(&t, b, MA_SRC_POOL, 64) == MA_OK, "already over soft when set");
+}
+
+static void overflow(void) {
+    static ma_table_t t;
+    static char owners[40];
+    ma_core_init(&t);
+    int last = -1;
+    for (int i = 0; i < 40; i++) {
+        char name[MA_NAME_LEN];
+        snprintf(name, sizeof(name), "worker%d", i);
+        last = ma_core_account(&t, &owners[i], name);
+        ma_core_charge(&t, last, MA_SRC_HEAP, 10);
+    }
+    CHECK(last == MA_MAX_ACCOUNTS - 1, "extra tasks go to the overflow account, got %d", last);
+    CHECK(strcmp(t.accounts[last].name, "other") == 0 &&
+          t.accounts[last].current == 10 * (40 - (MA_MAX_ACCOUNTS - 1)),
+          "overflow account holds %lu", (unsigned long)t.accounts[last].current);
+    CHECK(ma_core_account(&t, &owners[3], NULL) == 3, "known task keeps its account");
+}
+
+static void released(void) {
+    static ma_table_t t;
+    static char tcb;            // Same address for both tasks, like a reused TCB
+    ma_core_init(&t);
+    int old = ma_core_account(&t, &tcb, "Worker");
+    ma_core_charge(&t, old, MA_SRC_HEAP, 300);
+
+    // Deleted while still holding memory: visible until that is freed
+    ma_core_release(&t, old);
+    int fresh = ma_core_account(&t, &tcb, "Reborn");
+    CHECK(fresh != old && t.accounts[fresh].current == 0 && strcmp(t.accounts[fresh].name, "Reborn") == 0,
+          "new task inherited account %d (%s)", fresh, t.accounts[fresh].name);
+    CHECK(t.accounts[old].current == 300 && strcmp(t.accounts[old].name, "Worker") == 0,
+          "leftovers of the deleted task lost");
+
+    // Its memory freed later (by anyone): the slot is reusable
+    ma_core_uncharge(&t, old, MA_SRC_HEAP, 300);
+    CHECK(t.accounts[old].owner == NULL, "empty released account kept");
+    ma_core_release(&t, fresh);
+    CHECK(t.accounts[fresh].owner == NULL, "released with nothing held, kept");
+
+    // Tasks coming and going never run the table out
+    static char tasks[100];
+    for (int i = 0; i < 100; i++) {
+        int a = ma_core_account(&t, &tasks[i], "shortlived");
+        ma_core_charge(&t, a, MA_SRC_HEAP, 10);
+        ma_core_uncharge(&t, a, MA_SRC_HEAP, 10);
+        CHECK(a != MA_MAX_ACCOUNTS - 1, "task %d went to the overflow account", i);
+        ma_core_release(&t, a);
+    }
+    CHECK(t.bad_credits == 0, "%lu bad credits", (unsigned long)t.bad_credits);
+}
+
+int main(void) {
+    srand(95);
+    random_traffic();
+    quotas();
+    overflow();
+    released();
+    printf("%s\n", failures ? "FAILURES" : "OK");
+    return failures != 0;
+}
@@ -0,0 +1,158 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include "esp_err.h"
+
+#ifdef ESP_PLATFORM
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#endif
+
+// ================ PER-TASK MEMORY ACCOUNTING ================
+// Charges every allocation to the task that made it, so "free heap is
+// low" comes with "and StressTest holds 38 KB of it":
+//
+//   void *p = ma_malloc(size, MALLOC_CAP_INTERNAL);   // heap, attributed
+//   ma_free(p);                                       // credited back
+//
+// Allocators with their own headers (pools, arenas) charge and credit
+// explicitly and remember the account in the block:
+//
+//   int owner = ma_charge(MA_SRC_POOL, pool->block_size);
+//   if (owner < 0) { ...over its hard quota, refuse... }
+//   block->owner = owner;
+//   ...
+//   ma_uncharge(block->owner, MA_SRC_POOL, pool->block_size);
+//
+// Per task: current and peak bytes (in total and per source), calls,
+// and optional quotas set with ma_set_quota():
+//
+//   soft   crossing it calls the breach handler once (again only after
+//          usage has dropped back under), the allocation goes ahead
+//   hard   an allocation that would cross it is refused - ma_malloc()
+//          returns NULL, ma_charge() -1 - and the handler is told
+//
+// The handler runs in the allocating task, outside the accounting lock.
+// Memory freed by another task is credited to the one that allocated it.
+//
+// ma_snapshot() copies the accounts out as plain structs for whatever
+// consumes metrics; ma_report() prints one key=value line per task:
+//
+//   memacct task=StressTest cur=21480 peak=38112 heap=21480 pool=0 ...
+//
+// Accounts are made on a task's first allocation. When the task is
+// deleted its account is released: it stays visible under its name while
+// it still holds memory and its slot is reused once that is freed, so a
+// new task whose TCB lands at the same address starts from zero. Beyond
+// MA_MAX_ACCOUNTS live accounts everything goes to one shared "other".
+//
+// On the device the account index and the deletion callback sit in one
+// FreeRTOS thread-local storage pointer per task, MA_TLS_INDEX (the last
+// one). ESP-IDF's pthread keys use index 0, so memacct needs
+// CONFIG_FREERTOS_THREAD_LOCAL_STORAGE_POINTERS >= 2. The index comes from
+// the Kconfig value, not configNUM_THREAD_LOCAL_STORAGE_POINTERS: with
+// deletion callbacks enabled IDF doubles the latter and keeps the
+// callbacks in its upper half.
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define MA_MAX_ACCOUNTS     16      // Last one is the shared overflow account
+#ifndef MA_TLS_INDEX
+#define MA_TLS_INDEX        (CONFIG_FREERTOS_THREAD_LOCAL_STORAGE_POINTERS - 1)
+#endif
+#define MA_NAME_LEN         16
+#define MA_NO_QUOTA         0
+
+typedef enum {
+    MA_SRC_HEAP,                    // ma_malloc()
+    MA_SRC_POOL,                    // Fixed-block pools
+    MA_SRC_ARENA,                   // Bump/arena allocators
+    MA_SRC_COUNT,
+} ma_source_t;
+
+typedef enum {
+    MA_OK,
+    MA_SOFT_CROSSED,                // Allowed; went over the soft quota just now
+    MA_DENIED,                      // Would cross the hard quota
+} ma_verdict_t;
+
+typedef enum {
+    MA_BREACH_SOFT,
+    MA_BREACH_HARD,
+} ma_breach_kind_t;
+
+typedef struct {
+    ma_breach_kind_t kind;
+    const char *task;
+    ma_source_t source;
+    uint32_t request;               // Bytes asked for
+    uint32_t current;               // Held before this request
+    uint32_t quota;                 // The one crossed
+} ma_breach_t;
+
+typedef void (*ma_breach_fn)(const ma_breach_t *b, void *ctx);
+
+typedef struct {
+    const void *owner;              // Task handle; NULL = unused slot
+    char name[MA_NAME_LEN];
+    uint32_t current;
+    uint32_t peak;
+    uint32_t by_source[MA_SRC_COUNT];
+    uint32_t allocs;
+    uint32_t frees;
+    uint32_t soft_quota;            // MA_NO_QUOTA = none
+    uint32_t hard_quota;
+    bool over_soft;
+    uint32_t soft_breaches;
+    uint32_t denied;
+    bool released;                  // Owner gone; slot freed once current is 0
+} ma_account_t;
+
+typedef struct {
+    ma_account_t accounts[MA_MAX_ACCOUNTS];
+    uint32_t bad_credits;           // Credits to unknown accounts or below zero
+} ma_table_t;
+
+// ---- Portable core (the device functions lock around these) ----
+
+void ma_core_init(ma_table_t *t);
+// Live account of owner, created on first use; the overflow account when full
+int ma_core_account(ma_table_t *t, const void *owner, const char *name);
+// The owner is gone (task deleted): its account no longer matches the
+// owner, and its slot is reused as soon as it holds nothing
+void ma_core_release(ma_table_t *t, int account);
+ma_verdict_t ma_core_charge(ma_table_t *t, int account, ma_source_t src, uint32_t bytes);
+void ma_core_uncharge(ma_table_t *t, int account, ma_source_t src, uint32_t bytes);
+void ma_core_set_quota(ma_table_t *t, int account, uint32_t soft, uint32_t hard);
+// Copies the used accounts, largest current first; returns how many
+size_t ma_core_snapshot(const ma_table_t *t, ma_account_t *out, size_t max);
+void ma_core_report(const ma_account_t *accounts, size_t n, FILE *out);
+
+// ---- Device ----
+
+#ifdef ESP_PLATFORM
+// heap_caps_malloc() charged to the calling task (8-byte header)
+void *ma_malloc(size_t size, uint32_t caps);
+void ma_free(void *ptr);
+
+// For allocators with their own block headers: the account to store,
+// or -1 if the calling task's hard quota refuses it
+int ma_charge(ma_source_t src, size_t bytes);
+void ma_uncharge(int account, ma_source_t src, size_t bytes);
+
+// soft/hard in bytes, MA_NO_QUOTA for none; task NULL = the caller
+esp_err_t ma_set_quota(TaskHandle_t task, uint32_t soft, uint32_t hard);
+void ma_set_breach_handler(ma_breach_fn fn, void *ctx);
+
+size_t ma_snapshot(ma_account_t *out, size_t max);
+void ma_report(FILE *out);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,133 @@
+#include <string.h>
+#include <inttypes.h>
+#include "memacct.h"
+
+// ================ ACCOUNTS ================
+
+#define OVERFLOW_ACCOUNT    (MA_MAX_ACCOUNTS - 1)
+
+static const char *const source_names[MA_SRC_COUNT] = { "heap", "pool", "arena" };
+
+void ma_core_init(ma_table_t *t) {
+    memset(t, 0, sizeof(*t));
+    // The shared account always exists so a full table never fails
+    t->accounts[OVERFLOW_ACCOUNT].owner = t;
+    strncpy(t->accounts[OVERFLOW_ACCOUNT].name, "other", MA_NAME_LEN - 1);
+}
+
+int ma_core_account(ma_table_t *t, const void *owner, const char *name) {
+    // Released slots leave holes, so look for the owner everywhere first
+    int free_slot = -1;
+    for (int i = 0; i < OVERFLOW_ACCOUNT; i++) {
+        ma_account_t *a = &t->accounts[i];
+        if (a->owner == owner && !a->released) {
+            return i;
+        }
+        if (a->owner == NULL && free_slot < 0) {
+            free_slot = i;
+        }
+    }
+    if (free_slot < 0) {
+        return OVERFLOW_ACCOUNT;
+    }
+    ma_account_t *a = &t->accounts[free_slot];
+    a->owner = owner;
+    strncpy(a->name, name != NULL ? name : "?", MA_NAME_LEN - 1);
+    a->name[MA_NAME_LEN - 1] = '\0';
+    return free_slot;
+}
+
+static void reclaim_if_empty(ma_account_t *a) {
+    if (a->released && a->current == 0) {
+        memset(a, 0, sizeof(*a));
+    }
+}
+
+void ma_core_release(ma_table_t *t, int account) {
+    if (account < 0 || account >= OVERFLOW_ACCOUNT || t->accounts[account].owner == NULL) {
+        return;     // The shared account outlives every task
+    }
+    t->accounts[account].released = true;
+    reclaim_if_empty(&t->accounts[account]);
+}
+
+ma_verdict_t ma_core_charge(ma_table_t *t, int account, ma_source_t src, uint32_t bytes) {
+    ma_account_t *a = &t->accounts[account];
+    uint32_t after = a->current + bytes;
+
+    if (a->hard_quota != MA_NO_QUOTA && after > a->hard_quota) {
+        a->denied++;
+        return MA_DENIED;
+    }
+
+    a->current = after;
+    a->by_source[src] += bytes;
+    a->allocs++;
+    if (after > a->peak) {
+        a->peak = after;
+    }
+
+    // Edge-triggered: one event per excursion above the soft quota
+    if (a->soft_quota != MA_NO_QUOTA && after > a->soft_quota && !a->over_soft) {
+        a->over_soft = true;
+        a->soft_breaches++;
+        return MA_SOFT_CROSSED;
+    }
+    return MA_OK;
+}
+
+void ma_core_uncharge(ma_table_t *t, int account, ma_source_t src, uint32_t bytes) {
+    if (account < 0 || account >= MA_MAX_ACCOUNTS || t->accounts[account].owner == NULL ||
+        t->accounts[account].by_source[src] < bytes) {
+        t->bad_credits++;   // Double free or a block this table never charged
+        return;
+    }
+    ma_account_t *a = &t->accounts[account];
+    a->current -= bytes;
+    a->by_source[src] -= bytes;
+    a->frees++;
+    if (a->over_soft && a->current <= a->soft_quota) {
+        a->over_soft = false;
+    }
+    reclaim_if_empty(a);
+}
+
+void ma_core_set_quota(ma_table_t *t, int account, uint32_t soft, uint32_t hard) {
+    ma_account_t *a = &t->accounts[account];
+    a->soft_quota = soft;
+    a->hard_quota = hard;
+    a->over_soft = soft != MA_NO_QUOTA && a->current > soft;
+}
+
+// ================ METRICS ================
+
+size_t ma_core_snapshot(const ma_table_t *t, ma_account_t *out, size_t max) {
+    size_t n = 0;
+    for (int i = 0; i < MA_MAX_ACCOUNTS && n < max; i++) {
+        const ma_account_t *a = &t->accounts[i];
+        if (a->owner == NULL || (i == OVERFLOW_ACCOUNT && a->allocs == 0)) {
+            continue;
+        }
+        // Insertion sort, largest holder first; the table is small
+        size_t j = n++;
+        while (j > 0 && out[j - 1].current < a->current) {
+            out[j] = out[j - 1];
+            j--;
+        }
+        out[j] = *a;
+    }
+    return n;
+}
+
+void ma_core_report(const ma_account_t *accounts, size_t n, FILE *out) {
+    for (size_t i = 0; i < n; i++) {
+        const ma_account_t *a = &accounts[i];
+        fprintf(out, "memacct task=%s cur=%" PRIu32 " peak=%" PRIu32, a->name, a->current, a->peak);
+        for (int s = 0; s < MA_SRC_COUNT; s++) {
+            fprintf(out, " %s=%" PRIu32, source_names[s], a->by_source[s]);
+        }
+        fprintf(out, " allocs=%" PRIu32 " frees=%" PRIu32 " soft=%" PRIu32 " hard=%" PRIu32
+                     " breaches=%" PRIu32 " denied=%" PRIu32 "\n",
+                a->allocs, a->frees, a->soft_quota, a->hard_quota, a->soft_breaches, a->denied);
+    }
+}
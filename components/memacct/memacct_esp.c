@@ -0,0 +1,169 @@
+#ifdef ESP_PLATFORM
+
+#include <string.h>
+#include "memacct.h"
+#include "esp_heap_caps.h"
+
+// ================ DEVICE STATE ================
+
+#define HEADER_MAGIC        0x4D41u     // "MA"
+
+_Static_assert(CONFIG_FREERTOS_THREAD_LOCAL_STORAGE_POINTERS >= 2,
+               "memacct needs a TLS pointer of its own next to pthread's slot 0");
+
+// In front of every ma_malloc() block; 8 bytes keeps the payload aligned
+typedef struct {
+    uint16_t magic;
+    uint8_t account;
+    uint8_t source;
+    uint32_t size;
+} ma_header_t;
+
+static ma_table_t table;
+static bool table_ready;
+static portMUX_TYPE lock = portMUX_INITIALIZER_UNLOCKED;
+static ma_breach_fn breach_handler;
+static void *breach_ctx;
+
+// FreeRTOS calls this while deleting a task that has an account, before
+// its TCB is freed and can come back as another task's handle
+static void task_deleted(int index, void *value) {
+    (void)index;
+    taskENTER_CRITICAL(&lock);
+    ma_core_release(&table, (int)(intptr_t)value - 1);
+    taskEXIT_CRITICAL(&lock);
+}
+
+// Caller holds the lock
+static int account_of(TaskHandle_t task) {
+    if (!table_ready) {
+        ma_core_init(&table);
+        table_ready = true;
+    }
+    if (task == NULL) {
+        return ma_core_account(&table, NULL, "startup");
+    }
+    void *tls = pvTaskGetThreadLocalStoragePointer(task, MA_TLS_INDEX);
+    if (tls != NULL) {
+        return (int)(intptr_t)tls - 1;
+    }
+    int account = ma_core_account(&table, task, pcTaskGetName(task));
+    vTaskSetThreadLocalStoragePointerAndDelCallback(task, MA_TLS_INDEX,
+                                                    (void *)(intptr_t)(account + 1), task_deleted);
+    return account;
+}
+
+static int current_account(void) {
+    return account_of(xTaskGetCurrentTaskHandle());
+}
+
+// ================ CHARGING ================
+
+// Charges the caller and reports a crossed quota, outside the lock
+static int charge(ma_source_t src, uint32_t bytes) {
+    ma_breach_t b;
+    taskENTER_CRITICAL(&lock);
+    int account = current_account();
+    ma_account_t *a = &table.accounts[account];
+    b.current = a->current;
+    ma_verdict_t v = ma_core_charge(&table, account, src, bytes);
+    b.quota = v == MA_DENIED ? a->hard_quota : a->soft_quota;
+    b.task = a->name;
+    taskEXIT_CRITICAL(&lock);
+
+    ma_breach_fn fn = breach_handler;
+    if (v != MA_OK && fn != NULL) {
+        b.kind = v == MA_DENIED ? MA_BREACH_HARD : MA_BREACH_SOFT;
+        b.source = src;
+        b.request = bytes;
+        fn(&b, breach_ctx);
+    }
+    return v == MA_DENIED ? -1 : account;
+}
+
+int ma_charge(ma_source_t src, size_t bytes) {
+    return charge(src, (uint32_t)bytes);
+}
+
+void ma_uncharge(int account, ma_source_t src, size_t bytes) {
+    taskENTER_CRITICAL(&lock);
+    ma_core_uncharge(&table, account, src, (uint32_t)bytes);
+    taskEXIT_CRITICAL(&lock);
+}
+
+void *ma_malloc(size_t size, uint32_t caps) {
+    int account = charge(MA_SRC_HEAP, (uint32_t)size);
+    if (account < 0) {
+        return NULL;
+    }
+    ma_header_t *h = heap_caps_malloc(sizeof(ma_header_t) + size, caps);
+    if (h == NULL) {
+        // The heap said no, not the quota: give the charge back
+        ma_uncharge(account, MA_SRC_HEAP, size);
+        return NULL;
+    }
+    h->magic = HEADER_MAGIC;
+    h->account = (uint8_t)account;
+    h->source = MA_SRC_HEAP;
+    h->size = (uint32_t)size;
+    return h + 1;
+}
+
+void ma_free(void *ptr) {
+    if (ptr == NULL) {
+        return;
+    }
+    ma_header_t *h = (ma_header_t *)ptr - 1;
+    if (h->magic != HEADER_MAGIC) {
+        // Not ours (or the header was overwritten): don't guess a size
+        taskENTER_CRITICAL(&lock);
+        table.bad_credits++;
+        taskEXIT_CRITICAL(&lock);
+        return;
+    }
+    h->magic = 0;   // A second free of the same block is caught above
+    ma_uncharge(h->account, (ma_source_t)h->source, h->size);
+    heap_caps_free(h);
+}
+
+// ================ QUOTAS ================
+
+esp_err_t ma_set_quota(TaskHandle_t task, uint32_t soft, uint32_t hard) {
+    if (hard != MA_NO_QUOTA && soft > hard) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (task == NULL) {
+        task = xTaskGetCurrentTaskHandle();
+    }
+    taskENTER_CRITICAL(&lock);
+    int account = account_of(task);
+    ma_core_set_quota(&table, account, soft, hard);
+    taskEXIT_CRITICAL(&lock);
+    return ESP_OK;
+}
+
+void ma_set_breach_handler(ma_breach_fn fn, void *ctx) {
+    breach_ctx = ctx;
+    breach_handler = fn;
+}
+
+// ================ METRICS ================
+
+size_t ma_snapshot(ma_account_t *out, size_t max) {
+    taskENTER_CRITICAL(&lock);
+    size_t n = table_ready ? ma_core_snapshot(&table, out, max) : 0;
+    taskEXIT_CRITICAL(&lock);
+    return n;
+}
+
+void ma_report(FILE *out) {
+    // Static: a full copy is too big for a monitor task's stack
+    static ma_account_t accounts[MA_MAX_ACCOUNTS];
+    size_t n = ma_snapshot(accounts, MA_MAX_ACCOUNTS);
+    ma_core_report(accounts, n, out);
+    if (table.bad_credits) {
+        fprintf(out, "memacct bad_credits=%lu\n", (unsigned long)table.bad_credits);
+    }
+}
+
+#endif // ESP_PLATFORM
@@ -0,0 +1,149 @@
+// Host check for the trend recorder: two weeks of simulated 10 s heap
+// samples (stress-test noise on top of a slow leak, and the same noise
+// without one), a pool filling up, and a decline with outliers. Checks
+// that downsampling keeps the whole history and every sample, that the
+// leak warning comes days ahead with a sensible time-to-exhaustion, that
+// noise alone never warns, and that the robust slope shrugs off spikes
+// the least squares slope doesn't.
+//
+// Build and run from this directory:
+//   cc -O2 -I../include -I../../../tools/host_include ../memtrend.c memtrend_host_bench.c -o memtrend_bench -lm
+//   ./memtrend_bench
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include "memtrend.h"
+#include "host_check.h"
+
+#define DAY         86400u
+#define WEEK        (7 * DAY)
+#define PERIOD_S    10
+
+// Free heap with the lab's stress tasks running: up to ~40 KB in use,
+// changing every few samples, and a large block held now and then
+static float stress_noise(uint32_t t) {
+    static uint32_t held = 20000, large;
+    if (rand() % 3 == 0) {
+        held = 2000 + rand() % 40000;
+    }
+    if (t % 600 == 0) {
+        large = rand() % 4 == 0 ? 80000 : 0;
+    }
+    return -(float)held - (float)large;
+}
+
+static void slow_leak(void) {
+    mt_series_t s;
+    const float start = 250000, leak_per_h = 400, limit = 20000;
+    mt_series_init(&s, "free", "internal", MT_FALLING, limit, PERIOD_S, WEEK);
+
+    uint32_t raised_at = 0, samples = 0;
+    for (uint32_t t = 0; t < 16 * DAY; t += PERIOD_S) {
+        mt_add(&s, t, start - leak_per_h * t / 3600.0f + stress_noise(t));
+        samples++;
+        if (raised_at == 0 && s.forecast.warning) {
+            raised_at = t;
+        }
+    }
+
+    // Everything kept, at a coarser grain
+    uint32_t kept = s.open.n;
+    for (uint32_t i = 0; i < s.count; i++) {
+        kept += s.points[i].n;
+    }
+    CHECK(kept == samples && s.count <= MT_POINTS && s.points[0].t_s < DAY / 4,
+          "downsampling: %lu of %lu samples, %lu points, oldest at %lus", (unsigned long)kept,
+          (unsigned long)samples, (unsigned long)s.count, (unsigned long)s.points[0].t_s);
+
+    // The mean heap (stress tasks included) reaches the limit when
+    // start - 41000 - 20000 (average held + large) - leak * t = limit
+    float mean_noise = 21000 + 20000;
+    float exhausted_h = (start - mean_noise - limit) / leak_per_h;
+    float warn_expected_h = exhausted_h - WEEK / 3600.0f;
+    char when[16], tte[16];
+    mt_format_duration(raised_at, when, sizeof(when));
+    mt_format_duration(s.forecast.tte_s, tte, sizeof(tte));
+    printf("slow leak: warned at %s (expected ~%.0fh), exhaustion at %.0fh, "
+           "forecast at 16d: %s, slope %.0f/h robust %.0f/h\n",
+           when, warn_expected_h, exhausted_h, tte, s.forecast.slope_linear, s.forecast.slope_robust);
+    CHECK(raised_at > 0 && fabsf(raised_at / 3600.0f - warn_expected_h) < 24,
+          "leak warning at %s, expected ~%.0fh", when, warn_expected_h);
+    // The level under 80 KB swings is only known to a few KB: +-30%
+    float true_tte_h = exhausted_h - 16 * 24;
+    CHECK(fabsf(s.forecast.tte_s / 3600.0f - true_tte_h) < 0.3f * true_tte_h,
+          "tte %s, expected %.0fh", tte, true_tte_h);
+    CHECK(fabsf(s.forecast.slope_robust + leak_per_h) < 0.1f * leak_per_h, "robust slope %.1f",
+          s.forecast.slope_robust);
+}
+
+static void noise_only(void) {
+    mt_series_t s;
+    mt_series_init(&s, "free", "internal", MT_FALLING, 20000, PERIOD_S, WEEK);
+    uint32_t warned = 0;
+    for (uint32_t t = 0; t < 16 * DAY; t += PERIOD_S) {
+        mt_add(&s, t, 120000 + stress_noise(t));
+        warned += s.forecast.warning;
+    }
+    CHECK(warned == 0, "no leak, but warned on %lu points", (unsigned long)warned);
+    printf("noise only: slope %.1f/h robust %.1f/h noise %.0f, tte %s\n", s.forecast.slope_linear,
+           s.forecast.slope_robust, s.forecast.noise, s.forecast.tte_s == MT_NEVER ? "never" : "set");
+}
+
+static void pool_filling(void) {
+    // SMALL pool: 32 blocks, a block leaked every 6 hours
+    mt_series_t s;
+    mt_series_init(&s, "occupancy", "SMALL", MT_RISING, 32, 15, 2 * DAY);
+    uint32_t raised_at = 0;
+    for (uint32_t t = 0; t < 4 * DAY; t += 15) {
+        float used = 4 + rand() % 12 + t / (6 * 3600);
+        mt_add(&s, t, used);
+        if (raised_at == 0 && s.forecast.warning) {
+            raised_at = t;
+        }
+    }
+    // Mean use 9.5 + t/6h reaches 32 at 135 h; warned two days before
+    printf("pool filling: warned at %.0fh (expected ~87h), tte %.0fh at 96h\n",
+           raised_at / 3600.0f, s.forecast.tte_s / 3600.0f);
+    CHECK(raised_at > 0 && fabsf(raised_at / 3600.0f - 87) < 12, "pool warning at %.0fh",
+          raised_at / 3600.0f);
+}
+
+static void outliers(void) {
+    // One point a minute, a 40 KB dip in every tenth
+    mt_series_t s;
+    mt_series_init(&s, "largest", "internal", MT_FALLING, 4096, 60, WEEK);
+    for (uint32_t i = 0; i <= MT_POINTS / 2; i++) {
+        float v = 100000 - 10.0f * i - (i % 10 == 9 && i > MT_POINTS / 4 ? 40000 : 0);
+        mt_add(&s, i * 60, v);
+    }
+    mt_forecast_t f;
+    mt_fit(&s, &f);
+    printf("outliers: true -600/h, linear %.1f/h, robust %.1f/h\n", f.slope_linear, f.slope_robust);
+    CHECK(fabsf(f.slope_robust + 600) < 1 && fabsf(f.slope_robust + 600) < fabsf(f.slope_linear + 600),
+          "robust slope %.1f vs linear %.1f", f.slope_robust, f.slope_linear);
+
+    // Already under the limit but flat: tte 0, no trend to warn about
+    mt_series_init(&s, "largest", "internal", MT_FALLING, 4096, 3600, WEEK);
+    for (uint32_t i = 0; i < MT_MIN_POINTS + 1; i++) {
+        mt_add(&s, i * 3600, 3000);
+    }
+    mt_fit(&s, &f);
+    CHECK(f.tte_s == 0 && !f.warning, "at the limit: tte %lu, warning %d", (unsigned long)f.tte_s,
+          f.warning);
+
+    // Too little history: no forecast
+    mt_series_init(&s, "largest", "internal", MT_FALLING, 4096, 60, WEEK);
+    mt_add(&s, 0, 3000);
+    CHECK(!mt_fit(&s, &f) && !f.warning, "forecast from one sample");
+}
+
+int main(void) {
+    srand(96);
+    slow_leak();
+    noise_only();
+    pool_filling();
+    outliers();
+    printf("%s\n", failures ? "FAILURES" : "OK");
+    return failures != 0;
+}
@@ -0,0 +1,135 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include "esp_err.h"
+
+// ================ MEMORY TREND RECORDER ================
+// Remembers what the memory monitors print and forgets: a fixed-size
+// time series per metric, a trend fitted over it, and an early warning
+// with the estimated time until the metric reaches its limit.
+//
+//   static mt_series_t internal_free;
+//   mt_series_init(&internal_free, "free", "internal", MT_FALLING,
+//                  20000, 10, 7 * 24 * 3600);  // limit, s per point, horizon
+//   ...
+//   mt_record(&internal_free, heap_caps_get_free_size(MALLOC_CAP_INTERNAL));
+//
+// Samples are averaged into points of interval_s seconds (mean, min, max
+// kept). When all MT_POINTS are used, neighbouring points are merged in
+// pairs and the interval doubles, so a series always covers its whole
+// history - minutes after boot at full resolution, weeks later at one
+// point per few hours - in the same memory.
+//
+// Every closed point refits two trends over the series:
+//
+//   linear   least squares slope
+//   robust   repeated-median slope (Siegel) - a burst of allocations or
+//            a one-off spike doesn't move it
+//
+// and forecasts when the robust line crosses the limit (falling series:
+// free bytes, largest block, minimum-ever free; rising: pool occupancy).
+// The warning is raised when, with at least MT_MIN_SPAN_S of history,
+// both slopes head for the limit, the slope is well clear of the noise
+// around the line, the forecast doesn't reach more than MT_EXTRAPOLATE
+// spans of history ahead, and the crossing is within the warning
+// horizon - the slow leak or creeping fragmentation that takes days, not
+// the stress test that allocates and frees every few seconds. Sitting at
+// the limit without a trend is the low-memory check's business, not this
+// one's. The handler is called when the warning is raised and when it
+// clears.
+//
+// A series is fed and read from one task (the monitor); mt_report()
+// walks every recorded series.
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef MT_POINTS
+#define MT_POINTS           64      // Points kept per series (20 bytes each)
+#endif
+#define MT_MIN_POINTS       8       // Fewer: no forecast
+#define MT_MIN_SPAN_S       (6 * 3600)  // Less history: no warnings (boot-time churn)
+#define MT_EXTRAPOLATE      2       // Forecasts trusted up to this many spans ahead
+#define MT_SIGNIFICANCE     4.0f    // Slope must exceed this many standard errors
+#define MT_NEVER            UINT32_MAX
+
+typedef enum {
+    MT_FALLING,                     // Exhausted when the value drops to the limit
+    MT_RISING,                      // ... or climbs to it
+} mt_direction_t;
+
+typedef struct {
+    uint32_t t_s;                   // Mean sample time
+    uint32_t n;                     // Samples merged into it
+    float mean;
+    float min;
+    float max;
+} mt_point_t;
+
+typedef struct {
+    uint32_t points;
+    uint32_t span_s;                // Oldest to newest point
+    float level;                    // Robust line at the newest point
+    float slope_linear;             // Units per hour
+    float slope_robust;
+    float noise;                    // Median distance from the robust line
+    uint32_t tte_s;                 // Time to the limit, MT_NEVER = not heading there
+    bool warning;
+} mt_forecast_t;
+
+typedef struct mt_series {
+    const char *name;               // "free", "largest", "occupancy", ...
+    const char *region;             // "internal", "SMALL pool", ...
+    mt_direction_t direction;
+    float limit;
+    uint32_t warn_horizon_s;
+    struct mt_series *next;         // Registry, filled on first mt_record()
+    bool registered;
+
+    uint32_t interval_s;            // Current point width (doubles when full)
+    uint32_t open_start;            // Start of the point being filled
+    mt_point_t open;                // open.n == 0: none
+    mt_point_t points[MT_POINTS];
+    uint32_t count;
+    uint32_t samples;
+
+    mt_forecast_t forecast;         // As of the last closed point
+    uint32_t warnings;              // Times raised
+} mt_series_t;
+
+typedef void (*mt_warning_fn)(const mt_series_t *s, const mt_forecast_t *f, void *ctx);
+
+// ---- Portable core ----
+
+void mt_series_init(mt_series_t *s, const char *name, const char *region, mt_direction_t direction,
+                    float limit, uint32_t interval_s, uint32_t warn_horizon_s);
+
+// Adds a sample; returns true when it closed a point (and s->forecast
+// was refitted)
+bool mt_add(mt_series_t *s, uint32_t t_s, float value);
+
+// Fits the closed points plus the one being filled; false below
+// MT_MIN_POINTS (out still filled, without a forecast)
+bool mt_fit(const mt_series_t *s, mt_forecast_t *out);
+
+// "3d04h", "5h12m", "12m30s", "45s", "never"
+void mt_format_duration(uint32_t s, char *buf, size_t len);
+
+// ---- Device ----
+
+#ifdef ESP_PLATFORM
+// Timestamps with esp_timer; calls the warning handler on changes
+void mt_record(mt_series_t *s, float value);
+void mt_set_warning_handler(mt_warning_fn fn, void *ctx);
+
+// One line per recorded series
+void mt_report(FILE *out);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,194 @@
+#include <string.h>
+#include <math.h>
+#include "memtrend.h"
+
+// ================ RECORDING ================
+
+void mt_series_init(mt_series_t *s, const char *name, const char *region, mt_direction_t direction,
+                    float limit, uint32_t interval_s, uint32_t warn_horizon_s) {
+    memset(s, 0, sizeof(*s));
+    s->name = name;
+    s->region = region;
+    s->direction = direction;
+    s->limit = limit;
+    s->interval_s = interval_s > 0 ? interval_s : 1;
+    s->warn_horizon_s = warn_horizon_s;
+    s->forecast.tte_s = MT_NEVER;
+}
+
+// b follows a in time
+static void merge(mt_point_t *out, const mt_point_t *a, const mt_point_t *b) {
+    uint32_t n = a->n + b->n;
+    mt_point_t m = {
+        .t_s = a->t_s + (uint32_t)((uint64_t)(b->t_s - a->t_s) * b->n / n),
+        .n = n,
+        .mean = (a->mean * a->n + b->mean * b->n) / n,
+        .min = fminf(a->min, b->min),
+        .max = fmaxf(a->max, b->max),
+    };
+    *out = m;
+}
+
+static void close_point(mt_series_t *s) {
+    if (s->count == MT_POINTS) {
+        // Full: halve the resolution, keep the whole history
+        for (uint32_t i = 0; i < MT_POINTS / 2; i++) {
+            merge(&s->points[i], &s->points[2 * i], &s->points[2 * i + 1]);
+        }
+        s->count = MT_POINTS / 2;
+        s->interval_s *= 2;
+    }
+    s->points[s->count++] = s->open;
+    s->open.n = 0;
+}
+
+bool mt_add(mt_series_t *s, uint32_t t_s, float value) {
+    bool closed = false;
+    if (s->open.n > 0 && t_s - s->open_start >= s->interval_s) {
+        close_point(s);
+        closed = true;
+    }
+    mt_point_t *p = &s->open;
+    if (p->n == 0) {
+        s->open_start = t_s;
+        p->t_s = t_s;
+        p->mean = 0;
+        p->min = value;
+        p->max = value;
+    }
+    p->n++;
+    p->t_s += (uint32_t)(((uint64_t)(t_s - p->t_s)) / p->n);
+    p->mean += (value - p->mean) / p->n;
+    p->min = fminf(p->min, value);
+    p->max = fmaxf(p->max, value);
+    s->samples++;
+
+    if (closed) {
+        mt_fit(s, &s->forecast);
+    }
+    return closed;
+}
+
+// ================ TRENDS ================
+
+// Sorts a in place (n is at most MT_POINTS + 1)
+static float median(float *a, uint32_t n) {
+    for (uint32_t i = 1; i < n; i++) {
+        float v = a[i];
+        uint32_t j = i;
+        while (j > 0 && a[j - 1] > v) {
+            a[j] = a[j - 1];
+            j--;
+        }
+        a[j] = v;
+    }
+    return n % 2 ? a[n / 2] : (a[n / 2 - 1] + a[n / 2]) / 2;
+}
+
+bool mt_fit(const mt_series_t *s, mt_forecast_t *out) {
+    // Times in hours before the newest point, so floats keep precision
+    // however long the node has been up (about 1 KB of stack)
+    float t[MT_POINTS + 1], y[MT_POINTS + 1], scratch[MT_POINTS + 1], medians[MT_POINTS + 1];
+    uint32_t n = 0;
+    for (uint32_t i = 0; i < s->count; i++) {
+        y[n++] = s->points[i].mean;
+    }
+    if (s->open.n > 0) {
+        y[n++] = s->open.mean;
+    }
+    memset(out, 0, sizeof(*out));
+    out->points = n;
+    out->tte_s = MT_NEVER;
+    if (n == 0) {
+        return false;
+    }
+
+    const mt_point_t *newest = s->open.n > 0 ? &s->open : &s->points[s->count - 1];
+    const mt_point_t *oldest = s->count > 0 ? &s->points[0] : &s->open;
+    for (uint32_t i = 0; i < n; i++) {
+        const mt_point_t *p = i < s->count ? &s->points[i] : &s->open;
+        t[i] = -(float)(newest->t_s - p->t_s) / 3600.0f;
+    }
+
+    out->span_s = newest->t_s - oldest->t_s;
+    out->level = newest->mean;
+    if (n < MT_MIN_POINTS) {
+        return false;
+    }
+
+    // Least squares
+    float tm = 0, ym = 0;
+    for (uint32_t i = 0; i < n; i++) {
+        tm += t[i];
+        ym += y[i];
+    }
+    tm /= n;
+    ym /= n;
+    float sxy = 0, sxx = 0;
+    for (uint32_t i = 0; i < n; i++) {
+        sxy += (t[i] - tm) * (y[i] - ym);
+        sxx += (t[i] - tm) * (t[i] - tm);
+    }
+    out->slope_linear = sxx > 0 ? sxy / sxx : 0;
+
+    // Repeated median: per point the median slope to every other point,
+    // then the median of those
+    uint32_t m = 0;
+    for (uint32_t i = 0; i < n; i++) {
+        uint32_t k = 0;
+        for (uint32_t j = 0; j < n; j++) {
+            if (j != i && t[j] != t[i]) {
+                scratch[k++] = (y[j] - y[i]) / (t[j] - t[i]);
+            }
+        }
+        if (k > 0) {
+            medians[m++] = median(scratch, k);
+        }
+    }
+    float slope = m > 0 ? median(medians, m) : 0;
+    out->slope_robust = slope;
+
+    // Level at the newest point (t = 0) and the spread around the line
+    for (uint32_t i = 0; i < n; i++) {
+        scratch[i] = y[i] - slope * t[i];
+    }
+    out->level = median(scratch, n);
+    for (uint32_t i = 0; i < n; i++) {
+        scratch[i] = fabsf(y[i] - (out->level + slope * t[i]));
+    }
+    out->noise = median(scratch, n);
+
+    // Forecast along the robust line
+    float toward = s->direction == MT_FALLING ? -1.0f : 1.0f;
+    float distance = (s->limit - out->level) * toward;
+    bool heading = slope * toward > 0 && out->slope_linear * toward > 0;
+    if (distance <= 0) {
+        out->tte_s = 0;     // Already there (warned only if still heading further)
+    } else if (heading) {
+        float hours = distance / fabsf(slope);
+        out->tte_s = hours * 3600.0f < (float)(MT_NEVER - 1) ? (uint32_t)(hours * 3600.0f) : MT_NEVER - 1;
+    }
+    // Believed only with enough history, when the slope stands out of
+    // the noise (robust standard error from the residuals) and the line
+    // isn't stretched far past the history it was fitted on
+    float stderr_slope = sxx > 0 ? 1.4826f * out->noise / sqrtf(sxx) : INFINITY;
+    bool trusted = out->span_s >= MT_MIN_SPAN_S &&
+                   fabsf(slope) > MT_SIGNIFICANCE * stderr_slope &&
+                   out->tte_s / MT_EXTRAPOLATE <= out->span_s;
+    out->warning = heading && trusted && out->tte_s <= s->warn_horizon_s;
+    return true;
+}
+
+void mt_format_duration(uint32_t s, char *buf, size_t len) {
+    if (s == MT_NEVER) {
+        snprintf(buf, len, "never");
+    } else if (s >= 86400) {
+        snprintf(buf, len, "%lud%02luh", (unsigned long)(s / 86400), (unsigned long)(s % 86400 / 3600));
+    } else if (s >= 3600) {
+        snprintf(buf, len, "%luh%02lum", (unsigned long)(s / 3600), (unsigned long)(s % 3600 / 60));
+    } else if (s >= 60) {
+        snprintf(buf, len, "%lum%02lus", (unsigned long)(s / 60), (unsigned long)(s % 60));
+    } else {
+        snprintf(buf, len, "%lus", (unsigned long)s);
+    }
+}
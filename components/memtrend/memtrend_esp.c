@@ -0,0 +1,55 @@
+#ifdef ESP_PLATFORM
+
+#include <inttypes.h>
+#include "memtrend.h"
+#include "freertos/FreeRTOS.h"
+#include "esp_timer.h"
+
+// ================ DEVICE ================
+
+static mt_series_t *registry;
+static portMUX_TYPE registry_lock = portMUX_INITIALIZER_UNLOCKED;
+static mt_warning_fn warning_handler;
+static void *warning_ctx;
+
+void mt_set_warning_handler(mt_warning_fn fn, void *ctx) {
+    warning_ctx = ctx;
+    warning_handler = fn;
+}
+
+void mt_record(mt_series_t *s, float value) {
+    if (!s->registered) {
+        taskENTER_CRITICAL(&registry_lock);
+        s->next = registry;
+        registry = s;
+        s->registered = true;
+        taskEXIT_CRITICAL(&registry_lock);
+    }
+
+    bool was_warning = s->forecast.warning;
+    uint32_t now_s = (uint32_t)(esp_timer_get_time() / 1000000);
+    if (mt_add(s, now_s, value) && s->forecast.warning != was_warning) {
+        if (s->forecast.warning) {
+            s->warnings++;
+        }
+        mt_warning_fn fn = warning_handler;
+        if (fn != NULL) {
+            fn(s, &s->forecast, warning_ctx);
+        }
+    }
+}
+
+void mt_report(FILE *out) {
+    for (mt_series_t *s = registry; s != NULL; s = s->next) {
+        const mt_forecast_t *f = &s->forecast;
+        char span[16], tte[16];
+        mt_format_duration(f->span_s, span, sizeof(span));
+        mt_format_duration(f->tte_s, tte, sizeof(tte));
+        fprintf(out, "memtrend %s/%s level=%.0f linear=%+.1f/h robust=%+.1f/h noise=%.0f "
+                     "span=%s pts=%" PRIu32 " every=%" PRIu32 "s limit=%.0f tte=%s%s\n",
+                s->region, s->name, f->level, f->slope_linear, f->slope_robust, f->noise,
+                span, f->points, s->interval_s, s->limit, tte, f->warning ? " WARN" : "");
+    }
+}
+
+#endif // ESP_PLATFORM
@@ -0,0 +1,164 @@
+// Host check for the message codec: wire sizes against the original
+// padded structs, round-trips, a streamed batch, malformed input and
+// encode/decode speed.
+//
+// Build and run from this directory:
+//   cc -O2 -I../include -I../../../tools/host_include ../msgcodec.c ../lab_messages.c
+//      msgcodec_bench.c -o msgcodec_bench
+//   ./msgcodec_bench
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "lab_messages.h"
+
+// Layouts the labs used to put on their queues
+typedef struct { char source[20]; char message[100]; int priority; } old_network_message_t;
+typedef struct { int producer_id; int product_id; char product_name[30];
+                 uint32_t production_time; int processing_time_ms; } old_product_t;
+typedef struct { uint32_t workflow_id; char description[32]; uint32_t priority;
+                 uint32_t estimated_duration; bool requires_approval; } old_workflow_item_t;
+
+static int failures;
+
+#define CHECK(cond, what) do { if (!(cond)) { printf("  FAIL: %s\n", what); failures++; } } while (0)
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static void make_network(network_msg_t *m, uint32_t i) {
+    *m = (network_msg_t){
+        .source = network_sources.strings[i % network_sources.count],
+        .message = network_texts.strings[(i * 7) % network_texts.count],
+        .priority = 1 + i % 5,
+    };
+}
+
+static void make_product(product_msg_t *m, uint32_t i) {
+    *m = (product_msg_t){
+        .producer_id = 1 + i % 3,
+        .product_id = i,
+        .production_time = 1000 + i * 150,
+        .processing_time_ms = 500 + (i * 37) % 2000,
+    };
+}
+
+static void make_workflow(workflow_msg_t *m, uint32_t i) {
+    *m = (workflow_msg_t){
+        .workflow_id = i + 1,
+        .description = workflow_types.strings[i % workflow_types.count],
+        .priority = 1 + i % 5,
+        .estimated_duration = 2000 + (i * 113) % 4000,
+    };
+    if (i % 5 < 2) {
+        m->requires_approval = true;
+        MC_SET(workflow_msg, m, requires_approval);
+    }
+}
+
+static void report_sizes(const char *name, size_t old_size, size_t wire_max, size_t total, uint32_t n) {
+    double avg = (double)total / n;
+    printf("%-13s struct %3zu B -> wire avg %4.1f B (max %2zu, queue item %2zu B)  %.1fx smaller\n",
+           name, old_size, avg, wire_max, wire_max + 1, old_size / avg);
+}
+
+#define ROUND_TRIP(T, make, old_type, N)                                        \
+    do {                                                                        \
+        size_t total = 0;                                                       \
+        for (uint32_t i = 0; i < (N); i++) {                                    \
+            T##_t in, out;                                                      \
+            T##_wire_t wire;                                                    \
+            make(&in, i);                                                       \
+            T##_pack(&in, &wire);                                               \
+            CHECK(wire.len > 0, #T " encode");                                  \
+            CHECK(T##_unpack(&wire, &out) == ESP_OK, #T " decode");             \
+            CHECK(memcmp(&in, &out, sizeof(in)) == 0, #T " round-trip");        \
+            total += wire.len;                                                  \
+        }                                                                       \
+        report_sizes(#T, sizeof(old_type), T##_WIRE_MAX, total, (N));           \
+    } while (0)
+
+#define TIME_CODEC(T, make, N)                                                  \
+    do {                                                                        \
+        static T##_wire_t wires[N];                                             \
+        T##_t msg;                                                              \
+        uint32_t sink = 0;                                                      \
+        double t0 = now_ns();                                                   \
+        for (uint32_t i = 0; i < (N); i++) {                                    \
+            make(&msg, i);                                                      \
+            T##_pack(&msg, &wires[i]);                                          \
+        }                                                                       \
+        double t1 = now_ns();                                                   \
+        for (uint32_t i = 0; i < (N); i++) {                                    \
+            T##_unpack(&wires[i], &msg);                                        \
+            sink += msg.has + wires[i].len;                                     \
+        }                                                                       \
+        double t2 = now_ns();                                                   \
+        printf("%-13s encode %5.1f ns/msg, decode %5.1f ns/msg (%u)\n",         \
+               #T, (t1 - t0) / (N), (t2 - t1) / (N), sink & 1);                 \
+    } while (0)
+
+int main(void) {
+    printf("== Wire size ==\n");
+    ROUND_TRIP(network_msg, make_network, old_network_message_t, 1000);
+    ROUND_TRIP(product_msg, make_product, old_product_t, 1000);
+    ROUND_TRIP(workflow_msg, make_workflow, old_workflow_item_t, 1000);
+
+    // Several messages back to back through one cursor, no framing needed
+    printf("\n== Streaming cursor ==\n");
+    uint8_t stream[256];
+    mc_writer_t w;
+    mc_writer_init(&w, stream, sizeof(stream));
+    for (uint32_t i = 0; i < 10; i++) {
+        network_msg_t n;
+        workflow_msg_t f;
+        make_network(&n, i);
+        make_workflow(&f, i);
+        network_msg_write(&w, &n);
+        workflow_msg_write(&w, &f);
+    }
+    size_t stream_len = mc_writer_done(&w);
+    printf("20 mixed messages in %zu bytes\n", stream_len);
+
+    mc_reader_t r;
+    mc_reader_init(&r, stream, stream_len);
+    for (uint32_t i = 0; i < 10; i++) {
+        network_msg_t n, n_ref;
+        workflow_msg_t f, f_ref;
+        make_network(&n_ref, i);
+        make_workflow(&f_ref, i);
+        network_msg_read(&r, &n);
+        workflow_msg_read(&r, &f);
+        CHECK(memcmp(&n, &n_ref, sizeof(n)) == 0 && memcmp(&f, &f_ref, sizeof(f)) == 0,
+              "stream round-trip");
+    }
+    CHECK(mc_reader_at_end(&r), "stream fully consumed");
+
+    printf("\n== Malformed input ==\n");
+    network_msg_t n;
+    product_msg_t p;
+    uint8_t truncated[] = { 0x01, 0x02 };
+    uint8_t bad_sym[] = { 0x09, 0x01, 0x01 };
+    uint8_t long_varint[] = { 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x01, 0x00, 0x00, 0x00 };
+    uint8_t trailing[] = { 0x01, 0x01, 0x01, 0x00 };
+    CHECK(network_msg_decode(truncated, sizeof(truncated), &n) != ESP_OK, "truncated rejected");
+    CHECK(network_msg_decode(bad_sym, sizeof(bad_sym), &n) != ESP_OK, "unknown symbol rejected");
+    CHECK(product_msg_decode(long_varint, sizeof(long_varint), &p) != ESP_OK, "u32 overflow rejected");
+    CHECK(network_msg_decode(trailing, sizeof(trailing), &n) != ESP_OK, "trailing bytes rejected");
+
+    network_msg_t unknown = { .source = "Zigbee", .message = network_texts.strings[0] };
+    uint8_t buf[network_msg_WIRE_MAX];
+    CHECK(network_msg_encode(&unknown, buf, sizeof(buf)) == 0, "non-interned symbol refused");
+    printf("%s\n", failures ? "FAILED" : "all rejected");
+
+    printf("\n== Speed ==\n");
+    TIME_CODEC(network_msg, make_network, 100000);
+    TIME_CODEC(product_msg, make_product, 100000);
+    TIME_CODEC(workflow_msg, make_workflow, 100000);
+
+    printf("\n%s\n", failures ? "FAILURES" : "OK");
+    return failures != 0;
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include "msgcodec.h"
+
+// ================ LAB MESSAGE SCHEMAS ================
+// Field order is the wire order: append new fields at the end (as OPT so
+// old senders stay decodable) and never reorder or change a kind.
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// 03-queues/lab3: network events
+extern const mc_strtab_t network_sources;
+extern const mc_strtab_t network_texts;
+
+#define NETWORK_MSG_FIELDS(X, T)                    \
+    X(T, SYM,  source,   REQ, &network_sources)     \
+    X(T, SYM,  message,  REQ, &network_texts)       \
+    X(T, U32,  priority, REQ, 0)
+MC_DECLARE_MESSAGE(network_msg, NETWORK_MSG_FIELDS)
+
+// 03-queues/lab2: products (the display name is derived, not carried)
+#define PRODUCT_NAME_FMT    "Product-P%lu-#%lu"
+
+#define PRODUCT_MSG_FIELDS(X, T)                    \
+    X(T, U32,  producer_id,        REQ, 0)          \
+    X(T, U32,  product_id,         REQ, 0)          \
+    X(T, U32,  production_time,    REQ, 0)          \
+    X(T, U32,  processing_time_ms, REQ, 0)          \
+    X(T, U64,  intended_at,        OPT, 0)  /* loadgen schedule time (ts_t) */
+MC_DECLARE_MESSAGE(product_msg, PRODUCT_MSG_FIELDS)
+
+// 06-event-groups/lab2: workflow requests
+extern const mc_strtab_t workflow_types;
+
+#define WORKFLOW_MSG_FIELDS(X, T)                   \
+    X(T, U32,  workflow_id,        REQ, 0)          \
+    X(T, SYM,  description,        REQ, &workflow_types) \
+    X(T, U32,  priority,           REQ, 0)          \
+    X(T, U32,  estimated_duration, REQ, 0)          \
+    X(T, BOOL, requires_approval,  OPT, 0)          \
+    X(T, U32,  retries,            OPT, 0)  /* quality-check retries so far */
+MC_DECLARE_MESSAGE(workflow_msg, WORKFLOW_MSG_FIELDS)
+
+#ifdef __cplusplus
+}
+#endif
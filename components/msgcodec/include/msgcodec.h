@@ -0,0 +1,227 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <string.h>
+#include "esp_err.h"
+
+// ================ MESSAGE CODEC ================
+// Compact binary encoding for inter-task and uplink messages, driven by a
+// field list (X-macro) per message. From one list the macros generate the
+// decoded struct, a fixed-size wire buffer type for queues, and
+// encode/decode functions over a streaming cursor. No heap.
+//
+// Wire format of a message:
+//   varint presence mask (only if the message has OPT fields), then each
+//   field in order
+//   U32/U64/BOOL  unsigned LEB128 varint
+//   S32           zigzag varint
+//   F32           4 bytes little endian
+//   SYM           varint index+1 into an interned string table (0 = NULL)
+//   STR           varint length + bytes (no NUL)
+// Optional fields are only on the wire when their bit is set in 'has'.
+//
+// Declaring a message (see lab_messages.h):
+//
+//   #define PING_FIELDS(X, T)  (one X(...) per line, each line continued)
+//       X(T, U32, seq,    REQ, 0)
+//       X(T, SYM, origin, REQ, &ping_origins)
+//       X(T, STR, note,   OPT, 24)
+//   MC_DECLARE_MESSAGE(ping, PING_FIELDS)      // in a header
+//   MC_DEFINE_MESSAGE(ping, PING_FIELDS)       // in one .c file
+//
+// which provides ping_t, ping_wire_t, ping_WIRE_MAX, ping_write/read
+// (cursor), ping_encode/decode (buffer) and ping_pack/unpack (wire_t).
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// ---- Interned string tables ----
+
+typedef struct {
+    const char *const *strings;
+    uint8_t count;
+} mc_strtab_t;
+
+#define MC_STRTAB_DEFINE(name, ...)                                             \
+    static const char *const name##_strings[] = { __VA_ARGS__ };                \
+    _Static_assert(sizeof(name##_strings) / sizeof(name##_strings[0]) < 127,    \
+                   "SYM ids are encoded in one byte");                          \
+    const mc_strtab_t name = {                                                  \
+        name##_strings, sizeof(name##_strings) / sizeof(name##_strings[0]) }
+
+// ---- Cursors (errors are sticky; check once at the end) ----
+
+typedef struct {
+    uint8_t *buf;
+    size_t cap;
+    size_t pos;
+    bool overflow;
+} mc_writer_t;
+
+typedef struct {
+    const uint8_t *buf;
+    size_t len;
+    size_t pos;
+    bool error;
+} mc_reader_t;
+
+static inline void mc_writer_init(mc_writer_t *w, uint8_t *buf, size_t cap) {
+    *w = (mc_writer_t){ .buf = buf, .cap = cap };
+}
+
+static inline void mc_reader_init(mc_reader_t *r, const uint8_t *buf, size_t len) {
+    *r = (mc_reader_t){ .buf = buf, .len = len };
+}
+
+// Bytes written so far, or 0 if anything did not fit
+static inline size_t mc_writer_done(const mc_writer_t *w) {
+    return w->overflow ? 0 : w->pos;
+}
+
+static inline bool mc_reader_at_end(const mc_reader_t *r) {
+    return !r->error && r->pos == r->len;
+}
+
+void mc_put_uvarint(mc_writer_t *w, uint64_t v);
+void mc_put_f32(mc_writer_t *w, float v);
+void mc_put_str(mc_writer_t *w, const char *s, size_t cap);
+void mc_put_sym(mc_writer_t *w, const char *s, const mc_strtab_t *tab);
+
+static inline void mc_put_svarint(mc_writer_t *w, int32_t v) {
+    mc_put_uvarint(w, ((uint32_t)v << 1) ^ (uint32_t)(v >> 31));
+}
+
+uint64_t mc_get_uvarint(mc_reader_t *r);
+uint32_t mc_get_u32(mc_reader_t *r);
+float mc_get_f32(mc_reader_t *r);
+void mc_get_str(mc_reader_t *r, char *dst, size_t cap);
+const char *mc_get_sym(mc_reader_t *r, const mc_strtab_t *tab);
+
+static inline int32_t mc_get_svarint(mc_reader_t *r) {
+    uint32_t v = mc_get_u32(r);
+    return (int32_t)(v >> 1) ^ -(int32_t)(v & 1);
+}
+
+// ---- Field kinds: member, worst-case size, encode, decode ----
+
+#define MC_VARINT_MAX(n)    ((n) < 0x80 ? 1 : (n) < 0x4000 ? 2 : (n) < 0x200000 ? 3 : 5)
+
+#define MC_MEMBER_U32(name, arg)    uint32_t name;
+#define MC_MEMBER_S32(name, arg)    int32_t name;
+#define MC_MEMBER_U64(name, arg)    uint64_t name;
+#define MC_MEMBER_F32(name, arg)    float name;
+#define MC_MEMBER_BOOL(name, arg)   bool name;
+#define MC_MEMBER_SYM(name, arg)    const char *name;
+#define MC_MEMBER_STR(name, arg)    char name[arg];
+
+#define MC_MAX_U32(arg)     5
+#define MC_MAX_S32(arg)     5
+#define MC_MAX_U64(arg)     10
+#define MC_MAX_F32(arg)     4
+#define MC_MAX_BOOL(arg)    1
+#define MC_MAX_SYM(arg)     1
+#define MC_MAX_STR(arg)     (MC_VARINT_MAX(arg) + (arg) - 1)
+
+#define MC_ENC_U32(w, v, arg)   mc_put_uvarint((w), (v))
+#define MC_ENC_S32(w, v, arg)   mc_put_svarint((w), (v))
+#define MC_ENC_U64(w, v, arg)   mc_put_uvarint((w), (v))
+#define MC_ENC_F32(w, v, arg)   mc_put_f32((w), (v))
+#define MC_ENC_BOOL(w, v, arg)  mc_put_uvarint((w), (v) ? 1 : 0)
+#define MC_ENC_SYM(w, v, arg)   mc_put_sym((w), (v), (arg))
+#define MC_ENC_STR(w, v, arg)   mc_put_str((w), (v), (arg))
+
+#define MC_DEC_U32(r, v, arg)   (v) = mc_get_u32(r)
+#define MC_DEC_S32(r, v, arg)   (v) = mc_get_svarint(r)
+#define MC_DEC_U64(r, v, arg)   (v) = mc_get_uvarint(r)
+#define MC_DEC_F32(r, v, arg)   (v) = mc_get_f32(r)
+#define MC_DEC_BOOL(r, v, arg)  (v) = mc_get_u32(r) != 0
+#define MC_DEC_SYM(r, v, arg)   (v) = mc_get_sym((r), (arg))
+#define MC_DEC_STR(r, v, arg)   mc_get_str((r), (v), (arg))
+
+#define MC_IS_OPT_REQ   0
+#define MC_IS_OPT_OPT   1
+
+// ---- X-macro expanders ----
+
+#define MC_X_MEMBER(T, kind, name, opt, arg)    MC_MEMBER_##kind(name, arg)
+#define MC_X_INDEX(T, kind, name, opt, arg)     T##_F_##name,
+#define MC_X_OPTMASK(T, kind, name, opt, arg)   | (MC_IS_OPT_##opt << T##_F_##name)
+#define MC_X_MAX(T, kind, name, opt, arg)       + MC_MAX_##kind(arg)
+
+#define MC_X_ENCODE(T, kind, name, opt, arg)                         \
+    if (!MC_IS_OPT_##opt || (m->has & (1u << T##_F_##name))) {       \
+        MC_ENC_##kind(w, m->name, arg);                              \
+    }
+
+#define MC_X_DECODE(T, kind, name, opt, arg)                         \
+    if (!MC_IS_OPT_##opt || (m->has & (1u << T##_F_##name))) {       \
+        MC_DEC_##kind(r, m->name, arg);                              \
+    }
+
+// Set / test an optional field
+#define MC_SET(T, m, name)  ((m)->has |= 1u << T##_F_##name)
+#define MC_HAS(T, m, name)  (((m)->has >> T##_F_##name) & 1u)
+
+#define MC_DECLARE_MESSAGE(T, FIELDS)                                           \
+    typedef struct {                                                            \
+        uint32_t has;       /* Presence bits of OPT fields */                   \
+        FIELDS(MC_X_MEMBER, T)                                                  \
+    } T##_t;                                                                    \
+    enum { FIELDS(MC_X_INDEX, T) T##_FIELD_COUNT };                             \
+    enum { T##_OPT_MASK = 0 FIELDS(MC_X_OPTMASK, T) };                          \
+    enum { T##_WIRE_MAX = (T##_OPT_MASK ? MC_VARINT_MAX(T##_OPT_MASK) : 0)     \
+                          FIELDS(MC_X_MAX, T) };                                \
+    typedef struct {                                                            \
+        uint8_t len;                                                            \
+        uint8_t data[T##_WIRE_MAX];                                             \
+    } T##_wire_t;                                                               \
+    void T##_write(mc_writer_t *w, const T##_t *m);                             \
+    void T##_read(mc_reader_t *r, T##_t *m);                                    \
+    size_t T##_encode(const T##_t *m, uint8_t *buf, size_t cap);                \
+    esp_err_t T##_decode(const uint8_t *buf, size_t len, T##_t *m);             \
+    static inline void T##_pack(const T##_t *m, T##_wire_t *out) {              \
+        out->len = (uint8_t)T##_encode(m, out->data, sizeof(out->data));        \
+    }                                                                           \
+    static inline esp_err_t T##_unpack(const T##_wire_t *in, T##_t *m) {        \
+        return T##_decode(in->data, in->len, m);                                \
+    }
+
+#define MC_DEFINE_MESSAGE(T, FIELDS)                                            \
+    _Static_assert(T##_FIELD_COUNT <= 31, "presence mask is 32-bit");           \
+    _Static_assert(T##_WIRE_MAX <= 255, "wire_t length is one byte");           \
+    void T##_write(mc_writer_t *w, const T##_t *m) {                            \
+        if (T##_OPT_MASK) {                                                     \
+            mc_put_uvarint(w, m->has & T##_OPT_MASK);                           \
+        }                                                                       \
+        FIELDS(MC_X_ENCODE, T)                                                  \
+    }                                                                           \
+    void T##_read(mc_reader_t *r, T##_t *m) {                                   \
+        memset(m, 0, sizeof(*m));                                               \
+        if (T##_OPT_MASK) {                                                     \
+            m->has = mc_get_u32(r);                                             \
+            if (m->has & ~(uint32_t)T##_OPT_MASK) {                             \
+                r->error = true;                                                \
+                return;                                                         \
+            }                                                                   \
+        }                                                                       \
+        FIELDS(MC_X_DECODE, T)                                                  \
+    }                                                                           \
+    size_t T##_encode(const T##_t *m, uint8_t *buf, size_t cap) {               \
+        mc_writer_t w;                                                          \
+        mc_writer_init(&w, buf, cap);                                           \
+        T##_write(&w, m);                                                       \
+        return mc_writer_done(&w);                                              \
+    }                                                                           \
+    esp_err_t T##_decode(const uint8_t *buf, size_t len, T##_t *m) {            \
+        mc_reader_t r;                                                          \
+        mc_reader_init(&r, buf, len);                                           \
+        T##_read(&r, m);                                                        \
+        return mc_reader_at_end(&r) ? ESP_OK : ESP_ERR_INVALID_RESPONSE;        \
+    }
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,23 @@
+#include "lab_messages.h"
+
+// ================ STRING TABLES ================
+// Indices are part of the wire format: only append.
+
+MC_STRTAB_DEFINE(network_sources, "WiFi", "Bluetooth", "LoRa", "Ethernet");
+
+MC_STRTAB_DEFINE(network_texts,
+    "Status update received",
+    "Configuration changed",
+    "Alert notification",
+    "Data synchronization",
+    "Heartbeat signal");
+
+MC_STRTAB_DEFINE(workflow_types,
+    "Data Processing", "Report Generation", "System Backup",
+    "Quality Analysis", "Performance Test", "Security Scan");
+
+// ================ GENERATED CODECS ================
+
+MC_DEFINE_MESSAGE(network_msg, NETWORK_MSG_FIELDS)
+MC_DEFINE_MESSAGE(product_msg, PRODUCT_MSG_FIELDS)
+MC_DEFINE_MESSAGE(workflow_msg, WORKFLOW_MSG_FIELDS)
@@ -0,0 +1,121 @@
+#include "msgcodec.h"
+
+// ================ WRITER ================
+
+static inline bool reserve(mc_writer_t *w, size_t n) {
+    if (w->overflow || w->cap - w->pos < n) {
+        w->overflow = true;
+        return false;
+    }
+    return true;
+}
+
+void mc_put_uvarint(mc_writer_t *w, uint64_t v) {
+    uint8_t tmp[10];
+    size_t n = 0;
+    while (v >= 0x80) {
+        tmp[n++] = (uint8_t)(v | 0x80);
+        v >>= 7;
+    }
+    tmp[n++] = (uint8_t)v;
+
+    if (reserve(w, n)) {
+        memcpy(w->buf + w->pos, tmp, n);
+        w->pos += n;
+    }
+}
+
+void mc_put_f32(mc_writer_t *w, float v) {
+    if (reserve(w, sizeof(v))) {
+        memcpy(w->buf + w->pos, &v, sizeof(v));     // Little endian targets only
+        w->pos += sizeof(v);
+    }
+}
+
+void mc_put_str(mc_writer_t *w, const char *s, size_t cap) {
+    // Leave room for the NUL the decoder adds
+    size_t len = strnlen(s, cap - 1);
+    mc_put_uvarint(w, len);
+    if (reserve(w, len)) {
+        memcpy(w->buf + w->pos, s, len);
+        w->pos += len;
+    }
+}
+
+void mc_put_sym(mc_writer_t *w, const char *s, const mc_strtab_t *tab) {
+    if (s == NULL) {
+        mc_put_uvarint(w, 0);
+        return;
+    }
+    for (uint8_t i = 0; i < tab->count; i++) {
+        // Pointer match first: callers usually pass the table entry itself
+        if (tab->strings[i] == s || strcmp(tab->strings[i], s) == 0) {
+            mc_put_uvarint(w, i + 1u);
+            return;
+        }
+    }
+    w->overflow = true;     // Not interned - a schema/table mismatch
+}
+
+// ================ READER ================
+
+uint64_t mc_get_uvarint(mc_reader_t *r) {
+    uint64_t v = 0;
+    for (unsigned shift = 0; shift < 64; shift += 7) {
+        if (r->error || r->pos >= r->len) {
+            r->error = true;
+            return 0;
+        }
+        uint8_t b = r->buf[r->pos++];
+        v |= (uint64_t)(b & 0x7F) << shift;
+        if (!(b & 0x80)) {
+            return v;
+        }
+    }
+    r->error = true;
+    return 0;
+}
+
+uint32_t mc_get_u32(mc_reader_t *r) {
+    uint64_t v = mc_get_uvarint(r);
+    if (v > UINT32_MAX) {
+        r->error = true;
+        return 0;
+    }
+    return (uint32_t)v;
+}
+
+float mc_get_f32(mc_reader_t *r) {
+    float v = 0.0f;
+    if (r->error || r->len - r->pos < sizeof(v)) {
+        r->error = true;
+        return v;
+    }
+    memcpy(&v, r->buf + r->pos, sizeof(v));
+    r->pos += sizeof(v);
+    return v;
+}
+
+void mc_get_str(mc_reader_t *r, char *dst, size_t cap) {
+    uint32_t len = mc_get_u32(r);
+    if (r->error || len >= cap || r->len - r->pos < len) {
+        r->error = true;
+        dst[0] = '\0';
+        return;
+    }
+    memcpy(dst, r->buf + r->pos, len);
+    dst[len] = '\0';
+    r->pos += len;
+}
+
+const char *mc_get_sym(mc_reader_t *r, const mc_strtab_t *tab) {
+    uint32_t id = mc_get_u32(r);
+    if (id == 0) {
+        return NULL;
+    }
+    if (id > tab->count) {
+        r->error = true;
+        return NULL;
+    }
+    return tab->strings[id - 1];
+}
@@ -0,0 +1,200 @@
+// Host check for the profiler pipeline: SIGPROF stands in for the
+// sampling timer, the interrupted RIP and a frame-pointer walk stand in
+// for the Xtensa frame, and two fake "tasks" run known workloads. The
+// report lands in a log that tools/pcprof/pcprof.py can symbolize
+// against this binary, and the measured phase times say what the
+// profile should show. x86-64 Linux only.
+//
+// Build and run from this directory (-no-pie keeps addresses = ELF):
+//   cc -O2 -g -fno-omit-frame-pointer -no-pie -I../include -I../../../tools/host_include
+//      ../pcprof.c pcprof_host_bench.c -o pcprof_bench
+//   ./pcprof_bench pcprof_host.log
+//   python3 ../../../tools/pcprof/pcprof.py --elf pcprof_bench pcprof_host.log
+//   python3 ../../../tools/pcprof/pcprof.py --elf pcprof_bench --folded pcprof_host.log
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <time.h>
+#include <ucontext.h>
+#include <sys/time.h>
+#include "pcprof.h"
+
+#define SAMPLE_HZ       1000        // Requested; ITIMER_PROF rounds to the kernel tick
+#define RUN_SECONDS     3.0
+#define REPORT_EVERY    1.0         // Seconds between report blocks
+
+#define TASK_CTRL       ((uintptr_t)0x100)
+#define TASK_PATTERN    ((uintptr_t)0x200)
+
+static pcprof_ring_t ring;
+static pcprof_table_t table;
+static volatile uintptr_t current_task;
+static uintptr_t stack_top;
+static volatile float sink;
+
+// ================ SAMPLING (SIGPROF) ================
+
+static void on_sigprof(int sig, siginfo_t *info, void *ctx_ptr) {
+    (void)sig;
+    (void)info;
+    const ucontext_t *uc = (const ucontext_t *)ctx_ptr;
+    pcprof_sample_t *s = pcprof_ring_claim(&ring);
+    if (s == NULL) {
+        return;
+    }
+
+    uintptr_t sp = (uintptr_t)uc->uc_mcontext.gregs[REG_RSP];
+    uintptr_t fp = (uintptr_t)uc->uc_mcontext.gregs[REG_RBP];
+    s->task = current_task;
+    s->core = 0;
+    s->depth = 0;
+    s->pc[s->depth++] = (uintptr_t)uc->uc_mcontext.gregs[REG_RIP];
+
+    // [fp] = caller's fp, [fp + 8] = return address; stay inside the stack
+    while (s->depth < PCPROF_MAX_DEPTH && fp >= sp && fp < stack_top && (fp & 7) == 0) {
+        uintptr_t ret = ((uintptr_t *)fp)[1];
+        if (ret == 0) {
+            break;
+        }
+        s->pc[s->depth++] = ret - 1;    // Point into the call instruction
+        uintptr_t next = ((uintptr_t *)fp)[0];
+        if (next <= fp) {
+            break;
+        }
+        fp = next;
+    }
+    pcprof_ring_commit(&ring);
+}
+
+static void name_of(uintptr_t task, char *name, size_t len) {
+    snprintf(name, len, "%s", task == TASK_CTRL ? "Ctrl_1kHz" :
+                              task == TASK_PATTERN ? "PatternEngine" : "main");
+}
+
+// ================ WORKLOADS ================
+
+__attribute__((noinline)) static float fir_filter(const float *x, int n) {
+    static const float taps[16] = { 0.01f, 0.02f, 0.04f, 0.07f, 0.1f, 0.12f, 0.14f, 0.15f,
+                                    0.15f, 0.14f, 0.12f, 0.1f, 0.07f, 0.04f, 0.02f, 0.01f };
+    float acc = 0;
+    for (int i = 0; i + 16 <= n; i++) {
+        for (int k = 0; k < 16; k++) {
+            acc += x[i + k] * taps[k];
+        }
+    }
+    return acc;
+}
+
+__attribute__((noinline)) static float pid_update(float err) {
+    static float integ, prev;
+    float out = 0;
+    for (int i = 0; i < 200; i++) {
+        integ += err * 0.001f;
+        out = 1.2f * err + 0.5f * integ + 0.05f * (err - prev) - out * out * 1e-6f;
+        prev = err;
+    }
+    return out;
+}
+
+// Ctrl: mostly filtering, some PID
+__attribute__((noinline)) static void control_step(const float *x) {
+    sink = pid_update(fir_filter(x, 512));
+}
+
+__attribute__((noinline)) static uint32_t score_window(const uint8_t *events, int n, uint32_t pattern) {
+    uint32_t best = 0;
+    for (int i = 0; i + 4 <= n; i++) {
+        uint32_t w = (uint32_t)events[i] | events[i + 1] << 8 | events[i + 2] << 16 | (uint32_t)events[i + 3] << 24;
+        uint32_t s = 0;
+        for (uint32_t m = ~(w ^ pattern); m; m &= m - 1) s++;
+        best = s > best ? s : best;
+    }
+    return best;
+}
+
+__attribute__((noinline)) static void pattern_step(const uint8_t *events) {
+    static const uint32_t patterns[] = { 0x01020304, 0x0A0B0C0D, 0x11223344, 0xDEADBEEF };
+    uint32_t total = 0;
+    for (int p = 0; p < 4; p++) {
+        total += score_window(events, 1024, patterns[p]);
+    }
+    sink = (float)total;
+}
+
+static double now_s(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void drain(void) {
+    pcprof_sample_t s;
+    while (pcprof_ring_pop(&ring, &s)) {
+        pcprof_table_add(&table, &s);
+    }
+}
+
+int main(int argc, char **argv) {
+    const char *log_path = argc > 1 ? argv[1] : "pcprof_host.log";
+    FILE *log = fopen(log_path, "w");
+    if (log == NULL) {
+        perror(log_path);
+        return 1;
+    }
+
+    int top_marker;
+    stack_top = (uintptr_t)&top_marker + 4096;
+
+    static float x[512];
+    static uint8_t events[1024];
+    for (int i = 0; i < 512; i++) x[i] = (float)((i * 7) % 50) / 25.0f - 1.0f;
+    for (int i = 0; i < 1024; i++) events[i] = (uint8_t)(i * 37 + (i >> 3));
+
+    pcprof_ring_init(&ring);
+    pcprof_table_init(&table, name_of);
+
+    struct sigaction sa = { 0 };
+    sa.sa_sigaction = on_sigprof;
+    sa.sa_flags = SA_SIGINFO | SA_RESTART;
+    sigaction(SIGPROF, &sa, NULL);
+    struct itimerval it = { { 0, 1000000 / SAMPLE_HZ }, { 0, 1000000 / SAMPLE_HZ } };
+    setitimer(ITIMER_PROF, &it, NULL);
+
+    double t_ctrl = 0, t_pattern = 0;
+    double start = now_s(), last_report = start;
+    uint32_t reported_drops = 0;
+    while (now_s() - start < RUN_SECONDS) {
+        double t0 = now_s();
+        current_task = TASK_CTRL;
+        for (int i = 0; i < 12; i++) control_step(x);
+        double t1 = now_s();
+        current_task = TASK_PATTERN;
+        pattern_step(events);
+        double t2 = now_s();
+        current_task = 0;
+
+        t_ctrl += t1 - t0;
+        t_pattern += t2 - t1;
+        drain();
+        if (t2 - last_report >= REPORT_EVERY) {
+            pcprof_table_report(&table, log, SAMPLE_HZ, ring.dropped - reported_drops);
+            reported_drops = ring.dropped;
+            last_report = t2;
+        }
+    }
+
+    struct itimerval off = { 0 };
+    setitimer(ITIMER_PROF, &off, NULL);
+    drain();
+    pcprof_table_report(&table, log, SAMPLE_HZ, ring.dropped - reported_drops);
+    fclose(log);
+
+    double total = t_ctrl + t_pattern;
+    printf("Wrote %u report blocks to %s (ring drops %u)\n", table.seq, log_path, ring.dropped);
+    printf("Measured split: Ctrl_1kHz %.1f%%, PatternEngine %.1f%% of %.2f s\n",
+           100 * t_ctrl / total, 100 * t_pattern / total, total);
+    return 0;
+}
@@ -0,0 +1,152 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include "esp_err.h"
+
+// ================ PC-SAMPLING PROFILER ================
+// A periodic timer interrupt on each core records the interrupted PC, a
+// short call stack and the running task into a per-core ring. A drain
+// task folds the rings into a fixed-size table of (task, stack) -> count
+// and prints it now and then as PCPROF lines; tools/pcprof/pcprof.py
+// turns a captured log plus the app ELF into a flat profile or folded
+// stacks for a flame graph.
+//
+// Overhead is one short ISR per sample (a frame read and a bounded,
+// validated stack walk) and everything is preallocated at start, so it
+// can stay compiled in and be switched on in the field. Samples the
+// drain task can't keep up with are dropped and counted, never queued.
+//
+// Log line format (hex addresses, innermost first):
+//
+//   PCPROF B <seq> <rate_hz> <samples> <dropped> <overflow>
+//   PCPROF S <task> <count> <pc> [<caller> ...]
+//   PCPROF E <seq>
+//
+// The ring and table below are plain data structures shared with the
+// host bench; pcprof_start()/pcprof_stop() are the device side.
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef PCPROF_MAX_DEPTH
+#define PCPROF_MAX_DEPTH    8       // PC plus up to 7 callers
+#endif
+#ifndef PCPROF_RING_SIZE
+#define PCPROF_RING_SIZE    128     // Samples per core between drains (power of 2)
+#endif
+#ifndef PCPROF_TABLE_SLOTS
+#define PCPROF_TABLE_SLOTS  256     // Distinct (task, stack) pairs per report
+#endif
+#ifndef PCPROF_MAX_TASKS
+#define PCPROF_MAX_TASKS    24      // Task names remembered per report
+#endif
+
+#define PCPROF_TASK_NAME_LEN    16
+#define PCPROF_TASK_ISR         ((uintptr_t)1)  // Timer fired inside another ISR
+
+typedef struct {
+    uintptr_t task;                 // Opaque task id (TaskHandle_t on the device)
+    uint8_t core;
+    uint8_t depth;                  // Valid entries in pc[]
+    uintptr_t pc[PCPROF_MAX_DEPTH]; // pc[0] = interrupted PC, then return addresses
+} pcprof_sample_t;
+
+// ================ SAMPLE RING (SPSC) ================
+// One producer (the sampling ISR or signal handler), one consumer.
+
+typedef struct {
+    pcprof_sample_t slots[PCPROF_RING_SIZE];
+    uint32_t head;                  // Written by the producer only
+    uint32_t tail;                  // Written by the consumer only
+    uint32_t dropped;               // Samples lost to a full ring
+} pcprof_ring_t;
+
+void pcprof_ring_init(pcprof_ring_t *ring);
+
+// Producer side: claim the next slot, fill it, then commit. claim()
+// returns NULL (and counts a drop) when the ring is full.
+pcprof_sample_t *pcprof_ring_claim(pcprof_ring_t *ring);
+void pcprof_ring_commit(pcprof_ring_t *ring);
+
+bool pcprof_ring_pop(pcprof_ring_t *ring, pcprof_sample_t *out);
+
+// ================ AGGREGATION TABLE ================
+
+typedef struct {
+    uint32_t hash;                  // 0 = empty slot
+    uint32_t count;
+    uintptr_t task;
+    uint8_t depth;
+    uintptr_t pc[PCPROF_MAX_DEPTH];
+} pcprof_entry_t;
+
+typedef struct {
+    uintptr_t task;
+    char name[PCPROF_TASK_NAME_LEN];
+} pcprof_task_name_t;
+
+// Resolves a task id to a name, or leaves it empty if the task is gone
+// (called as samples are added, not at report time; an empty name is
+// reported as task@<id>)
+typedef void (*pcprof_name_fn)(uintptr_t task, char *name, size_t len);
+
+typedef struct {
+    pcprof_entry_t entries[PCPROF_TABLE_SLOTS];
+    pcprof_task_name_t names[PCPROF_MAX_TASKS];
+    uint8_t name_count;
+    pcprof_name_fn name_fn;
+    uint32_t samples;               // Everything added, overflow included
+    uint32_t overflow;              // Samples whose stack found no free slot
+    uint32_t seq;                   // Report number
+} pcprof_table_t;
+
+void pcprof_table_init(pcprof_table_t *t, pcprof_name_fn name_fn);
+void pcprof_table_add(pcprof_table_t *t, const pcprof_sample_t *s);
+
+// Print one B/S.../E report block and clear the counts (names and seq
+// carry over). `dropped` is the ring drop count for the same period.
+void pcprof_table_report(pcprof_table_t *t, FILE *out, uint32_t rate_hz, uint32_t dropped);
+
+// ================ DEVICE PROFILER ================
+
+typedef struct {
+    uint32_t rate_hz;               // Per core; keep it off the task rates (997, not 1000)
+    uint32_t report_ms;             // 0 = only report on pcprof_report()
+    uint8_t core_mask;              // bit n = sample core n
+    uint8_t drain_priority;
+    int drain_core;                 // Core for the drain task (tskNO_AFFINITY allowed)
+} pcprof_config_t;
+
+#define PCPROF_CONFIG_DEFAULT() {   \
+    .rate_hz = 997,                 \
+    .report_ms = 10000,             \
+    .core_mask = 0x3,               \
+    .drain_priority = 2,            \
+    .drain_core = 1,                \
+}
+
+typedef struct {
+    uint32_t samples;               // Taken by the ISRs since start
+    uint32_t dropped;               // Lost to full rings
+    uint32_t in_isr;                // Timer fired inside another ISR
+    uint32_t truncated;             // Stack walks cut at PCPROF_MAX_DEPTH
+    uint32_t reports;
+} pcprof_stats_t;
+
+#ifdef ESP_PLATFORM
+esp_err_t pcprof_start(const pcprof_config_t *cfg);
+void pcprof_stop(void);
+
+// Ask the drain task for a report now (it also reports every report_ms)
+void pcprof_report(void);
+
+void pcprof_get_stats(pcprof_stats_t *out);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
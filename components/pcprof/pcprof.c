@@ -0,0 +1,145 @@
+#include <string.h>
+#include <inttypes.h>
+#include "pcprof.h"
+
+// ================ SAMPLE RING ================
+
+void pcprof_ring_init(pcprof_ring_t *ring) {
+    ring->head = 0;
+    ring->tail = 0;
+    ring->dropped = 0;
+}
+
+pcprof_sample_t *pcprof_ring_claim(pcprof_ring_t *ring) {
+    uint32_t head = ring->head;
+    uint32_t tail = __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+    if (head - tail >= PCPROF_RING_SIZE) {
+        ring->dropped++;
+        return NULL;
+    }
+    return &ring->slots[head & (PCPROF_RING_SIZE - 1)];
+}
+
+void pcprof_ring_commit(pcprof_ring_t *ring) {
+    // Publish the slot contents before the new head
+    __atomic_store_n(&ring->head, ring->head + 1, __ATOMIC_RELEASE);
+}
+
+bool pcprof_ring_pop(pcprof_ring_t *ring, pcprof_sample_t *out) {
+    uint32_t tail = ring->tail;
+    if (__atomic_load_n(&ring->head, __ATOMIC_ACQUIRE) == tail) {
+        return false;
+    }
+    *out = ring->slots[tail & (PCPROF_RING_SIZE - 1)];
+    __atomic_store_n(&ring->tail, tail + 1, __ATOMIC_RELEASE);
+    return true;
+}
+
+// ================ AGGREGATION TABLE ================
+
+#define PROBE_LIMIT     16      // Linear probes before a stack counts as overflow
+
+static uint32_t sample_hash(const pcprof_sample_t *s) {
+    // FNV-1a over the task id and the PCs
+    uint32_t h = 2166136261u;
+    h = (h ^ (uint32_t)s->task) * 16777619u;
+    for (uint8_t i = 0; i < s->depth; i++) {
+        h = (h ^ (uint32_t)s->pc[i]) * 16777619u;
+    }
+    return h ? h : 1;           // 0 marks an empty slot
+}
+
+static bool same_stack(const pcprof_entry_t *e, const pcprof_sample_t *s) {
+    return e->task == s->task && e->depth == s->depth &&
+           memcmp(e->pc, s->pc, s->depth * sizeof(s->pc[0])) == 0;
+}
+
+static void remember_task(pcprof_table_t *t, uintptr_t task) {
+    if (t->name_fn == NULL || task == PCPROF_TASK_ISR) {
+        return;
+    }
+    for (uint8_t i = 0; i < t->name_count; i++) {
+        if (t->names[i].task == task) {
+            return;
+        }
+    }
+    if (t->name_count < PCPROF_MAX_TASKS) {
+        pcprof_task_name_t *n = &t->names[t->name_count++];
+        n->task = task;
+        t->name_fn(task, n->name, sizeof(n->name));
+        n->name[sizeof(n->name) - 1] = '\0';
+        for (char *c = n->name; *c; c++) {
+            if (*c == ' ') *c = '_';    // "Tmr Svc" - keep the line format space-separated
+        }
+    }
+}
+
+static const char *task_name(const pcprof_table_t *t, uintptr_t task) {
+    if (task == PCPROF_TASK_ISR) {
+        return "[isr]";
+    }
+    for (uint8_t i = 0; i < t->name_count; i++) {
+        if (t->names[i].task == task) {
+            // Empty: the task was gone before its name could be read
+            return t->names[i].name[0] ? t->names[i].name : NULL;
+        }
+    }
+    return NULL;
+}
+
+void pcprof_table_init(pcprof_table_t *t, pcprof_name_fn name_fn) {
+    memset(t, 0, sizeof(*t));
+    t->name_fn = name_fn;
+}
+
+void pcprof_table_add(pcprof_table_t *t, const pcprof_sample_t *s) {
+    uint32_t h = sample_hash(s);
+    t->samples++;
+
+    for (uint32_t probe = 0; probe < PROBE_LIMIT; probe++) {
+        pcprof_entry_t *e = &t->entries[(h + probe) % PCPROF_TABLE_SLOTS];
+        if (e->hash == 0) {
+            e->hash = h;
+            e->count = 1;
+            e->task = s->task;
+            e->depth = s->depth;
+            memcpy(e->pc, s->pc, s->depth * sizeof(s->pc[0]));
+            remember_task(t, s->task);
+            return;
+        }
+        if (e->hash == h && same_stack(e, s)) {
+            e->count++;
+            return;
+        }
+    }
+    t->overflow++;
+}
+
+void pcprof_table_report(pcprof_table_t *t, FILE *out, uint32_t rate_hz, uint32_t dropped) {
+    t->seq++;
+    fprintf(out, "PCPROF B %" PRIu32 " %" PRIu32 " %" PRIu32 " %" PRIu32 " %" PRIu32 "\n",
+            t->seq, rate_hz, t->samples, dropped, t->overflow);
+
+    for (uint32_t i = 0; i < PCPROF_TABLE_SLOTS; i++) {
+        const pcprof_entry_t *e = &t->entries[i];
+        if (e->hash == 0) {
+            continue;
+        }
+        const char *name = task_name(t, e->task);
+        if (name != NULL) {
+            fprintf(out, "PCPROF S %s %" PRIu32, name, e->count);
+        } else {
+            fprintf(out, "PCPROF S task@%" PRIxPTR " %" PRIu32, e->task, e->count);
+        }
+        for (uint8_t d = 0; d < e->depth; d++) {
+            fprintf(out, " %" PRIxPTR, e->pc[d]);
+        }
+        fputc('\n', out);
+    }
+    fprintf(out, "PCPROF E %" PRIu32 "\n", t->seq);
+    fflush(out);
+
+    memset(t->entries, 0, sizeof(t->entries));
+    t->samples = 0;
+    t->overflow = 0;
+}
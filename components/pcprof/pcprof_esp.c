@@ -0,0 +1,322 @@
+#ifdef ESP_PLATFORM
+
+#include <string.h>
+#include <stdlib.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "driver/gptimer.h"
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include "esp_cpu.h"
+#include "esp_memory_utils.h"
+#include "pcprof.h"
+
+#if CONFIG_IDF_TARGET_ARCH_XTENSA
+#include "freertos/xtensa_context.h"
+#include "esp_debug_helpers.h"
+#else
+#include "riscv/rvruntime-frames.h"
+#endif
+
+static const char *TAG = "PCPROF";
+
+#define DRAIN_PERIOD_MS     50      // Ring holds RING_SIZE / rate_hz seconds (~128 ms at 997 Hz)
+
+// Nesting depth kept by the port's interrupt entry code
+extern volatile unsigned port_interruptNesting[portNUM_PROCESSORS];
+
+typedef struct {
+    pcprof_ring_t rings[portNUM_PROCESSORS];
+    pcprof_table_t table;
+    gptimer_handle_t timers[portNUM_PROCESSORS];
+    pcprof_config_t cfg;
+    TaskHandle_t drain_task;
+    volatile bool running;
+    uint32_t in_isr[portNUM_PROCESSORS];
+    uint32_t truncated[portNUM_PROCESSORS];
+    uint32_t taken[portNUM_PROCESSORS];
+    uint32_t reported_drops;
+    uint32_t reports;
+} pcprof_state_t;
+
+static pcprof_state_t *prof;
+
+// ================ SAMPLING ISR ================
+
+// Fill pc[] from the frame the port saved when the timer interrupted the
+// task. The first member of a TCB is pxTopOfStack, and the interrupt
+// entry code stores the task's SP there before switching to the ISR
+// stack, so it points at the interrupted context.
+static IRAM_ATTR uint8_t capture_stack(TaskHandle_t task, uintptr_t *pc, uint32_t *truncated) {
+    void *frame_ptr = *(void **)task;
+
+#if CONFIG_IDF_TARGET_ARCH_XTENSA
+    const XtExcFrame *frame = (const XtExcFrame *)frame_ptr;
+    esp_backtrace_frame_t bt = {
+        .pc = frame->pc,
+        .sp = frame->a1,
+        .next_pc = frame->a0,
+        .exc_frame = frame,
+    };
+    uint8_t depth = 0;
+
+    pc[depth++] = bt.pc;
+    // Windows were spilled on interrupt entry; stop at the first frame
+    // that doesn't look like code on a sane stack
+    while (depth < PCPROF_MAX_DEPTH && bt.next_pc != 0) {
+        if (!esp_backtrace_get_next_frame(&bt) ||
+            !esp_stack_ptr_is_sane(bt.sp) ||
+            !esp_ptr_executable((void *)esp_cpu_process_stack_pc(bt.pc))) {
+            return depth;
+        }
+        pc[depth++] = esp_cpu_process_stack_pc(bt.pc);
+    }
+    if (bt.next_pc != 0) {
+        (*truncated)++;
+    }
+    return depth;
+#else
+    // No frame pointers on RISC-V builds: PC only (flat profile, no stacks)
+    (void)truncated;
+    pc[0] = ((const RvExcFrame *)frame_ptr)->mepc;
+    return 1;
+#endif
+}
+
+static IRAM_ATTR bool on_sample_timer(gptimer_handle_t timer, const gptimer_alarm_event_data_t *edata, void *arg) {
+    int core = xPortGetCoreID();
+    pcprof_sample_t *s = pcprof_ring_claim(&prof->rings[core]);
+    prof->taken[core]++;
+    if (s == NULL) {
+        return false;
+    }
+
+    s->core = core;
+    if (port_interruptNesting[core] > 1) {
+        // Preempted another ISR: the saved task frame is stale
+        s->task = PCPROF_TASK_ISR;
+        s->depth = 0;
+        prof->in_isr[core]++;
+    } else {
+        TaskHandle_t task = xTaskGetCurrentTaskHandleForCore(core);
+        s->task = (uintptr_t)task;
+        s->depth = capture_stack(task, s->pc, &prof->truncated[core]);
+    }
+    pcprof_ring_commit(&prof->rings[core]);
+    return false;
+}
+
+// The timer interrupt is allocated on the core that enables it, so this
+// runs in a short-lived task pinned to each sampled core
+typedef struct {
+    TaskHandle_t caller;
+    esp_err_t err;
+} timer_setup_t;
+
+static void timer_setup_task(void *arg) {
+    timer_setup_t *setup = (timer_setup_t *)arg;
+    int core = xPortGetCoreID();
+
+    gptimer_config_t timer_cfg = {
+        .clk_src = GPTIMER_CLK_SRC_DEFAULT,
+        .direction = GPTIMER_COUNT_UP,
+        .resolution_hz = 1000000,       // 1 us ticks
+    };
+    gptimer_alarm_config_t alarm_cfg = {
+        .alarm_count = 1000000 / prof->cfg.rate_hz,
+        .reload_count = 0,
+        .flags.auto_reload_on_alarm = true,
+    };
+    gptimer_event_callbacks_t cbs = { .on_alarm = on_sample_timer };
+
+    gptimer_handle_t timer = NULL;
+    esp_err_t err = gptimer_new_timer(&timer_cfg, &timer);
+    if (err == ESP_OK) err = gptimer_set_alarm_action(timer, &alarm_cfg);
+    if (err == ESP_OK) err = gptimer_register_event_callbacks(timer, &cbs, NULL);
+    if (err == ESP_OK) err = gptimer_enable(timer);
+    if (err == ESP_OK) err = gptimer_start(timer);
+
+    if (err != ESP_OK && timer != NULL) {
+        gptimer_disable(timer);
+        gptimer_del_timer(timer);
+        timer = NULL;
+    }
+    prof->timers[core] = timer;
+    setup->err = err;
+    xTaskNotifyGive(setup->caller);
+    vTaskDelete(NULL);
+}
+
+// ================ DRAIN / REPORT ================
+
+// A sample can be a drain period old, and its task deleted since then,
+// so the handle is only matched against the live task list, never
+// dereferenced. Without CONFIG_FREERTOS_USE_TRACE_FACILITY there is no
+// such list and the report shows task@<handle> instead of a name.
+static void name_of(uintptr_t task, char *name, size_t len) {
+    name[0] = '\0';
+#if configUSE_TRACE_FACILITY
+    UBaseType_t n = uxTaskGetNumberOfTasks() + 4;    // Room for tasks created meanwhile
+    TaskStatus_t *tasks = malloc(n * sizeof(*tasks));
+    if (tasks == NULL) {
+        return;
+    }
+    n = uxTaskGetSystemState(tasks, n, NULL);
+    for (UBaseType_t i = 0; i < n; i++) {
+        if ((uintptr_t)tasks[i].xHandle == task) {
+            strncpy(name, tasks[i].pcTaskName, len - 1);
+            name[len - 1] = '\0';
+            break;
+        }
+    }
+    free(tasks);
+#else
+    (void)task;
+    (void)len;
+#endif
+}
+
+static void drain_rings(void) {
+    pcprof_sample_t s;
+    for (int core = 0; core < portNUM_PROCESSORS; core++) {
+        while (pcprof_ring_pop(&prof->rings[core], &s)) {
+            pcprof_table_add(&prof->table, &s);
+        }
+    }
+}
+
+static uint32_t total_drops(void) {
+    uint32_t n = 0;
+    for (int core = 0; core < portNUM_PROCESSORS; core++) {
+        n += prof->rings[core].dropped;
+    }
+    return n;
+}
+
+static void report_now(void) {
+    drain_rings();
+    uint32_t drops = total_drops();
+    pcprof_table_report(&prof->table, stdout, prof->cfg.rate_hz, drops - prof->reported_drops);
+    prof->reported_drops = drops;
+    prof->reports++;
+}
+
+static void drain_task(void *arg) {
+    TickType_t last_report = xTaskGetTickCount();
+
+    // Only this task touches the table while sampling runs; a notify
+    // from pcprof_report() asks for a report now
+    while (prof->running) {
+        bool requested = ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(DRAIN_PERIOD_MS)) > 0;
+        drain_rings();
+
+        if (requested || (prof->cfg.report_ms > 0 &&
+            xTaskGetTickCount() - last_report >= pdMS_TO_TICKS(prof->cfg.report_ms))) {
+            report_now();
+            last_report = xTaskGetTickCount();
+        }
+    }
+    prof->drain_task = NULL;
+    vTaskDelete(NULL);
+}
+
+// ================ PUBLIC API ================
+
+esp_err_t pcprof_start(const pcprof_config_t *cfg) {
+    if (prof != NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (cfg->rate_hz == 0 || cfg->rate_hz > 10000 || cfg->core_mask == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    // Rings are written from the ISR: internal RAM only
+    prof = heap_caps_calloc(1, sizeof(*prof), MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    if (prof == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    prof->cfg = *cfg;
+    for (int core = 0; core < portNUM_PROCESSORS; core++) {
+        pcprof_ring_init(&prof->rings[core]);
+    }
+    pcprof_table_init(&prof->table, name_of);
+    prof->running = true;
+
+    if (xTaskCreatePinnedToCore(drain_task, "pcprof", 3072, NULL, cfg->drain_priority,
+                                &prof->drain_task, cfg->drain_core) != pdPASS) {
+        heap_caps_free(prof);
+        prof = NULL;
+        return ESP_ERR_NO_MEM;
+    }
+
+    esp_err_t err = ESP_OK;
+    for (int core = 0; core < portNUM_PROCESSORS && err == ESP_OK; core++) {
+        if (!(cfg->core_mask & (1u << core))) {
+            continue;
+        }
+        timer_setup_t setup = { .caller = xTaskGetCurrentTaskHandle(), .err = ESP_FAIL };
+        if (xTaskCreatePinnedToCore(timer_setup_task, "pcprof_init", 3072, &setup,
+                                    configMAX_PRIORITIES - 1, NULL, core) != pdPASS) {
+            err = ESP_ERR_NO_MEM;
+            break;
+        }
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        err = setup.err;
+    }
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "❌ Sampling timer setup failed: %s", esp_err_to_name(err));
+        pcprof_stop();
+        return err;
+    }
+
+    ESP_LOGI(TAG, "🔬 Sampling cores 0x%x at %lu Hz, report every %lu ms (%u bytes)",
+             cfg->core_mask, cfg->rate_hz, cfg->report_ms, (unsigned)sizeof(*prof));
+    return ESP_OK;
+}
+
+void pcprof_stop(void) {
+    if (prof == NULL) {
+        return;
+    }
+    for (int core = 0; core < portNUM_PROCESSORS; core++) {
+        if (prof->timers[core] != NULL) {
+            gptimer_stop(prof->timers[core]);
+            gptimer_disable(prof->timers[core]);
+            gptimer_del_timer(prof->timers[core]);
+            prof->timers[core] = NULL;
+        }
+    }
+
+    // Let the drain task see running == false and exit before freeing
+    prof->running = false;
+    while (prof->drain_task != NULL) {
+        vTaskDelay(pdMS_TO_TICKS(DRAIN_PERIOD_MS));
+    }
+    report_now();
+
+    heap_caps_free(prof);
+    prof = NULL;
+    ESP_LOGI(TAG, "🔬 Sampling stopped");
+}
+
+void pcprof_report(void) {
+    if (prof != NULL && prof->drain_task != NULL) {
+        xTaskNotifyGive(prof->drain_task);
+    }
+}
+
+void pcprof_get_stats(pcprof_stats_t *out) {
+    memset(out, 0, sizeof(*out));
+    if (prof == NULL) {
+        return;
+    }
+    for (int core = 0; core < portNUM_PROCESSORS; core++) {
+        out->samples += prof->taken[core];
+        out->dropped += prof->rings[core].dropped;
+        out->in_isr += prof->in_isr[core];
+        out->truncated += prof->truncated[core];
+    }
+    out->reports = prof->reports;
+}
+
+#endif // ESP_PLATFORM
@@ -0,0 +1,119 @@
+// Host check for the token-bucket core: burst then sustained rate,
+// exact pacing of blocked (reserved) slots, defer hints, idle gaps past
+// where a 32-bit microsecond clock wraps, and several threads racing on one bucket - the compare-and-swap
+// must never hand out more than the bucket holds.
+//
+// Build and run from this directory:
+//   cc -O2 -pthread -I../include -I../../../tools/host_include ../ratelim.c ratelim_host_bench.c -o ratelim_bench
+//   ./ratelim_bench
+
+#include <stdio.h>
+#include <pthread.h>
+#include "ratelim.h"
+#include "host_check.h"
+
+#define THREADS         4
+#define BURST           5
+
+// Offer one item every `every_us` for `duration_us`; count what conforms
+static uint32_t offer(rl_t *rl, uint64_t start, uint32_t every_us, uint32_t duration_us) {
+    uint32_t accepted = 0;
+    for (uint32_t t = 0; t < duration_us; t += every_us) {
+        accepted += rl_reserve(rl, start + t, 0) == 0;
+    }
+    return accepted;
+}
+
+static rl_t shared;
+static volatile int go;
+
+static void *racer(void *arg) {
+    uint32_t *won = arg;
+    while (!go) {
+    }
+    // Everyone at the same instant: only the bucket's contents may pass
+    for (int i = 0; i < 100000; i++) {
+        *won += rl_reserve(&shared, 1000, 0) == 0;
+    }
+    return NULL;
+}
+
+int main(void) {
+    rl_t rl;
+
+    // 10/s, burst 5: five at once, then one per 100 ms
+    rl_init(&rl, "burst", 10, BURST, RL_DROP);
+    uint64_t now = 1000;
+    uint32_t burst = 0;
+    while (rl_reserve(&rl, now, 0) == 0) {
+        burst++;
+    }
+    CHECK(burst == BURST, "burst admitted %u, expected %u", burst, BURST);
+    CHECK(rl_wait_us(&rl, now) == 100000, "defer hint %u us, expected 100000", rl_wait_us(&rl, now));
+    CHECK(rl_reserve(&rl, now + 99999, 0) == RL_NO_SLOT, "admitted before the interval");
+    CHECK(rl_reserve(&rl, now + 100000, 0) == 0, "not admitted after the interval");
+
+    // 100x overload for 100 s: rate x time plus the burst, no more
+    rl_init(&rl, "sustained", 10, BURST, RL_DROP);
+    uint32_t got = offer(&rl, 5000, 1000, 100000000);
+    printf("  sustained: %u of 100000 offered at 1000/s -> %.2f/s (limit 10/s, burst %u)\n",
+           got, got / 100.0, BURST);
+    CHECK(got >= 1000 && got <= 1000 + BURST, "accepted %u, expected 1000..%u", got, 1000 + BURST);
+
+    // Under the limit nothing is lost
+    rl_init(&rl, "under", 10, 1, RL_DROP);
+    CHECK(offer(&rl, 5000, 150000, 60000000) == 400, "under-limit producer was limited");
+
+    // Blocked callers reserve in order: waits are 0 x burst, then T, 2T, ...
+    rl_init(&rl, "block", 4, 2, RL_BLOCK);
+    int paced = 1;
+    for (int i = 0; i < 20; i++) {
+        uint32_t wait = rl_reserve(&rl, 7000, UINT32_MAX / 4);
+        uint32_t expect = i < 2 ? 0 : (uint32_t)(i - 1) * 250000;
+        paced &= wait == expect;
+    }
+    CHECK(paced, "reservations not paced at the interval");
+    CHECK(rl_reserve(&rl, 7000, 4000000) == RL_NO_SLOT, "reserved past max_wait");
+    CHECK(rl_reserve(&rl, 7000, 5000000) == 4750000, "max_wait refusal took a slot");
+
+    // Idle gaps: a spent bucket is full again after any pause, including
+    // the 54-71 min ones where a 32-bit microsecond tat reads as "ahead"
+    static const uint32_t idle_min[] = { 40, 55, 60, 65, 70, 72, 180 };
+    for (unsigned g = 0; g < sizeof(idle_min) / sizeof(idle_min[0]); g++) {
+        rl_init(&rl, "idle", 1, BURST, RL_DROP);
+        now = (uint64_t)UINT32_MAX - 500000;    // Where the old clock wrapped
+        while (rl_reserve(&rl, now, 0) == 0) {
+        }
+        CHECK(rl_reserve(&rl, now + 1000000, 0) == 0, "no slot one interval later");
+        now += (uint64_t)idle_min[g] * 60 * 1000000;
+        CHECK(rl_wait_us(&rl, now) == 0, "after %u min idle: wait %u us", idle_min[g], rl_wait_us(&rl, now));
+        burst = 0;
+        while (rl_reserve(&rl, now, 0) == 0) {
+            burst++;
+        }
+        CHECK(burst == BURST, "after %u min idle: %u admitted, expected %u", idle_min[g], burst, BURST);
+    }
+
+    // Racing producers
+    rl_init(&shared, "race", 1000, 64, RL_DROP);
+    pthread_t th[THREADS];
+    uint32_t won[THREADS] = { 0 };
+    for (int i = 0; i < THREADS; i++) {
+        pthread_create(&th[i], NULL, racer, &won[i]);
+    }
+    go = 1;
+    uint32_t total = 0;
+    for (int i = 0; i < THREADS; i++) {
+        pthread_join(th[i], NULL);
+        total += won[i];
+    }
+    printf("  race: %u threads, %u admitted from a bucket of 64\n", THREADS, total);
+    CHECK(total == 64, "racing threads got %u slots from a bucket of 64", total);
+
+    shared.accepted = total;
+    shared.rejected = THREADS * 100000 - total;
+    rl_report(stdout);
+
+    printf("\n%s\n", failures ? "FAILURES" : "OK");
+    return failures != 0;
+}
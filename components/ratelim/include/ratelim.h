@@ -0,0 +1,123 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include "esp_err.h"
+
+#ifdef ESP_PLATFORM
+#include "esp_log.h"
+#endif
+
+// ================ TOKEN-BUCKET RATE LIMITER ================
+// Contains a producer at the source: at most `burst` items back to back,
+// `rate_per_s` sustained. What happens to an item over the limit is the
+// limiter's policy:
+//
+//   RL_DROP    rl_admit() says RL_DROPPED; the caller discards the item
+//   RL_BLOCK   rl_admit() sleeps until the item conforms, then RL_OK
+//              (RL_DROPPED if that would take longer than max_wait_ms)
+//   RL_DEFER   rl_admit() says RL_DEFERRED and when to try again; the
+//              caller keeps the item and carries on with other work
+//
+//   static rl_t net_limit;
+//   rl_init(&net_limit, "network", 0.5f, 4, RL_DEFER);
+//
+//   uint32_t retry_ms;
+//   switch (rl_admit(&net_limit, &retry_ms)) { ... }
+//
+// The bucket is kept in its virtual-scheduling form (GCRA): one 64-bit
+// "theoretical arrival time" in microseconds, advanced by one emission
+// interval per admitted item with a compare-and-swap - no task lock, safe
+// from any number of tasks or ISRs (rl_admit() with RL_BLOCK sleeps, so
+// not from an ISR; on the ESP32 the compiler's 64-bit CAS helper masks
+// interrupts for a few instructions). An item conforms when now >= tat - (burst - 1) x interval.
+// RL_BLOCK reserves its slot before sleeping, so blocked callers are
+// released in order at exactly the sustained rate.
+//
+// RL_LOGI()/RL_LOGW() put the same limiter on a log line; the next line
+// that gets through says how many were suppressed in between.
+//
+// Times are esp_timer_get_time() on the device - 64 bits, so a bucket
+// left idle for hours is simply full again, there is no wraparound.
+// rl_reserve() takes the time as an argument, so any clock can drive it.
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define RL_NO_SLOT          UINT32_MAX
+
+typedef enum {
+    RL_DROP,
+    RL_BLOCK,
+    RL_DEFER,
+} rl_policy_t;
+
+typedef enum {
+    RL_OK,
+    RL_DROPPED,
+    RL_DEFERRED,
+} rl_result_t;
+
+typedef struct rl {
+    const char *name;
+    rl_policy_t policy;
+    uint32_t interval_us;           // 1 / sustained rate
+    uint32_t tolerance_us;          // (burst - 1) x interval
+    uint32_t max_wait_ms;           // RL_BLOCK; 0 = as long as it takes
+    uint64_t tat;                   // Theoretical arrival time (atomic)
+
+    // Counters (atomic)
+    uint32_t accepted;
+    uint32_t rejected;              // Dropped (RL_DROP, RL_BLOCK past max_wait)
+    uint32_t deferrals;             // RL_DEFERRED answers; a retried item counts each time
+    uint32_t blocked;               // Accepted after a wait
+    uint32_t blocked_ms;            // Total wait
+    uint32_t suppressed;            // Log lines since the last one printed
+
+    struct rl *next;
+} rl_t;
+
+// rate_per_s may be fractional (0.2 = one every 5 s); burst >= 1
+esp_err_t rl_init(rl_t *rl, const char *name, float rate_per_s, uint32_t burst, rl_policy_t policy);
+
+// Take the next slot if it is due within max_wait_us of now_us. Returns
+// how long until it's due (0 = now), or RL_NO_SLOT with nothing taken.
+uint32_t rl_reserve(rl_t *rl, uint64_t now_us, uint32_t max_wait_us);
+
+// Microseconds until an item would conform (0 = now); takes nothing
+uint32_t rl_wait_us(const rl_t *rl, uint64_t now_us);
+
+#ifdef ESP_PLATFORM
+// Apply the limiter's policy to one item. retry_ms (may be NULL) gets
+// the time to wait before trying a deferred item again.
+rl_result_t rl_admit(rl_t *rl, uint32_t *retry_ms);
+
+// RL_DROP check for log lines; *suppressed = lines dropped since the
+// last one that got through
+bool rl_log_ok(rl_t *rl, uint32_t *suppressed);
+
+#define RL_LOG_LEVEL(level, rl, tag, fmt, ...) do {                                     \
+    uint32_t _rl_sup;                                                                   \
+    if (rl_log_ok((rl), &_rl_sup)) {                                                    \
+        if (_rl_sup) {                                                                  \
+            ESP_LOG_LEVEL_LOCAL(level, tag, fmt " (+%lu suppressed)", ##__VA_ARGS__,    \
+                                (unsigned long)_rl_sup);                                \
+        } else {                                                                        \
+            ESP_LOG_LEVEL_LOCAL(level, tag, fmt, ##__VA_ARGS__);                        \
+        }                                                                               \
+    }                                                                                   \
+} while (0)
+
+#define RL_LOGI(rl, tag, fmt, ...) RL_LOG_LEVEL(ESP_LOG_INFO, rl, tag, fmt, ##__VA_ARGS__)
+#define RL_LOGW(rl, tag, fmt, ...) RL_LOG_LEVEL(ESP_LOG_WARN, rl, tag, fmt, ##__VA_ARGS__)
+#endif
+
+// One line per limiter: accepted, rejected or deferrals, blocked and
+// time blocked
+void rl_report(FILE *out);
+
+#ifdef __cplusplus
+}
+#endif
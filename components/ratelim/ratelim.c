@@ -0,0 +1,99 @@
+#include <string.h>
+#include <inttypes.h>
+#include "ratelim.h"
+
+// Burst tolerance, and with it every wait, stays well inside 32 bits
+#define MAX_SPAN_US         (1u << 29)
+
+static rl_t *registry;
+
+// ================ BUCKET ================
+
+// Call before the producers start (the registry isn't locked)
+esp_err_t rl_init(rl_t *rl, const char *name, float rate_per_s, uint32_t burst, rl_policy_t policy) {
+    if (rate_per_s <= 0 || burst == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    double interval = 1e6 / rate_per_s;
+    if (interval < 1 || interval * burst > MAX_SPAN_US) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    bool listed = false;
+    for (rl_t *it = registry; it != NULL; it = it->next) {
+        listed |= it == rl;
+    }
+    rl_t *next = rl->next;
+    memset(rl, 0, sizeof(*rl));
+    rl->name = name;
+    rl->policy = policy;
+    rl->interval_us = (uint32_t)(interval + 0.5);
+    rl->tolerance_us = rl->interval_us * (burst - 1);
+    if (listed) {
+        rl->next = next;            // Re-initialised: keep its place
+    } else {
+        rl->next = registry;
+        registry = rl;
+    }
+    return ESP_OK;
+}
+
+// Where the next slot counts from: the tat, or now if it's in the past
+static uint64_t slot_base(uint64_t tat, uint64_t now_us) {
+    return tat > now_us ? tat : now_us;
+}
+
+static uint32_t wait_for(const rl_t *rl, uint64_t base, uint64_t now_us) {
+    uint64_t ahead = base - now_us;
+    if (ahead <= rl->tolerance_us) {
+        return 0;
+    }
+    // Only a long queue of RL_BLOCK reservations gets near this
+    return ahead - rl->tolerance_us < RL_NO_SLOT ? (uint32_t)(ahead - rl->tolerance_us) : RL_NO_SLOT - 1;
+}
+
+uint32_t rl_reserve(rl_t *rl, uint64_t now_us, uint32_t max_wait_us) {
+    uint64_t tat = __atomic_load_n(&rl->tat, __ATOMIC_RELAXED);
+    for (;;) {
+        uint64_t base = slot_base(tat, now_us);
+        uint32_t wait = wait_for(rl, base, now_us);
+        if (wait > max_wait_us) {
+            return RL_NO_SLOT;
+        }
+        if (__atomic_compare_exchange_n(&rl->tat, &tat, base + rl->interval_us,
+                                        true, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+            return wait;
+        }
+        // Lost to another producer: tat now holds its value, go again
+    }
+}
+
+uint32_t rl_wait_us(const rl_t *rl, uint64_t now_us) {
+    uint64_t tat = __atomic_load_n(&rl->tat, __ATOMIC_RELAXED);
+    return wait_for(rl, slot_base(tat, now_us), now_us);
+}
+
+// ================ REPORT ================
+
+void rl_report(FILE *out) {
+    static const char *policies[] = { "drop", "block", "defer" };
+    for (rl_t *rl = registry; rl != NULL; rl = rl->next) {
+        uint32_t accepted = __atomic_load_n(&rl->accepted, __ATOMIC_RELAXED);
+        uint32_t rejected = __atomic_load_n(&rl->rejected, __ATOMIC_RELAXED);
+        uint32_t blocked = __atomic_load_n(&rl->blocked, __ATOMIC_RELAXED);
+        uint32_t blocked_ms = __atomic_load_n(&rl->blocked_ms, __ATOMIC_RELAXED);
+        uint32_t total = accepted + rejected;
+        fprintf(out, "ratelim [%s]: %.2f/s burst %" PRIu32 " (%s), %" PRIu32 " accepted, ",
+                rl->name, 1e6 / rl->interval_us, rl->tolerance_us / rl->interval_us + 1,
+                policies[rl->policy], accepted);
+        if (rl->policy == RL_DEFER) {
+            // Deferred items come back, so nothing is lost: no percentage
+            fprintf(out, "%" PRIu32 " deferrals", __atomic_load_n(&rl->deferrals, __ATOMIC_RELAXED));
+        } else {
+            fprintf(out, "%" PRIu32 " rejected (%.1f%%)", rejected, total ? 100.0 * rejected / total : 0.0);
+        }
+        if (rl->policy == RL_BLOCK) {
+            fprintf(out, ", %" PRIu32 " blocked avg %" PRIu32 " ms", blocked, blocked ? blocked_ms / blocked : 0);
+        }
+        fprintf(out, "\n");
+    }
+}
@@ -0,0 +1,56 @@
+#ifdef ESP_PLATFORM
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_timer.h"
+#include "ratelim.h"
+
+#define MAX_BLOCK_US        (1u << 29)      // max_wait_ms = 0: ~9 min
+
+static uint64_t now_us(void) {
+    return (uint64_t)esp_timer_get_time();
+}
+
+rl_result_t rl_admit(rl_t *rl, uint32_t *retry_ms) {
+    uint64_t now = now_us();
+    uint32_t max_wait = 0;
+    if (rl->policy == RL_BLOCK) {
+        max_wait = rl->max_wait_ms && rl->max_wait_ms < MAX_BLOCK_US / 1000 ? rl->max_wait_ms * 1000 : MAX_BLOCK_US;
+    }
+
+    uint32_t wait = rl_reserve(rl, now, max_wait);
+    if (wait == RL_NO_SLOT) {
+        if (rl->policy != RL_DEFER) {
+            __atomic_fetch_add(&rl->rejected, 1, __ATOMIC_RELAXED);
+            return RL_DROPPED;
+        }
+        __atomic_fetch_add(&rl->deferrals, 1, __ATOMIC_RELAXED);
+        if (retry_ms != NULL) {
+            *retry_ms = (rl_wait_us(rl, now) + 999) / 1000;
+        }
+        return RL_DEFERRED;
+    }
+
+    if (wait > 0) {
+        // Our slot is reserved; round up so we never go early
+        const uint32_t tick_us = portTICK_PERIOD_MS * 1000;
+        vTaskDelay((wait + tick_us - 1) / tick_us);
+        __atomic_fetch_add(&rl->blocked, 1, __ATOMIC_RELAXED);
+        __atomic_fetch_add(&rl->blocked_ms, (uint32_t)((now_us() - now) / 1000), __ATOMIC_RELAXED);
+    }
+    __atomic_fetch_add(&rl->accepted, 1, __ATOMIC_RELAXED);
+    return RL_OK;
+}
+
+bool rl_log_ok(rl_t *rl, uint32_t *suppressed) {
+    if (rl_reserve(rl, now_us(), 0) == RL_NO_SLOT) {
+        __atomic_fetch_add(&rl->rejected, 1, __ATOMIC_RELAXED);
+        __atomic_fetch_add(&rl->suppressed, 1, __ATOMIC_RELAXED);
+        return false;
+    }
+    __atomic_fetch_add(&rl->accepted, 1, __ATOMIC_RELAXED);
+    *suppressed = __atomic_exchange_n(&rl->suppressed, 0, __ATOMIC_RELAXED);
+    return true;
+}
+
+#endif // ESP_PLATFORM
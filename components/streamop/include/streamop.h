@@ -0,0 +1,151 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include "esp_err.h"
+
+// ================ WINDOWED STREAM OPERATORS ================
+// Turns a stream of (key, time, value) samples into one result per key
+// per time window, so a consumer does its real work - logging, alerts,
+// LED changes - once per window instead of once per sample:
+//
+//   sample -> filter -> map -> ... -> keyed window -> sink(window result)
+//
+//   static so_stream_t temps;
+//   so_config_t cfg = { .size_ms = 30000, .slide_ms = 10000, .lateness_ms = 5000 };
+//   so_init(&temps, "temperature", &cfg, on_window, NULL);
+//   so_filter(&temps, in_range, NULL);
+//   so_map(&temps, calibrate, NULL);
+//
+//   so_push(&temps, sensor_id, timestamp_ms, value);     // per sample: cheap
+//   so_advance(&temps, now_ms);                          // when idle
+//
+// Windows are [start, start + size_ms) and start every slide_ms:
+// slide_ms = size_ms (or 0) gives tumbling windows, a smaller slide
+// (dividing size_ms) overlapping sliding ones. Each key (sensor ID,
+// channel...) gets its own windows. Samples are folded into slide_ms
+// "panes" as they arrive, and a sliding window is the merge of its
+// panes, so overlapping windows don't cost a pass over their samples.
+//
+// Results: count, sum, mean, min, max, standard deviation, and
+// optionally so_reduce()'s fold. For sliding windows the fold is also
+// used to merge panes, so it must be associative and commutative (max,
+// sum, bitwise or, ...).
+//
+// Time is event time - the sample's own timestamp. The watermark is
+// the newest timestamp seen minus lateness_ms: a window is emitted once
+// the watermark passes its end, so samples up to lateness_ms out of
+// order still count. Anything older than that is late, counted and
+// dropped. so_advance() moves the watermark on the consumer's clock, so
+// windows still close when the samples stop coming.
+//
+// A stream is not thread-safe - own it from the pipeline task that
+// consumes the samples. No allocation; timestamps are 32-bit ms.
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define SO_MAX_STAGES       4       // filter/map stages
+#define SO_MAX_KEYS         8
+#define SO_MAX_PANES        16      // size/slide + lateness/slide + 2 must fit
+
+typedef bool (*so_filter_fn)(uint32_t key, float value, void *ctx);
+typedef float (*so_map_fn)(uint32_t key, float value, void *ctx);
+typedef float (*so_reduce_fn)(float acc, float value, void *ctx);
+
+typedef struct {
+    uint32_t key;
+    uint32_t start_ms;
+    uint32_t end_ms;                // Exclusive
+    uint32_t count;
+    float sum;
+    float mean;
+    float min;
+    float max;
+    float stddev;
+    float reduced;                  // so_reduce() result (its init if unset)
+} so_window_t;
+
+typedef void (*so_sink_fn)(const so_window_t *w, void *ctx);
+
+typedef struct {
+    uint32_t size_ms;
+    uint32_t slide_ms;              // 0 = size_ms (tumbling)
+    uint32_t lateness_ms;           // Out-of-order tolerance
+} so_config_t;
+
+typedef struct {
+    uint32_t id;                    // Pane number (time / slide); valid if count > 0
+    uint32_t count;
+    float sum;
+    float mean;
+    float m2;                       // Sum of squared deviations (Welford)
+    float min;
+    float max;
+    float acc;
+} so_pane_t;
+
+typedef struct {
+    bool used;
+    uint32_t key;
+    uint32_t newest;                // Newest pane with samples
+    so_pane_t panes[SO_MAX_PANES];
+} so_keystate_t;
+
+typedef struct {
+    bool is_map;
+    union {
+        so_filter_fn filter;
+        so_map_fn map;
+    };
+    void *ctx;
+} so_stage_t;
+
+typedef struct {
+    const char *name;
+    so_config_t cfg;
+    uint32_t panes_per_window;
+    so_stage_t stages[SO_MAX_STAGES];
+    uint32_t stage_count;
+    so_reduce_fn reduce;
+    float reduce_init;
+    void *reduce_ctx;
+    so_sink_fn sink;
+    void *sink_ctx;
+
+    bool started;
+    uint32_t max_ts;                // Newest event time seen
+    uint32_t emitted;               // Windows ending at pane boundaries <= this are out
+    so_keystate_t keys[SO_MAX_KEYS];
+
+    // Statistics
+    uint32_t samples;
+    uint32_t filtered;
+    uint32_t late;
+    uint32_t no_key;                // More keys than SO_MAX_KEYS
+    uint32_t windows;
+} so_stream_t;
+
+esp_err_t so_init(so_stream_t *s, const char *name, const so_config_t *cfg, so_sink_fn sink, void *ctx);
+
+// Stages run in the order they're added
+esp_err_t so_filter(so_stream_t *s, so_filter_fn fn, void *ctx);
+esp_err_t so_map(so_stream_t *s, so_map_fn fn, void *ctx);
+void so_reduce(so_stream_t *s, so_reduce_fn fn, float init, void *ctx);
+
+// One sample; may emit the windows its timestamp closes. false if it was
+// filtered out, late or had no key slot.
+bool so_push(so_stream_t *s, uint32_t key, uint32_t ts_ms, float value);
+
+// Move the watermark to now_ms - lateness_ms (never backwards) and emit
+// what that closes
+void so_advance(so_stream_t *s, uint32_t now_ms);
+
+// One line: samples, filtered, late, windows
+void so_report(const so_stream_t *s, FILE *out);
+
+#ifdef __cplusplus
+}
+#endif
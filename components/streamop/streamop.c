@@ -0,0 +1,229 @@
+#include <string.h>
+#include <math.h>
+#include "streamop.h"
+
+// ================ SETUP ================
+
+esp_err_t so_init(so_stream_t *s, const char *name, const so_config_t *cfg, so_sink_fn sink, void *ctx) {
+    uint32_t slide = cfg->slide_ms ? cfg->slide_ms : cfg->size_ms;
+    if (cfg->size_ms == 0 || slide > cfg->size_ms || cfg->size_ms % slide != 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    uint32_t k = cfg->size_ms / slide;
+    uint32_t late_panes = (cfg->lateness_ms + slide - 1) / slide;
+    if (k + late_panes + 2 > SO_MAX_PANES) {
+        return ESP_ERR_INVALID_SIZE;    // Not enough panes to keep that much open
+    }
+    memset(s, 0, sizeof(*s));
+    s->name = name;
+    s->cfg = *cfg;
+    s->cfg.slide_ms = slide;
+    s->panes_per_window = k;
+    s->sink = sink;
+    s->sink_ctx = ctx;
+    return ESP_OK;
+}
+
+static esp_err_t add_stage(so_stream_t *s, so_stage_t stage) {
+    if (s->stage_count == SO_MAX_STAGES) {
+        return ESP_ERR_NO_MEM;
+    }
+    s->stages[s->stage_count++] = stage;
+    return ESP_OK;
+}
+
+esp_err_t so_filter(so_stream_t *s, so_filter_fn fn, void *ctx) {
+    return add_stage(s, (so_stage_t){ .is_map = false, .filter = fn, .ctx = ctx });
+}
+
+esp_err_t so_map(so_stream_t *s, so_map_fn fn, void *ctx) {
+    return add_stage(s, (so_stage_t){ .is_map = true, .map = fn, .ctx = ctx });
+}
+
+void so_reduce(so_stream_t *s, so_reduce_fn fn, float init, void *ctx) {
+    s->reduce = fn;
+    s->reduce_init = init;
+    s->reduce_ctx = ctx;
+}
+
+// ================ WINDOWS ================
+
+// Running mean and M2 (Welford), merged pairwise (Chan et al.) - stable
+// for readings with a large offset and a small spread
+static void pane_add(so_stream_t *s, so_pane_t *p, float v) {
+    p->count++;
+    p->sum += v;
+    float d = v - p->mean;
+    p->mean += d / p->count;
+    p->m2 += d * (v - p->mean);
+    if (p->count == 1 || v < p->min) {
+        p->min = v;
+    }
+    if (p->count == 1 || v > p->max) {
+        p->max = v;
+    }
+    if (s->reduce) {
+        p->acc = s->reduce(p->acc, v, s->reduce_ctx);
+    }
+}
+
+static void pane_merge(so_stream_t *s, so_pane_t *into, const so_pane_t *p) {
+    if (into->count == 0) {
+        float acc = into->acc;
+        *into = *p;
+        into->acc = s->reduce ? s->reduce(acc, p->acc, s->reduce_ctx) : acc;
+        return;
+    }
+    uint32_t n = into->count + p->count;
+    float d = p->mean - into->mean;
+    into->mean += d * p->count / n;
+    into->m2 += p->m2 + d * d * ((float)into->count * p->count / n);
+    into->count = n;
+    into->sum += p->sum;
+    into->min = p->min < into->min ? p->min : into->min;
+    into->max = p->max > into->max ? p->max : into->max;
+    if (s->reduce) {
+        into->acc = s->reduce(into->acc, p->acc, s->reduce_ctx);
+    }
+}
+
+static uint32_t watermark_boundary(const so_stream_t *s, uint32_t t) {
+    return t > s->cfg.lateness_ms ? (t - s->cfg.lateness_ms) / s->cfg.slide_ms : 0;
+}
+
+// The window ending at pane boundary b is panes [b - k, b)
+static void emit_window(so_stream_t *s, const so_keystate_t *ks, uint32_t b) {
+    uint32_t k = s->panes_per_window;
+    uint32_t first = b > k ? b - k : 0;
+    so_pane_t agg = { .acc = s->reduce_init };
+    for (uint32_t id = first; id < b; id++) {
+        const so_pane_t *p = &ks->panes[id % SO_MAX_PANES];
+        if (p->count > 0 && p->id == id) {
+            pane_merge(s, &agg, p);
+        }
+    }
+    if (agg.count == 0) {
+        return;
+    }
+    so_window_t w = {
+        .key = ks->key,
+        .start_ms = first * s->cfg.slide_ms,
+        .end_ms = b * s->cfg.slide_ms,
+        .count = agg.count,
+        .sum = agg.sum,
+        .mean = agg.mean,
+        .min = agg.min,
+        .max = agg.max,
+        .stddev = sqrtf(agg.m2 > 0 ? agg.m2 / agg.count : 0),
+        .reduced = agg.acc,
+    };
+    s->windows++;
+    if (s->sink) {
+        s->sink(&w, s->sink_ctx);
+    }
+}
+
+static void emit_until(so_stream_t *s, uint32_t boundary) {
+    uint32_t k = s->panes_per_window;
+    while (s->emitted < boundary) {
+        uint32_t b = s->emitted + 1;
+        // Every key's data is older than this window: so are all the
+        // ones after it, skip straight to the end
+        bool any = false;
+        for (int i = 0; i < SO_MAX_KEYS; i++) {
+            if (s->keys[i].used && s->keys[i].newest + k >= b) {
+                any = true;
+                break;
+            }
+        }
+        if (!any) {
+            s->emitted = boundary;
+            break;
+        }
+        for (int i = 0; i < SO_MAX_KEYS; i++) {
+            if (s->keys[i].used) {
+                emit_window(s, &s->keys[i], b);
+            }
+        }
+        s->emitted = b;
+    }
+}
+
+static so_keystate_t *key_state(so_stream_t *s, uint32_t key, uint32_t pane) {
+    so_keystate_t *spare = NULL;
+    for (int i = 0; i < SO_MAX_KEYS; i++) {
+        if (s->keys[i].used && s->keys[i].key == key) {
+            return &s->keys[i];
+        }
+        if (!s->keys[i].used && spare == NULL) {
+            spare = &s->keys[i];
+        }
+    }
+    if (spare != NULL) {
+        memset(spare, 0, sizeof(*spare));
+        spare->used = true;
+        spare->key = key;
+        spare->newest = pane;
+    }
+    return spare;
+}
+
+bool so_push(so_stream_t *s, uint32_t key, uint32_t ts_ms, float value) {
+    s->samples++;
+    for (uint32_t i = 0; i < s->stage_count; i++) {
+        const so_stage_t *st = &s->stages[i];
+        if (st->is_map) {
+            value = st->map(key, value, st->ctx);
+        } else if (!st->filter(key, value, st->ctx)) {
+            s->filtered++;
+            return false;
+        }
+    }
+
+    if (!s->started) {
+        s->started = true;
+        s->max_ts = ts_ms;
+        s->emitted = watermark_boundary(s, ts_ms);
+    } else if (ts_ms > s->max_ts) {
+        s->max_ts = ts_ms;
+        emit_until(s, watermark_boundary(s, ts_ms));
+    }
+
+    uint32_t pane = ts_ms / s->cfg.slide_ms;
+    if (pane < s->emitted) {
+        s->late++;                  // Its first window is already out
+        return false;
+    }
+    so_keystate_t *ks = key_state(s, key, pane);
+    if (ks == NULL) {
+        s->no_key++;
+        return false;
+    }
+    so_pane_t *p = &ks->panes[pane % SO_MAX_PANES];
+    if (p->count == 0 || p->id != pane) {
+        *p = (so_pane_t){ .id = pane, .acc = s->reduce_init };
+    }
+    pane_add(s, p, value);
+    if (pane > ks->newest) {
+        ks->newest = pane;
+    }
+    return true;
+}
+
+void so_advance(so_stream_t *s, uint32_t now_ms) {
+    if (s->started) {
+        emit_until(s, watermark_boundary(s, now_ms));
+    }
+}
+
+void so_report(const so_stream_t *s, FILE *out) {
+    uint32_t keys = 0;
+    for (int i = 0; i < SO_MAX_KEYS; i++) {
+        keys += s->keys[i].used;
+    }
+    fprintf(out, "streamop [%s]: %lu samples -> %lu windows (%lu keys, %lu ms every %lu ms), "
+                 "%lu filtered, %lu late, %lu without a key slot\n",
+            s->name, (unsigned long)s->samples, (unsigned long)s->windows, (unsigned long)keys,
+            (unsigned long)s->cfg.size_ms, (unsigned long)s->cfg.slide_ms,
+            (unsigned long)s->filtered, (unsigned long)s->late, (unsigned long)s->no_key);
+}
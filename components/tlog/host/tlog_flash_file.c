@@ -0,0 +1,94 @@
+#include <stdlib.h>
+#include <string.h>
+#include "tlog_flash_file.h"
+
+static esp_err_t file_read(void *ctx, size_t addr, void *dst, size_t len) {
+    tlog_flash_file_t *ff = (tlog_flash_file_t *)ctx;
+    if (addr + len > ff->sector_size * ff->sector_count) return ESP_ERR_INVALID_SIZE;
+    if (fseek(ff->file, (long)addr, SEEK_SET) != 0) return ESP_FAIL;
+    return fread(dst, 1, len, ff->file) == len ? ESP_OK : ESP_FAIL;
+}
+
+static esp_err_t file_program(void *ctx, size_t addr, const void *src, size_t len) {
+    tlog_flash_file_t *ff = (tlog_flash_file_t *)ctx;
+    const uint8_t *in = (const uint8_t *)src;
+    uint8_t cur[256];
+
+    if (addr + len > ff->sector_size * ff->sector_count) return ESP_ERR_INVALID_SIZE;
+
+    for (size_t done = 0; done < len; ) {
+        size_t n = len - done < sizeof(cur) ? len - done : sizeof(cur);
+        esp_err_t err = file_read(ff, addr + done, cur, n);
+        if (err != ESP_OK) return err;
+
+        for (size_t i = 0; i < n; i++) {
+            if (in[done + i] & ~cur[i]) ff->bit_set_violations++;
+            cur[i] &= in[done + i];
+        }
+        if (fseek(ff->file, (long)(addr + done), SEEK_SET) != 0) return ESP_FAIL;
+        if (fwrite(cur, 1, n, ff->file) != n) return ESP_FAIL;
+        done += n;
+    }
+
+    ff->program_ops++;
+    ff->program_bytes += len;
+    return ESP_OK;
+}
+
+static esp_err_t file_erase(void *ctx, size_t sector) {
+    tlog_flash_file_t *ff = (tlog_flash_file_t *)ctx;
+    uint8_t blank[256];
+
+    if (sector >= ff->sector_count) return ESP_ERR_INVALID_ARG;
+    memset(blank, 0xFF, sizeof(blank));
+
+    if (fseek(ff->file, (long)(sector * ff->sector_size), SEEK_SET) != 0) return ESP_FAIL;
+    for (size_t done = 0; done < ff->sector_size; done += sizeof(blank)) {
+        size_t n = ff->sector_size - done < sizeof(blank) ? ff->sector_size - done : sizeof(blank);
+        if (fwrite(blank, 1, n, ff->file) != n) return ESP_FAIL;
+    }
+
+    ff->erase_ops++;
+    ff->sector_erases[sector]++;
+    return ESP_OK;
+}
+
+esp_err_t tlog_flash_file_open(tlog_flash_file_t *ff, const char *path,
+                               size_t sector_size, size_t sector_count) {
+    memset(ff, 0, sizeof(*ff));
+    ff->sector_size = sector_size;
+    ff->sector_count = sector_count;
+    ff->sector_erases = calloc(sector_count, sizeof(uint32_t));
+    if (!ff->sector_erases) return ESP_ERR_NO_MEM;
+
+    ff->file = fopen(path, "r+b");
+    if (!ff->file) {
+        // New image - looks like a freshly erased chip
+        ff->file = fopen(path, "w+b");
+        if (!ff->file) return ESP_FAIL;
+        for (size_t s = 0; s < sector_count; s++) {
+            esp_err_t err = file_erase(ff, s);
+            if (err != ESP_OK) return err;
+        }
+        ff->erase_ops = 0;
+        memset(ff->sector_erases, 0, sector_count * sizeof(uint32_t));
+    }
+    return ESP_OK;
+}
+
+void tlog_flash_file_close(tlog_flash_file_t *ff) {
+    if (ff->file) fclose(ff->file);
+    free(ff->sector_erases);
+    memset(ff, 0, sizeof(*ff));
+}
+
+void tlog_flash_file_bind(tlog_flash_file_t *ff, tlog_flash_t *flash) {
+    *flash = (tlog_flash_t){
+        .sector_size = ff->sector_size,
+        .sector_count = ff->sector_count,
+        .read = file_read,
+        .program = file_program,
+        .erase_sector = file_erase,
+        .ctx = ff,
+    };
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+// Host NOR flash emulator for tlog, backed by a regular file.
+// Erase sets a sector to 0xFF; program can only clear bits (new = old & data),
+// like real NOR. Program/erase activity is counted for wear analysis.
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stddef.h>
+#include "tlog.h"
+
+typedef struct {
+    FILE *file;
+    size_t sector_size;
+    size_t sector_count;
+
+    uint32_t program_ops;
+    uint64_t program_bytes;
+    uint32_t erase_ops;
+    uint32_t bit_set_violations;    // Programs that tried to turn 0 bits into 1
+    uint32_t *sector_erases;        // Per-sector erase cycles (this run)
+} tlog_flash_file_t;
+
+// Open (or create, filled with 0xFF) an image of sector_size * sector_count bytes
+esp_err_t tlog_flash_file_open(tlog_flash_file_t *ff, const char *path,
+                               size_t sector_size, size_t sector_count);
+void tlog_flash_file_close(tlog_flash_file_t *ff);
+
+// Fill a tlog_flash_t that routes to this emulator
+void tlog_flash_file_bind(tlog_flash_file_t *ff, tlog_flash_t *flash);
@@ -0,0 +1,130 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "esp_err.h"
+
+// ================ TELEMETRY LOG ================
+// Append-only, log-structured record store on raw NOR flash.
+//
+// Layout: every flash sector is one segment. A segment starts with a
+// 20-byte header (magic, erase count, sequence number, two CRCs) followed
+// by records packed back to back:
+//
+//   | magic u16 | length u16 | timestamp u32 | crc32 u32 | payload | pad to 4 |
+//
+// Appends are collected in a page buffer and programmed one flash page at
+// a time; a record never straddles two segments. When the head segment is
+// full the store opens the least-erased free segment, or reclaims the
+// oldest one when none are free, so every erase buys a full segment of
+// appends and wear spreads evenly. Mount rebuilds a small per-segment
+// index (sequence, time range, record count) and finds the write pointer
+// by scanning the newest segment; a torn record at the tail seals that
+// segment instead of being overwritten.
+//
+// A tlog_t is not thread-safe - own it from a single task.
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define TLOG_MAX_SEGMENTS   64
+#define TLOG_PAGE_SIZE      256     // Program granularity of the page buffer
+#define TLOG_MAX_RECORD     200     // Largest payload accepted by tlog_append
+
+// Raw flash access supplied by a backend (ESP partition, host file...)
+typedef struct {
+    size_t sector_size;
+    size_t sector_count;
+    esp_err_t (*read)(void *ctx, size_t addr, void *dst, size_t len);
+    esp_err_t (*program)(void *ctx, size_t addr, const void *src, size_t len);
+    esp_err_t (*erase_sector)(void *ctx, size_t sector);
+    void *ctx;
+} tlog_flash_t;
+
+typedef enum {
+    TLOG_SEG_BLANK = 0,     // Header never written (fresh or erased flash)
+    TLOG_SEG_PREPARED,      // Formatted: erase count recorded, not in use
+    TLOG_SEG_ACTIVE,        // Holds records, ordered by seq
+    TLOG_SEG_INVALID,       // Unreadable header - erased before reuse
+} tlog_seg_state_t;
+
+// In-RAM index entry - one per segment
+typedef struct {
+    tlog_seg_state_t state;
+    uint32_t seq;
+    uint32_t erase_count;
+    uint32_t first_ts;
+    uint32_t last_ts;
+    uint32_t records;
+} tlog_segment_t;
+
+typedef struct {
+    uint32_t records_appended;
+    uint32_t bytes_appended;        // Payload bytes
+    uint32_t bytes_programmed;      // Everything written to flash
+    uint32_t program_ops;
+    uint32_t erase_ops;
+    uint32_t segments_dropped;      // Oldest segments reclaimed while full
+    uint32_t torn_records;          // Corrupt records found by recovery
+    uint32_t records_stored;        // Currently readable records (computed)
+    uint32_t segments_used;
+    uint32_t min_erase_count;
+    uint32_t max_erase_count;
+} tlog_stats_t;
+
+typedef struct {
+    tlog_flash_t flash;
+    tlog_segment_t segments[TLOG_MAX_SEGMENTS];
+    uint32_t segment_count;
+
+    // Head segment and its page buffer
+    int head;                       // Index into segments[], -1 = none open
+    bool head_sealed;               // No more appends (full or torn tail)
+    uint32_t head_seq;
+    size_t page_offset;             // Segment offset of the buffered page
+    size_t page_fill;               // Bytes valid in page_buf
+    size_t page_flushed;            // Bytes of page_buf already programmed
+    uint8_t page_buf[TLOG_PAGE_SIZE];
+
+    uint32_t last_timestamp;
+    tlog_stats_t stats;
+} tlog_t;
+
+// Called for each record in a range read; return false to stop early
+typedef bool (*tlog_visit_fn_t)(uint32_t timestamp, const void *data, uint16_t len, void *ctx);
+
+// Scan the flash, rebuild the index and position the write pointer.
+// Blank or foreign flash is adopted segment by segment as it is needed.
+esp_err_t tlog_mount(tlog_t *log, const tlog_flash_t *flash);
+
+// Erase every segment and start an empty log
+esp_err_t tlog_format(tlog_t *log);
+
+// Append one record. Timestamps should be non-decreasing (e.g. ms since
+// first boot - see tlog_last_timestamp) for range reads to skip segments.
+esp_err_t tlog_append(tlog_t *log, uint32_t timestamp, const void *data, uint16_t len);
+
+// Program the partially filled page so buffered records survive a reset
+esp_err_t tlog_flush(tlog_t *log);
+
+// Visit records with from <= timestamp <= to, oldest segment first
+esp_err_t tlog_read_range(tlog_t *log, uint32_t from, uint32_t to,
+                          tlog_visit_fn_t visit, void *ctx);
+
+// Newest timestamp in the log (0 if empty)
+static inline uint32_t tlog_last_timestamp(const tlog_t *log) {
+    return log->last_timestamp;
+}
+
+void tlog_get_stats(const tlog_t *log, tlog_stats_t *out);
+
+#ifdef ESP_PLATFORM
+// Backend over a raw data partition (see partitions.csv of the lab)
+esp_err_t tlog_flash_partition_init(tlog_flash_t *flash, const char *label);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,549 @@
+#include <string.h>
+#include "tlog.h"
+#include "integrity.h"
+
+#define SEG_MAGIC           0x474F4C54u     // "TLOG"
+#define SEG_HEADER_SIZE     20
+#define SEQ_BLANK           0xFFFFFFFFu
+
+#define REC_MAGIC           0x5A7Eu
+#define REC_HEADER_SIZE     12
+#define REC_ALIGN           4
+
+// Segment header. magic/erase_count/info_crc are written when the segment
+// is prepared; seq/seq_crc are written when it becomes the head, so a
+// formatted segment can be opened without a second erase.
+typedef struct {
+    uint32_t magic;
+    uint32_t erase_count;
+    uint32_t info_crc;
+    uint32_t seq;
+    uint32_t seq_crc;
+} seg_header_t;
+
+typedef struct {
+    uint16_t magic;
+    uint16_t length;
+    uint32_t timestamp;
+    uint32_t crc;
+} rec_header_t;
+
+_Static_assert(sizeof(seg_header_t) == SEG_HEADER_SIZE, "segment header layout");
+_Static_assert(sizeof(rec_header_t) == REC_HEADER_SIZE, "record header layout");
+
+typedef enum {
+    SCAN_END,       // Reached erased space or the end of the segment
+    SCAN_CORRUPT,   // Found a torn or damaged record
+    SCAN_STOPPED,   // Visitor asked to stop
+    SCAN_ERROR,     // Flash read failed
+} scan_result_t;
+
+typedef bool (*scan_fn_t)(tlog_t *log, const rec_header_t *hdr, const uint8_t *payload, void *ctx);
+
+static inline size_t align_up(size_t n) {
+    return (n + REC_ALIGN - 1) & ~(size_t)(REC_ALIGN - 1);
+}
+
+static inline size_t seg_addr(const tlog_t *log, int seg) {
+    return (size_t)seg * log->flash.sector_size;
+}
+
+static inline size_t write_pointer(const tlog_t *log) {
+    return log->page_offset + log->page_fill;
+}
+
+static bool is_blank(const void *data, size_t len) {
+    return integrity_verify8(data, 0xFF, len, NULL);
+}
+
+static uint32_t info_crc(const seg_header_t *hdr) {
+    return integrity_crc32(0, hdr, offsetof(seg_header_t, info_crc));
+}
+
+static uint32_t seq_crc(uint32_t seq) {
+    return integrity_crc32(0, &seq, sizeof(seq));
+}
+
+static uint32_t record_crc(const rec_header_t *hdr, const void *payload) {
+    uint32_t crc = integrity_crc32(0, &hdr->length, sizeof(hdr->length) + sizeof(hdr->timestamp));
+    return integrity_crc32(crc, payload, hdr->length);
+}
+
+// ================ FLASH ACCESS ================
+
+// Read segment bytes, overlaying anything still sitting in the page buffer
+static esp_err_t seg_read(tlog_t *log, int seg, size_t offset, void *dst, size_t len) {
+    esp_err_t err = log->flash.read(log->flash.ctx, seg_addr(log, seg) + offset, dst, len);
+    if (err != ESP_OK || seg != log->head) {
+        return err;
+    }
+
+    size_t buf_start = log->page_offset;
+    size_t buf_end = log->page_offset + log->page_fill;
+    size_t lo = offset > buf_start ? offset : buf_start;
+    size_t hi = (offset + len) < buf_end ? (offset + len) : buf_end;
+    if (lo < hi) {
+        memcpy((uint8_t *)dst + (lo - offset), log->page_buf + (lo - buf_start), hi - lo);
+    }
+    return ESP_OK;
+}
+
+static esp_err_t program(tlog_t *log, int seg, size_t offset, const void *src, size_t len) {
+    esp_err_t err = log->flash.program(log->flash.ctx, seg_addr(log, seg) + offset, src, len);
+    if (err == ESP_OK) {
+        log->stats.program_ops++;
+        log->stats.bytes_programmed += len;
+    }
+    return err;
+}
+
+static esp_err_t flush_page(tlog_t *log) {
+    if (log->head < 0 || log->page_fill == log->page_flushed) {
+        return ESP_OK;
+    }
+    esp_err_t err = program(log, log->head, log->page_offset + log->page_flushed,
+                            log->page_buf + log->page_flushed,
+                            log->page_fill - log->page_flushed);
+    if (err == ESP_OK) {
+        log->page_flushed = log->page_fill;
+    }
+    return err;
+}
+
+// Copy into the page buffer, programming each page as it fills
+static esp_err_t buffer_write(tlog_t *log, const void *data, size_t len) {
+    const uint8_t *src = (const uint8_t *)data;
+
+    while (len > 0) {
+        size_t n = TLOG_PAGE_SIZE - log->page_fill;
+        if (n > len) n = len;
+
+        memcpy(log->page_buf + log->page_fill, src, n);
+        log->page_fill += n;
+        src += n;
+        len -= n;
+
+        if (log->page_fill == TLOG_PAGE_SIZE) {
+            esp_err_t err = flush_page(log);
+            if (err != ESP_OK) return err;
+            log->page_offset += TLOG_PAGE_SIZE;
+            log->page_fill = 0;
+            log->page_flushed = 0;
+        }
+    }
+    return ESP_OK;
+}
+
+// ================ SEGMENT SCANNING ================
+
+static tlog_seg_state_t parse_header(const seg_header_t *hdr) {
+    if (is_blank(hdr, sizeof(*hdr))) {
+        return TLOG_SEG_BLANK;
+    }
+    if (hdr->magic != SEG_MAGIC || hdr->info_crc != info_crc(hdr)) {
+        return TLOG_SEG_INVALID;
+    }
+    if (hdr->seq == SEQ_BLANK && hdr->seq_crc == SEQ_BLANK) {
+        return TLOG_SEG_PREPARED;
+    }
+    if (hdr->seq == SEQ_BLANK || hdr->seq_crc != seq_crc(hdr->seq)) {
+        return TLOG_SEG_INVALID;    // Torn while becoming the head
+    }
+    return TLOG_SEG_ACTIVE;
+}
+
+// Walk records from the start of a segment; *end_out receives the offset
+// just past the last good record
+static scan_result_t scan_segment(tlog_t *log, int seg, scan_fn_t fn, void *ctx, size_t *end_out) {
+    size_t sector = log->flash.sector_size;
+    size_t offset = SEG_HEADER_SIZE;
+    uint8_t payload[TLOG_MAX_RECORD];
+    scan_result_t result = SCAN_END;
+
+    while (offset + REC_HEADER_SIZE <= sector) {
+        rec_header_t hdr;
+        if (seg_read(log, seg, offset, &hdr, sizeof(hdr)) != ESP_OK) {
+            result = SCAN_ERROR;
+            break;
+        }
+        if (is_blank(&hdr, sizeof(hdr))) {
+            break;
+        }
+        if (hdr.magic != REC_MAGIC || hdr.length == 0 || hdr.length > TLOG_MAX_RECORD ||
+            offset + REC_HEADER_SIZE + hdr.length > sector) {
+            result = SCAN_CORRUPT;
+            break;
+        }
+        if (seg_read(log, seg, offset + REC_HEADER_SIZE, payload, hdr.length) != ESP_OK) {
+            result = SCAN_ERROR;
+            break;
+        }
+        if (hdr.crc != record_crc(&hdr, payload)) {
+            result = SCAN_CORRUPT;
+            break;
+        }
+
+        offset += align_up(REC_HEADER_SIZE + hdr.length);
+        if (fn && !fn(log, &hdr, payload, ctx)) {
+            result = SCAN_STOPPED;
+            break;
+        }
+    }
+
+    if (end_out) *end_out = offset;
+    return result;
+}
+
+static bool index_record(tlog_t *log, const rec_header_t *hdr, const uint8_t *payload, void *ctx) {
+    tlog_segment_t *entry = (tlog_segment_t *)ctx;
+    (void)log;
+    (void)payload;
+
+    if (entry->records == 0) {
+        entry->first_ts = hdr->timestamp;
+    }
+    entry->last_ts = hdr->timestamp;
+    entry->records++;
+    return true;
+}
+
+// ================ SEGMENT ROTATION ================
+
+static int pick_next_segment(tlog_t *log) {
+    int best = -1;
+
+    // Least-worn segment that holds no live data
+    for (int i = 0; i < (int)log->segment_count; i++) {
+        const tlog_segment_t *s = &log->segments[i];
+        if (s->state != TLOG_SEG_ACTIVE &&
+            (best < 0 || s->erase_count < log->segments[best].erase_count)) {
+            best = i;
+        }
+    }
+    if (best >= 0) return best;
+
+    // Log is full - reclaim the oldest segment
+    for (int i = 0; i < (int)log->segment_count; i++) {
+        if (i != log->head &&
+            (best < 0 || log->segments[i].seq < log->segments[best].seq)) {
+            best = i;
+        }
+    }
+    return best;
+}
+
+// True if everything after the header area is still erased
+static esp_err_t data_area_blank(tlog_t *log, int seg, bool *blank) {
+    uint8_t chunk[64];
+    *blank = false;
+
+    for (size_t off = SEG_HEADER_SIZE; off < log->flash.sector_size; off += sizeof(chunk)) {
+        size_t n = log->flash.sector_size - off;
+        if (n > sizeof(chunk)) n = sizeof(chunk);
+        esp_err_t err = log->flash.read(log->flash.ctx, seg_addr(log, seg) + off, chunk, n);
+        if (err != ESP_OK) return err;
+        if (!is_blank(chunk, n)) return ESP_OK;
+    }
+    *blank = true;
+    return ESP_OK;
+}
+
+static esp_err_t open_segment(tlog_t *log) {
+    esp_err_t err = flush_page(log);
+    if (err != ESP_OK) return err;
+
+    int seg = pick_next_segment(log);
+    if (seg < 0) return ESP_ERR_NO_MEM;
+
+    tlog_segment_t *entry = &log->segments[seg];
+    bool dropping = entry->state == TLOG_SEG_ACTIVE;
+
+    // Blank and prepared segments skip the erase if nothing else was written
+    bool reuse = false;
+    if (entry->state == TLOG_SEG_BLANK || entry->state == TLOG_SEG_PREPARED) {
+        err = data_area_blank(log, seg, &reuse);
+        if (err != ESP_OK) return err;
+    }
+
+    seg_header_t hdr;
+    if (!reuse) {
+        err = log->flash.erase_sector(log->flash.ctx, seg);
+        if (err != ESP_OK) return err;
+        log->stats.erase_ops++;
+        entry->erase_count++;
+        entry->state = TLOG_SEG_BLANK;
+        // Only now are its records gone; a failed erase leaves them readable
+        if (dropping) {
+            log->stats.segments_dropped++;
+        }
+    }
+
+    hdr.magic = SEG_MAGIC;
+    hdr.erase_count = entry->erase_count;
+    hdr.info_crc = info_crc(&hdr);
+    hdr.seq = log->head_seq + 1;
+    hdr.seq_crc = seq_crc(hdr.seq);
+
+    // Prepared segments already carry magic/erase_count - add only the seq
+    size_t skip = entry->state == TLOG_SEG_PREPARED ? offsetof(seg_header_t, seq) : 0;
+
+    log->head = seg;
+    log->head_sealed = false;
+    log->head_seq = hdr.seq;
+    log->page_offset = 0;
+    log->page_fill = 0;
+    log->page_flushed = 0;
+
+    entry->state = TLOG_SEG_ACTIVE;
+    entry->seq = hdr.seq;
+    entry->records = 0;
+    entry->first_ts = 0;
+    entry->last_ts = 0;
+
+    // Header goes out immediately so recovery recognises the segment
+    memcpy(log->page_buf, &hdr, sizeof(hdr));
+    log->page_fill = SEG_HEADER_SIZE;
+    log->page_flushed = skip;
+    return flush_page(log);
+}
+
+// ================ PUBLIC API ================
+
+esp_err_t tlog_mount(tlog_t *log, const tlog_flash_t *flash) {
+    if (!log || !flash || !flash->read || !flash->program || !flash->erase_sector) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (flash->sector_count < 2 || flash->sector_count > TLOG_MAX_SEGMENTS ||
+        flash->sector_size % TLOG_PAGE_SIZE != 0) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    memset(log, 0, sizeof(*log));
+    log->flash = *flash;
+    log->segment_count = flash->sector_count;
+    log->head = -1;
+
+    int newest = -1;
+    size_t newest_end = 0;
+    scan_result_t newest_result = SCAN_END;
+    uint32_t max_erase = 0;
+    bool unknown_wear[TLOG_MAX_SEGMENTS] = { false };
+
+    for (int i = 0; i < (int)log->segment_count; i++) {
+        tlog_segment_t *entry = &log->segments[i];
+        seg_header_t hdr;
+
+        esp_err_t err = flash->read(flash->ctx, seg_addr(log, i), &hdr, sizeof(hdr));
+        if (err != ESP_OK) return err;
+
+        entry->state = parse_header(&hdr);
+        if (entry->state == TLOG_SEG_BLANK) {
+            continue;
+        }
+        // A segment torn while becoming the head still has a good info
+        // part; only a damaged one has lost its erase count
+        if (hdr.magic == SEG_MAGIC && hdr.info_crc == info_crc(&hdr)) {
+            entry->erase_count = hdr.erase_count;
+            if (hdr.erase_count > max_erase) max_erase = hdr.erase_count;
+        } else {
+            unknown_wear[i] = true;
+        }
+        if (entry->state != TLOG_SEG_ACTIVE) {
+            continue;
+        }
+
+        entry->seq = hdr.seq;
+        size_t end;
+        scan_result_t result = scan_segment(log, i, index_record, entry, &end);
+        if (result == SCAN_ERROR) return ESP_FAIL;
+        if (result == SCAN_CORRUPT) log->stats.torn_records++;
+
+        if (entry->records > 0 && entry->last_ts > log->last_timestamp) {
+            log->last_timestamp = entry->last_ts;
+        }
+        if (newest < 0 || entry->seq > log->segments[newest].seq) {
+            newest = i;
+            newest_end = end;
+            newest_result = result;
+        }
+    }
+
+    // Damaged headers: assume the wear of the most-worn segment rather
+    // than 0, so wear levelling doesn't pick them first
+    for (int i = 0; i < (int)log->segment_count; i++) {
+        if (unknown_wear[i]) {
+            log->segments[i].erase_count = max_erase;
+        }
+    }
+
+    if (newest < 0) {
+        return ESP_OK;      // Empty log - first append opens a segment
+    }
+
+    // Resume appending at the end of the newest segment
+    log->head = newest;
+    log->head_seq = log->segments[newest].seq;
+
+    if (newest_result == SCAN_CORRUPT ||
+        newest_end + REC_HEADER_SIZE + REC_ALIGN > flash->sector_size) {
+        log->head_sealed = true;
+        log->page_offset = newest_end;
+        return ESP_OK;
+    }
+
+    log->page_offset = newest_end & ~(size_t)(TLOG_PAGE_SIZE - 1);
+    log->page_fill = newest_end - log->page_offset;
+    log->page_flushed = log->page_fill;
+    return flash->read(flash->ctx, seg_addr(log, newest) + log->page_offset,
+                       log->page_buf, log->page_fill);
+}
+
+esp_err_t tlog_format(tlog_t *log) {
+    for (int i = 0; i < (int)log->segment_count; i++) {
+        tlog_segment_t *entry = &log->segments[i];
+
+        esp_err_t err = log->flash.erase_sector(log->flash.ctx, i);
+        if (err != ESP_OK) return err;
+        log->stats.erase_ops++;
+
+        seg_header_t hdr = {
+            .magic = SEG_MAGIC,
+            .erase_count = entry->erase_count + 1,
+            .seq = SEQ_BLANK,
+            .seq_crc = SEQ_BLANK,
+        };
+        hdr.info_crc = info_crc(&hdr);
+
+        err = program(log, i, 0, &hdr, offsetof(seg_header_t, seq));
+        if (err != ESP_OK) return err;
+
+        *entry = (tlog_segment_t){
+            .state = TLOG_SEG_PREPARED,
+            .erase_count = hdr.erase_count,
+        };
+    }
+
+    log->head = -1;
+    log->head_sealed = false;
+    log->head_seq = 0;
+    log->page_offset = 0;
+    log->page_fill = 0;
+    log->page_flushed = 0;
+    log->last_timestamp = 0;
+    return ESP_OK;
+}
+
+esp_err_t tlog_append(tlog_t *log, uint32_t timestamp, const void *data, uint16_t len) {
+    if (len == 0 || len > TLOG_MAX_RECORD) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    size_t rec_size = align_up(REC_HEADER_SIZE + len);
+    if (log->head < 0 || log->head_sealed ||
+        write_pointer(log) + rec_size > log->flash.sector_size) {
+        esp_err_t err = open_segment(log);
+        if (err != ESP_OK) return err;
+    }
+
+    rec_header_t hdr = {
+        .magic = REC_MAGIC,
+        .length = len,
+        .timestamp = timestamp,
+    };
+    hdr.crc = record_crc(&hdr, data);
+
+    static const uint8_t pad[REC_ALIGN] = {0xFF, 0xFF, 0xFF, 0xFF};
+    esp_err_t err = buffer_write(log, &hdr, sizeof(hdr));
+    if (err == ESP_OK) err = buffer_write(log, data, len);
+    if (err == ESP_OK) err = buffer_write(log, pad, rec_size - REC_HEADER_SIZE - len);
+    if (err != ESP_OK) {
+        log->head_sealed = true;    // Never append after a failed program
+        return err;
+    }
+
+    tlog_segment_t *entry = &log->segments[log->head];
+    if (entry->records == 0) {
+        entry->first_ts = timestamp;
+    }
+    entry->last_ts = timestamp;
+    entry->records++;
+
+    if (timestamp > log->last_timestamp) {
+        log->last_timestamp = timestamp;
+    }
+    log->stats.records_appended++;
+    log->stats.bytes_appended += len;
+    return ESP_OK;
+}
+
+esp_err_t tlog_flush(tlog_t *log) {
+    if (log->head_sealed) {
+        return ESP_OK;
+    }
+    return flush_page(log);
+}
+
+typedef struct {
+    uint32_t from;
+    uint32_t to;
+    tlog_visit_fn_t visit;
+    void *ctx;
+} range_ctx_t;
+
+static bool range_record(tlog_t *log, const rec_header_t *hdr, const uint8_t *payload, void *ctx) {
+    range_ctx_t *range = (range_ctx_t *)ctx;
+    (void)log;
+
+    if (hdr->timestamp < range->from || hdr->timestamp > range->to) {
+        return true;
+    }
+    return range->visit(hdr->timestamp, payload, hdr->length, range->ctx);
+}
+
+esp_err_t tlog_read_range(tlog_t *log, uint32_t from, uint32_t to,
+                          tlog_visit_fn_t visit, void *ctx) {
+    range_ctx_t range = {from, to, visit, ctx};
+    uint32_t last_seq = 0;
+
+    // Visit active segments in sequence order (index is small - no sort needed)
+    while (1) {
+        int next = -1;
+        for (int i = 0; i < (int)log->segment_count; i++) {
+            const tlog_segment_t *s = &log->segments[i];
+            if (s->state == TLOG_SEG_ACTIVE && s->seq > last_seq &&
+                (next < 0 || s->seq < log->segments[next].seq)) {
+                next = i;
+            }
+        }
+        if (next < 0) break;
+
+        const tlog_segment_t *s = &log->segments[next];
+        last_seq = s->seq;
+        if (s->records == 0 || s->last_ts < from || s->first_ts > to) {
+            continue;
+        }
+
+        scan_result_t result = scan_segment(log, next, range_record, &range, NULL);
+        if (result == SCAN_ERROR) return ESP_FAIL;
+        if (result == SCAN_STOPPED) break;
+    }
+    return ESP_OK;
+}
+
+void tlog_get_stats(const tlog_t *log, tlog_stats_t *out) {
+    *out = log->stats;
+    out->records_stored = 0;
+    out->segments_used = 0;
+    out->min_erase_count = UINT32_MAX;
+    out->max_erase_count = 0;
+
+    for (int i = 0; i < (int)log->segment_count; i++) {
+        const tlog_segment_t *s = &log->segments[i];
+        if (s->state == TLOG_SEG_ACTIVE) {
+            out->records_stored += s->records;
+            out->segments_used++;
+        }
+        if (s->erase_count < out->min_erase_count) out->min_erase_count = s->erase_count;
+        if (s->erase_count > out->max_erase_count) out->max_erase_count = s->erase_count;
+    }
+}
@@ -0,0 +1,36 @@
+#include "tlog.h"
+#include "esp_partition.h"
+
+// ================ ESP PARTITION BACKEND ================
+
+static esp_err_t partition_read(void *ctx, size_t addr, void *dst, size_t len) {
+    return esp_partition_read((const esp_partition_t *)ctx, addr, dst, len);
+}
+
+static esp_err_t partition_program(void *ctx, size_t addr, const void *src, size_t len) {
+    return esp_partition_write((const esp_partition_t *)ctx, addr, src, len);
+}
+
+static esp_err_t partition_erase(void *ctx, size_t sector) {
+    const esp_partition_t *part = (const esp_partition_t *)ctx;
+    return esp_partition_erase_range(part, sector * part->erase_size, part->erase_size);
+}
+
+esp_err_t tlog_flash_partition_init(tlog_flash_t *flash, const char *label) {
+    const esp_partition_t *part = esp_partition_find_first(ESP_PARTITION_TYPE_DATA,
+                                                           ESP_PARTITION_SUBTYPE_ANY,
+                                                           label);
+    if (part == NULL) {
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    *flash = (tlog_flash_t){
+        .sector_size = part->erase_size,
+        .sector_count = part->size / part->erase_size,
+        .read = partition_read,
+        .program = partition_program,
+        .erase_sector = partition_erase,
+        .ctx = (void *)part,
+    };
+    return ESP_OK;
+}
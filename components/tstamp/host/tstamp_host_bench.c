@@ -0,0 +1,109 @@
+// Host check for the timestamp service: cost of ts_now() next to
+// clock_gettime(), agreement with CLOCK_MONOTONIC after calibration,
+// the ts_us32() fast path against the exact conversion, and ordering of
+// timestamps handed between threads on whatever CPUs the OS picks.
+//
+// Build and run from this directory:
+//   cc -O2 -pthread -I../include -I../../../tools/host_include ../tstamp.c tstamp_host_bench.c -o tstamp_bench
+//   ./tstamp_bench
+
+#include <stdio.h>
+#include <inttypes.h>
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+#include "tstamp.h"
+#include "host_check.h"
+
+#define CALLS           10000000
+#define HANDOFFS        200000
+
+static uint64_t mono_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000u + ts.tv_nsec / 1000;
+}
+
+// ---- Ping-pong: each side stamps after seeing the other's stamp ----
+
+static ts_t baton;
+static uint32_t turn;
+static uint32_t backwards;
+
+static void *pong(void *arg) {
+    uint32_t me = (uint32_t)(uintptr_t)arg;
+    for (int i = 0; i < HANDOFFS; i++) {
+        while (__atomic_load_n(&turn, __ATOMIC_ACQUIRE) != me) {
+            sched_yield();
+        }
+        ts_t seen = __atomic_load_n(&baton, __ATOMIC_RELAXED);
+        ts_t now = ts_now();
+        if (now < seen) {
+            backwards++;
+        }
+        __atomic_store_n(&baton, now, __ATOMIC_RELAXED);
+        __atomic_store_n(&turn, 1 - me, __ATOMIC_RELEASE);
+    }
+    return NULL;
+}
+
+int main(void) {
+    ts_init();
+    ts_calibration_t cal;
+    ts_get_calibration(&cal);
+    printf("Clock: %" PRIu64 " Hz, offset %" PRId64 " ticks (+/- %u)\n",
+           cal.hz, cal.offset[0], cal.error[0]);
+
+    printf("\n== Cost ==\n");
+    volatile ts_t sink = 0;
+    uint64_t t0 = mono_us();
+    for (int i = 0; i < CALLS; i++) {
+        sink = ts_now();
+    }
+    uint64_t t1 = mono_us();
+    for (int i = 0; i < CALLS; i++) {
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        sink = (ts_t)ts.tv_nsec;
+    }
+    uint64_t t2 = mono_us();
+    printf("ts_now: %.1f ns, clock_gettime: %.1f ns\n",
+           (t1 - t0) * 1000.0 / CALLS, (t2 - t1) * 1000.0 / CALLS);
+    (void)sink;
+
+    printf("\n== Epoch and rate ==\n");
+    int64_t skew_start = (int64_t)ts_to_us(ts_now()) - (int64_t)mono_us();
+    struct timespec pause = { 0, 200000000 };
+    nanosleep(&pause, NULL);
+    int64_t skew_end = (int64_t)ts_to_us(ts_now()) - (int64_t)mono_us();
+    printf("ts - CLOCK_MONOTONIC: %" PRId64 " us, %" PRId64 " us after 200 ms\n",
+           skew_start, skew_end);
+    CHECK(skew_start >= -2 && skew_start <= 2, "epoch off by %" PRId64 " us", skew_start);
+    CHECK(skew_end - skew_start >= -20 && skew_end - skew_start <= 20,
+          "rate drifts %" PRId64 " us per 200 ms", skew_end - skew_start);
+
+    printf("\n== ts_us32 ==\n");
+    uint32_t worst = 0;
+    for (uint64_t us = 1; us < 4000000000u; us = us * 3 + 7) {
+        ts_t dt = ts_from_us(us);
+        uint32_t fast = ts_us32(dt);
+        uint64_t exact = ts_to_us(dt);
+        uint32_t diff = fast > exact ? (uint32_t)(fast - exact) : (uint32_t)(exact - fast);
+        worst = diff > worst ? diff : worst;
+    }
+    printf("worst fast-path error: %u us\n", worst);
+    CHECK(worst <= 1, "ts_us32 off by %u us", worst);
+    CHECK(ts_us32(ts_from_us(10000000000ull)) == UINT32_MAX, "no saturation");
+
+    printf("\n== %d hand-offs between threads ==\n", HANDOFFS);
+    pthread_t a, b;
+    pthread_create(&a, NULL, pong, (void *)0);
+    pthread_create(&b, NULL, pong, (void *)1);
+    pthread_join(a, NULL);
+    pthread_join(b, NULL);
+    printf("went backwards: %u\n", backwards);
+    CHECK(backwards == 0, "%u timestamps older than the one handed over", backwards);
+
+    printf("\n%s\n", failures ? "FAILURES" : "OK");
+    return failures != 0;
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <stdint.h>
+#include "esp_err.h"
+
+// ================ TIMESTAMPS ================
+// One 64-bit monotonic timestamp for all instrumentation: CPU cycles
+// since boot, extended from each core's 32-bit cycle counter and shifted
+// per core so values taken on either core compare directly.
+//
+//   ts_t t0 = ts_now();                    // a few dozen cycles, ISR safe
+//   ...
+//   uint32_t us = ts_us32(ts_now() - t0);  // one multiply
+//
+// Call ts_init() once from app_main before anything timestamps. It
+// calibrates each core's offset against esp_timer, so
+// ts_to_us(ts_now()) tracks esp_timer_get_time() and the two can be
+// mixed. Until then ts_now() still counts, but values from different
+// cores are not comparable and a counter wrap (~18 s at 240 MHz) with
+// no read in between is missed.
+//
+// The cycle counter is the clock: this needs a fixed CPU frequency
+// (no CONFIG_PM_ENABLE frequency scaling or light sleep).
+//
+// On the host the same API runs on rdtsc (x86) or CLOCK_MONOTONIC.
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define TS_MAX_CORES        2
+
+typedef uint64_t ts_t;              // Ticks: CPU cycles (host: TSC ticks or ns)
+
+typedef struct {
+    uint64_t hz;                    // Ticks per second
+    uint8_t cores;
+    int64_t offset[TS_MAX_CORES];   // Added to each core's extended counter
+    uint32_t error[TS_MAX_CORES];   // +/- ticks the offset may be off by
+} ts_calibration_t;
+
+esp_err_t ts_init(void);
+
+ts_t ts_now(void);
+
+uint64_t ts_hz(void);
+uint64_t ts_to_ns(ts_t t);
+uint64_t ts_to_us(ts_t t);
+ts_t ts_from_us(uint64_t us);
+
+// Fast path for short intervals: microseconds, saturating at UINT32_MAX
+uint32_t ts_us32(ts_t dt);
+
+void ts_get_calibration(ts_calibration_t *out);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,268 @@
+#include "tstamp.h"
+
+#ifdef ESP_PLATFORM
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_attr.h"
+#include "esp_cpu.h"
+#include "esp_rom_sys.h"
+#include "esp_timer.h"
+#include "esp_freertos_hooks.h"
+#include "esp_log.h"
+#else
+#include <time.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define TS_HOST_TSC         1
+#endif
+#endif
+
+#define CALIBRATION_ROUNDS  16
+
+static uint64_t clock_hz;
+static uint32_t us_mul_q32;         // 2^32 * 1e6 / clock_hz, for ts_us32()
+static ts_calibration_t calib;
+
+static void set_rate(uint64_t hz) {
+    clock_hz = hz;
+    us_mul_q32 = (uint32_t)((1000000ull << 32) / hz);
+    calib.hz = hz;
+}
+
+#ifdef ESP_PLATFORM
+
+static const char *TAG = "TSTAMP";
+
+// ================ CYCLE COUNTER (DEVICE) ================
+// The cycle counter is 32 bits and per core. Each core extends its own
+// with interrupts masked, so only code on that core ever touches its
+// state, and a tick hook reads it every tick so no wrap is missed.
+
+typedef struct {
+    uint32_t last;
+    uint32_t high;
+} ts_core_t;
+
+static DRAM_ATTR ts_core_t cores[portNUM_PROCESSORS];
+static DRAM_ATTR int64_t core_offset[portNUM_PROCESSORS];
+static bool initialized;
+
+static inline IRAM_ATTR uint64_t extend(ts_core_t *c) {
+    uint32_t cc = esp_cpu_get_cycle_count();
+    if (cc < c->last) {
+        c->high++;
+    }
+    c->last = cc;
+    return (uint64_t)c->high << 32 | cc;
+}
+
+IRAM_ATTR ts_t ts_now(void) {
+    uint32_t irq = portSET_INTERRUPT_MASK_FROM_ISR();
+    int core = esp_cpu_get_core_id();
+    ts_t t = extend(&cores[core]) + core_offset[core];
+    portCLEAR_INTERRUPT_MASK_FROM_ISR(irq);
+    return t;
+}
+
+static IRAM_ATTR void tick_hook(void) {
+    (void)ts_now();
+}
+
+static void ensure_rate(void) {
+    if (clock_hz == 0) {
+        set_rate((uint64_t)esp_rom_get_cpu_ticks_per_us() * 1000000u);
+    }
+}
+
+// Pin this core's counter to esp_timer (one timer shared by both cores).
+// Spin until the microsecond count steps: the step happened at exactly
+// that microsecond, somewhere between the cycle reads bracketing the
+// two esp_timer calls. The narrowest bracket of a few rounds wins.
+static void calibrate_this_core(int core) {
+    ts_core_t *c = &cores[core];
+    uint64_t best_window = UINT64_MAX;
+
+    for (int round = 0; round < CALIBRATION_ROUNDS; round++) {
+        uint32_t irq = portSET_INTERRUPT_MASK_FROM_ISR();
+        uint64_t before_prev = extend(c);
+        int64_t prev = esp_timer_get_time();
+        int64_t step;
+        uint64_t after;
+        for (;;) {
+            uint64_t before = extend(c);
+            step = esp_timer_get_time();
+            after = extend(c);
+            if (step != prev) {
+                break;
+            }
+            before_prev = before;
+        }
+        portCLEAR_INTERRUPT_MASK_FROM_ISR(irq);
+
+        uint64_t window = after - before_prev;
+        if (window < best_window) {
+            best_window = window;
+            core_offset[core] = (int64_t)((uint64_t)step * (clock_hz / 1000000u)) -
+                                (int64_t)(before_prev + window / 2);
+        }
+    }
+    calib.offset[core] = core_offset[core];
+    calib.error[core] = (uint32_t)(best_window / 2);
+}
+
+typedef struct {
+    TaskHandle_t caller;
+    esp_err_t err;
+} calib_setup_t;
+
+// Runs pinned to each core: the counter it calibrates is that core's
+static void calib_task(void *arg) {
+    calib_setup_t *setup = (calib_setup_t *)arg;
+    int core = xPortGetCoreID();
+
+    setup->err = esp_register_freertos_tick_hook_for_cpu(tick_hook, core);
+    if (setup->err == ESP_OK) {
+        calibrate_this_core(core);
+    }
+    xTaskNotifyGive(setup->caller);
+    vTaskDelete(NULL);
+}
+
+esp_err_t ts_init(void) {
+    if (initialized) {
+        return ESP_OK;
+    }
+    ensure_rate();
+    calib.cores = portNUM_PROCESSORS;
+
+    for (int core = 0; core < portNUM_PROCESSORS; core++) {
+        calib_setup_t setup = { .caller = xTaskGetCurrentTaskHandle(), .err = ESP_FAIL };
+        if (xTaskCreatePinnedToCore(calib_task, "ts_calib", 2048, &setup,
+                                    configMAX_PRIORITIES - 1, NULL, core) != pdPASS) {
+            return ESP_ERR_NO_MEM;
+        }
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        if (setup.err != ESP_OK) {
+            ESP_LOGE(TAG, "❌ Tick hook on core %d failed: %s", core, esp_err_to_name(setup.err));
+            return setup.err;
+        }
+    }
+    initialized = true;
+
+    for (int core = 0; core < portNUM_PROCESSORS; core++) {
+        ESP_LOGI(TAG, "⏱️ Core %d: cycle clock %lu MHz, offset %lld cycles (±%lu ns)",
+                 core, (uint32_t)(clock_hz / 1000000u), calib.offset[core],
+                 (uint32_t)ts_to_ns(calib.error[core]));
+    }
+    return ESP_OK;
+}
+
+#else
+
+// ================ HOST CLOCK ================
+// TSC on x86: invariant and kept in step across cores by the kernel on
+// anything recent, so one offset (to the CLOCK_MONOTONIC epoch) serves
+// every core. Elsewhere CLOCK_MONOTONIC in nanoseconds.
+
+static int64_t host_offset;
+
+static uint64_t ticks_from_ns(uint64_t ns) {
+    return ns / 1000000000u * clock_hz + ns % 1000000000u * clock_hz / 1000000000u;
+}
+
+static uint64_t mono_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+static inline uint64_t raw_now(void) {
+#ifdef TS_HOST_TSC
+    return __rdtsc();
+#else
+    return mono_ns();
+#endif
+}
+
+ts_t ts_now(void) {
+    return raw_now() + (uint64_t)host_offset;
+}
+
+static void ensure_rate(void) {
+    if (clock_hz != 0) {
+        return;
+    }
+#ifdef TS_HOST_TSC
+    // TSC rate against CLOCK_MONOTONIC over ~20 ms
+    uint64_t m0 = mono_ns(), t0 = __rdtsc();
+    uint64_t m1, t1;
+    do {
+        m1 = mono_ns();
+        t1 = __rdtsc();
+    } while (m1 - m0 < 20000000u);
+    set_rate((t1 - t0) * 1000000000u / (m1 - m0));
+#else
+    set_rate(1000000000u);
+#endif
+}
+
+esp_err_t ts_init(void) {
+    ensure_rate();
+    calib.cores = 1;
+#ifdef TS_HOST_TSC
+    // Narrowest TSC bracket around a CLOCK_MONOTONIC read
+    uint64_t best_window = UINT64_MAX;
+    for (int round = 0; round < CALIBRATION_ROUNDS; round++) {
+        uint64_t before = __rdtsc();
+        uint64_t ns = mono_ns();
+        uint64_t after = __rdtsc();
+        if (after - before < best_window) {
+            best_window = after - before;
+            host_offset = (int64_t)ticks_from_ns(ns) - (int64_t)(before + best_window / 2);
+        }
+    }
+    calib.error[0] = (uint32_t)(best_window / 2);
+#endif
+    calib.offset[0] = host_offset;
+    return ESP_OK;
+}
+
+#endif
+
+// ================ CONVERSIONS ================
+
+uint64_t ts_hz(void) {
+    ensure_rate();
+    return clock_hz;
+}
+
+uint64_t ts_to_ns(ts_t t) {
+    ensure_rate();
+    return t / clock_hz * 1000000000u + t % clock_hz * 1000000000u / clock_hz;
+}
+
+uint64_t ts_to_us(ts_t t) {
+    ensure_rate();
+    return t / clock_hz * 1000000u + t % clock_hz * 1000000u / clock_hz;
+}
+
+ts_t ts_from_us(uint64_t us) {
+    ensure_rate();
+    return us / 1000000u * clock_hz + us % 1000000u * clock_hz / 1000000u;
+}
+
+uint32_t ts_us32(ts_t dt) {
+    if (us_mul_q32 == 0) {
+        ensure_rate();
+    }
+    if (dt >> 32) {
+        uint64_t us = ts_to_us(dt);
+        return us > UINT32_MAX ? UINT32_MAX : (uint32_t)us;
+    }
+    return (uint32_t)((dt * us_mul_q32) >> 32);
+}
+
+void ts_get_calibration(ts_calibration_t *out) {
+    ensure_rate();
+    *out = calib;
+}
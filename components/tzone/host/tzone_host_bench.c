@@ -0,0 +1,137 @@
+// Host check for timing zones: self/total under nesting, lock-free
+// counting from several threads, scope guards on early returns, the
+// cost of a begin/end pair, and a Chrome trace from the trace hook
+// (open tzone_trace.json in chrome://tracing or ui.perfetto.dev).
+//
+// Build and run from this directory:
+//   cc -O2 -pthread -I../include -I../../tstamp/include -I../../../tools/host_include
+//      ../tzone.c ../../tstamp/tstamp.c tzone_host_bench.c -o tzone_bench
+//   ./tzone_bench
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <time.h>
+#include <inttypes.h>
+#include "tzone.h"
+#include "host_check.h"
+
+#define THREADS         4
+#define CALLS_PER_THREAD 200000
+
+TZ_DEFINE(zone_outer, "outer");
+TZ_DEFINE(zone_inner, "inner");
+TZ_DEFINE(zone_shared, "shared");
+TZ_DEFINE(zone_guarded, "guarded");
+TZ_DEFINE(zone_empty, "empty");
+TZ_DEFINE(zone_e2e, "end_to_end");
+
+static void sleep_us(long us) {
+    struct timespec ts = { us / 1000000, (us % 1000000) * 1000 };
+    nanosleep(&ts, NULL);
+}
+
+static void *shared_worker(void *arg) {
+    (void)arg;
+    for (int i = 0; i < CALLS_PER_THREAD; i++) {
+        TZ_BEGIN(zone_shared);
+        TZ_END(zone_shared);
+    }
+    return NULL;
+}
+
+static int guarded(int fail_early) {
+    TZ_SCOPE(zone_guarded);
+    if (fail_early) {
+        return -1;      // Zone still ends here
+    }
+    sleep_us(100);
+    return 0;
+}
+
+// ---- Chrome trace ("X" complete events) ----
+
+static FILE *trace;
+static int trace_events;
+
+static void trace_zone(void *ctx, const tz_zone_t *zone, ts_t start, uint32_t dur_us, uint8_t depth) {
+    (void)ctx;
+    (void)depth;
+    if (trace_events++ > 0) {
+        fputs(",\n", trace);
+    }
+    fprintf(trace, "{\"name\":\"%s\",\"ph\":\"X\",\"ts\":%" PRIu64 ",\"dur\":%u,\"pid\":1,\"tid\":1}",
+            zone->name, ts_to_us(start), dur_us);
+}
+
+int main(void) {
+    tz_stats_t st;
+
+    ts_init();
+    printf("== Nesting ==\n");
+    trace = fopen("tzone_trace.json", "w");
+    fputs("[\n", trace);
+    tz_set_trace(trace_zone, NULL);
+    for (int i = 0; i < 20; i++) {
+        TZ_BEGIN(zone_outer);
+        sleep_us(1000);             // Outer's own work
+        TZ_BEGIN(zone_inner);
+        sleep_us(3000);
+        TZ_END(zone_inner);
+        TZ_END(zone_outer);
+    }
+    tz_set_trace(NULL, NULL);
+    fputs("\n]\n", trace);
+    fclose(trace);
+
+    tz_get_stats(&zone_outer, &st);
+    printf("outer: avg %u us, self %u us\n", st.avg_us, st.avg_self_us);
+    CHECK(st.calls == 20, "outer calls %u", st.calls);
+    CHECK(st.avg_us >= 4000 && st.avg_self_us >= 1000 && st.avg_self_us < 2000,
+          "outer total %u / self %u", st.avg_us, st.avg_self_us);
+    tz_get_stats(&zone_inner, &st);
+    CHECK(st.avg_self_us == st.avg_us, "leaf self == total");
+    printf("%d trace events -> tzone_trace.json\n", trace_events);
+
+    printf("\n== %d threads x %d calls ==\n", THREADS, CALLS_PER_THREAD);
+    pthread_t threads[THREADS];
+    for (int i = 0; i < THREADS; i++) pthread_create(&threads[i], NULL, shared_worker, NULL);
+    for (int i = 0; i < THREADS; i++) pthread_join(threads[i], NULL);
+    tz_get_stats(&zone_shared, &st);
+    CHECK(st.calls == THREADS * CALLS_PER_THREAD, "lost updates: %u calls", st.calls);
+    printf("shared: %u calls counted\n", st.calls);
+
+    printf("\n== Scope guard ==\n");
+    guarded(1);
+    guarded(0);
+    tz_get_stats(&zone_guarded, &st);
+    CHECK(st.calls == 2, "guarded calls %u", st.calls);
+    tz_errors_t err;
+    tz_get_errors(&err);
+    CHECK(err.mismatched_end == 0 && err.nest_overflow == 0, "zone errors");
+    printf("early return closed the zone (%u calls, max %u us)\n", st.calls, st.max_us);
+
+    printf("\n== Overhead ==\n");
+    const int n = 1000000;
+    struct timespec t0, t1;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for (int i = 0; i < n; i++) {
+        TZ_BEGIN(zone_empty);
+        TZ_END(zone_empty);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    double ns = ((t1.tv_sec - t0.tv_sec) * 1e9 + (t1.tv_nsec - t0.tv_nsec)) / n;
+    printf("begin/end pair: %.1f ns (clock reads included)\n", ns);
+
+    for (uint32_t i = 1; i <= 100; i++) {
+        TZ_RECORD(zone_e2e, i * 100);
+    }
+    tz_get_stats(&zone_e2e, &st);
+    CHECK(st.p50_us >= 5000 && st.p99_us >= 9900, "percentiles p50 %u p99 %u", st.p50_us, st.p99_us);
+
+    printf("\n== Report ==\n");
+    tz_report(stdout, 0);
+
+    printf("\n%s\n", failures ? "FAILURES" : "OK");
+    return failures != 0;
+}
@@ -0,0 +1,147 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include "tstamp.h"
+
+// ================ TIMING ZONES ================
+// Named, nestable timing scopes that feed per-zone latency histograms.
+//
+//   TZ_DEFINE(zone_fetch, "fetch");
+//
+//   void fetch(void) {
+//       TZ_SCOPE(zone_fetch);          // ends when the block is left
+//       ...
+//   }
+//
+//   TZ_BEGIN(zone_wait);               // or explicit begin/end pairs
+//   xEventGroupWaitBits(...);
+//   TZ_END(zone_wait);
+//
+// Each task keeps its own stack of open zones (thread-local), so a zone
+// opened inside another one is charged to its parent's child time:
+// "total" is wall time between begin and end, "self" is total minus the
+// time spent in nested zones. Durations that aren't a scope on one task
+// (queue hand-offs, end-to-end latency) go in with TZ_RECORD().
+//
+// Zones are timed with ts_now() from tstamp (call ts_init() first), so
+// the cost of a begin/end pair is two cycle-counter reads; durations are
+// kept in microseconds.
+//
+// Every counter is a 32-bit atomic add, so any task on any core can
+// record into the same zone without a lock. Counters wrap; the report
+// works on differences between snapshots, so run it at least once an
+// hour of accumulated zone time. Task context only - not from ISRs.
+//
+// Build with TZ_ENABLE=0 to compile every BEGIN/END/SCOPE/RECORD out;
+// zone objects still exist so tables of zones keep compiling.
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef TZ_ENABLE
+#define TZ_ENABLE           1
+#endif
+#ifndef TZ_MAX_NEST
+#define TZ_MAX_NEST         8       // Open zones per task
+#endif
+
+#define TZ_HIST_BUCKETS     24      // [0] < 1 us, [b] < 2^b us, last = 4 s and up
+
+typedef struct tz_zone {
+    const char *name;
+    const char *instance;           // Optional, e.g. the pool name (NULL = none)
+    struct tz_zone *next;           // Registry, filled on first use
+    uint32_t registered;
+
+    // Written by any task with relaxed atomic adds (calls = sum of hist)
+    uint32_t total_us;
+    uint32_t self_us;
+    uint32_t max_us;                // Since the last report
+    uint32_t hist[TZ_HIST_BUCKETS];
+
+    // Report bookkeeping (the reporting task only)
+    uint32_t last_total_us;
+    uint32_t last_self_us;
+    uint32_t last_hist[TZ_HIST_BUCKETS];
+} tz_zone_t;
+
+#define TZ_ZONE_INIT(zone_name, inst)   { .name = (zone_name), .instance = (inst) }
+#define TZ_DEFINE(var, zone_name)       static tz_zone_t var = TZ_ZONE_INIT(zone_name, NULL)
+
+typedef struct {
+    uint32_t calls;
+    uint32_t total_us;
+    uint32_t self_us;
+    uint32_t avg_us;
+    uint32_t avg_self_us;
+    uint32_t max_us;
+    uint32_t p50_us;                // Interpolated within log2 buckets
+    uint32_t p90_us;
+    uint32_t p99_us;
+} tz_stats_t;
+
+typedef struct {
+    uint32_t nest_overflow;         // BEGIN past TZ_MAX_NEST (zone not timed)
+    uint32_t mismatched_end;        // END for a zone that wasn't open
+} tz_errors_t;
+
+// Optional trace sink, called at every zone end (and TZ_RECORD) with the
+// start time, duration and nesting depth - e.g. a Chrome trace writer
+typedef void (*tz_trace_fn)(void *ctx, const tz_zone_t *zone, ts_t start,
+                            uint32_t dur_us, uint8_t depth);
+
+void tz_zone_init(tz_zone_t *zone, const char *name, const char *instance);
+
+void tz_begin(tz_zone_t *zone);
+uint32_t tz_end(tz_zone_t *zone);
+void tz_record(tz_zone_t *zone, uint32_t dur_us);
+
+void tz_set_trace(tz_trace_fn fn, void *ctx);
+
+// Cumulative stats since boot (or since zone init), max since last report
+void tz_get_stats(const tz_zone_t *zone, tz_stats_t *out);
+void tz_get_errors(tz_errors_t *out);
+
+// One line per registered zone for the interval since the previous
+// report; `interval_us` (0 = unknown) adds a share-of-wall-time column
+void tz_report(FILE *out, uint32_t interval_us);
+
+// ---- Scope guard ----
+
+typedef struct {
+    tz_zone_t *zone;
+} tz_scope_t;
+
+static inline tz_scope_t tz_scope_enter(tz_zone_t *zone) {
+    tz_begin(zone);
+    return (tz_scope_t){ zone };
+}
+
+static inline void tz_scope_exit(tz_scope_t *scope) {
+    tz_end(scope->zone);
+}
+
+#define TZ_CAT_(a, b)   a##b
+#define TZ_CAT(a, b)    TZ_CAT_(a, b)
+
+#if TZ_ENABLE
+#define TZ_BEGIN(zone)          tz_begin(&(zone))
+#define TZ_END(zone)            ((void)tz_end(&(zone)))
+#define TZ_SCOPE(zone)          tz_scope_t TZ_CAT(tz_scope_, __LINE__)      \
+                                    __attribute__((cleanup(tz_scope_exit))) \
+                                    = tz_scope_enter(&(zone))
+#define TZ_RECORD(zone, dur_us) tz_record(&(zone), (dur_us))
+#else
+#define TZ_BEGIN(zone)          ((void)0)
+#define TZ_END(zone)            ((void)0)
+#define TZ_SCOPE(zone)          do { } while (0)
+#define TZ_RECORD(zone, dur_us) ((void)0)
+#endif
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,225 @@
+#include <string.h>
+#include <inttypes.h>
+#include "tzone.h"
+
+// ================ PER-TASK ZONE STACK ================
+
+typedef struct {
+    tz_zone_t *zone;
+    ts_t start;
+    uint32_t child_us;              // Time spent in zones nested inside this one
+} tz_frame_t;
+
+static __thread tz_frame_t zone_stack[TZ_MAX_NEST];
+static __thread uint8_t zone_depth;
+
+static tz_zone_t *registry;
+static tz_errors_t errors;
+static tz_trace_fn trace_fn;
+static void *trace_ctx;
+
+static void register_zone(tz_zone_t *zone) {
+    uint32_t expected = 0;
+    if (!__atomic_compare_exchange_n(&zone->registered, &expected, 1, false,
+                                     __ATOMIC_ACQ_REL, __ATOMIC_RELAXED)) {
+        return;
+    }
+    tz_zone_t *head = __atomic_load_n(&registry, __ATOMIC_ACQUIRE);
+    do {
+        zone->next = head;
+    } while (!__atomic_compare_exchange_n(&registry, &head, zone, true,
+                                          __ATOMIC_RELEASE, __ATOMIC_ACQUIRE));
+}
+
+static inline uint8_t bucket_of(uint32_t us) {
+    uint8_t b = us == 0 ? 0 : (uint8_t)(32 - __builtin_clz(us));
+    return b < TZ_HIST_BUCKETS ? b : TZ_HIST_BUCKETS - 1;
+}
+
+static void account(tz_zone_t *zone, ts_t start, uint32_t total, uint32_t self, uint8_t depth) {
+    if (!zone->registered) {
+        register_zone(zone);
+    }
+    __atomic_fetch_add(&zone->total_us, total, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&zone->self_us, self, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&zone->hist[bucket_of(total)], 1, __ATOMIC_RELAXED);
+
+    uint32_t max = __atomic_load_n(&zone->max_us, __ATOMIC_RELAXED);
+    while (total > max &&
+           !__atomic_compare_exchange_n(&zone->max_us, &max, total, true,
+                                        __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+    }
+
+    if (trace_fn != NULL) {
+        trace_fn(trace_ctx, zone, start, total, depth);
+    }
+}
+
+void tz_zone_init(tz_zone_t *zone, const char *name, const char *instance) {
+    // Keep the registry link if the zone was already in use
+    tz_zone_t *next = zone->next;
+    uint32_t registered = zone->registered;
+    memset(zone, 0, sizeof(*zone));
+    zone->name = name;
+    zone->instance = instance;
+    zone->next = next;
+    zone->registered = registered;
+}
+
+void tz_begin(tz_zone_t *zone) {
+    if (zone_depth >= TZ_MAX_NEST) {
+        // Too deep: there is no frame to time it with, so the zone only
+        // shows up as a nest overflow (its time stays in the innermost
+        // open zone's self time); the matching END just pops the depth
+        __atomic_fetch_add(&errors.nest_overflow, 1, __ATOMIC_RELAXED);
+        zone_depth++;
+        return;
+    }
+    tz_frame_t *f = &zone_stack[zone_depth++];
+    f->zone = zone;
+    f->child_us = 0;
+    f->start = ts_now();
+}
+
+uint32_t tz_end(tz_zone_t *zone) {
+    ts_t now = ts_now();
+
+    if (zone_depth > TZ_MAX_NEST) {
+        zone_depth--;
+        return 0;
+    }
+    // Unwind to the matching frame; anything above it was never ended
+    while (zone_depth > 0 && zone_stack[zone_depth - 1].zone != zone) {
+        __atomic_fetch_add(&errors.mismatched_end, 1, __ATOMIC_RELAXED);
+        zone_depth--;
+    }
+    if (zone_depth == 0) {
+        return 0;
+    }
+
+    tz_frame_t *f = &zone_stack[--zone_depth];
+    uint32_t total = ts_us32(now - f->start);
+    uint32_t self = total >= f->child_us ? total - f->child_us : 0;
+    if (zone_depth > 0) {
+        zone_stack[zone_depth - 1].child_us += total;
+    }
+    account(zone, f->start, total, self, zone_depth);
+    return total;
+}
+
+void tz_record(tz_zone_t *zone, uint32_t dur_us) {
+    // The start time only matters to a trace sink
+    ts_t start = trace_fn != NULL ? ts_now() - ts_from_us(dur_us) : 0;
+    account(zone, start, dur_us, dur_us, zone_depth);
+}
+
+void tz_set_trace(tz_trace_fn fn, void *ctx) {
+    trace_ctx = ctx;
+    trace_fn = fn;
+}
+
+// ================ STATS ================
+
+static uint32_t percentile(const uint32_t *hist, uint32_t count, uint32_t pct) {
+    if (count == 0) {
+        return 0;
+    }
+    uint32_t rank = (uint32_t)(((uint64_t)count * pct + 99) / 100);
+    uint32_t seen = 0;
+    for (uint8_t b = 0; b < TZ_HIST_BUCKETS; b++) {
+        if (seen + hist[b] >= rank) {
+            if (b == 0) {
+                return 0;
+            }
+            // Interpolate inside [2^(b-1), 2^b)
+            uint32_t lo = 1u << (b - 1);
+            return lo + (uint32_t)((uint64_t)lo * (rank - seen) / hist[b]) - 1;
+        }
+        seen += hist[b];
+    }
+    return UINT32_MAX;
+}
+
+static void fill_stats(tz_stats_t *out, uint32_t calls, uint32_t total, uint32_t self,
+                       uint32_t max, const uint32_t *hist) {
+    out->calls = calls;
+    out->total_us = total;
+    out->self_us = self;
+    out->avg_us = calls ? total / calls : 0;
+    out->avg_self_us = calls ? self / calls : 0;
+    out->max_us = max;
+    out->p50_us = percentile(hist, calls, 50);
+    out->p90_us = percentile(hist, calls, 90);
+    out->p99_us = percentile(hist, calls, 99);
+    if (max > 0) {
+        // Interpolation can overshoot the largest sample actually seen
+        if (out->p50_us > max) out->p50_us = max;
+        if (out->p90_us > max) out->p90_us = max;
+        if (out->p99_us > max) out->p99_us = max;
+    }
+}
+
+void tz_get_stats(const tz_zone_t *zone, tz_stats_t *out) {
+    uint32_t hist[TZ_HIST_BUCKETS];
+    uint32_t calls = 0;
+    for (uint8_t b = 0; b < TZ_HIST_BUCKETS; b++) {
+        hist[b] = __atomic_load_n(&zone->hist[b], __ATOMIC_RELAXED);
+        calls += hist[b];
+    }
+    fill_stats(out, calls,
+               __atomic_load_n(&zone->total_us, __ATOMIC_RELAXED),
+               __atomic_load_n(&zone->self_us, __ATOMIC_RELAXED),
+               __atomic_load_n(&zone->max_us, __ATOMIC_RELAXED), hist);
+}
+
+void tz_get_errors(tz_errors_t *out) {
+    out->nest_overflow = __atomic_load_n(&errors.nest_overflow, __ATOMIC_RELAXED);
+    out->mismatched_end = __atomic_load_n(&errors.mismatched_end, __ATOMIC_RELAXED);
+}
+
+void tz_report(FILE *out, uint32_t interval_us) {
+    fprintf(out, "%-28s %8s %9s %9s %8s %8s %8s %9s %6s\n",
+            "zone", "calls", "avg_us", "self_us", "p50", "p90", "p99", "max_us", "load%");
+
+    for (tz_zone_t *z = __atomic_load_n(&registry, __ATOMIC_ACQUIRE); z != NULL; z = z->next) {
+        // Differences since the last report; wrapping u32 arithmetic
+        uint32_t hist[TZ_HIST_BUCKETS];
+        uint32_t calls = 0;
+        for (uint8_t b = 0; b < TZ_HIST_BUCKETS; b++) {
+            uint32_t now = __atomic_load_n(&z->hist[b], __ATOMIC_RELAXED);
+            hist[b] = now - z->last_hist[b];
+            z->last_hist[b] = now;
+            calls += hist[b];
+        }
+        uint32_t total = __atomic_load_n(&z->total_us, __ATOMIC_RELAXED);
+        uint32_t self = __atomic_load_n(&z->self_us, __ATOMIC_RELAXED);
+        uint32_t max = __atomic_exchange_n(&z->max_us, 0, __ATOMIC_RELAXED);
+
+        tz_stats_t st;
+        fill_stats(&st, calls, total - z->last_total_us, self - z->last_self_us, max, hist);
+        z->last_total_us = total;
+        z->last_self_us = self;
+
+        char label[48];
+        if (z->instance != NULL) {
+            snprintf(label, sizeof(label), "%s[%s]", z->name, z->instance);
+        } else {
+            snprintf(label, sizeof(label), "%s", z->name);
+        }
+        if (st.calls == 0) {
+            fprintf(out, "%-28s %8d\n", label, 0);
+            continue;
+        }
+        fprintf(out, "%-28s %8" PRIu32 " %9" PRIu32 " %9" PRIu32 " %8" PRIu32 " %8" PRIu32
+                " %8" PRIu32 " %9" PRIu32 " %6.1f\n",
+                label, st.calls, st.avg_us, st.avg_self_us, st.p50_us, st.p90_us, st.p99_us,
+                st.max_us, interval_us ? 100.0 * st.self_us / interval_us : 0.0);
+    }
+
+    tz_errors_t e;
+    tz_get_errors(&e);
+    if (e.nest_overflow || e.mismatched_end) {
+        fprintf(out, "(zone errors: %" PRIu32 " nest overflow (not timed), %" PRIu32 " mismatched end)\n",
+                e.nest_overflow, e.mismatched_end);
+    }
+}
@@ -0,0 +1,202 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include "esp_err.h"
+
+// ================ TELEMETRY UPLINK ================
+// Batches small messages into frames so the link pays its per-send cost
+// once per frame instead of once per message.
+//
+// A frame is closed when its payload reaches max_frame_bytes or when its
+// oldest message has waited max_delay_ms, whichever comes first. Closed
+// frames go to a small backlog ring and are handed to the transport; a
+// failed send (or a link marked down) keeps the frame for a retry with
+// exponential backoff. When the backlog is full the oldest frame is
+// dropped, so memory stays bounded however long the link is out.
+//
+// Wire format (little endian):
+//
+//   | uplink_frame_header_t (20) | payload |
+//   payload = { varint length | message bytes } x msg_count
+//
+// With compression on, the payload is LZ4 block format (raw_len bytes
+// once decoded) whenever that is smaller than the raw payload.
+//
+// An uplink_t is not thread-safe - own it from a single task and pass
+// the current time in (esp_timer_get_time() on the device).
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef UPLINK_MAX_PAYLOAD
+#define UPLINK_MAX_PAYLOAD  1024    // Largest frame payload (before compression)
+#endif
+#ifndef UPLINK_BACKLOG_MAX
+#define UPLINK_BACKLOG_MAX  8       // Closed frames kept for (re)transmission
+#endif
+
+#define UPLINK_FRAME_MAGIC      0x4655u     // "UF"
+#define UPLINK_FRAME_VERSION    1
+#define UPLINK_FLAG_LZ4         0x01
+
+#define UPLINK_LZ_HASH_LOG      10
+#define UPLINK_LZ_BOUND(n)      ((n) + (n) / 255 + 16)
+
+typedef struct {
+    uint16_t magic;
+    uint8_t version;
+    uint8_t flags;              // UPLINK_FLAG_*
+    uint32_t seq;
+    uint16_t msg_count;
+    uint16_t payload_len;       // Bytes after the header
+    uint16_t raw_len;           // Payload size before compression
+    uint16_t reserved;
+    uint32_t crc32;             // CRC-32 of the payload bytes as sent
+} uplink_frame_header_t;
+
+#define UPLINK_FRAME_MAX    (sizeof(uplink_frame_header_t) + UPLINK_LZ_BOUND(UPLINK_MAX_PAYLOAD))
+
+// Where frames go. send() returns ESP_OK once the frame is handed off;
+// anything else keeps it in the backlog for a retry.
+typedef struct {
+    const char *name;
+    esp_err_t (*send)(void *ctx, const void *frame, size_t len);
+    void *ctx;
+} uplink_transport_t;
+
+typedef struct {
+    size_t max_frame_bytes;     // Close a frame at this payload size (<= UPLINK_MAX_PAYLOAD)
+    uint32_t max_delay_ms;      // ...or when its oldest message is this old
+    bool compress;
+    uint8_t backlog_frames;     // Retry ring depth (<= UPLINK_BACKLOG_MAX)
+    uint32_t retry_ms;          // First retry delay, doubled per failure
+    uint32_t retry_max_ms;
+} uplink_config_t;
+
+#define UPLINK_CONFIG_DEFAULT() {           \
+    .max_frame_bytes = 512,                 \
+    .max_delay_ms = 1000,                   \
+    .compress = true,                       \
+    .backlog_frames = UPLINK_BACKLOG_MAX,   \
+    .retry_ms = 250,                        \
+    .retry_max_ms = 8000,                   \
+}
+
+typedef struct {
+    uint32_t messages_submitted;
+    uint32_t messages_sent;
+    uint32_t messages_dropped;      // Oversized, or lost with a dropped frame
+    uint32_t frames_sent;
+    uint32_t frames_dropped;        // Evicted from a full backlog
+    uint32_t frames_compressed;
+    uint32_t send_failures;
+    uint32_t bytes_submitted;       // Message bytes handed to uplink_submit
+    uint32_t bytes_raw;             // Payload bytes of sent frames before compression
+    uint32_t bytes_sent;            // Frame bytes accepted by the transport
+    uint64_t queue_delay_sum_us;    // Submit -> send, summed over sent messages
+    uint32_t queue_delay_max_us;
+    uint32_t backlog;               // Frames waiting right now
+} uplink_stats_t;
+
+// Interval figures derived from two stats snapshots
+typedef struct {
+    float frames_per_s;
+    float msgs_per_s;
+    float msgs_per_frame;
+    float wire_bytes_per_msg;       // Including header and length prefixes
+    float compression_ratio;        // Raw payload / payload on the wire
+    float avg_queue_delay_ms;
+} uplink_rates_t;
+
+typedef struct {
+    uint8_t data[UPLINK_FRAME_MAX];
+    size_t len;
+    uint16_t msg_count;
+    int64_t submit_sum_us;          // Sum of submit times of its messages
+    int64_t oldest_us;
+} uplink_slot_t;
+
+typedef struct {
+    uplink_config_t config;
+    uplink_transport_t transport;
+    bool link_up;
+
+    // Open frame
+    uint8_t open_buf[UPLINK_MAX_PAYLOAD];
+    size_t open_len;
+    uint16_t open_count;
+    int64_t open_oldest_us;
+    int64_t open_submit_sum_us;
+
+    // Backlog ring of closed frames, oldest at tail
+    uplink_slot_t backlog[UPLINK_BACKLOG_MAX];
+    uint8_t backlog_tail;
+    uint8_t backlog_count;
+    uint32_t failures;              // Consecutive, drives the backoff
+    int64_t next_attempt_us;
+
+    uint32_t seq;
+    uint16_t lz_table[1 << UPLINK_LZ_HASH_LOG];
+    uplink_stats_t stats;
+} uplink_t;
+
+esp_err_t uplink_init(uplink_t *up, const uplink_config_t *config,
+                      const uplink_transport_t *transport);
+
+// Queue one message; may close and send a frame
+esp_err_t uplink_submit(uplink_t *up, const void *msg, size_t len, int64_t now_us);
+
+// Close frames that hit max_delay_ms and retry the backlog. Call at least
+// every few hundred milliseconds from the owning task.
+void uplink_poll(uplink_t *up, int64_t now_us);
+
+// Close the open frame now and try to send everything
+void uplink_flush(uplink_t *up, int64_t now_us);
+
+// Link state from the connectivity layer; while down nothing is sent
+void uplink_set_link(uplink_t *up, bool up_now, int64_t now_us);
+
+void uplink_get_stats(const uplink_t *up, uplink_stats_t *out);
+void uplink_rates(const uplink_stats_t *cur, const uplink_stats_t *prev,
+                  uint32_t interval_ms, uplink_rates_t *out);
+
+// ---- Receiver side ----
+
+typedef void (*uplink_msg_fn_t)(const void *msg, size_t len, void *ctx);
+
+// Check and unpack one frame; 'scratch' needs UPLINK_MAX_PAYLOAD bytes
+// for compressed frames. Returns the header through 'hdr' if non-NULL.
+// visit sees every message of a good frame and none of a bad one.
+esp_err_t uplink_frame_decode(const void *frame, size_t len, uint8_t *scratch,
+                              uplink_frame_header_t *hdr, uplink_msg_fn_t visit, void *ctx);
+
+// LZ4 block format. compress returns 0 if the output would not fit;
+// decompress returns 0 on malformed input.
+size_t uplink_lz_compress(const uint8_t *src, size_t len, uint8_t *dst, size_t cap,
+                          uint16_t *table);
+size_t uplink_lz_decompress(const uint8_t *src, size_t len, uint8_t *dst, size_t cap);
+
+// ---- Transports ----
+
+// UDP datagrams to ip:port (e.g. "127.0.0.1" for a loopback receiver).
+// On the device the TCP/IP stack must be up (esp_netif_init).
+typedef struct {
+    int sock;
+    uint32_t addr;                  // Network byte order
+    uint16_t port;
+} uplink_udp_t;
+
+esp_err_t uplink_udp_open(uplink_udp_t *udp, const char *ip, uint16_t port,
+                          uplink_transport_t *out);
+void uplink_udp_close(uplink_udp_t *udp);
+
+// Append frames to an open stdio file (host file, or a VFS path on the device)
+esp_err_t uplink_file_open(FILE *fp, uplink_transport_t *out);
+
+#ifdef __cplusplus
+}
+#endif
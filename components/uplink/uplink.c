@@ -0,0 +1,300 @@
+#include <string.h>
+#include "uplink.h"
+#include "integrity.h"
+
+_Static_assert(sizeof(uplink_frame_header_t) == 20, "uplink frame header layout");
+_Static_assert(UPLINK_MAX_PAYLOAD <= 0xFFFF, "payload length is 16-bit");
+
+static size_t varint_put(uint8_t *dst, size_t value) {
+    size_t n = 0;
+    while (value >= 0x80) {
+        dst[n++] = (uint8_t)(value | 0x80);
+        value >>= 7;
+    }
+    dst[n++] = (uint8_t)value;
+    return n;
+}
+
+static size_t varint_size(size_t value) {
+    size_t n = 1;
+    while (value >= 0x80) {
+        value >>= 7;
+        n++;
+    }
+    return n;
+}
+
+// ================ BACKLOG ================
+
+static uplink_slot_t *slot_at(uplink_t *up, uint8_t i) {
+    return &up->backlog[(up->backlog_tail + i) % up->config.backlog_frames];
+}
+
+static void drop_oldest(uplink_t *up) {
+    uplink_slot_t *slot = slot_at(up, 0);
+    up->stats.frames_dropped++;
+    up->stats.messages_dropped += slot->msg_count;
+    up->backlog_tail = (up->backlog_tail + 1) % up->config.backlog_frames;
+    up->backlog_count--;
+}
+
+static void try_send(uplink_t *up, int64_t now_us) {
+    while (up->backlog_count > 0 && up->link_up && now_us >= up->next_attempt_us) {
+        uplink_slot_t *slot = slot_at(up, 0);
+
+        if (up->transport.send(up->transport.ctx, slot->data, slot->len) != ESP_OK) {
+            // Back off: retry_ms, 2x, 4x ... capped at retry_max_ms
+            up->stats.send_failures++;
+            uint32_t shift = up->failures < 16 ? up->failures : 16;
+            uint64_t wait_ms = (uint64_t)up->config.retry_ms << shift;
+            if (wait_ms > up->config.retry_max_ms) {
+                wait_ms = up->config.retry_max_ms;
+            }
+            up->failures++;
+            up->next_attempt_us = now_us + (int64_t)wait_ms * 1000;
+            return;
+        }
+
+        const uplink_frame_header_t *hdr = (const uplink_frame_header_t *)slot->data;
+        up->failures = 0;
+        up->stats.frames_sent++;
+        up->stats.messages_sent += slot->msg_count;
+        up->stats.bytes_sent += slot->len;
+        up->stats.bytes_raw += hdr->raw_len;
+        if (hdr->flags & UPLINK_FLAG_LZ4) {
+            up->stats.frames_compressed++;
+        }
+
+        up->stats.queue_delay_sum_us += (uint64_t)(now_us * slot->msg_count - slot->submit_sum_us);
+        uint32_t oldest = (uint32_t)(now_us - slot->oldest_us);
+        if (oldest > up->stats.queue_delay_max_us) {
+            up->stats.queue_delay_max_us = oldest;
+        }
+
+        up->backlog_tail = (up->backlog_tail + 1) % up->config.backlog_frames;
+        up->backlog_count--;
+    }
+}
+
+// Seal the open frame into the backlog
+static void close_frame(uplink_t *up) {
+    if (up->open_count == 0) {
+        return;
+    }
+    if (up->backlog_count == up->config.backlog_frames) {
+        drop_oldest(up);
+    }
+
+    uplink_slot_t *slot = slot_at(up, up->backlog_count);
+    uint8_t *payload = slot->data + sizeof(uplink_frame_header_t);
+    uplink_frame_header_t hdr = {
+        .magic = UPLINK_FRAME_MAGIC,
+        .version = UPLINK_FRAME_VERSION,
+        .seq = up->seq++,
+        .msg_count = up->open_count,
+        .raw_len = (uint16_t)up->open_len,
+    };
+
+    size_t packed = 0;
+    if (up->config.compress) {
+        // Only keep the compressed form if it actually saves bytes
+        packed = uplink_lz_compress(up->open_buf, up->open_len, payload,
+                                    up->open_len - 1, up->lz_table);
+    }
+    if (packed > 0) {
+        hdr.flags |= UPLINK_FLAG_LZ4;
+    } else {
+        memcpy(payload, up->open_buf, up->open_len);
+        packed = up->open_len;
+    }
+
+    hdr.payload_len = (uint16_t)packed;
+    hdr.crc32 = integrity_crc32(0, payload, packed);
+    memcpy(slot->data, &hdr, sizeof(hdr));
+
+    slot->len = sizeof(hdr) + packed;
+    slot->msg_count = up->open_count;
+    slot->submit_sum_us = up->open_submit_sum_us;
+    slot->oldest_us = up->open_oldest_us;
+    up->backlog_count++;
+
+    up->open_len = 0;
+    up->open_count = 0;
+    up->open_submit_sum_us = 0;
+}
+
+// ================ PUBLIC API ================
+
+esp_err_t uplink_init(uplink_t *up, const uplink_config_t *config,
+                      const uplink_transport_t *transport) {
+    if (up == NULL || config == NULL || transport == NULL || transport->send == NULL ||
+        config->max_frame_bytes < 16 || config->max_frame_bytes > UPLINK_MAX_PAYLOAD ||
+        config->backlog_frames == 0 || config->backlog_frames > UPLINK_BACKLOG_MAX) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    memset(up, 0, sizeof(*up));
+    up->config = *config;
+    up->transport = *transport;
+    up->link_up = true;
+    return ESP_OK;
+}
+
+esp_err_t uplink_submit(uplink_t *up, const void *msg, size_t len, int64_t now_us) {
+    size_t need = varint_size(len) + len;
+
+    up->stats.messages_submitted++;
+    if (need > up->config.max_frame_bytes) {
+        up->stats.messages_dropped++;
+        return ESP_ERR_INVALID_SIZE;
+    }
+    up->stats.bytes_submitted += len;
+
+    if (up->open_len + need > up->config.max_frame_bytes) {
+        close_frame(up);
+    }
+
+    if (up->open_count == 0) {
+        up->open_oldest_us = now_us;
+    }
+    up->open_len += varint_put(up->open_buf + up->open_len, len);
+    memcpy(up->open_buf + up->open_len, msg, len);
+    up->open_len += len;
+    up->open_count++;
+    up->open_submit_sum_us += now_us;
+
+    // Full frames go out right away; the time bound is checked in poll
+    if (up->open_len == up->config.max_frame_bytes) {
+        close_frame(up);
+    }
+    try_send(up, now_us);
+    return ESP_OK;
+}
+
+void uplink_poll(uplink_t *up, int64_t now_us) {
+    if (up->open_count > 0 &&
+        now_us - up->open_oldest_us >= (int64_t)up->config.max_delay_ms * 1000) {
+        close_frame(up);
+    }
+    try_send(up, now_us);
+}
+
+void uplink_flush(uplink_t *up, int64_t now_us) {
+    close_frame(up);
+    up->next_attempt_us = 0;
+    try_send(up, now_us);
+}
+
+void uplink_set_link(uplink_t *up, bool up_now, int64_t now_us) {
+    if (up_now && !up->link_up) {
+        // Fresh link: retry immediately instead of waiting out the backoff
+        up->failures = 0;
+        up->next_attempt_us = 0;
+    }
+    up->link_up = up_now;
+    try_send(up, now_us);
+}
+
+void uplink_get_stats(const uplink_t *up, uplink_stats_t *out) {
+    *out = up->stats;
+    out->backlog = up->backlog_count;
+}
+
+void uplink_rates(const uplink_stats_t *cur, const uplink_stats_t *prev,
+                  uint32_t interval_ms, uplink_rates_t *out) {
+    static const uplink_stats_t zero;
+    if (prev == NULL) {
+        prev = &zero;
+    }
+
+    uint32_t frames = cur->frames_sent - prev->frames_sent;
+    uint32_t msgs = cur->messages_sent - prev->messages_sent;
+    uint32_t wire = cur->bytes_sent - prev->bytes_sent;
+    uint32_t raw = cur->bytes_raw - prev->bytes_raw;
+    uint32_t payload = wire - frames * (uint32_t)sizeof(uplink_frame_header_t);
+    float seconds = interval_ms > 0 ? interval_ms / 1000.0f : 1.0f;
+
+    out->frames_per_s = frames / seconds;
+    out->msgs_per_s = msgs / seconds;
+    out->msgs_per_frame = frames > 0 ? (float)msgs / frames : 0.0f;
+    out->wire_bytes_per_msg = msgs > 0 ? (float)wire / msgs : 0.0f;
+    out->compression_ratio = payload > 0 ? (float)raw / payload : 1.0f;
+    out->avg_queue_delay_ms = msgs > 0 ?
+        (float)(cur->queue_delay_sum_us - prev->queue_delay_sum_us) / msgs / 1000.0f : 0.0f;
+}
+
+// ================ RECEIVER ================
+
+// Walk the length-prefixed messages; visit may be NULL (check only)
+static esp_err_t walk_messages(const uint8_t *payload, const uplink_frame_header_t *hdr,
+                               uplink_msg_fn_t visit, void *ctx) {
+    size_t pos = 0;
+    for (uint16_t i = 0; i < hdr->msg_count; i++) {
+        size_t msg_len = 0;
+        for (unsigned shift = 0; ; shift += 7) {
+            if (pos >= hdr->raw_len || shift > 21) {
+                return ESP_ERR_INVALID_SIZE;
+            }
+            uint8_t b = payload[pos++];
+            msg_len |= (size_t)(b & 0x7F) << shift;
+            if (!(b & 0x80)) {
+                break;
+            }
+        }
+        if (pos + msg_len > hdr->raw_len) {
+            return ESP_ERR_INVALID_SIZE;
+        }
+        if (visit) {
+            visit(payload + pos, msg_len, ctx);
+        }
+        pos += msg_len;
+    }
+    return pos == hdr->raw_len ? ESP_OK : ESP_ERR_INVALID_SIZE;
+}
+
+esp_err_t uplink_frame_decode(const void *frame, size_t len, uint8_t *scratch,
+                              uplink_frame_header_t *hdr_out, uplink_msg_fn_t visit, void *ctx) {
+    uplink_frame_header_t hdr;
+    if (len < sizeof(hdr)) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    memcpy(&hdr, frame, sizeof(hdr));
+    if (hdr.magic != UPLINK_FRAME_MAGIC) {
+        return ESP_ERR_INVALID_RESPONSE;
+    }
+    if (hdr.version != UPLINK_FRAME_VERSION) {
+        return ESP_ERR_INVALID_VERSION;
+    }
+    if (sizeof(hdr) + hdr.payload_len > len || hdr.raw_len > UPLINK_MAX_PAYLOAD) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    const uint8_t *payload = (const uint8_t *)frame + sizeof(hdr);
+    if (integrity_crc32(0, payload, hdr.payload_len) != hdr.crc32) {
+        return ESP_ERR_INVALID_CRC;
+    }
+
+    if (hdr.flags & UPLINK_FLAG_LZ4) {
+        if (uplink_lz_decompress(payload, hdr.payload_len, scratch, UPLINK_MAX_PAYLOAD) != hdr.raw_len) {
+            return ESP_ERR_INVALID_RESPONSE;
+        }
+        payload = scratch;
+    } else if (hdr.payload_len != hdr.raw_len) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    // The whole frame is checked before the first message is delivered,
+    // so a bad tail can't leave the receiver with half a frame
+    esp_err_t err = walk_messages(payload, &hdr, NULL, NULL);
+    if (err != ESP_OK) {
+        return err;
+    }
+    if (visit) {
+        walk_messages(payload, &hdr, visit, ctx);
+    }
+
+    if (hdr_out) {
+        *hdr_out = hdr;
+    }
+    return ESP_OK;
+}
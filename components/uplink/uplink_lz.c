@@ -0,0 +1,169 @@
+#include <string.h>
+#include "uplink.h"
+
+// ================ LZ4 BLOCK CODEC ================
+// Greedy single-pass compressor in the LZ4 block format: sequences of
+// [token | literal length+ | literals | offset u16 | match length+].
+// Small hash table (UPLINK_LZ_HASH_LOG bits) so it fits next to the frame
+// buffers; telemetry text with repeated keys/sources still shrinks well.
+
+#define LZ_MIN_MATCH        4
+#define LZ_LAST_LITERALS    5       // Format rule: block ends with >= 5 literals
+#define LZ_MFLIMIT          12      // Format rule: last match starts >= 12 before end
+#define LZ_MAX_OFFSET       65535
+
+static inline uint32_t read32(const uint8_t *p) {
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static inline uint32_t lz_hash(uint32_t v) {
+    return (v * 2654435761u) >> (32 - UPLINK_LZ_HASH_LOG);
+}
+
+// Extended length: runs of 255 then the remainder
+static uint8_t *put_length(uint8_t *op, size_t len) {
+    while (len >= 255) {
+        *op++ = 255;
+        len -= 255;
+    }
+    *op++ = (uint8_t)len;
+    return op;
+}
+
+static uint8_t *emit_literals(uint8_t *op, uint8_t *token, const uint8_t *lit, size_t len) {
+    if (len >= 15) {
+        *token = 15 << 4;
+        op = put_length(op, len - 15);
+    } else {
+        *token = (uint8_t)(len << 4);
+    }
+    memcpy(op, lit, len);
+    return op + len;
+}
+
+size_t uplink_lz_compress(const uint8_t *src, size_t len, uint8_t *dst, size_t cap,
+                          uint16_t *table) {
+    uint8_t *op = dst;
+    const uint8_t *const op_end = dst + cap;
+    size_t anchor = 0;
+    size_t ip = 0;
+
+    memset(table, 0, sizeof(uint16_t) << UPLINK_LZ_HASH_LOG);
+
+    if (len > LZ_MFLIMIT) {
+        const size_t match_limit = len - LZ_MFLIMIT;
+        const size_t end_limit = len - LZ_LAST_LITERALS;
+
+        while (ip < match_limit) {
+            uint32_t v = read32(src + ip);
+            uint32_t h = lz_hash(v);
+            size_t cand = table[h];
+            table[h] = (uint16_t)ip;
+
+            if (cand >= ip || ip - cand > LZ_MAX_OFFSET || read32(src + cand) != v) {
+                ip++;
+                continue;
+            }
+
+            size_t mlen = LZ_MIN_MATCH;
+            while (ip + mlen < end_limit && src[cand + mlen] == src[ip + mlen]) {
+                mlen++;
+            }
+
+            // Worst case for this sequence: token, lengths, literals, offset
+            size_t lit = ip - anchor;
+            if ((size_t)(op_end - op) < 1 + lit + lit / 255 + 1 + 2 + mlen / 255 + 1) {
+                return 0;
+            }
+
+            uint8_t *token = op++;
+            op = emit_literals(op, token, src + anchor, lit);
+
+            uint16_t offset = (uint16_t)(ip - cand);
+            *op++ = (uint8_t)offset;
+            *op++ = (uint8_t)(offset >> 8);
+
+            size_t ml = mlen - LZ_MIN_MATCH;
+            if (ml >= 15) {
+                *token |= 15;
+                op = put_length(op, ml - 15);
+            } else {
+                *token |= (uint8_t)ml;
+            }
+
+            ip += mlen;
+            anchor = ip;
+        }
+    }
+
+    size_t lit = len - anchor;
+    if ((size_t)(op_end - op) < 1 + lit + lit / 255 + 1) {
+        return 0;
+    }
+    uint8_t *token = op++;
+    op = emit_literals(op, token, src + anchor, lit);
+    return (size_t)(op - dst);
+}
+
+static bool get_length(const uint8_t **ip, const uint8_t *end, size_t *len) {
+    uint8_t b;
+    do {
+        if (*ip >= end) {
+            return false;
+        }
+        b = *(*ip)++;
+        *len += b;
+    } while (b == 255);
+    return true;
+}
+
+size_t uplink_lz_decompress(const uint8_t *src, size_t len, uint8_t *dst, size_t cap) {
+    const uint8_t *ip = src;
+    const uint8_t *const ip_end = src + len;
+    size_t op = 0;
+
+    while (ip < ip_end) {
+        uint8_t token = *ip++;
+
+        size_t lit = token >> 4;
+        if (lit == 15 && !get_length(&ip, ip_end, &lit)) {
+            return 0;
+        }
+        if ((size_t)(ip_end - ip) < lit || cap - op < lit) {
+            return 0;
+        }
+        memcpy(dst + op, ip, lit);
+        ip += lit;
+        op += lit;
+
+        if (ip == ip_end) {
+            break;      // Last sequence has no match
+        }
+
+        if (ip_end - ip < 2) {
+            return 0;
+        }
+        size_t offset = ip[0] | (ip[1] << 8);
+        ip += 2;
+        if (offset == 0 || offset > op) {
+            return 0;
+        }
+
+        size_t mlen = token & 15;
+        if (mlen == 15 && !get_length(&ip, ip_end, &mlen)) {
+            return 0;
+        }
+        mlen += LZ_MIN_MATCH;
+        if (cap - op < mlen) {
+            return 0;
+        }
+
+        // Byte copy: matches may overlap their own output
+        for (size_t i = 0; i < mlen; i++, op++) {
+            dst[op] = dst[op - offset];
+        }
+    }
+    return op;
+}
@@ -0,0 +1,72 @@
+#include <string.h>
+#include "uplink.h"
+
+#ifdef ESP_PLATFORM
+#include "lwip/sockets.h"
+#include "lwip/inet.h"
+#else
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#endif
+
+// ================ UDP TRANSPORT ================
+
+static esp_err_t udp_send(void *ctx, const void *frame, size_t len) {
+    const uplink_udp_t *udp = (const uplink_udp_t *)ctx;
+    struct sockaddr_in dest = {
+        .sin_family = AF_INET,
+        .sin_port = htons(udp->port),
+        .sin_addr.s_addr = udp->addr,
+    };
+
+    // Never block the owning task - a full socket buffer is just a retry
+    ssize_t sent = sendto(udp->sock, frame, len, MSG_DONTWAIT,
+                          (const struct sockaddr *)&dest, sizeof(dest));
+    return sent == (ssize_t)len ? ESP_OK : ESP_FAIL;
+}
+
+esp_err_t uplink_udp_open(uplink_udp_t *udp, const char *ip, uint16_t port,
+                          uplink_transport_t *out) {
+    struct in_addr addr;
+    if (inet_pton(AF_INET, ip, &addr) != 1) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    int sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    if (sock < 0) {
+        return ESP_FAIL;
+    }
+
+    udp->sock = sock;
+    udp->addr = addr.s_addr;
+    udp->port = port;
+    *out = (uplink_transport_t){ .name = "udp", .send = udp_send, .ctx = udp };
+    return ESP_OK;
+}
+
+void uplink_udp_close(uplink_udp_t *udp) {
+    if (udp->sock >= 0) {
+        close(udp->sock);
+        udp->sock = -1;
+    }
+}
+
+// ================ FILE SINK ================
+
+static esp_err_t file_send(void *ctx, const void *frame, size_t len) {
+    FILE *fp = (FILE *)ctx;
+    if (fwrite(frame, 1, len, fp) != len || fflush(fp) != 0) {
+        return ESP_FAIL;
+    }
+    return ESP_OK;
+}
+
+esp_err_t uplink_file_open(FILE *fp, uplink_transport_t *out) {
+    if (fp == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    *out = (uplink_transport_t){ .name = "file", .send = file_send, .ctx = fp };
+    return ESP_OK;
+}
@@ -0,0 +1,324 @@
+#!/usr/bin/env python3
+"""Config blob compiler for the labs.
+
+Turns a TOML text config into the fixed-layout binary read in place by
+components/cfgblob (see cfgblob.h and lab_config_schema.h), and dumps
+existing blobs back to text.
+
+    python3 cfgc.py lab_config.toml -o config.bin
+    python3 cfgc.py --dump config.bin
+
+Flash the result to the "config" partition of a lab without rebuilding:
+
+    parttool.py --port /dev/ttyUSB0 write_partition \\
+        --partition-name=config --input config.bin
+
+Sections missing from the TOML are left out of the blob and the firmware
+uses its compiled-in defaults for them.
+"""
+
+import argparse
+import struct
+import sys
+import tomllib
+import zlib
+
+MAGIC = 0x31474643          # "CFG1"
+FORMAT_VERSION = 1
+ALIGN = 4
+HEADER = struct.Struct("<IHHII")
+SECTION = struct.Struct("<HHII")
+MS_MIN, MS_MAX = 100, 3600000   # CFG_MS_MIN/CFG_MS_MAX in lab_config_schema.h
+
+MALLOC_CAPS = {
+    "exec": 1 << 0,
+    "32bit": 1 << 1,
+    "8bit": 1 << 2,
+    "dma": 1 << 3,
+    "spiram": 1 << 10,
+    "internal": 1 << 11,
+    "default": 1 << 12,
+}
+
+# ---- Schema (mirror of lab_config_schema.h) ----
+# Field kinds: u32, f32, bool (u8), pad (n bytes), caps (u32 from names),
+# str (cfgblob_str_t), array (cfgblob_array_t of an element schema)
+
+POOL_ENTRY = [
+    ("str", "name"),
+    ("u32", "block_size"),
+    ("u32", "block_count"),
+    ("caps", "caps"),
+]
+
+SECTIONS = {
+    "system_timing": {
+        "id": 1, "version": 1, "size": 24,
+        "fields": [
+            ("u32", "network_check_ms"),
+            ("u32", "sensor_sample_ms"),
+            ("u32", "config_check_ms"),
+            ("u32", "storage_flush_ms"),
+            ("u32", "storage_report_ms"),
+            ("u32", "health_check_ms"),
+        ],
+    },
+    "adaptive": {
+        "id": 2, "version": 1, "size": 24,
+        "fields": [
+            ("f32", "motion_sensitivity"),
+            ("f32", "sensitivity_min"),
+            ("f32", "sensitivity_max"),
+            ("u32", "auto_light_timeout_ms"),
+            ("u32", "security_delay_ms"),
+            ("bool", "learning_mode"),
+            ("pad", 3),
+        ],
+    },
+    "pools": {
+        "id": 3, "version": 1, "size": 8,
+        "fields": [
+            ("array", "pools", POOL_ENTRY, 20),
+        ],
+    },
+}
+
+
+class ConfigError(Exception):
+    pass
+
+
+def align(n):
+    return (n + ALIGN - 1) & ~(ALIGN - 1)
+
+
+class VarArea:
+    """Strings and arrays placed after the fixed sections."""
+
+    def __init__(self, base):
+        self.base = base
+        self.data = bytearray()
+        self.strings = {}
+
+    def reserve(self, size):
+        self.data += b"\0" * (align(len(self.data)) - len(self.data))
+        offset = self.base + len(self.data)
+        self.data += b"\0" * size
+        return offset
+
+    def put(self, offset, raw):
+        start = offset - self.base
+        self.data[start:start + len(raw)] = raw
+
+    def string(self, text):
+        if text not in self.strings:
+            raw = text.encode("utf-8")
+            offset = self.base + len(self.data)
+            self.data += raw + b"\0"
+            self.strings[text] = (offset, len(raw))
+        return self.strings[text]
+
+
+def encode_fields(fields, values, var, where):
+    unknown = set(values) - {f[1] for f in fields if f[0] != "pad"}
+    if unknown:
+        raise ConfigError(f"{where}: unknown key(s) {', '.join(sorted(unknown))}")
+
+    out = bytearray()
+    for field in fields:
+        kind = field[0]
+        if kind == "pad":
+            out += b"\0" * field[1]
+            continue
+
+        name = field[1]
+        if name not in values:
+            raise ConfigError(f"{where}: missing '{name}'")
+        value = values[name]
+
+        if kind == "u32":
+            out += struct.pack("<I", int(value))
+        elif kind == "f32":
+            out += struct.pack("<f", float(value))
+        elif kind == "bool":
+            out += struct.pack("<B", 1 if value else 0)
+        elif kind == "caps":
+            out += struct.pack("<I", parse_caps(value, f"{where}.{name}"))
+        elif kind == "str":
+            out += struct.pack("<II", *var.string(str(value)))
+        elif kind == "array":
+            elem_fields, elem_size = field[2], field[3]
+            offset = var.reserve(elem_size * len(value))
+            for i, item in enumerate(value):
+                raw = encode_fields(elem_fields, item, var, f"{where}.{name}[{i}]")
+                assert len(raw) == elem_size, f"schema size mismatch in {name}"
+                var.put(offset + i * elem_size, raw)
+            out += struct.pack("<II", offset, len(value))
+        else:
+            raise AssertionError(kind)
+    return bytes(out)
+
+
+def parse_caps(value, where):
+    if isinstance(value, int):
+        return value
+    caps = 0
+    for part in str(value).split("|"):
+        part = part.strip().lower()
+        if part not in MALLOC_CAPS:
+            raise ConfigError(f"{where}: unknown capability '{part}'")
+        caps |= MALLOC_CAPS[part]
+    return caps
+
+
+def validate(config):
+    for section in ("system_timing", "adaptive"):
+        for key, value in config.get(section, {}).items():
+            if key.endswith("_ms") and not MS_MIN <= value <= MS_MAX:
+                raise ConfigError(f"{section}: {key} = {value} outside [{MS_MIN}, {MS_MAX}]")
+
+    adaptive = config.get("adaptive")
+    if adaptive and not all(0.0 <= adaptive[k] <= 1.0 for k in
+                            ("motion_sensitivity", "sensitivity_min", "sensitivity_max")):
+        raise ConfigError("adaptive: sensitivities must be within [0, 1]")
+    if adaptive and not (adaptive["sensitivity_min"] <= adaptive["motion_sensitivity"]
+                         <= adaptive["sensitivity_max"]):
+        raise ConfigError("adaptive: motion_sensitivity outside [sensitivity_min, sensitivity_max]")
+
+    pools = config.get("pools", {}).get("pools", [])
+    sizes = [p["block_size"] for p in pools]
+    if sizes != sorted(sizes):
+        raise ConfigError("pools: block_size must be ascending")
+
+
+def compile_config(config):
+    unknown = set(config) - set(SECTIONS)
+    if unknown:
+        raise ConfigError(f"unknown section(s) {', '.join(sorted(unknown))}")
+
+    # TOML arrays of tables ([[pools]]) map onto the single-field pools section
+    if isinstance(config.get("pools"), list):
+        config = dict(config, pools={"pools": config["pools"]})
+    validate(config)
+
+    names = [n for n in SECTIONS if n in config]
+    table_end = HEADER.size + SECTION.size * len(names)
+
+    offsets = {}
+    cursor = align(table_end)
+    for name in names:
+        offsets[name] = cursor
+        cursor = align(cursor + SECTIONS[name]["size"])
+
+    var = VarArea(cursor)
+    body = bytearray(cursor - HEADER.size)
+    for i, name in enumerate(names):
+        schema = SECTIONS[name]
+        raw = encode_fields(schema["fields"], config[name], var, name)
+        assert len(raw) == schema["size"], f"schema size mismatch in {name}"
+        SECTION.pack_into(body, SECTION.size * i, schema["id"], schema["version"],
+                          offsets[name], schema["size"])
+        start = offsets[name] - HEADER.size
+        body[start:start + len(raw)] = raw
+
+    body += var.data
+    body += b"\0" * (align(len(body) + HEADER.size) - HEADER.size - len(body))
+    total = HEADER.size + len(body)
+    header = HEADER.pack(MAGIC, FORMAT_VERSION, len(names), total, zlib.crc32(body))
+    return header + bytes(body)
+
+
+def decode_fields(fields, blob, offset):
+    values = {}
+    for field in fields:
+        kind = field[0]
+        if kind == "pad":
+            offset += field[1]
+            continue
+        name = field[1]
+        if kind in ("u32", "caps"):
+            values[name] = struct.unpack_from("<I", blob, offset)[0]
+            offset += 4
+        elif kind == "f32":
+            values[name] = round(struct.unpack_from("<f", blob, offset)[0], 6)
+            offset += 4
+        elif kind == "bool":
+            values[name] = bool(blob[offset])
+            offset += 1
+        elif kind == "str":
+            ref, length = struct.unpack_from("<II", blob, offset)
+            values[name] = blob[ref:ref + length].decode("utf-8")
+            offset += 8
+        elif kind == "array":
+            ref, count = struct.unpack_from("<II", blob, offset)
+            values[name] = [decode_fields(field[2], blob, ref + i * field[3])[0]
+                            for i in range(count)]
+            offset += 8
+    return values, offset
+
+
+def dump(blob):
+    magic, version, count, total, crc = HEADER.unpack_from(blob)
+    if magic != MAGIC:
+        raise ConfigError("not a config blob")
+    ok = zlib.crc32(blob[HEADER.size:total]) == crc
+    print(f"# format v{version}, {count} sections, {total} bytes, CRC {'OK' if ok else 'BAD'}")
+
+    by_id = {s["id"]: (n, s) for n, s in SECTIONS.items()}
+    for i in range(count):
+        sid, sver, offset, size = SECTION.unpack_from(blob, HEADER.size + SECTION.size * i)
+        if sid not in by_id:
+            print(f"\n# unknown section id {sid} v{sver} ({size} bytes)")
+            continue
+        name, schema = by_id[sid]
+        values, _ = decode_fields(schema["fields"], blob, offset)
+        print(f"\n# id {sid} v{sver}, {size} bytes")
+        if name == "pools":
+            for entry in values["pools"]:
+                print("[[pools]]")
+                print_values(entry)
+        else:
+            print(f"[{name}]")
+            print_values(values)
+
+
+def print_values(values):
+    for key, value in values.items():
+        if isinstance(value, bool):
+            text = "true" if value else "false"
+        elif isinstance(value, str):
+            text = f'"{value}"'
+        elif key == "caps":
+            text = f"0x{value:X}"
+        else:
+            text = str(value)
+        print(f"{key} = {text}")
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("input", help="TOML config, or blob with --dump")
+    parser.add_argument("-o", "--output", help="blob to write")
+    parser.add_argument("--dump", action="store_true", help="print an existing blob")
+    args = parser.parse_args()
+
+    try:
+        if args.dump:
+            with open(args.input, "rb") as f:
+                dump(f.read())
+            return 0
+
+        with open(args.input, "rb") as f:
+            blob = compile_config(tomllib.load(f))
+        output = args.output or args.input.rsplit(".", 1)[0] + ".bin"
+        with open(output, "wb") as f:
+            f.write(blob)
+        print(f"{output}: {len(blob)} bytes")
+        return 0
+    except (ConfigError, KeyError, ValueError, tomllib.TOMLDecodeError) as e:
+        print(f"error: {e}", file=sys.stderr)
+        return 1
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,17 @@
+#pragma once
+
+// Pass/fail bookkeeping shared by the component host benches:
+//
+//   CHECK(got == want, "got %d, want %d", got, want);
+//   ...
+//   printf("%s\n", failures ? "FAILURES" : "OK");
+//   return failures != 0;
+//
+// A failed check prints its message and counts; the bench carries on so
+// one run shows every failure.
+
+#include <stdio.h>
+
+static int failures;
+
+#define CHECK(cond, ...) do { if (!(cond)) { printf("  FAIL: " __VA_ARGS__); printf("\n"); failures++; } } while (0)
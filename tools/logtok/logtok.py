@@ -0,0 +1,312 @@
+#!/usr/bin/env python3
+"""Detokenizer for logs from components/logtok.
+
+Replaces every "$<base64>" frame in a captured log (idf.py monitor
+output, a file, or stdin) with the text ESP_LOGx would have printed,
+using the format strings kept in the app ELF's logtok_entries section.
+Other lines pass through untouched.
+
+    python3 logtok.py --elf build/lab2.elf monitor.log
+    idf.py monitor | python3 logtok.py --elf build/lab2.elf
+    python3 logtok.py --elf build/lab2.elf --db tokens.csv --save
+    python3 logtok.py --db tokens.csv --stats old_capture.log
+
+--db keeps a token database across builds: with --save the ELF's
+formats are merged into it, so captures from older firmware still
+decode after the strings change. Tags are hashed on the device; their
+names come from the strings in the ELF's read-only data (and the
+database).
+"""
+
+import argparse
+import base64
+import binascii
+import csv
+import os
+import re
+import struct
+import sys
+
+ENTRY_MAGIC = 0x4B4F544C
+HASH_LEN = 96
+LEVELS = "NEWIDV"
+TRUNCATED = 0x80
+
+# ---- Tokens ----
+
+
+def token(text):
+    """65599 hash of the first HASH_LEN bytes, seeded with the length."""
+    h, k = len(text), 65599
+    for c in text[:HASH_LEN]:
+        h = (h + k * c) & 0xFFFFFFFF
+        k = (k * 65599) & 0xFFFFFFFF
+    return h
+
+
+def tag_hash(text):
+    h = token(text)
+    return (h ^ (h >> 16)) & 0xFFFF
+
+
+# ---- ELF ----
+
+SHF_ALLOC = 0x2
+SHF_EXECINSTR = 0x4
+SHT_PROGBITS = 1
+
+
+def elf_sections(path):
+    """(name, type, flags, bytes) for every section (32 or 64 bit, LE)."""
+    with open(path, "rb") as f:
+        data = f.read()
+    if data[:4] != b"\x7fELF":
+        raise ValueError(f"{path}: not an ELF file")
+    if data[5] != 1:
+        raise ValueError(f"{path}: big-endian ELF not supported")
+    if data[4] == 2:
+        shoff, = struct.unpack_from("<Q", data, 0x28)
+        shentsize, shnum, shstrndx = struct.unpack_from("<HHH", data, 0x3A)
+        sh_fmt = "<IIQQQQIIQQ"
+    else:
+        shoff, = struct.unpack_from("<I", data, 0x20)
+        shentsize, shnum, shstrndx = struct.unpack_from("<HHH", data, 0x2E)
+        sh_fmt = "<IIIIIIIIII"
+    headers = [struct.unpack_from(sh_fmt, data, shoff + i * shentsize) for i in range(shnum)]
+    names_off = headers[shstrndx][4]
+    out = []
+    for sh in headers:
+        name_end = data.index(b"\0", names_off + sh[0])
+        name = data[names_off + sh[0]:name_end].decode(errors="replace")
+        body = data[sh[4]:sh[4] + sh[5]] if sh[1] != 8 else b""     # NOBITS
+        out.append((name, sh[1], sh[2], body))
+    return out
+
+
+class Database:
+    def __init__(self):
+        self.formats = {}       # token -> set of format strings
+        self.tags = {}          # 16-bit hash -> set of tag names
+
+    def add_format(self, text):
+        self.formats.setdefault(token(text.encode()), set()).add(text)
+
+    def add_tag(self, text):
+        self.tags.setdefault(tag_hash(text.encode()), set()).add(text)
+
+    def load_elf(self, path):
+        found = 0
+        for name, sh_type, flags, body in elf_sections(path):
+            if name == "logtok_entries":
+                # Entries are 4-aligned; the compiler may align some further
+                pos = 0
+                while pos + 8 <= len(body):
+                    magic, length = struct.unpack_from("<II", body, pos)
+                    if magic != ENTRY_MAGIC:
+                        pos += 4
+                        continue
+                    raw = body[pos + 8:pos + 8 + length]
+                    self.add_format(raw.decode("utf-8", errors="replace"))
+                    found += 1
+                    pos += (8 + length + 1 + 3) & ~3
+            elif sh_type == SHT_PROGBITS and flags & SHF_ALLOC and not flags & SHF_EXECINSTR:
+                # Candidate tags: short identifier-like strings
+                for s in re.findall(rb"[A-Za-z_][A-Za-z0-9_\-]{0,31}(?=\0)", body):
+                    self.add_tag(s.decode())
+        if found == 0:
+            raise ValueError(f"{path}: no logtok_entries (not built with logtok, or stripped?)")
+
+    def load_csv(self, path):
+        with open(path, newline="", encoding="utf-8") as f:
+            for row in csv.reader(f):
+                if len(row) == 3 and row[0] == "tag":
+                    self.add_tag(row[2])
+                elif len(row) == 3 and row[0] == "fmt":
+                    self.add_format(row[2])
+
+    def save_csv(self, path):
+        with open(path, "w", newline="", encoding="utf-8") as f:
+            w = csv.writer(f)
+            for h, names in sorted(self.tags.items()):
+                for n in sorted(names):
+                    w.writerow(["tag", f"{h:04x}", n])
+            for t, texts in sorted(self.formats.items()):
+                for text in sorted(texts):
+                    w.writerow(["fmt", f"{t:08x}", text])
+
+    def collisions(self):
+        return {t: texts for t, texts in self.formats.items() if len(texts) > 1}
+
+
+# ---- Frames ----
+
+CONVERSION = re.compile(
+    r"%(?P<flags>[-+ #0]*)(?P<width>\d+|\*)?(?:\.(?P<prec>\d+|\*))?"
+    r"(?P<length>hh|h|ll|l|j|z|t|L)?(?P<conv>[diouxXeEfFgGaAcsp%])")
+
+
+class Reader:
+    def __init__(self, data):
+        self.data = data
+        self.pos = 0
+
+    def varint(self):
+        v = shift = 0
+        while True:
+            if self.pos >= len(self.data):
+                raise EOFError
+            b = self.data[self.pos]
+            self.pos += 1
+            v |= (b & 0x7F) << shift
+            shift += 7
+            if not b & 0x80:
+                return v
+
+    def int(self):
+        z = self.varint()
+        return (z >> 1) ^ -(z & 1)
+
+    def take(self, n):
+        if self.pos + n > len(self.data):
+            raise EOFError
+        out = self.data[self.pos:self.pos + n]
+        self.pos += n
+        return out
+
+    def float(self):
+        return struct.unpack("<f", self.take(4))[0]
+
+    def string(self):
+        head = self.take(1)[0]
+        text = self.take(head & 0x7F).decode("utf-8", errors="replace")
+        return text + ("…" if head & 0x80 else "")
+
+
+def render(fmt, r):
+    """printf(fmt) with arguments read from the frame."""
+    out = []
+    last = 0
+    for m in CONVERSION.finditer(fmt):
+        out.append(fmt[last:m.start()])
+        last = m.end()
+        conv = m["conv"]
+        if conv == "%":
+            out.append("%")
+            continue
+        if m["width"] == "*" or m["prec"] == "*":
+            raise ValueError("'*' width is not supported")
+        spec = "%" + m["flags"] + (m["width"] or "") + (f".{m['prec']}" if m["prec"] else "")
+        if conv in "eEfFgGaA":
+            v = r.float()
+            out.append((spec + ("e" if conv in "aA" else conv)) % v)
+        elif conv == "s":
+            out.append((spec + "s") % r.string())
+        elif conv == "c":
+            out.append((spec + "c") % (r.int() & 0xFF))
+        else:
+            v = r.int()
+            if conv in "uoxXp":
+                v &= 0xFFFFFFFFFFFFFFFF if m["length"] in ("ll", "j") else 0xFFFFFFFF
+            if conv == "p":
+                out.append((spec + "s") % f"0x{v:x}")
+            else:
+                out.append((spec + ("d" if conv in "iu" else conv)) % v)
+    out.append(fmt[last:])
+    return "".join(out)
+
+
+def decode(frame, db):
+    r = Reader(frame)
+    head = r.take(1)[0]
+    ts = r.varint()
+    tag_h, tok = struct.unpack("<HI", r.take(6))
+    level = LEVELS[head & 7] if head & 7 < len(LEVELS) else "?"
+    tags = db.tags.get(tag_h)
+    tag = "|".join(sorted(tags)) if tags else f"tag#{tag_h:04x}"
+    formats = db.formats.get(tok)
+    if not formats:
+        return f"{level} ({ts}) {tag}: <unknown token {tok:08x}: {frame[r.pos:].hex()}>"
+    texts = []
+    for fmt in sorted(formats):
+        rr = Reader(frame)
+        rr.pos = r.pos
+        try:
+            text = render(fmt, rr)
+        except EOFError:
+            text = fmt + " <arguments cut off>"
+        if head & TRUNCATED:
+            text += " [truncated]"
+        texts.append(text)
+    return f"{level} ({ts}) {tag}: " + " <or> ".join(texts)
+
+
+FRAME = re.compile(r"\$([A-Za-z0-9+/]{12,}={0,2})")
+
+
+def detokenize(lines, db, out, stats):
+    for line in lines:
+        m = FRAME.search(line)
+        if not m:
+            out.write(line)
+            continue
+        try:
+            frame = base64.b64decode(m.group(1), validate=True)
+            text = decode(frame, db)
+        except (binascii.Error, EOFError, struct.error):
+            out.write(line)     # Not ours, or torn
+            stats["bad"] += 1
+            continue
+        stats["frames"] += 1
+        stats["wire"] += len(m.group(0)) + 1
+        stats["packed"] += len(frame)
+        stats["text"] += len(text) + 1
+        out.write(line[:m.start()] + text + line[m.end():])
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("logs", nargs="*", help="captured logs (default: stdin)")
+    parser.add_argument("--elf", action="append", default=[], help="app ELF(s) with logtok_entries")
+    parser.add_argument("--db", help="token database (CSV) to read")
+    parser.add_argument("--save", action="store_true", help="merge the ELF formats into --db")
+    parser.add_argument("--stats", action="store_true", help="bytes on the wire vs decoded text")
+    args = parser.parse_args()
+
+    db = Database()
+    try:
+        if args.db and os.path.exists(args.db):
+            db.load_csv(args.db)
+        for path in args.elf:
+            db.load_elf(path)
+    except (OSError, ValueError) as e:
+        sys.exit(f"logtok: {e}")
+    if not db.formats:
+        sys.exit("logtok: no formats - give --elf or an existing --db")
+    for t, texts in db.collisions().items():
+        print(f"logtok: token {t:08x} is shared by {len(texts)} formats", file=sys.stderr)
+    if args.save:
+        if not args.db:
+            sys.exit("logtok: --save needs --db")
+        db.save_csv(args.db)
+        if not args.logs:
+            return
+
+    stats = dict(frames=0, wire=0, packed=0, text=0, bad=0)
+    if args.logs:
+        for path in args.logs:
+            with open(path, encoding="utf-8", errors="replace") as f:
+                detokenize(f, db, sys.stdout, stats)
+    else:
+        detokenize(sys.stdin, db, sys.stdout, stats)
+
+    if args.stats and stats["frames"]:
+        print(f"logtok: {stats['frames']} frames, {stats['wire']} bytes as base64 lines "
+              f"({stats['packed']} packed) for {stats['text']} bytes of text: "
+              f"{stats['text'] / stats['wire']:.1f}x ({stats['text'] / stats['packed']:.1f}x packed)",
+              file=sys.stderr)
+    if stats["bad"]:
+        print(f"logtok: left {stats['bad']} undecodable '$' lines as they were", file=sys.stderr)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,203 @@
+#!/usr/bin/env python3
+"""Symbolizer for PC-sampling profiles from components/pcprof.
+
+Reads PCPROF report blocks out of a captured serial log (idf.py monitor
+output or a plain file), maps every address to a function using the
+symbol table of the app ELF, and prints a flat profile or folded stacks.
+
+    python3 pcprof.py --elf build/Core_Pinned.elf monitor.log
+    python3 pcprof.py --elf build/Core_Pinned.elf --task Ctrl_1kHz monitor.log
+    python3 pcprof.py --elf build/Core_Pinned.elf --folded monitor.log > out.folded
+
+Folded output is one "task;outer;...;leaf count" line per stack, the
+input format of flamegraph.pl and speedscope.
+
+The flat profile lists, per function, "self" samples (the function was
+executing) and "total" samples (it was anywhere on the captured stack).
+Stacks are cut at PCPROF_MAX_DEPTH frames, so totals of deep callers
+are lower bounds.
+"""
+
+import argparse
+import bisect
+import collections
+import struct
+import sys
+
+# ---- ELF symbol table ----
+
+SHT_SYMTAB = 2
+STT_FUNC = 2
+
+
+class Symbols:
+    """Function symbols of an ELF file (32 or 64 bit, little endian)."""
+
+    def __init__(self, path):
+        with open(path, "rb") as f:
+            data = f.read()
+        if data[:4] != b"\x7fELF":
+            raise ValueError(f"{path}: not an ELF file")
+        if data[5] != 1:
+            raise ValueError(f"{path}: big-endian ELF not supported")
+
+        is64 = data[4] == 2
+        if is64:
+            shoff, = struct.unpack_from("<Q", data, 0x28)
+            shentsize, shnum = struct.unpack_from("<HH", data, 0x3A)
+            sh_fmt, sym_fmt = "<IIQQQQIIQQ", "<IBBHQQ"
+        else:
+            shoff, = struct.unpack_from("<I", data, 0x20)
+            shentsize, shnum = struct.unpack_from("<HH", data, 0x2E)
+            sh_fmt, sym_fmt = "<IIIIIIIIII", "<IIIBBH"
+
+        sections = [struct.unpack_from(sh_fmt, data, shoff + i * shentsize)
+                    for i in range(shnum)]
+        funcs = {}
+        for sh in sections:
+            if sh[1] != SHT_SYMTAB:
+                continue
+            offset, size, link, entsize = sh[4], sh[5], sh[6], sh[9]
+            strtab = sections[link]
+            str_off = strtab[4]
+            for i in range(size // entsize):
+                ent = struct.unpack_from(sym_fmt, data, offset + i * entsize)
+                if is64:
+                    name_off, info, _, _, value, sym_size = ent
+                else:
+                    name_off, value, sym_size, info, _, _ = ent
+                if info & 0xF != STT_FUNC or value == 0:
+                    continue
+                end = data.index(b"\0", str_off + name_off)
+                name = data[str_off + name_off:end].decode(errors="replace")
+                # Keep the sized entry when aliases share an address
+                if value not in funcs or funcs[value][1] == 0:
+                    funcs[value] = (name, sym_size)
+
+        self.addrs = sorted(funcs)
+        self.entries = [funcs[a] for a in self.addrs]
+        if not self.addrs:
+            raise ValueError(f"{path}: no function symbols (stripped?)")
+
+    def lookup(self, addr):
+        i = bisect.bisect_right(self.addrs, addr) - 1
+        if i >= 0:
+            name, size = self.entries[i]
+            start = self.addrs[i]
+            if addr < start + max(size, 1) or (size == 0 and i + 1 < len(self.addrs)):
+                return name
+        return f"0x{addr:08x}"
+
+
+# ---- Log parsing ----
+
+class Profile:
+    def __init__(self):
+        self.stacks = collections.Counter()     # (task, (pc, caller, ...)) -> count
+        self.reports = 0
+        self.samples = 0
+        self.dropped = 0
+        self.overflow = 0
+        self.rate_hz = 0
+        self.bad_lines = 0
+
+    def parse(self, lines):
+        for line in lines:
+            pos = line.find("PCPROF ")
+            if pos < 0:
+                continue
+            fields = line[pos:].split()
+            try:
+                if fields[1] == "B":
+                    self.reports += 1
+                    self.rate_hz = int(fields[3])
+                    self.samples += int(fields[4])
+                    self.dropped += int(fields[5])
+                    self.overflow += int(fields[6])
+                elif fields[1] == "S":
+                    task, count = fields[2], int(fields[3])
+                    pcs = tuple(int(a, 16) for a in fields[4:])
+                    self.stacks[(task, pcs)] += count
+            except (IndexError, ValueError):
+                self.bad_lines += 1     # Torn line from a noisy capture
+
+
+def symbolize(profile, symbols, task_filter):
+    """(task, [outermost ... leaf]) -> count, with recursion collapsed."""
+    out = collections.Counter()
+    for (task, pcs), count in profile.stacks.items():
+        if task_filter and task != task_filter:
+            continue
+        frames = [symbols.lookup(pc) for pc in reversed(pcs)] if pcs else ["[unknown]"]
+        out[(task, tuple(frames))] += count
+    return out
+
+
+def print_flat(profile, stacks, by_task, limit):
+    total = sum(stacks.values())
+    if total == 0:
+        print("No samples.")
+        return
+
+    self_counts = collections.Counter()
+    total_counts = collections.Counter()
+    task_counts = collections.Counter()
+    for (task, frames), count in stacks.items():
+        key = (lambda f: (task, f)) if by_task else (lambda f: f)
+        self_counts[key(frames[-1])] += count
+        for f in set(frames):
+            total_counts[key(f)] += count
+        task_counts[task] += count
+
+    seconds = profile.samples / profile.rate_hz if profile.rate_hz else 0
+    print(f"{profile.reports} reports, {profile.samples} samples "
+          f"(~{seconds:.1f} core-seconds at {profile.rate_hz} Hz), "
+          f"{profile.dropped} dropped, {profile.overflow} overflowed")
+    print()
+    print("Per task:")
+    for task, count in task_counts.most_common():
+        print(f"  {100.0 * count / total:6.2f}%  {count:8d}  {task}")
+    print()
+    print(f"  {'self%':>7} {'self':>8} {'total%':>7} {'total':>8}  function")
+    for key, count in self_counts.most_common(limit):
+        name = f"{key[1]}  [{key[0]}]" if by_task else key
+        print(f"  {100.0 * count / total:6.2f}% {count:8d} "
+              f"{100.0 * total_counts[key] / total:6.2f}% {total_counts[key]:8d}  {name}")
+
+
+def print_folded(stacks):
+    for (task, frames), count in sorted(stacks.items()):
+        print(";".join((task,) + frames), count)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("logs", nargs="+", help="captured logs with PCPROF lines")
+    parser.add_argument("--elf", required=True, help="app ELF the samples came from")
+    parser.add_argument("--task", help="only samples from this task")
+    parser.add_argument("--folded", action="store_true", help="folded stacks for flame graphs")
+    parser.add_argument("--by-task", action="store_true", help="flat profile rows per task")
+    parser.add_argument("--top", type=int, default=25, help="flat profile rows (default 25)")
+    args = parser.parse_args()
+
+    try:
+        symbols = Symbols(args.elf)
+    except (OSError, ValueError) as e:
+        sys.exit(f"pcprof: {e}")
+
+    profile = Profile()
+    for path in args.logs:
+        with open(path, errors="replace") as f:
+            profile.parse(f)
+    if profile.bad_lines:
+        print(f"pcprof: skipped {profile.bad_lines} malformed lines", file=sys.stderr)
+
+    stacks = symbolize(profile, symbols, args.task)
+    if args.folded:
+        print_folded(stacks)
+    else:
+        print_flat(profile, stacks, args.by_task, args.top)
+
+
+if __name__ == "__main__":
+    main()
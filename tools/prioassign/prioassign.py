@@ -0,0 +1,286 @@
+#!/usr/bin/env python3
+"""Priority assignment for periodic FreeRTOS task sets.
+
+Reads a task set (period, deadline, measured WCET and core of every
+task) from a TOML file, finds a priority order in which every task
+meets its deadline, and maps it onto FreeRTOS priorities.
+
+    python3 prioassign.py core_pinned_tasks.toml
+    python3 prioassign.py --dm core_pinned_tasks.toml
+    python3 prioassign.py --current core_pinned_tasks.toml
+    python3 prioassign.py --defines --max 24 --min 5 core_pinned_tasks.toml
+
+The default order comes from Audsley's algorithm: fill priority levels
+from the lowest up, each time with a task that still meets its deadline
+below all tasks not yet placed. It finds a feasible order whenever one
+exists. --dm uses deadline-monotonic order instead (shortest deadline
+highest), --current checks the priorities written in the file.
+
+Every order is checked with response-time analysis for fixed-priority
+preemptive scheduling, per core:
+
+    R = C + B + sum over higher-priority tasks j of ceil((R + Jj) / Tj) * Cj
+
+with the task's release jitter J added to R at the end. Only tasks that
+can run on the same core interfere. A task with core = "any" is counted
+against both cores and suffers interference from both - pessimistic for
+an unpinned task, but safe.
+
+The slack report lists per task the worst-case response, the slack to
+its deadline, and how much its WCET may grow before some task in the
+set misses - the margin left for the measurement being optimistic.
+Exits with 1 when no feasible order was found or a deadline is missed.
+
+Task set format (times in microseconds; deadline defaults to period,
+jitter and blocking to 0; macro and priority are optional):
+
+    [[task]]
+    name = "Ctrl_1kHz"
+    macro = "PRIO_CTRL"
+    period_us = 1000
+    wcet_us = 120
+    core = 0
+"""
+
+import argparse
+import sys
+import tomllib
+
+CORES = 2               # ESP32 dual core
+MAX_PRIORITY = 24       # configMAX_PRIORITIES - 1
+
+# ---- Task set ----
+
+
+class TaskSetError(Exception):
+    pass
+
+
+class Task:
+    KEYS = {"name", "macro", "period_us", "deadline_us", "wcet_us", "jitter_us",
+            "blocking_us", "core", "priority"}
+
+    def __init__(self, entry, index):
+        where = f"task {index + 1}"
+        unknown = set(entry) - self.KEYS
+        if unknown:
+            raise TaskSetError(f"{where}: unknown key(s) {', '.join(sorted(unknown))}")
+        for key in ("name", "period_us", "wcet_us"):
+            if key not in entry:
+                raise TaskSetError(f"{where}: missing '{key}'")
+
+        self.name = entry["name"]
+        self.macro = entry.get("macro")
+        self.period = int(entry["period_us"])
+        self.deadline = int(entry.get("deadline_us", self.period))
+        self.wcet = int(entry["wcet_us"])
+        self.jitter = int(entry.get("jitter_us", 0))
+        self.blocking = int(entry.get("blocking_us", 0))
+        self.priority = entry.get("priority")
+
+        core = entry.get("core", "any")
+        if core == "any":
+            self.cores = set(range(CORES))
+        elif isinstance(core, int) and 0 <= core < CORES:
+            self.cores = {core}
+        else:
+            raise TaskSetError(f"{self.name}: core must be 0..{CORES - 1} or \"any\"")
+        self.core_label = "any" if core == "any" else str(core)
+
+        if self.period <= 0 or self.wcet <= 0:
+            raise TaskSetError(f"{self.name}: period and WCET must be positive")
+        if self.deadline <= 0:
+            raise TaskSetError(f"{self.name}: deadline must be positive")
+
+    def shares_core(self, other):
+        return bool(self.cores & other.cores)
+
+
+def load_tasks(path):
+    with open(path, "rb") as f:
+        entries = tomllib.load(f).get("task", [])
+    if not entries:
+        raise TaskSetError(f"{path}: no [[task]] entries")
+    tasks = [Task(e, i) for i, e in enumerate(entries)]
+    names = [t.name for t in tasks]
+    for name in names:
+        if names.count(name) > 1:
+            raise TaskSetError(f"task '{name}' listed twice")
+    return tasks
+
+
+# ---- Response-time analysis ----
+
+
+def response_time(task, higher, extra=None):
+    """Worst-case response of task below the tasks in higher, None on a miss.
+
+    extra: additional WCET per task name, for the margin search.
+    """
+    extra = extra or {}
+    c = task.wcet + extra.get(task.name, 0)
+    interferers = [(h.period, h.jitter, h.wcet + extra.get(h.name, 0))
+                   for h in higher if h.shares_core(task)]
+    limit = task.deadline - task.jitter
+    r = c + task.blocking
+    while r <= limit:
+        demand = c + task.blocking + sum(-(-(r + j) // t) * hc for t, j, hc in interferers)
+        if demand == r:
+            return r + task.jitter
+        r = demand
+    return None
+
+
+def higher_than(order, i, ties):
+    """Tasks that can delay order[i]. With ties, equal priorities count:
+    FreeRTOS time-slices them, so each can delay the other by a whole job."""
+    higher = order[:i]
+    if ties:
+        higher += [t for t in order[i + 1:] if t.priority == order[i].priority]
+    return higher
+
+
+def responses(order, ties=False, extra=None):
+    return [response_time(t, higher_than(order, i, ties), extra) for i, t in enumerate(order)]
+
+
+def feasible(order, ties=False, extra=None):
+    """order: highest priority first. True if every task meets its deadline."""
+    return None not in responses(order, ties, extra)
+
+
+def wcet_margin(order, task, ties=False):
+    """Largest extra WCET of task that keeps the whole order feasible."""
+    lo, hi = 0, task.deadline
+    while lo < hi:
+        mid = (lo + hi + 1) // 2
+        if feasible(order, ties, {task.name: mid}):
+            lo = mid
+        else:
+            hi = mid - 1
+    return lo
+
+
+# ---- Priority orders ----
+
+
+def audsley(tasks):
+    """Highest priority first; (order, None) or (None, tasks left unplaced)."""
+    unplaced = list(tasks)
+    lowest_first = []
+    while unplaced:
+        fits = [t for t in unplaced
+                if response_time(t, [u for u in unplaced if u is not t]) is not None]
+        if not fits:
+            return None, unplaced
+        # Of the tasks that fit, the one with the longest deadline goes
+        # lowest, so the result reads like deadline-monotonic order
+        # wherever that works
+        pick = max(fits, key=lambda t: (t.deadline - t.jitter, t.period, t.name))
+        unplaced.remove(pick)
+        lowest_first.append(pick)
+    return lowest_first[::-1], None
+
+
+def deadline_monotonic(tasks):
+    return sorted(tasks, key=lambda t: (t.deadline - t.jitter, t.period, t.name))
+
+
+def current_order(tasks):
+    missing = [t.name for t in tasks if t.priority is None]
+    if missing:
+        raise TaskSetError(f"no priority for {', '.join(missing)}")
+    return sorted(tasks, key=lambda t: -t.priority)
+
+
+def map_priorities(order, lo, hi, step):
+    """FreeRTOS priority per task, highest first, step apart if they fit."""
+    n = len(order)
+    while step > 1 and hi - step * (n - 1) < lo:
+        step -= 1
+    if hi - step * (n - 1) < lo:
+        raise TaskSetError(f"{n} tasks don't fit in priorities {lo}..{hi}")
+    return {t.name: hi - step * i for i, t in enumerate(order)}
+
+
+# ---- Reports ----
+
+
+def utilisation(tasks):
+    return {core: sum(t.wcet / t.period for t in tasks if core in t.cores) for core in range(CORES)}
+
+
+def print_report(order, priorities, method):
+    print(f"prioassign: {method}, {len(order)} tasks")
+    for core, u in utilisation(order).items():
+        print(f"  core {core}: utilisation {u * 100:.1f}%")
+    print()
+    print(f"{'prio':>4}  {'task':<16} {'core':>4} {'period':>8} {'deadline':>8} {'wcet':>7} "
+          f"{'jitter':>7} {'response':>8} {'slack':>8} {'slack%':>6} {'+wcet':>7}")
+
+    ties = method == "current"
+    ok = True
+    for t, r in zip(order, responses(order, ties)):
+        if r is None:
+            ok = False
+            resp, slack, pct, margin = "MISS", "-", "-", "-"
+        else:
+            resp = f"{r}"
+            slack = f"{t.deadline - r}"
+            pct = f"{(t.deadline - r) * 100 / t.deadline:.0f}"
+            margin = f"{wcet_margin(order, t, ties)}"
+        print(f"{priorities[t.name]:>4}  {t.name:<16} {t.core_label:>4} {t.period:>8} {t.deadline:>8} "
+              f"{t.wcet:>7} {t.jitter:>7} {resp:>8} {slack:>8} {pct:>6} {margin:>7}")
+    print()
+    print("times in us; +wcet = extra execution time the task may take before any task misses")
+    return ok
+
+
+def print_defines(order, priorities):
+    for t in order:
+        macro = t.macro or "PRIO_" + "".join(c if c.isalnum() else "_" for c in t.name).upper()
+        print(f"#define {macro:<18} {priorities[t.name]}")
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("taskset", help="TOML task set")
+    group = parser.add_mutually_exclusive_group()
+    group.add_argument("--dm", action="store_true", help="deadline-monotonic order instead of Audsley")
+    group.add_argument("--current", action="store_true", help="check the priorities given in the file")
+    parser.add_argument("--max", type=int, default=MAX_PRIORITY, help="highest priority to use (default 24)")
+    parser.add_argument("--min", type=int, default=1, help="lowest priority to use (default 1)")
+    parser.add_argument("--step", type=int, default=2,
+                        help="gap between levels, narrowed if the band is too small (default 2)")
+    parser.add_argument("--defines", action="store_true", help="print #define lines only")
+    args = parser.parse_args()
+
+    try:
+        tasks = load_tasks(args.taskset)
+        if args.current:
+            order, method = current_order(tasks), "current"
+            priorities = {t.name: t.priority for t in tasks}
+        else:
+            if args.dm:
+                order, method = deadline_monotonic(tasks), "deadline-monotonic"
+            else:
+                order, unplaced = audsley(tasks)
+                method = "Audsley"
+                if order is None:
+                    names = ", ".join(t.name for t in unplaced)
+                    print(f"prioassign: no feasible order - none of {names} meets its deadline "
+                          f"below the others", file=sys.stderr)
+                    print("deadline-monotonic order for reference:\n", file=sys.stderr)
+                    order, method = deadline_monotonic(tasks), "deadline-monotonic (infeasible)"
+            priorities = map_priorities(order, args.min, args.max, max(args.step, 1))
+    except (OSError, TaskSetError, ValueError, tomllib.TOMLDecodeError) as e:
+        sys.exit(f"prioassign: {e}")
+
+    if args.defines:
+        print_defines(order, priorities)
+        return 0 if feasible(order, args.current) else 1
+    return 0 if print_report(order, priorities, method) else 1
+
+
+if __name__ == "__main__":
+    sys.exit(main())